@@ -0,0 +1,89 @@
+/*
+ * SMC value decode microbenchmark
+ *
+ * Measures the cost of decoding one key value, per data type, through the
+ * decoder table (decoder index resolved once, as the key-info cache does)
+ * and through the string compare chain it replaced.
+ *
+ *   npm run bench:decode
+ */
+
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../smc/smc.h"
+
+static const int ITERATIONS = 20000000;
+
+typedef struct {
+  const char *type;
+  UInt32 size;
+  UInt8 bytes[4];
+} Sample;
+
+static const Sample samples[] = {
+  {"sp78", 2, {0x2d, 0x80}},
+  {"sp87", 2, {0x16, 0xc0}},
+  {"sp96", 2, {0x0b, 0x60}},
+  {"fpe2", 2, {0x12, 0xc0}},
+  {"fp88", 2, {0x2d, 0x80}},
+  {"flt ", 4, {0x00, 0x00, 0x36, 0x42}},
+  {"ui8 ", 1, {0x02}},
+  {"ui16", 2, {0x09, 0x60}},
+  {"ui32", 4, {0x00, 0x01, 0x00, 0x00}},
+  {"si8 ", 1, {0xf6}},
+  {"si16", 2, {0xff, 0x10}},
+  {"flag", 1, {0x01}},
+};
+
+// The dispatch the decoder table replaced: compare the type string, then
+// convert the bytes
+static double DecodeByName(const char *type, const UInt8 *b, UInt32 size) {
+  if (strcmp(type, "sp78") == 0) return (int16_t)((b[0] << 8) | b[1]) / 256.0;
+  if (strcmp(type, "sp87") == 0) return (int16_t)((b[0] << 8) | b[1]) / 128.0;
+  if (strcmp(type, "sp96") == 0) return (int16_t)((b[0] << 8) | b[1]) / 64.0;
+  if (strcmp(type, "fpe2") == 0) return ((b[0] << 8) | b[1]) / 4.0;
+  if (strcmp(type, "fp88") == 0) return ((b[0] << 8) | b[1]) / 256.0;
+  if (strcmp(type, "flt ") == 0 && size == 4) {
+    float f;
+    memcpy(&f, b, sizeof(float));
+    return f;
+  }
+  if (strcmp(type, "ui8 ") == 0) return b[0];
+  if (strcmp(type, "ui16") == 0) return (b[0] << 8) | b[1];
+  if (strcmp(type, "ui32") == 0) return ((UInt32)b[0] << 24) | (b[1] << 16) | (b[2] << 8) | b[3];
+  if (strcmp(type, "si8 ") == 0) return (int8_t)b[0];
+  if (strcmp(type, "si16") == 0) return (int16_t)((b[0] << 8) | b[1]);
+  if (strcmp(type, "flag") == 0) return b[0] ? 1 : 0;
+  return NAN;
+}
+
+template <typename F>
+static double NanosPerKey(F decode) {
+  volatile double sink = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < ITERATIONS; i++) {
+    sink = sink + decode();
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  return std::chrono::duration<double, std::nano>(elapsed).count() / ITERATIONS;
+}
+
+int main() {
+  printf("%-6s %10s %10s\n", "type", "table", "strcmp");
+
+  for (const Sample &sample : samples) {
+    UInt8 decoder = SMCFindDecoder(SMCKeyFromString(sample.type), sample.size);
+    const UInt8 *volatile bytes = sample.bytes;
+    const char *volatile type = sample.type;
+
+    double table = NanosPerKey([&] { return SMCDecode(decoder, bytes); });
+    double byName = NanosPerKey([&] { return DecodeByName(type, bytes, sample.size); });
+
+    printf("%-6s %8.2fns %8.2fns\n", sample.type, table, byName);
+  }
+
+  return 0;
+}
@@ -0,0 +1,87 @@
+/*
+ * Energy Model sample parse microbenchmark
+ *
+ * Measures the cost of turning one Energy Model sample into PowerMetrics:
+ * through the channel index built at subscription time (integers summed by
+ * position), and by name as every sample used to be parsed (copy the name
+ * and unit out of each channel, then classify and scale them). The channel
+ * list is an M1 Max's; copying from a std::string stands in for
+ * CFStringGetCString, so the by-name numbers are a lower bound.
+ *
+ * On a Mac, powerSamplerStats().sample_us reports the whole per-sample time,
+ * IOReport included.
+ *
+ *   npm run bench:energy
+ */
+
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+
+#include "../smc/smc.h"
+
+static const int ITERATIONS = 200000;
+
+static const char *const m1_max_channels[] = {
+  "EACC_CPU0", "EACC_CPU1", "EACC_CPU", "EACC_CPU_SRAM",
+  "PACC0_CPU0", "PACC0_CPU1", "PACC0_CPU2", "PACC0_CPU3", "PACC0_CPU", "PACC0_CPU_SRAM",
+  "PACC1_CPU0", "PACC1_CPU1", "PACC1_CPU2", "PACC1_CPU3", "PACC1_CPU", "PACC1_CPU_SRAM",
+  "CPU Energy", "GPU0", "GPU SRAM0", "GPU Energy", "ANE0", "ANE0_DTL", "DRAM0", "DRAM0_DTL",
+  "AMCC0", "AMCC1", "AMCC2", "AMCC3", "DCS0", "DCS1", "DCS2", "DCS3",
+  "DISP0", "DISPEXT0", "ISP0", "AVE0", "MSR0", "PCIe0", "SOC_AON", "AFR"
+};
+static const size_t CHANNEL_COUNT = sizeof(m1_max_channels) / sizeof(m1_max_channels[0]);
+
+template <typename F>
+static double NanosPerSample(F parse) {
+  volatile double sink = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < ITERATIONS; i++) {
+    sink = sink + parse();
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  return std::chrono::duration<double, std::nano>(elapsed).count() / ITERATIONS;
+}
+
+int main() {
+  std::vector<SMCReportChannelInfo> channels;
+  std::vector<int64_t> values;
+  for (size_t i = 0; i < CHANNEL_COUNT; i++) {
+    SMCReportChannelInfo channel;
+    channel.group = "Energy Model";
+    channel.name = m1_max_channels[i];
+    channel.unit = i % 3 ? "mJ" : "nJ";
+    channel.format = SMC_REPORT_SIMPLE;
+    channels.push_back(channel);
+    values.push_back((int64_t)(i + 1) * 1000);
+  }
+  SMCLayOutReport(&channels);
+
+  std::vector<SMCEnergyIndexEntry> index = SMCBuildEnergyIndex(channels);
+  const int64_t *volatile data = values.data();
+
+  double indexed = NanosPerSample([&] {
+    PowerMetrics joules = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+    SMCSumEnergy(index.data(), index.size(), data, &joules);
+    return joules.total;
+  });
+
+  double byName = NanosPerSample([&] {
+    PowerMetrics joules = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+    for (size_t i = 0; i < channels.size(); i++) {
+      char name[256] = {0};
+      char unit[32] = {0};
+      strncpy(name, channels[i].name.c_str(), sizeof(name) - 1);
+      strncpy(unit, channels[i].unit.c_str(), sizeof(unit) - 1);
+
+      double scale = SMCEnergyUnitScale(unit);
+      SMCAddEnergy(SMCClassifyEnergyChannel(name), data[i] * scale, &joules);
+    }
+    return joules.total;
+  });
+
+  printf("%zu channels per sample\n", CHANNEL_COUNT);
+  printf("%-8s %10s\n", "index", "by name");
+  printf("%6.1fns %8.1fns\n", indexed, byName);
+  return 0;
+}
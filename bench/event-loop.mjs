@@ -0,0 +1,53 @@
+/*
+ * Event-loop delay benchmark
+ *
+ * Samples every getter for a while, once with the async API and once with
+ * the sync API wrapped in a promise (what the async API used to be), and
+ * reports the event-loop delay measured meanwhile. With the async getters
+ * the hardware is read on worker threads, so the delay should stay near
+ * the histogram's resolution even while power is being sampled.
+ *
+ *   npm run bench:event-loop -- [seconds]
+ */
+
+import { monitorEventLoopDelay } from 'node:perf_hooks';
+import * as index from '../dist/index.js';
+import * as disk from '../dist/disk.js';
+import * as sensors from '../dist/sensors.js';
+
+const macstats = { ...index, ...disk, ...sensors };
+
+const seconds = Number(process.argv[2] ?? 5);
+
+const getters = [
+  'getCpuData', 'getCPUUsage', 'getGpuData', 'getFanData', 'getPowerData', 'getSensorData',
+  'getBatteryData', 'getMemoryData', 'getRAMUsage', 'getDiskInfo', 'getSystemData'
+];
+
+const modes = {
+  async: (name) => macstats[name](),
+  'sync in promise': (name) => new Promise((resolve) => resolve(macstats[`${name}Sync`]()))
+};
+
+async function run(label, sample) {
+  const histogram = monitorEventLoopDelay({ resolution: 10 });
+  const deadline = Date.now() + seconds * 1000;
+  let rounds = 0;
+
+  histogram.enable();
+  while (Date.now() < deadline) {
+    await Promise.all(getters.map(sample));
+    rounds++;
+  }
+  histogram.disable();
+
+  const ms = (ns) => (ns / 1e6).toFixed(1).padStart(8);
+  console.log(
+    `${label.padEnd(16)} ${String(rounds).padStart(6)} rounds  ` +
+      `delay mean ${ms(histogram.mean)} ms  p99 ${ms(histogram.percentile(99))} ms  max ${ms(histogram.max)} ms`
+  );
+}
+
+for (const [label, sample] of Object.entries(modes)) {
+  await run(label, sample);
+}
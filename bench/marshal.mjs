@@ -0,0 +1,59 @@
+/*
+ * Marshalling benchmark
+ *
+ * Result objects per second for the getters whose objects come from cached
+ * property names and object templates: RAM usage, CPU usage, disks, battery
+ * and power. The SMC runs on the simulated transport and power on the fake
+ * source, so the numbers are mostly object building rather than hardware.
+ *
+ * To compare with another build (e.g. the commit before), build it elsewhere
+ * and pass its addon; both are measured in the same process:
+ *
+ *   npm run bench:marshal -- [seconds-per-getter] [baseline/smc.node]
+ */
+
+import { createRequire } from 'node:module';
+import { resolve } from 'node:path';
+
+const require = createRequire(import.meta.url);
+const seconds = Number(process.argv[2] ?? 1);
+const addons = { current: require('../build/Release/smc.node') };
+if (process.argv[3]) {
+  addons.baseline = require(resolve(process.argv[3]));
+}
+
+const getters = {
+  getRAMUsageData: (smc) => (smc.getRAMUsageData(), 1),
+  getCPUUsageData: (smc) => (smc.getCPUUsageData(), 1),
+  getDiskData: (smc) => smc.getDiskData().length,
+  getBatteryData: (smc) => (smc.getBatteryData(), 1),
+  getAllPower: (smc) => (smc.getAllPower(), 1)
+};
+
+function measure(smc, getter) {
+  let objects = 0;
+  const deadline = process.hrtime.bigint() + BigInt(Math.round(seconds * 1e9));
+  const started = process.hrtime.bigint();
+  while (process.hrtime.bigint() < deadline) {
+    for (let i = 0; i < 100; i++) {
+      objects += getter(smc);
+    }
+  }
+  return objects / (Number(process.hrtime.bigint() - started) / 1e9);
+}
+
+for (const smc of Object.values(addons)) {
+  smc.setTransport({ type: 'simulated', chip: 'M3' });
+  smc.setPowerSource({ type: 'fake', cpu: 4, gpu: 2, ane: 1 });
+  smc.getAllPower();
+}
+
+console.log(`${'getter'.padEnd(16)}${Object.keys(addons).map((name) => name.padStart(16)).join('')}`);
+for (const [name, getter] of Object.entries(getters)) {
+  const rates = Object.values(addons).map((smc) => measure(smc, getter));
+  console.log(`${name.padEnd(16)}${rates.map((rate) => `${Math.round(rate)}/s`.padStart(16)).join('')}`);
+}
+
+for (const smc of Object.values(addons)) {
+  smc.stopPowerSampler();
+}
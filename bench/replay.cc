@@ -0,0 +1,71 @@
+/*
+ * SMC trace replay benchmark
+ *
+ * Replays a trace recorded with setTransport({type: 'record', path}) through
+ * the hardware-independent SMC layer (connection manager, key-info cache,
+ * key catalog, decoders) and reports SMC call counts and time spent. Needs
+ * no Apple hardware, so it can run in CI to catch regressions in the number
+ * of SMC round-trips or their recorded latency.
+ *
+ *   npm run bench:replay -- trace.bin [rounds]
+ */
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../smc/smc.h"
+
+static double Millis(std::chrono::steady_clock::duration elapsed) {
+  return std::chrono::duration<double, std::milli>(elapsed).count();
+}
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s trace.bin [rounds]\n", argv[0]);
+    return 2;
+  }
+  int rounds = argc > 2 ? atoi(argv[2]) : 100;
+
+  // Recorded latency is replayed so timings follow the traced machine
+  SMCTraceReplay *replay = SMCTraceReplayCreate(argv[1], true);
+  if (!replay) {
+    fprintf(stderr, "cannot read trace %s\n", argv[1]);
+    return 1;
+  }
+  SMCSetTransport(SMCTraceReplayTransport(replay));
+
+  // Cold: enumerate keys and find the temperature sensors
+  auto start = std::chrono::steady_clock::now();
+  const char *prefixes[] = {"Tp", "Te", "Tg"};
+  std::vector<UInt32> keys;
+  bool catalog = SMCFindKeys(prefixes, 3, SMC_TYPE_FLT, 4, &keys);
+  double discoverMs = Millis(std::chrono::steady_clock::now() - start);
+  uint64_t discoverCalls = SMCGetConnectionStats().calls;
+
+  // Warm: read every temperature key once per round
+  std::vector<double> values(keys.size());
+  std::vector<int32_t> status(keys.size());
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < rounds; i++) {
+    SMCReadKeys(keys.data(), keys.size(), values.data(), status.data());
+  }
+  double readMs = Millis(std::chrono::steady_clock::now() - start);
+  uint64_t readCalls = SMCGetConnectionStats().calls - discoverCalls;
+
+  SMCTraceReplayStats stats = SMCTraceReplayGetStats(replay);
+  std::vector<SMCKeyEntry> entries;
+  SMCGetKeyCatalog(&entries);
+
+  printf("trace records      %llu\n", (unsigned long long)stats.records);
+  printf("catalog keys       %zu%s\n", entries.size(), catalog ? "" : " (no catalog)");
+  printf("temperature keys   %zu\n", keys.size());
+  printf("discovery          %llu calls, %.2f ms\n", (unsigned long long)discoverCalls, discoverMs);
+  printf("reads x%-4d        %llu calls, %.3f ms per round\n", rounds, (unsigned long long)readCalls,
+         rounds > 0 ? readMs / rounds : 0.0);
+  printf("replay misses      %llu\n", (unsigned long long)stats.misses);
+
+  SMCSetTransport(NULL);
+  SMCTraceReplayDestroy(replay);
+  return 0;
+}
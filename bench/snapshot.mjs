@@ -0,0 +1,46 @@
+/*
+ * Snapshot benchmark
+ *
+ * Compares one dashboard tick done the old way, with every module getter
+ * called separately, against one snapshot() call collecting the same
+ * metrics. Reports time and SMC round-trips per tick for both, sync and
+ * async.
+ *
+ *   npm run bench:snapshot -- [ticks]
+ */
+
+import { createRequire } from 'node:module';
+import * as index from '../dist/index.js';
+import * as disk from '../dist/disk.js';
+import * as sensors from '../dist/sensors.js';
+
+const smc = createRequire(import.meta.url)('../build/Release/smc.node');
+const macstats = { ...index, ...disk, ...sensors };
+const ticks = Number(process.argv[2] ?? 50);
+
+const getters = [
+  'getSystemData', 'getCpuData', 'getCPUUsage', 'getGpuData', 'getRAMUsage',
+  'getBatteryData', 'getSensorData', 'getFanData', 'getDiskInfo', 'getPowerData'
+];
+const metrics = ['system', 'cpu', 'cpuUsage', 'gpu', 'ram', 'battery', 'sensors', 'fans', 'disks', 'power'];
+
+const modes = {
+  'getters (sync)': () => getters.forEach((name) => macstats[`${name}Sync`]()),
+  'snapshot (sync)': () => macstats.getSnapshotSync(metrics),
+  'getters (async)': () => Promise.all(getters.map((name) => macstats[name]())),
+  'snapshot (async)': () => macstats.getSnapshot(metrics)
+};
+
+// Start the power sampler and fill the key caches first
+await macstats.getSnapshot();
+
+for (const [label, tick] of Object.entries(modes)) {
+  const calls = smc.smcStats().calls;
+  const started = process.hrtime.bigint();
+  for (let i = 0; i < ticks; i++) {
+    await tick();
+  }
+  const ms = Number(process.hrtime.bigint() - started) / 1e6 / ticks;
+  const perTick = (smc.smcStats().calls - calls) / ticks;
+  console.log(`${label.padEnd(18)} ${ms.toFixed(2).padStart(8)} ms/tick  ${perTick.toFixed(1).padStart(6)} SMC calls/tick`);
+}
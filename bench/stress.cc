@@ -0,0 +1,220 @@
+/*
+ * SMC concurrency stress test
+ *
+ * Runs many reader threads against one simulated SMC device through the
+ * hardware-independent SMC layer: batched reads, single reads, key info
+ * lookups and catalog scans, with calls failing at random so the connection
+ * keeps being dropped and reopened underneath the readers. Every value that
+ * reads OK must be the programmed one, and the connection must end with no
+ * references held. A second phase pushes a numbered sequence through a
+ * small sample ring while a consumer pops it: every number must come out
+ * once, in order, either popped or evicted. A third phase has readers copy
+ * a shared value block while one writer publishes samples whose values are
+ * all equal: a copy mixing two samples is a torn read. Build it with
+ * -fsanitize=thread to catch data races:
+ *
+ *   npm run test:stress -- [threads] [iterations]
+ */
+
+#include <atomic>
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+
+#include "../smc/smc.h"
+
+static const int KEY_COUNT = 64;
+
+static UInt32 keys[KEY_COUNT];
+static double expected[KEY_COUNT];
+
+static std::atomic<uint64_t> reads(0);
+static std::atomic<uint64_t> failed(0);
+static std::atomic<uint64_t> wrong(0);
+
+static void Check(int i, int32_t status, double value) {
+  reads++;
+  if (status == SMC_READ_ERROR) {
+    failed++;
+  } else if (status != SMC_READ_OK || value != expected[i]) {
+    wrong++;
+  }
+}
+
+static void Reader(int id, int iterations) {
+  double values[KEY_COUNT];
+  int32_t status[KEY_COUNT];
+  const char *prefixes[] = {"T"};
+
+  for (int n = 0; n < iterations; n++) {
+    switch ((id + n) % 4) {
+      case 0:
+        SMCReadKeys(keys, KEY_COUNT, values, status);
+        for (int i = 0; i < KEY_COUNT; i++) Check(i, status[i], values[i]);
+        break;
+      case 1: {
+        int i = (id * 7 + n) % KEY_COUNT;
+        SMCOpen();
+        status[0] = SMCReadKeyValue(keys[i], &values[0]);
+        SMCClose();
+        Check(i, status[0], values[0]);
+        break;
+      }
+      case 2: {
+        int i = (id + n * 3) % KEY_COUNT;
+        SMCKeyData_keyInfo_t info;
+        kern_return_t result = SMCLookupKeyInfo(keys[i], &info);
+        if (result == kIOReturnSuccess && (info.dataSize != 4 || info.dataType != SMC_TYPE_FLT)) {
+          wrong++;
+        }
+        break;
+      }
+      default: {
+        std::vector<UInt32> found;
+        if (SMCFindKeys(prefixes, 1, SMC_TYPE_FLT, 4, &found) && found.size() != KEY_COUNT) {
+          wrong++;
+        }
+        break;
+      }
+    }
+  }
+}
+
+// Producer pushes 1..count, the consumer pops; returns false on loss or reordering
+static bool RingStress(uint64_t count) {
+  SMCRing *ring = SMCRingCreate(8);
+  std::atomic<bool> done(false);
+  uint64_t popped = 0, evicted = 0, last_popped = 0, last_evicted = 0;
+  bool ordered = true;
+
+  std::thread consumer([&] {
+    for (;;) {
+      bool finished = done.load();
+      void *item;
+      while ((item = SMCRingPop(ring)) != NULL) {
+        uint64_t value = (uint64_t)(uintptr_t)item;
+        if (value <= last_popped) ordered = false;
+        last_popped = value;
+        popped++;
+      }
+      if (finished) break;
+    }
+  });
+
+  for (uint64_t i = 1; i <= count; i++) {
+    void *item = SMCRingPush(ring, (void *)(uintptr_t)i);
+    if (item) {
+      uint64_t value = (uint64_t)(uintptr_t)item;
+      if (value <= last_evicted) ordered = false;
+      last_evicted = value;
+      evicted++;
+    }
+    if (i % 4 == 0) {
+      std::this_thread::yield();  // Let the consumer keep up some of the time
+    }
+  }
+  done = true;
+  consumer.join();
+
+  printf("ring               %llu pushed, %llu popped, %llu evicted\n", (unsigned long long)count,
+         (unsigned long long)popped, (unsigned long long)evicted);
+  SMCRingDestroy(ring);
+  return ordered && popped + evicted == count;
+}
+
+// One writer publishes samples 1..count with every value equal to the sample
+// number; returns false if a reader copied a torn or out-of-order sample
+static bool BlockStress(int readers, uint64_t count) {
+  const uint32_t VALUES = 32;
+  SMCBlock *block = SMCBlockCreate(VALUES, 1);
+  std::atomic<bool> done(false);
+  std::atomic<uint64_t> copies(0), torn(0);
+
+  std::vector<std::thread> pool;
+  for (int r = 0; r < readers; r++) {
+    pool.emplace_back([&] {
+      double values[VALUES];
+      double last = 0;
+      while (!done.load()) {
+        uint32_t seq = SMCBlockRead(block, values);
+        bool whole = (seq & 1) == 0 && values[0] >= last;
+        for (uint32_t i = 1; i < VALUES; i++) {
+          whole = whole && values[i] == values[0];
+        }
+        if (!whole) torn++;
+        last = values[0];
+        copies++;
+      }
+    });
+  }
+
+  double values[VALUES];
+  for (uint64_t n = 1; n <= count; n++) {
+    for (uint32_t i = 0; i < VALUES; i++) {
+      values[i] = (double)n;
+    }
+    SMCBlockWrite(block, values);
+  }
+  done = true;
+  for (std::thread &thread : pool) {
+    thread.join();
+  }
+
+  printf("block              %llu samples, %llu copies, %llu torn\n", (unsigned long long)count,
+         (unsigned long long)copies.load(), (unsigned long long)torn.load());
+  bool ok = torn == 0 && block->header->sequence.load() == count * 2;
+  SMCBlockDestroy(block);
+  return ok;
+}
+
+int main(int argc, char **argv) {
+  int threads = argc > 1 ? atoi(argv[1]) : 16;
+  int iterations = argc > 2 ? atoi(argv[2]) : 2000;
+
+  SMCSimDevice *device = SMCSimCreate();
+  device->error_rate = 0.01;
+  SMCSimSeed(device, 42);
+  for (int i = 0; i < KEY_COUNT; i++) {
+    char name[5];
+    snprintf(name, sizeof(name), "T%03d", i);
+    keys[i] = SMCKeyFromString(name);
+    expected[i] = 30 + i * 0.5;
+    SMCSimAddValue(device, name, "flt ", expected[i]);
+  }
+  SMCSetTransport(&device->transport);
+
+  std::vector<std::thread> pool;
+  for (int t = 0; t < threads; t++) {
+    pool.emplace_back(Reader, t, iterations);
+  }
+  for (std::thread &thread : pool) {
+    thread.join();
+  }
+
+  SMCConnectionStats stats = SMCGetConnectionStats();
+  SMCKeyInfoCacheStats cache = SMCGetKeyInfoCacheStats();
+
+  printf("threads            %d x %d iterations\n", threads, iterations);
+  printf("value reads        %llu (%llu failed by injected errors)\n",
+         (unsigned long long)reads.load(), (unsigned long long)failed.load());
+  printf("smc calls          %llu, %llu errors, %llu reconnects\n", (unsigned long long)stats.calls,
+         (unsigned long long)stats.errors, (unsigned long long)stats.reconnects);
+  printf("key info cache     %llu entries, %llu misses\n", (unsigned long long)cache.entries,
+         (unsigned long long)cache.misses);
+  printf("wrong results      %llu\n", (unsigned long long)wrong.load());
+  printf("refs left          %d\n", stats.refs);
+
+  bool ok = wrong == 0 && stats.refs == 0 && stats.calls == device->stats.calls;
+  ok = RingStress((uint64_t)iterations * 100) && ok;
+  ok = BlockStress(threads, (uint64_t)iterations * 100) && ok;
+
+  SMCSetTransport(NULL);
+  SMCSimDestroy(device);
+
+  if (!ok) {
+    printf("FAILED\n");
+    return 1;
+  }
+  printf("OK\n");
+  return 0;
+}
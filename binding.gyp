@@ -4,7 +4,21 @@
             "target_name": "smc",
             "sources": [
                 "smc/smc.h",
-                "smc/smc.cc"
+                "smc/smc.cc",
+                "smc/smc_block.cc",
+                "smc/smc_connection.cc",
+                "smc/smc_energy.cc",
+                "smc/smc_keys.cc",
+                "smc/smc_key_cache.cc",
+                "smc/smc_power.cc",
+                "smc/smc_refresh.cc",
+                "smc/smc_region.cc",
+                "smc/smc_report.cc",
+                "smc/smc_residency.cc",
+                "smc/smc_ring.cc",
+                "smc/smc_sim.cc",
+                "smc/smc_trace.cc",
+                "smc/smc_types.cc"
             ],
             "link_settings": {
                 "libraries": [
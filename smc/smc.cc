@@ -29,10 +29,18 @@
 #include <CoreFoundation/CoreFoundation.h>
 #include <nan.h>
 #include <node.h>
+#include <uv.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <string.h>
 #include <string>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
 #include <vector>
 #include <v8.h>
 #include <sys/sysctl.h>
@@ -72,6 +80,10 @@ extern "C" {
   CFStringRef IOReportChannelGetSubGroup(CFDictionaryRef channel);
   CFStringRef IOReportChannelGetUnitLabel(CFDictionaryRef channel);
   void IOReportMergeChannels(CFDictionaryRef a, CFDictionaryRef b, CFTypeRef c);
+  uint8_t IOReportChannelGetFormat(CFDictionaryRef channel);
+  int32_t IOReportStateGetCount(CFDictionaryRef channel);
+  CFStringRef IOReportStateGetNameForIndex(CFDictionaryRef channel, int32_t index);
+  int64_t IOReportStateGetResidency(CFDictionaryRef channel, int32_t index);
 }
 
 // IOKit HID constants
@@ -79,13 +91,25 @@ extern "C" {
 #define kIOHIDEventTypePower 25
 #define IOHIDEventFieldBase(type) (type << 16)
 
+// IOReport channel format of state-residency channels (kIOReportFormatState)
+#define IOREPORT_FORMAT_STATE 2
+
 using namespace v8;
 
 static io_connect_t conn;
 
+// Generation reported by a simulated device, overriding the host's
+static std::atomic<ChipGeneration> chip_override(CHIP_UNKNOWN);
+
 // Get chip generation from CPU brand string for SMC key selection
 ChipGeneration GetChipGeneration() {
-  static ChipGeneration cached_gen = CHIP_UNKNOWN;
+  // Atomic: getters run on worker threads too
+  static std::atomic<ChipGeneration> cached_gen(CHIP_UNKNOWN);
+
+  ChipGeneration override = chip_override;
+  if (override != CHIP_UNKNOWN) {
+    return override;
+  }
 
   if (cached_gen != CHIP_UNKNOWN) {
     return cached_gen;
@@ -249,8 +273,9 @@ const MacModelInfo* LookupMacModel(const char* hw_model) {
   return NULL;
 }
 
-// IOKit HID sensor functions for Apple Silicon
-IOKitSensorList GetIOKitSensors(int page, int usage, int eventType) {
+// IOKit HID sensor functions for Apple Silicon. Sensors of one kind through
+// an existing event system client.
+static IOKitSensorList CopyIOKitSensors(IOHIDEventSystemClientRef system, int page, int usage, int eventType) {
   IOKitSensorList result;
   result.sensors = NULL;
   result.count = 0;
@@ -275,27 +300,18 @@ IOKitSensorList GetIOKitSensors(int page, int usage, int eventType) {
   CFRelease(pageNum);
   CFRelease(usageNum);
 
-  // Create HID event system client
-  IOHIDEventSystemClientRef system = IOHIDEventSystemClientCreate(kCFAllocatorDefault);
-  if (!system) {
-    CFRelease(matchingDict);
-    return result;
-  }
-
   IOHIDEventSystemClientSetMatching(system, matchingDict);
   CFArrayRef services = IOHIDEventSystemClientCopyServices(system);
 
   CFRelease(matchingDict);
 
   if (!services) {
-    CFRelease(system);
     return result;
   }
 
   CFIndex count = CFArrayGetCount(services);
   if (count == 0) {
     CFRelease(services);
-    CFRelease(system);
     return result;
   }
 
@@ -342,11 +358,26 @@ IOKitSensorList GetIOKitSensors(int page, int usage, int eventType) {
   }
 
   CFRelease(services);
-  CFRelease(system);
 
   return result;
 }
 
+IOKitSensorList GetIOKitSensors(int page, int usage, int eventType) {
+  IOKitSensorList result;
+  result.sensors = NULL;
+  result.count = 0;
+
+  // Create HID event system client
+  IOHIDEventSystemClientRef system = IOHIDEventSystemClientCreate(kCFAllocatorDefault);
+  if (!system) {
+    return result;
+  }
+
+  result = CopyIOKitSensors(system, page, usage, eventType);
+  CFRelease(system);
+  return result;
+}
+
 IOKitSensorList GetIOKitTemperatureSensors() {
   // kHIDPage_AppleVendor = 0xff00
   // kHIDUsage_AppleVendor_TemperatureSensor = 0x0005
@@ -371,40 +402,8 @@ void FreeIOKitSensorList(IOKitSensorList list) {
   }
 }
 
-UInt32 _strtoul(char *str, int size, int base) {
-  UInt32 total = 0;
-  int i;
-
-  for (i = 0; i < size; i++) {
-    if (base == 16)
-      total += str[i] << (size - 1 - i) * 8;
-    else
-      total += (unsigned char)(str[i] << (size - 1 - i) * 8);
-  }
-  return total;
-}
-
-float _strtof(char *str, int size, int e) {
-  float total = 0;
-  int i;
-
-  for (i = 0; i < size; i++) {
-    if (i == (size - 1))
-      total += (str[i] & 0xff) >> e;
-    else
-      total += str[i] << (size - 1 - i) * (8 - e);
-  }
-
-  return total;
-}
-
-void _ultostr(char *str, UInt32 val) {
-  str[0] = '\0';
-  snprintf(str, 5, "%c%c%c%c", (unsigned int)val >> 24, (unsigned int)val >> 16,
-           (unsigned int)val >> 8, (unsigned int)val);
-}
-
-kern_return_t SMCOpen(void) {
+// IOKit transport: the AppleSMC user client behind SMCCall()
+static kern_return_t IOKitSMCOpen(void * /*ctx*/) {
   kern_return_t result;
   io_iterator_t iterator;
   io_object_t device;
@@ -460,10 +459,13 @@ kern_return_t SMCOpen(void) {
   return kIOReturnSuccess;
 }
 
-kern_return_t SMCClose() { return IOServiceClose(conn); }
+static void IOKitSMCClose(void * /*ctx*/) {
+  IOServiceClose(conn);
+  conn = 0;
+}
 
-kern_return_t SMCCall(int index, SMCKeyData_t *inputStructure,
-                      SMCKeyData_t *outputStructure) {
+static kern_return_t IOKitSMCCall(void * /*ctx*/, int index, SMCKeyData_t *inputStructure,
+                                  SMCKeyData_t *outputStructure) {
   size_t structureInputSize;
   size_t structureOutputSize;
 
@@ -485,62 +487,143 @@ kern_return_t SMCCall(int index, SMCKeyData_t *inputStructure,
 #endif
 }
 
-kern_return_t SMCReadKey(UInt32Char_t key, SMCVal_t *val) {
-  kern_return_t result;
-  SMCKeyData_t inputStructure;
-  SMCKeyData_t outputStructure;
+static const SMCTransport iokit_transport = {
+  "iokit", IOKitSMCOpen, IOKitSMCClose, IOKitSMCCall, NULL
+};
 
-  memset(&inputStructure, 0, sizeof(SMCKeyData_t));
-  memset(&outputStructure, 0, sizeof(SMCKeyData_t));
-  memset(val, 0, sizeof(SMCVal_t));
+// Discovered temperature keys and their disk cache state, shared by every
+// thread reading temperatures
+static std::mutex temp_keys_lock;
 
-  inputStructure.key = _strtoul(key, 4, 16);
-  inputStructure.data8 = SMC_CMD_READ_KEYINFO;
+// Cache for discovered CPU temperature keys
+static std::vector<UInt32> cpu_temp_keys_cache;
+static bool cpu_temp_keys_initialized = false;
 
-  result = SMCCall(KERNEL_INDEX_SMC, &inputStructure, &outputStructure);
-  if (result != kIOReturnSuccess)
-    return result;
+// Cache for discovered GPU temperature keys
+static std::vector<UInt32> gpu_temp_keys_cache;
+static bool gpu_temp_keys_initialized = false;
 
-  val->dataSize = outputStructure.keyInfo.dataSize;
-  _ultostr(val->dataType, outputStructure.keyInfo.dataType);
-  inputStructure.keyInfo.dataSize = val->dataSize;
-  inputStructure.data8 = SMC_CMD_READ_BYTES;
+// Collect flt temperature keys with the given prefixes from the SMC key
+// catalog. Returns false if the SMC cannot enumerate its keys.
+static bool FindTemperatureKeys(const char *const *prefixes, int prefixCount,
+                                std::vector<UInt32> *cache) {
+  return SMCFindKeys(prefixes, prefixCount, SMC_TYPE_FLT, 4, cache);
+}
 
-  result = SMCCall(KERNEL_INDEX_SMC, &inputStructure, &outputStructure);
-  if (result != kIOReturnSuccess)
-    return result;
+// Probe for a flt temperature key; discovery only needs the key info
+static bool IsTemperatureKey(UInt32 key) {
+  SMCKeyData_keyInfo_t keyInfo;
+  return SMCLookupKeyInfo(key, &keyInfo) == kIOReturnSuccess && keyInfo.dataSize == 4 &&
+         keyInfo.dataType == SMC_TYPE_FLT;
+}
 
-  memcpy(val->bytes, outputStructure.bytes, sizeof(outputStructure.bytes));
+// Average of the keys reading as a plausible temperature (0 to maxTemp)
+static double AverageTemperature(const std::vector<UInt32> &keys, double maxTemp, int *count) {
+  double total = 0.0;
+  *count = 0;
 
-  return kIOReturnSuccess;
+  for (UInt32 key : keys) {
+    double temp;
+    if (SMCReadKeyValue(key, &temp) == SMC_READ_OK && temp > 0.0 && temp < maxTemp) {
+      total += temp;
+      (*count)++;
+    }
+  }
+
+  return *count > 0 ? total / *count : 0.0;
 }
 
-kern_return_t SMCReadKeyInfo(UInt32Char_t key, SMCKeyData_keyInfo_t *keyInfo) {
-  kern_return_t result;
-  SMCKeyData_t inputStructure;
-  SMCKeyData_t outputStructure;
+// On-disk cache of discovered temperature keys, see smc_key_cache.cc. Only
+// used with the IOKit transport.
+static bool key_cache_loaded = false;
+static const char *key_cache_state = "none";  // none, disabled, missing, stale, loaded, saved
+static std::string key_cache_model;
+static std::string key_cache_os;
+
+// $MACSTATS_CACHE_DIR/smc-keys, or ~/Library/Caches/macstats/smc-keys. An
+// empty MACSTATS_CACHE_DIR disables the cache.
+static std::string KeyCachePath() {
+  const char *dir = getenv("MACSTATS_CACHE_DIR");
+  if (dir) {
+    return dir[0] ? std::string(dir) + "/smc-keys" : std::string();
+  }
 
-  memset(&inputStructure, 0, sizeof(SMCKeyData_t));
-  memset(&outputStructure, 0, sizeof(SMCKeyData_t));
+  const char *home = getenv("HOME");
+  if (!home || !home[0]) {
+    return std::string();
+  }
+  return std::string(home) + "/Library/Caches/macstats/smc-keys";
+}
 
-  inputStructure.key = _strtoul(key, 4, 16);
-  inputStructure.data8 = SMC_CMD_READ_KEYINFO;
+// Load the discovered keys once per transport, if the cache matches this
+// machine and its keys still check out
+static void LoadTemperatureKeys() {
+  if (key_cache_loaded) {
+    return;
+  }
+  key_cache_loaded = true;
 
-  result = SMCCall(KERNEL_INDEX_SMC, &inputStructure, &outputStructure);
-  if (result == kIOReturnSuccess) {
-    *keyInfo = outputStructure.keyInfo;
+  std::string path = KeyCachePath();
+  if (SMCGetTransport() != &iokit_transport || path.empty()) {
+    key_cache_state = "disabled";
+    return;
   }
 
-  return result;
+  SystemInfo info = GetSystemInfo();
+  key_cache_model = info.hardware_model;
+  key_cache_os = info.os_version;
+
+  SMCKeyCacheFile cache;
+  if (!SMCKeyCacheLoad(path.c_str(), &cache)) {
+    key_cache_state = "missing";
+    return;
+  }
+  if (!SMCKeyCacheValidate(&cache, key_cache_model.c_str(), key_cache_os.c_str())) {
+    key_cache_state = "stale";
+    return;
+  }
+
+  if (cache.has_cpu_temp_keys) {
+    cpu_temp_keys_cache = cache.cpu_temp_keys;
+    cpu_temp_keys_initialized = true;
+  }
+  if (cache.has_gpu_temp_keys) {
+    gpu_temp_keys_cache = cache.gpu_temp_keys;
+    gpu_temp_keys_initialized = true;
+  }
+  key_cache_state = "loaded";
 }
 
-// Cache for discovered CPU temperature keys
-static std::vector<std::string> cpu_temp_keys_cache;
-static bool cpu_temp_keys_initialized = false;
+// Persist whatever key sets have been discovered so far
+static void SaveTemperatureKeys() {
+  std::string path = KeyCachePath();
+  if (SMCGetTransport() != &iokit_transport || path.empty()) {
+    return;
+  }
 
-// Cache for discovered GPU temperature keys
-static std::vector<std::string> gpu_temp_keys_cache;
-static bool gpu_temp_keys_initialized = false;
+  SMCKeyCacheFile cache;
+  cache.hw_model = key_cache_model;
+  cache.os_version = key_cache_os;
+  cache.has_cpu_temp_keys = cpu_temp_keys_initialized;
+  cache.cpu_temp_keys = cpu_temp_keys_cache;
+  cache.has_gpu_temp_keys = gpu_temp_keys_initialized;
+  cache.gpu_temp_keys = gpu_temp_keys_cache;
+
+  if (SMCKeyCacheSave(path.c_str(), &cache)) {
+    key_cache_state = "saved";
+  }
+}
+
+// Temperature keys belong to the device behind the transport
+static void ResetTemperatureKeys() {
+  std::lock_guard<std::mutex> lock(temp_keys_lock);
+  cpu_temp_keys_cache.clear();
+  cpu_temp_keys_initialized = false;
+  gpu_temp_keys_cache.clear();
+  gpu_temp_keys_initialized = false;
+  key_cache_loaded = false;
+  key_cache_state = "none";
+}
 
 // Get CPU temperature - reads SMC temperature sensors directly
 double SMCGetTemperature() {
@@ -548,10 +631,24 @@ double SMCGetTemperature() {
 
   if (gen == CHIP_INTEL) {
     // Intel: use traditional SMC key
-    return SMCGetTemperatureKey("TC0P");
+    return SMCGetTemperatureKey(SMC_FOURCC('T', 'C', '0', 'P'));
   }
 
+  std::unique_lock<std::mutex> lock(temp_keys_lock);
+  LoadTemperatureKeys();
+
   // Initialize cache on first call - optimized scanning
+  bool discover = !cpu_temp_keys_initialized;
+  if (!cpu_temp_keys_initialized) {
+    const char* prefixes[] = {"Tp", "Te"};
+
+    // Preferred: filter the SMC key catalog, which also finds keys outside
+    // the patterns probed below
+    if (FindTemperatureKeys(prefixes, 2, &cpu_temp_keys_cache)) {
+      cpu_temp_keys_initialized = true;
+    }
+  }
+
   if (!cpu_temp_keys_initialized) {
     const char* prefixes[] = {"Tp", "Te"};
 
@@ -562,13 +659,8 @@ double SMCGetTemperature() {
     for (int p = 0; p < 2; p++) {
       for (int i = 0; i <= 9; i++) {
         for (int j = 0; j <= 9; j++) {
-          char key[5];
-          snprintf(key, sizeof(key), "%s%d%d", prefixes[p], i, j);
-
-          SMCVal_t val;
-          kern_return_t result = SMCReadKey(key, &val);
-
-          if (result == kIOReturnSuccess && val.dataSize == 4 && strcmp(val.dataType, DATATYPE_FLT) == 0) {
+          UInt32 key = SMC_FOURCC(prefixes[p][0], prefixes[p][1], '0' + i, '0' + j);
+          if (IsTemperatureKey(key)) {
             cpu_temp_keys_cache.push_back(key);
           }
         }
@@ -581,13 +673,8 @@ double SMCGetTemperature() {
       for (int p = 0; p < 2; p++) {
         for (int i = 0; i <= 9; i++) {
           for (char j = 'a'; j <= 'f'; j++) {
-            char key[5];
-            snprintf(key, sizeof(key), "%s%d%c", prefixes[p], i, j);
-
-            SMCVal_t val;
-            kern_return_t result = SMCReadKey(key, &val);
-
-            if (result == kIOReturnSuccess && val.dataSize == 4 && strcmp(val.dataType, DATATYPE_FLT) == 0) {
+            UInt32 key = SMC_FOURCC(prefixes[p][0], prefixes[p][1], '0' + i, j);
+            if (IsTemperatureKey(key)) {
               cpu_temp_keys_cache.push_back(key);
             }
           }
@@ -598,27 +685,17 @@ double SMCGetTemperature() {
     cpu_temp_keys_initialized = true;
   }
 
-  // Read from cached keys
-  double total = 0.0;
-  int valid_count = 0;
-
-  for (const auto& key_str : cpu_temp_keys_cache) {
-    SMCVal_t val;
-    kern_return_t result = SMCReadKey((char*)key_str.c_str(), &val);
-
-    if (result == kIOReturnSuccess && val.dataSize == 4 && strcmp(val.dataType, DATATYPE_FLT) == 0) {
-      float temp;
-      memcpy(&temp, val.bytes, sizeof(float));
-
-      if (temp > 0.0 && temp < 110.0) {
-        total += temp;
-        valid_count++;
-      }
-    }
+  if (discover) {
+    SaveTemperatureKeys();
   }
 
+  // Read from cached keys
+  int valid_count;
+  double average = AverageTemperature(cpu_temp_keys_cache, 110.0, &valid_count);
+  lock.unlock();
+
   if (valid_count > 0) {
-    return total / valid_count;
+    return average;
   }
 
   // Fallback to IOKit HID sensors (for older M1 or systems without SMC access)
@@ -628,7 +705,7 @@ double SMCGetTemperature() {
     return 0.0;
   }
 
-  total = 0.0;
+  double total = 0.0;
   valid_count = 0;
 
   for (int i = 0; i < sensors.count; i++) {
@@ -648,112 +725,51 @@ double SMCGetTemperature() {
   return valid_count > 0 ? total / valid_count : 0.0;
 }
 
-double SMCGetTemperatureKey(const char *key) {
-  SMCVal_t val;
-  kern_return_t result;
-
-  result = SMCReadKey((char *)key, &val);
-  if (result == kIOReturnSuccess) {
-    if (val.dataSize > 0) {
-      // Handle sp78 format (older chips)
-      if (strcmp(val.dataType, DATATYPE_SP78) == 0) {
-        int intValue = val.bytes[0] * 256 + (unsigned char)val.bytes[1];
-        return intValue / 256.0;
-      }
-      // Handle flt  format (newer chips like M3) - macmon uses little-endian float
-      if (strcmp(val.dataType, DATATYPE_FLT) == 0 && val.dataSize == 4) {
-        // Read as little-endian float (macmon approach)
-        uint32_t intVal = (uint32_t)val.bytes[0] | ((uint32_t)val.bytes[1] << 8) |
-                          ((uint32_t)val.bytes[2] << 16) | ((uint32_t)val.bytes[3] << 24);
-        float temp;
-        memcpy(&temp, &intVal, 4);
-        return (double)temp;
-      }
-    }
-  }
-  return 0.0;
+// Read a single key as a number, 0 if it is missing or cannot be decoded
+static double SMCGetKeyValue(UInt32 key) {
+  double value;
+  return SMCReadKeyValue(key, &value) == SMC_READ_OK ? value : 0.0;
 }
 
-double SMCGetPower(const char *key) {
-  SMCVal_t val;
-  kern_return_t result;
-
-  result = SMCReadKey((char *)key, &val);
-  if (result == kIOReturnSuccess) {
-    if (val.dataSize > 0) {
-      if (strcmp(val.dataType, DATATYPE_FPE2) == 0) {
-        float floatValue = _strtof(val.bytes, val.dataSize, 2);
-        return (double)floatValue;
-      }
-    }
-  }
-  return 0.0;
+double SMCGetTemperatureKey(UInt32 key) {
+  return SMCGetKeyValue(key);
 }
 
-double SMCGetVoltage(const char *key) {
-  SMCVal_t val;
-  kern_return_t result;
-
-  result = SMCReadKey((char *)key, &val);
-  if (result == kIOReturnSuccess) {
-    if (val.dataSize > 0) {
-      if (strcmp(val.dataType, DATATYPE_FPE2) == 0) {
-        int intValue = _strtof(val.bytes, val.dataSize, 2);
-        return intValue / 1000.0; // Convert to volts
-      }
-    }
-  }
-  return 0.0;
+double SMCGetPower(UInt32 key) {
+  return SMCGetKeyValue(key);
 }
 
-int SMCGetFanNumber() {
-  SMCVal_t val;
-  kern_return_t result;
+double SMCGetVoltage(UInt32 key) {
+  double value = SMCGetKeyValue(key);
 
-  result = SMCReadKey((char *)"FNum", &val);
-  if (result == kIOReturnSuccess) {
-    // read succeeded - check returned value
-    if (val.dataSize > 0) {
-      if (strcmp(val.dataType, DATATYPE_UINT8) == 0) {
-        int intValue = _strtoul((char *)val.bytes, val.dataSize, 10);
-        return intValue;
-      }
-    }
+  // Fixed point voltage keys report millivolts, flt keys volts
+  SMCKeyData_keyInfo_t keyInfo;
+  if (value != 0.0 && SMCLookupKeyInfo(key, &keyInfo) == kIOReturnSuccess &&
+      keyInfo.dataType == SMC_TYPE_FPE2) {
+    return (int)value / 1000.0;
   }
-  // read failed
-  return 0;
+  return value;
 }
 
-// Helper function to read fan values (RPM, Min, Max)
-int SMCGetFanValue(int fan_number, const char* key_format) {
-  SMCVal_t val;
-  kern_return_t result;
-  UInt32Char_t key;
-
-  snprintf(key, sizeof(key), key_format, fan_number);
-
-  result = SMCReadKey(key, &val);
-  if (result == kIOReturnSuccess) {
-    if (val.dataSize > 0) {
-      if (strcmp(val.dataType, DATATYPE_FPE2) == 0) {
-        int intValue = _strtof(val.bytes, val.dataSize, 2);
-        return intValue;
-      }
-    }
-  }
-  return 0;
+// Through the batch path, so the fan count's static refresh policy applies
+int SMCGetFanNumber() {
+  UInt32 key = SMC_KEY_FAN_COUNT;
+  double value = 0.0;
+  int32_t status;
+  SMCReadKeys(&key, 1, &value, &status);
+  return status == SMC_READ_OK ? (int)value : 0;
 }
 
 int SMCGetFanRPM(int fan_number) {
-  return SMCGetFanValue(fan_number, SMC_PKEY_FAN_RPM);
+  return (int)SMCGetKeyValue(SMC_FAN_KEY(fan_number, 'A', 'c'));
 }
 
 int SMCGetFanMin(int fan_number) {
-  return SMCGetFanValue(fan_number, SMC_PKEY_FAN_MIN);
+  return (int)SMCGetKeyValue(SMC_FAN_KEY(fan_number, 'M', 'n'));
 }
 
 int SMCGetFanMax(int fan_number) {
-  return SMCGetFanValue(fan_number, SMC_PKEY_FAN_MAX);
+  return (int)SMCGetKeyValue(SMC_FAN_KEY(fan_number, 'M', 'x'));
 }
 
 void Temperature(const FunctionCallbackInfo<Value> &args) {
@@ -811,51 +827,52 @@ void FanMax(const FunctionCallbackInfo<Value> &args) {
   FanCallback(args, SMCGetFanMax);
 }
 
-void CpuTemperatureDie(const FunctionCallbackInfo<Value> &args) {
-  Isolate *isolate = Isolate::GetCurrent();
-  HandleScope scope(isolate);
+// CPU die temperature from the key the chip generation uses
+double SMCGetCpuDieTemperature() {
   SMCOpen();
 
   ChipGeneration gen = GetChipGeneration();
-  const char *key;
+  UInt32 key;
 
   // Select appropriate CPU die key based on chip generation
   switch (gen) {
     case CHIP_INTEL:
-      key = "TC0D";
+      key = SMC_FOURCC('T', 'C', '0', 'D');
       break;
     case CHIP_M1:
-      key = "Tp01";
+      key = SMC_FOURCC('T', 'p', '0', '1');
       break;
     case CHIP_M2:
-      key = "Tp01";
+      key = SMC_FOURCC('T', 'p', '0', '1');
       break;
     case CHIP_M3:
-      key = "Tf04";
+      key = SMC_FOURCC('T', 'f', '0', '4');
       break;
     case CHIP_M4:
-      key = "Tp01";
+      key = SMC_FOURCC('T', 'p', '0', '1');
       break;
     case CHIP_M5:
-      key = "Tp01";  // Use M4 key as fallback for M5
+      key = SMC_FOURCC('T', 'p', '0', '1');  // Use M4 key as fallback for M5
       break;
     default:
-      key = "TC0D";
+      key = SMC_FOURCC('T', 'C', '0', 'D');
       break;
   }
 
   double temperature = SMCGetTemperatureKey(key);
   SMCClose();
-  args.GetReturnValue().Set(Number::New(isolate, temperature));
+  return temperature;
 }
 
-void GpuTemperature(const FunctionCallbackInfo<Value> &args) {
+void CpuTemperatureDie(const FunctionCallbackInfo<Value> &args) {
   Isolate *isolate = Isolate::GetCurrent();
   HandleScope scope(isolate);
+  args.GetReturnValue().Set(Number::New(isolate, SMCGetCpuDieTemperature()));
+}
 
-  // Try IOKit HID sensors first (Apple Silicon) - macmon approach
-  // Look for "GPU MTR Temp Sensor" sensors
-  IOKitSensorList sensors = GetIOKitTemperatureSensors();
+// GPU temperature: HID sensors first, then the SMC Tg keys
+// Mean of the "GPU MTR Temp Sensor" HID sensors, 0 if there are none
+static double GpuSensorTemperature(const IOKitSensorList &sensors) {
   double total = 0.0;
   int count = 0;
 
@@ -871,26 +888,37 @@ void GpuTemperature(const FunctionCallbackInfo<Value> &args) {
     }
   }
 
-  FreeIOKitSensorList(sensors);
-
-  if (count > 0) {
-    args.GetReturnValue().Set(Number::New(isolate, total / count));
-    return;
-  }
+  return count > 0 ? total / count : 0.0;
+}
 
+// GPU temperature from the SMC: TG0D on Intel, the mean of the Tg keys on
+// Apple Silicon
+static double SMCGetGpuTemperature() {
   // Fallback to SMC - scan for Tg** keys (macmon approach)
   ChipGeneration gen = GetChipGeneration();
 
   if (gen == CHIP_INTEL) {
     // Intel: use traditional SMC key
     SMCOpen();
-    double temperature = SMCGetTemperatureKey("TG0D");
+    double temperature = SMCGetTemperatureKey(SMC_FOURCC('T', 'G', '0', 'D'));
     SMCClose();
-    args.GetReturnValue().Set(Number::New(isolate, temperature));
-    return;
+    return temperature;
   }
 
+  std::unique_lock<std::mutex> lock(temp_keys_lock);
+  LoadTemperatureKeys();
+
   // Initialize GPU cache on first call - optimized scanning
+  bool discover = !gpu_temp_keys_initialized;
+  if (!gpu_temp_keys_initialized) {
+    const char* prefixes[] = {"Tg"};
+
+    // Preferred: filter the SMC key catalog
+    if (FindTemperatureKeys(prefixes, 1, &gpu_temp_keys_cache)) {
+      gpu_temp_keys_initialized = true;
+    }
+  }
+
   if (!gpu_temp_keys_initialized) {
     SMCOpen();
 
@@ -900,13 +928,8 @@ void GpuTemperature(const FunctionCallbackInfo<Value> &args) {
     // Pattern 1: Numeric keys (0-9)(0-9) - most common
     for (int i = 0; i <= 9; i++) {
       for (int j = 0; j <= 9; j++) {
-        char key[5];
-        snprintf(key, sizeof(key), "Tg%d%d", i, j);
-
-        SMCVal_t val;
-        kern_return_t result = SMCReadKey(key, &val);
-
-        if (result == kIOReturnSuccess && val.dataSize == 4 && strcmp(val.dataType, DATATYPE_FLT) == 0) {
+        UInt32 key = SMC_FOURCC('T', 'g', '0' + i, '0' + j);
+        if (IsTemperatureKey(key)) {
           gpu_temp_keys_cache.push_back(key);
         }
       }
@@ -915,13 +938,8 @@ void GpuTemperature(const FunctionCallbackInfo<Value> &args) {
     // Pattern 2: Hex patterns (0-9)(a-f) - common for GPU sensors
     for (int i = 0; i <= 9; i++) {
       for (char j = 'a'; j <= 'f'; j++) {
-        char key[5];
-        snprintf(key, sizeof(key), "Tg%d%c", i, j);
-
-        SMCVal_t val;
-        kern_return_t result = SMCReadKey(key, &val);
-
-        if (result == kIOReturnSuccess && val.dataSize == 4 && strcmp(val.dataType, DATATYPE_FLT) == 0) {
+        UInt32 key = SMC_FOURCC('T', 'g', '0' + i, j);
+        if (IsTemperatureKey(key)) {
           gpu_temp_keys_cache.push_back(key);
         }
       }
@@ -931,94 +949,117 @@ void GpuTemperature(const FunctionCallbackInfo<Value> &args) {
     gpu_temp_keys_initialized = true;
   }
 
-  // Read from cached keys
-  total = 0.0;
-  count = 0;
+  if (discover) {
+    SaveTemperatureKeys();
+  }
 
+  // Read from cached keys
+  int count = 0;
   SMCOpen();
-  for (const auto& key_str : gpu_temp_keys_cache) {
-    SMCVal_t val;
-    kern_return_t result = SMCReadKey((char*)key_str.c_str(), &val);
-
-    if (result == kIOReturnSuccess && val.dataSize == 4 && strcmp(val.dataType, DATATYPE_FLT) == 0) {
-      float temp;
-      memcpy(&temp, val.bytes, sizeof(float));
-
-      if (temp > 0.0 && temp < 150.0) {
-        total += temp;
-        count++;
-      }
-    }
-  }
+  double average = AverageTemperature(gpu_temp_keys_cache, 150.0, &count);
   SMCClose();
+  lock.unlock();
 
   if (count > 0) {
-    args.GetReturnValue().Set(Number::New(isolate, total / count));
-    return;
+    return average;
   }
 
   // If no Tg keys found, return 0
-  args.GetReturnValue().Set(Number::New(isolate, 0.0));
+  return 0.0;
 }
 
-void GpuUsage(const FunctionCallbackInfo<Value> &args) {
-  Isolate *isolate = Isolate::GetCurrent();
-  HandleScope scope(isolate);
+double GetGpuTemperature() {
+  // Try IOKit HID sensors first (Apple Silicon) - macmon approach
+  IOKitSensorList sensors = GetIOKitTemperatureSensors();
+  double temperature = GpuSensorTemperature(sensors);
+  FreeIOKitSensorList(sensors);
 
-  double usage = 0.0;
+  return temperature > 0.0 ? temperature : SMCGetGpuTemperature();
+}
 
-  // Get IOAccelerator services
-  io_iterator_t iterator;
-  io_service_t service;
-  kern_return_t kr;
+void GpuTemperature(const FunctionCallbackInfo<Value> &args) {
+  Isolate *isolate = Isolate::GetCurrent();
+  HandleScope scope(isolate);
+  args.GetReturnValue().Set(Number::New(isolate, GetGpuTemperature()));
+}
 
-  CFMutableDictionaryRef matchingDict = IOServiceMatching("IOAccelerator");
-  if (!matchingDict) {
-    args.GetReturnValue().Set(Number::New(isolate, 0.0));
-    return;
+// The first IOAccelerator, looked up once and kept for the process; its
+// registry properties are read from the cached handle
+static std::mutex accelerator_lock;
+static io_service_t accelerator_service = 0;
+static bool accelerator_looked_up = false;
+
+static io_service_t AcceleratorService() {
+  std::lock_guard<std::mutex> lock(accelerator_lock);
+  if (!accelerator_looked_up) {
+    accelerator_looked_up = true;
+    // Consumes the matching dictionary
+    accelerator_service = IOServiceGetMatchingService(kIOMainPortDefault, IOServiceMatching("IOAccelerator"));
   }
+  return accelerator_service;
+}
 
-  kr = IOServiceGetMatchingServices(kIOMainPortDefault, matchingDict, &iterator);
-  if (kr != KERN_SUCCESS) {
-    args.GetReturnValue().Set(Number::New(isolate, 0.0));
-    return;
+// The accelerator's PerformanceStatistics, NULL without an accelerator.
+// Caller releases.
+static CFDictionaryRef CopyAcceleratorStatistics() {
+  io_service_t service = AcceleratorService();
+  if (!service) {
+    return NULL;
   }
+  CFTypeRef stats = IORegistryEntryCreateCFProperty(service, CFSTR("PerformanceStatistics"), kCFAllocatorDefault, 0);
+  if (stats && CFGetTypeID(stats) != CFDictionaryGetTypeID()) {
+    CFRelease(stats);
+    return NULL;
+  }
+  return (CFDictionaryRef)stats;
+}
 
-  // Get the first GPU accelerator
-  service = IOIteratorNext(iterator);
-  if (service) {
-    CFDictionaryRef stats = (CFDictionaryRef)IORegistryEntryCreateCFProperty(
-      service, CFSTR("PerformanceStatistics"), kCFAllocatorDefault, 0);
-
-    if (stats) {
-      // Try to get Device Utilization %
-      CFNumberRef utilization = (CFNumberRef)CFDictionaryGetValue(stats, CFSTR("Device Utilization %"));
-      if (!utilization) {
-        // Fallback to GPU Activity(%)
-        utilization = (CFNumberRef)CFDictionaryGetValue(stats, CFSTR("GPU Activity(%)"));
-      }
-
-      if (utilization) {
-        int util_value = 0;
-        CFNumberGetValue(utilization, kCFNumberIntType, &util_value);
-        usage = (double)util_value / 100.0;
-        if (usage > 1.0) usage = 1.0;
-      }
-
-      CFRelease(stats);
+// First of keys present in stats as a number
+static bool AcceleratorStatistic(CFDictionaryRef stats, const char *const *keys, size_t count, int64_t *value) {
+  for (size_t i = 0; i < count; i++) {
+    CFStringRef key = CFStringCreateWithCString(kCFAllocatorDefault, keys[i], kCFStringEncodingUTF8);
+    CFNumberRef number = (CFNumberRef)CFDictionaryGetValue(stats, key);
+    CFRelease(key);
+    if (number && CFGetTypeID(number) == CFNumberGetTypeID()) {
+      CFNumberGetValue(number, kCFNumberSInt64Type, value);
+      return true;
     }
+  }
+  return false;
+}
 
-    IOObjectRelease(service);
+// GPU utilization (0-1): the GPU's active share of the latest sampler window
+// from IOReport GPU Stats, or the accelerator's own Device Utilization until
+// there is a GPU Stats sample, on machines without a GPUPH channel and where
+// the sampler cannot run. Never waits for the sampler.
+double GetGpuUsage() {
+  SMCGpuFrequency gpu;
+  if (!SMCPowerSourceUnavailable() && SMCGetGpuFrequency(&gpu, 0)) {
+    return gpu.residency.active_ratio;
   }
 
-  IOObjectRelease(iterator);
-  args.GetReturnValue().Set(Number::New(isolate, usage));
+  CFDictionaryRef stats = CopyAcceleratorStatistics();
+  if (!stats) {
+    return 0.0;
+  }
+  static const char *const keys[] = {"Device Utilization %", "GPU Activity(%)"};
+  int64_t percent = 0;
+  AcceleratorStatistic(stats, keys, sizeof(keys) / sizeof(keys[0]), &percent);
+  CFRelease(stats);
+  return percent > 100 ? 1.0 : (double)percent / 100.0;
+}
+
+void GpuUsage(const FunctionCallbackInfo<Value> &args) {
+  Isolate *isolate = Isolate::GetCurrent();
+  HandleScope scope(isolate);
+  args.GetReturnValue().Set(Number::New(isolate, GetGpuUsage()));
 }
 
 // Cache for IOReport subscription (reused across calls for better performance)
 struct IOReportCache {
   IOReportSubscriptionRef subscription;
   CFMutableDictionaryRef subbedChannels;
+  std::vector<std::string> groups;  // "group" or "group/subgroup", as subscribed
 
   IOReportCache() : subscription(NULL), subbedChannels(NULL) {}
 
@@ -1028,328 +1069,489 @@ struct IOReportCache {
   }
 };
 
-static IOReportCache* energyModelCache = nullptr;
+// One subscription to every group the sampler's consumers read, so a tick is
+// one IOReportCreateSamples() call whatever the number of groups
+static IOReportCache* reportCache = nullptr;
+static std::mutex report_lock;  // Guards reportCache and its subscription
 
-// Helper to convert energy to watts based on unit
-inline double ConvertEnergyToWatts(int64_t value, const char* unit, double duration_s) {
-  if (strcmp(unit, "mJ") == 0) {
-    return (value / 1000.0) / duration_s;
-  } else if (strcmp(unit, "uJ") == 0) {
-    return (value / 1000000.0) / duration_s;
-  } else if (strcmp(unit, "nJ") == 0) {
-    return (value / 1000000000.0) / duration_s;
+static std::vector<std::string> GroupKeys(const std::vector<SMCReportGroup> &groups) {
+  std::vector<std::string> keys;
+  for (const SMCReportGroup &group : groups) {
+    keys.push_back(group.subgroup ? std::string(group.group) + "/" + group.subgroup : group.group);
   }
-  return 0.0;
+  return keys;
 }
 
-// Helper to check if channel name matches pattern
-inline bool MatchesChannelPattern(const char* name, const char* pattern) {
-  if (!pattern) return true;
-
-  if (strstr(pattern, "CPU") != NULL) {
-    // Match "CPU Energy" or anything ending with "CPU Energy" (e.g., "DIE_0_CPU Energy" for Ultra)
-    const char* energyPos = strstr(name, "CPU Energy");
-    return (energyPos != NULL && energyPos[10] == '\0');
-  } else if (strstr(pattern, "GPU") != NULL) {
-    // Match exactly "GPU Energy"
-    return (strcmp(name, "GPU Energy") == 0);
-  } else if (strstr(pattern, "Package") != NULL) {
-    // Match "Package" channel for total system power
-    return (strcmp(name, "Package") == 0);
-  } else if (strstr(pattern, "All") != NULL) {
-    // Match "All" channel
-    return (strcmp(name, "All") == 0);
-  } else if (strstr(pattern, "Whole") != NULL) {
-    // Match "Whole" channel
-    return (strcmp(name, "Whole") == 0);
+// Subscribe to the merged channels of groups, reusing the subscription while
+// the groups stay the same. A group this machine lacks is left out. Caller
+// holds report_lock.
+static bool SubscribeGroups(const std::vector<SMCReportGroup> &groups) {
+  std::vector<std::string> keys = GroupKeys(groups);
+  if (reportCache && reportCache->subscription && reportCache->groups == keys) {
+    return true;
   }
 
-  return false;
-}
-
-// Helper function to read IOReport power metrics (optimized like macmon)
-double GetIOReportPower(const char* group, const char* subgroup, const char* channel_pattern) {
-  // Initialize cache on first call
-  if (!energyModelCache) {
-    energyModelCache = new IOReportCache();
-
-    CFStringRef groupRef = CFStringCreateWithCString(kCFAllocatorDefault, group, kCFStringEncodingUTF8);
-    CFStringRef subgroupRef = subgroup ? CFStringCreateWithCString(kCFAllocatorDefault, subgroup, kCFStringEncodingUTF8) : NULL;
+  delete reportCache;
+  reportCache = new IOReportCache();
+  reportCache->groups = keys;
 
+  CFMutableDictionaryRef merged = NULL;
+  for (const SMCReportGroup &group : groups) {
+    CFStringRef groupRef = CFStringCreateWithCString(kCFAllocatorDefault, group.group, kCFStringEncodingUTF8);
+    CFStringRef subgroupRef = group.subgroup ?
+        CFStringCreateWithCString(kCFAllocatorDefault, group.subgroup, kCFStringEncodingUTF8) : NULL;
     CFDictionaryRef channels = IOReportCopyChannelsInGroup(groupRef, subgroupRef, 0, 0, 0);
     CFRelease(groupRef);
     if (subgroupRef) CFRelease(subgroupRef);
+    if (!channels) continue;
 
-    if (!channels) return 0.0;
-
-    CFMutableDictionaryRef channelsMut = CFDictionaryCreateMutableCopy(kCFAllocatorDefault, 0, channels);
-    energyModelCache->subscription = IOReportCreateSubscription(NULL, channelsMut, &energyModelCache->subbedChannels, 0, NULL);
+    if (!merged) {
+      merged = CFDictionaryCreateMutableCopy(kCFAllocatorDefault, 0, channels);
+    } else {
+      IOReportMergeChannels(merged, channels, NULL);
+    }
     CFRelease(channels);
-    CFRelease(channelsMut);
+  }
 
-    if (!energyModelCache->subscription) return 0.0;
+  if (merged) {
+    reportCache->subscription = IOReportCreateSubscription(NULL, merged, &reportCache->subbedChannels, 0, NULL);
+    CFRelease(merged);
   }
+  return reportCache->subscription != NULL;
+}
 
-  // Take multiple samples and average (like macmon does - improves accuracy)
-  const int numSamples = 4; // 4 samples for better accuracy (matches macmon approach)
-  const int sampleIntervalMs = 100; // 100ms sample interval
-  double totalPower = 0.0;
+// Channel array of an IOReport sample, NULL if it has none
+static CFArrayRef SampleChannels(CFDictionaryRef sample) {
+  CFArrayRef channels_array = (CFArrayRef)CFDictionaryGetValue(sample, CFSTR("IOReportChannels"));
+  if (!channels_array || CFGetTypeID(channels_array) != CFArrayGetTypeID()) {
+    return NULL;
+  }
+  return channels_array;
+}
 
-  for (int sampleIdx = 0; sampleIdx < numSamples; sampleIdx++) {
-    // Get current sample
-    CFDictionaryRef sample1 = IOReportCreateSamples(energyModelCache->subscription, energyModelCache->subbedChannels, NULL);
-    if (!sample1) return 0.0;
+static std::string ReportString(CFStringRef value) {
+  char buffer[256] = {0};
+  if (value) {
+    CFStringGetCString(value, buffer, sizeof(buffer), kCFStringEncodingUTF8);
+  }
+  return buffer;
+}
 
-    // Wait for measurement interval
-    usleep(sampleIntervalMs * 1000);
+// Group, name, unit and format of every channel, in sample order. The
+// strings are converted here once per subscription rather than on every
+// sample. Formats other than state are read as simple integers.
+static void DescribeReportChannels(CFDictionaryRef sample, std::vector<SMCReportChannelInfo> *infos) {
+  CFArrayRef channels_array = SampleChannels(sample);
+  if (!channels_array) {
+    return;
+  }
 
-    // Get second sample
-    CFDictionaryRef sample2 = IOReportCreateSamples(energyModelCache->subscription, energyModelCache->subbedChannels, NULL);
-    if (!sample2) {
-      CFRelease(sample1);
-      return 0.0;
+  CFIndex count = CFArrayGetCount(channels_array);
+  for (CFIndex i = 0; i < count; i++) {
+    CFDictionaryRef channel = (CFDictionaryRef)CFArrayGetValueAtIndex(channels_array, i);
+    SMCReportChannelInfo info;
+    info.format = SMC_REPORT_SIMPLE;
+    info.offset = 0;
+
+    // Channels without a name or unit stay in place, unit-less, so positions line up
+    if (channel) {
+      info.group = ReportString(IOReportChannelGetGroup(channel));
+      info.subgroup = ReportString(IOReportChannelGetSubGroup(channel));
+      info.name = ReportString(IOReportChannelGetChannelName(channel));
+      info.unit = ReportString(IOReportChannelGetUnitLabel(channel));
+      if (IOReportChannelGetFormat(channel) == IOREPORT_FORMAT_STATE) {
+        info.format = SMC_REPORT_STATE;
+        int32_t states = IOReportStateGetCount(channel);
+        for (int32_t s = 0; s < states; s++) {
+          info.states.push_back(ReportString(IOReportStateGetNameForIndex(channel, s)));
+        }
+      }
     }
+    infos->push_back(info);
+  }
+}
 
-    // Calculate delta
-    CFDictionaryRef delta = IOReportCreateSamplesDelta(sample1, sample2, NULL);
-    CFRelease(sample1);
-    CFRelease(sample2);
-
-    if (!delta) return 0.0;
-
-    // Parse results
-    double samplePower = 0.0;
-    CFArrayRef channels_array = (CFArrayRef)CFDictionaryGetValue(delta, CFSTR("IOReportChannels"));
+// IOReport source for the background sampler. Keeps the previous sample so
+// every delta is taken once, and the layout of its channels so a sample is
+// read by position.
+static CFDictionaryRef reportPrevious = NULL;
+static std::vector<SMCReportChannelInfo> reportLayout;
+
+static bool ReportStart(void * /*ctx*/, const std::vector<SMCReportGroup> &groups,
+                        std::vector<SMCReportChannelInfo> *channels) {
+  std::lock_guard<std::mutex> lock(report_lock);
+  if (!SubscribeGroups(groups)) {
+    return false;
+  }
 
-    if (channels_array && CFGetTypeID(channels_array) == CFArrayGetTypeID()) {
-      CFIndex count = CFArrayGetCount(channels_array);
+  reportPrevious = IOReportCreateSamples(reportCache->subscription, reportCache->subbedChannels, NULL);
+  if (!reportPrevious) {
+    return false;
+  }
+  reportLayout.clear();
+  DescribeReportChannels(reportPrevious, &reportLayout);
+  SMCLayOutReport(&reportLayout);
+  *channels = reportLayout;
+  return true;
+}
 
-      for (CFIndex i = 0; i < count; i++) {
-        CFDictionaryRef channel = (CFDictionaryRef)CFArrayGetValueAtIndex(channels_array, i);
-        if (!channel) continue;
+static void ReportStop(void * /*ctx*/) {
+  std::lock_guard<std::mutex> lock(report_lock);
+  if (reportPrevious) {
+    CFRelease(reportPrevious);
+    reportPrevious = NULL;
+  }
+}
 
-        // Get channel name
-        CFStringRef channelName = IOReportChannelGetChannelName(channel);
-        if (!channelName) continue;
+// Raw channel values of the delta, by position; only integers are read here
+static bool ReportSample(void * /*ctx*/, int64_t *values, size_t count) {
+  std::lock_guard<std::mutex> lock(report_lock);
+  CFDictionaryRef current = IOReportCreateSamples(reportCache->subscription, reportCache->subbedChannels, NULL);
+  if (!current) {
+    return false;
+  }
 
-        char name[256] = {0};
-        CFStringGetCString(channelName, name, sizeof(name), kCFStringEncodingUTF8);
+  CFDictionaryRef delta = IOReportCreateSamplesDelta(reportPrevious, current, NULL);
+  CFRelease(reportPrevious);
+  reportPrevious = current;
+  if (!delta) {
+    return false;
+  }
 
-        // Pattern matching like macmon
-        if (!MatchesChannelPattern(name, channel_pattern)) continue;
+  // The subscription fixes the channel list, so positions match the description
+  CFArrayRef channels_array = SampleChannels(delta);
+  bool ok = channels_array && (size_t)CFArrayGetCount(channels_array) == reportLayout.size();
+  for (size_t i = 0; ok && i < reportLayout.size(); i++) {
+    CFDictionaryRef channel = (CFDictionaryRef)CFArrayGetValueAtIndex(channels_array, i);
+    const SMCReportChannelInfo &info = reportLayout[i];
+    if (info.format == SMC_REPORT_STATE) {
+      for (size_t s = 0; s < info.states.size() && info.offset + s < count; s++) {
+        values[info.offset + s] = channel ? IOReportStateGetResidency(channel, (int32_t)s) : 0;
+      }
+    } else if (info.offset < count) {
+      values[info.offset] = channel ? IOReportSimpleGetIntegerValue(channel, 0) : 0;
+    }
+  }
 
-        // Get unit label
-        CFStringRef unit = IOReportChannelGetUnitLabel(channel);
-        if (!unit) continue;
+  CFRelease(delta);
+  return ok;
+}
 
-        char unitStr[32];
-        CFStringGetCString(unit, unitStr, sizeof(unitStr), kCFStringEncodingUTF8);
+static const SMCPowerSource report_source = {
+  "ioreport", ReportStart, ReportStop, ReportSample, NULL
+};
 
-        // Get value
-        int64_t value = IOReportSimpleGetIntegerValue(channel, 0);
+// One DVFS table of the pmgr device: pairs of uint32 frequency and voltage,
+// slowest first. Frequencies are in Hz up to M3 and in kHz from M4 on.
+static std::vector<double> ReadDvfsTable(io_registry_entry_t pmgr, CFStringRef key) {
+  std::vector<double> mhz;
+  CFTypeRef data = IORegistryEntryCreateCFProperty(pmgr, key, kCFAllocatorDefault, 0);
+  if (!data) {
+    return mhz;
+  }
 
-        // Convert to watts
-        samplePower += ConvertEnergyToWatts(value, unitStr, sampleIntervalMs / 1000.0);
+  if (CFGetTypeID(data) == CFDataGetTypeID()) {
+    const uint8_t *bytes = CFDataGetBytePtr((CFDataRef)data);
+    CFIndex length = CFDataGetLength((CFDataRef)data);
+    std::vector<uint32_t> raw;
+    for (CFIndex offset = 0; offset + 8 <= length; offset += 8) {
+      uint32_t frequency;
+      memcpy(&frequency, bytes + offset, sizeof(frequency));
+      if (frequency > 0) {
+        raw.push_back(frequency);
       }
     }
 
-    CFRelease(delta);
-    totalPower += samplePower;
+    double scale = !raw.empty() && raw.back() >= 100000000 ? 1e-6 : 1e-3;
+    for (uint32_t frequency : raw) {
+      mhz.push_back(frequency * scale);
+    }
+  }
+  CFRelease(data);
+  return mhz;
+}
+
+// DVFS tables of this machine, for weighting CPU and GPU state residencies
+static SMCDvfsTables ReadDvfsTables() {
+  SMCDvfsTables tables;
+  io_iterator_t iterator;
+  if (IOServiceGetMatchingServices(kIOMainPortDefault, IOServiceMatching("AppleARMIODevice"),
+                                   &iterator) != KERN_SUCCESS) {
+    return tables;
   }
 
-  // Return average across samples
-  return totalPower / numSamples;
+  io_registry_entry_t entry;
+  while ((entry = IOIteratorNext(iterator)) != 0) {
+    io_name_t name;
+    if (IORegistryEntryGetName(entry, name) == kIOReturnSuccess && strcmp(name, "pmgr") == 0) {
+      tables.ecpu = ReadDvfsTable(entry, CFSTR("voltage-states1-sram"));
+      tables.pcpu = ReadDvfsTable(entry, CFSTR("voltage-states5-sram"));
+      tables.gpu = ReadDvfsTable(entry, CFSTR("voltage-states9"));
+      IOObjectRelease(entry);
+      break;
+    }
+    IOObjectRelease(entry);
+  }
+  IOObjectRelease(iterator);
+  return tables;
 }
 
+// Read once at load; a canned source with recorded tables replaces them until
+// setPowerSource() restores IOReport
+static SMCDvfsTables machine_dvfs;
 
+// Power stand-ins installed through setPowerSource(), freed when replaced;
+// guarded by transport_config_lock. At most one is set.
+static SMCPowerFake *power_fake = NULL;
+static SMCPowerCanned *power_canned = NULL;
 
-// Helper function to read all power metrics from IOReport
+// Latest power metrics from the background sampler. Only the first call
+// waits, for the sampler's first window.
 // Returns: {cpu, gpu, ane, ram, gpu_ram, total}
 PowerMetrics GetAllPowerMetrics() {
   PowerMetrics metrics = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+  SMCPowerSnapshot snapshot;
 
-  // Initialize cache if needed
-  if (!energyModelCache) {
-    energyModelCache = new IOReportCache();
-    CFStringRef groupRef = CFStringCreateWithCString(kCFAllocatorDefault, "Energy Model", kCFStringEncodingUTF8);
-    CFDictionaryRef channels = IOReportCopyChannelsInGroup(groupRef, NULL, 0, 0, 0);
-    CFRelease(groupRef);
-
-    if (channels) {
-      CFMutableDictionaryRef channelsMut = CFDictionaryCreateMutableCopy(kCFAllocatorDefault, 0, channels);
-      energyModelCache->subscription = IOReportCreateSubscription(NULL, channelsMut, &energyModelCache->subbedChannels, 0, NULL);
-      CFRelease(channels);
-      CFRelease(channelsMut);
-    }
+  if (SMCReadPowerSnapshot(&snapshot, SMCGetPowerSamplerPeriod() * 2 + 100)) {
+    metrics = snapshot.watts;
   }
+  return metrics;
+}
 
-  if (!energyModelCache || !energyModelCache->subscription) {
-    return metrics;
-  }
+// Result object shapes. Every RAM usage, CPU usage, disk, battery and power
+// object has the same properties in the same order, so their names are
+// internalized once per isolate and each kind gets an ObjectTemplate that
+// declares them up front: results share one hidden class, and filling one in
+// looks up cached names instead of creating a string per property. The field
+// lists double as the layouts of the Float64Array output mode.
+static const char *const power_fields[] = {"cpu", "gpu", "ane", "all", "system", "ram", "gpu_ram"};
+static const size_t POWER_FIELD_COUNT = sizeof(power_fields) / sizeof(power_fields[0]);
+
+static const char *const ram_usage_fields[] = {
+  "total", "used", "free", "active", "inactive", "wired", "compressed",
+  "app", "cache", "swap_total", "swap_used", "swap_free", "pressure_level"
+};
+static const size_t RAM_USAGE_FIELD_COUNT = sizeof(ram_usage_fields) / sizeof(ram_usage_fields[0]);
 
-  // Take multiple samples and average (like macmon does)
-  const int numSamples = 4;
-  const int sampleIntervalMs = 100;
-  PowerMetrics totalMetrics = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+static const char *const cpu_usage_fields[] = {
+  "user_load", "system_load", "idle_load", "total_usage", "load_avg_1", "load_avg_5", "load_avg_15"
+};
+static const size_t CPU_USAGE_FIELD_COUNT = sizeof(cpu_usage_fields) / sizeof(cpu_usage_fields[0]);
 
-  for (int sampleIdx = 0; sampleIdx < numSamples; sampleIdx++) {
-    CFDictionaryRef sample1 = IOReportCreateSamples(energyModelCache->subscription, energyModelCache->subbedChannels, NULL);
-    if (!sample1) continue;
+static const char *const disk_info_fields[] = {
+  "name", "mount_point", "file_system", "total_size", "free_size", "used_size", "bsd_name", "is_removable"
+};
 
-    usleep(sampleIntervalMs * 1000);
+static const char *const battery_info_fields[] = {
+  "external_connected", "battery_installed", "is_charging", "fully_charged", "voltage",
+  "cycle_count", "design_capacity", "max_capacity", "current_capacity", "design_cycle_count",
+  "time_remaining", "temperature", "amperage", "charge_percent", "health_percent"
+};
 
-    CFDictionaryRef sample2 = IOReportCreateSamples(energyModelCache->subscription, energyModelCache->subbedChannels, NULL);
-    if (!sample2) {
-      CFRelease(sample1);
-      continue;
-    }
+static const char *const energy_channel_fields[] = {
+  "name", "component", "cluster", "core", "die", "in_component", "in_total", "sram", "detail",
+  "watts", "joules"
+};
 
-    CFDictionaryRef delta = IOReportCreateSamplesDelta(sample1, sample2, NULL);
-    CFRelease(sample1);
-    CFRelease(sample2);
+static const char *const energy_counter_fields[] = {"cpu", "gpu", "ane", "ram", "gpu_ram", "total", "time_ms"};
 
-    if (!delta) continue;
+// Per-component values of an energy region: the counter fields but time_ms
+static const char *const energy_region_metric_fields[] = {"cpu", "gpu", "ane", "ram", "gpu_ram", "total"};
 
-    CFArrayRef channels_array = (CFArrayRef)CFDictionaryGetValue(delta, CFSTR("IOReportChannels"));
+static const char *const energy_region_fields[] = {"joules", "mean_watts", "peak_watts", "duration_ms", "samples"};
 
-    if (channels_array && CFGetTypeID(channels_array) == CFArrayGetTypeID()) {
-      CFIndex count = CFArrayGetCount(channels_array);
+static const char *const cpu_frequency_fields[] = {
+  "name", "cluster", "core", "die", "active_mhz", "active_ratio", "idle_ratio", "max_mhz"
+};
 
-      for (CFIndex i = 0; i < count; i++) {
-        CFDictionaryRef channel = (CFDictionaryRef)CFArrayGetValueAtIndex(channels_array, i);
-        if (!channel) continue;
+static const char *const gpu_frequency_fields[] = {
+  "name", "active_mhz", "active_ratio", "idle_ratio", "max_mhz", "states"
+};
 
-        CFStringRef channelName = IOReportChannelGetChannelName(channel);
-        if (!channelName) continue;
+static const char *const gpu_state_fields[] = {"mhz", "ratio"};
+
+static const char *const gpu_memory_fields[] = {"in_use", "allocated"};
+
+typedef enum {
+  SHAPE_POWER,
+  SHAPE_RAM_USAGE,
+  SHAPE_CPU_USAGE,
+  SHAPE_DISK_INFO,
+  SHAPE_BATTERY_INFO,
+  SHAPE_ENERGY_CHANNEL,
+  SHAPE_ENERGY_COUNTERS,
+  SHAPE_ENERGY_REGION_METRICS,
+  SHAPE_ENERGY_REGION,
+  SHAPE_CPU_FREQUENCY,
+  SHAPE_GPU_FREQUENCY,
+  SHAPE_GPU_STATE,
+  SHAPE_GPU_MEMORY,
+  SHAPE_COUNT
+} ObjectShapeId;
+
+typedef struct {
+  const char *const *fields;
+  size_t count;
+} ObjectShapeFields;
+
+#define SHAPE_FIELDS(fields) {fields, sizeof(fields) / sizeof(fields[0])}
+
+static const ObjectShapeFields shape_fields[SHAPE_COUNT] = {
+  SHAPE_FIELDS(power_fields),
+  SHAPE_FIELDS(ram_usage_fields),
+  SHAPE_FIELDS(cpu_usage_fields),
+  SHAPE_FIELDS(disk_info_fields),
+  SHAPE_FIELDS(battery_info_fields),
+  SHAPE_FIELDS(energy_channel_fields),
+  SHAPE_FIELDS(energy_counter_fields),
+  SHAPE_FIELDS(energy_region_metric_fields),
+  SHAPE_FIELDS(energy_region_fields),
+  SHAPE_FIELDS(cpu_frequency_fields),
+  SHAPE_FIELDS(gpu_frequency_fields),
+  SHAPE_FIELDS(gpu_state_fields),
+  SHAPE_FIELDS(gpu_memory_fields)
+};
 
-        char name[256] = {0};
-        CFStringGetCString(channelName, name, sizeof(name), kCFStringEncodingUTF8);
+typedef struct {
+  std::vector<Eternal<String>> names[SHAPE_COUNT];
+  Eternal<ObjectTemplate> templates[SHAPE_COUNT];
+} ObjectShapes;
 
-        CFStringRef unit = IOReportChannelGetUnitLabel(channel);
-        if (!unit) continue;
+// Per environment, since the handles belong to its isolate. Each environment
+// (the main thread, every worker) runs its JS on its own thread.
+static thread_local ObjectShapes *object_shapes = NULL;  // Created by InitObjectShapes()
 
-        char unitStr[32];
-        CFStringGetCString(unit, unitStr, sizeof(unitStr), kCFStringEncodingUTF8);
+static void InitObjectShapes(Isolate *isolate) {
+  HandleScope scope(isolate);
+  object_shapes = new ObjectShapes();
+
+  for (int shape = 0; shape < SHAPE_COUNT; shape++) {
+    Local<ObjectTemplate> tmpl = ObjectTemplate::New(isolate);
+    for (size_t i = 0; i < shape_fields[shape].count; i++) {
+      Local<String> name = String::NewFromUtf8(isolate, shape_fields[shape].fields[i],
+                                               NewStringType::kInternalized).ToLocalChecked();
+      object_shapes->names[shape].push_back(Eternal<String>(isolate, name));
+      tmpl->Set(name, Undefined(isolate));
+    }
+    object_shapes->templates[shape].Set(isolate, tmpl);
+  }
+}
 
-        int64_t value = IOReportSimpleGetIntegerValue(channel, 0);
-        double power = ConvertEnergyToWatts(value, unitStr, sampleIntervalMs / 1000.0);
+// New object of the given shape with values in field order
+static Local<Object> ShapedObject(Isolate *isolate, ObjectShapeId shape, const Local<Value> *values) {
+  Local<v8::Context> context = isolate->GetCurrentContext();
+  Local<Object> result = object_shapes->templates[shape].Get(isolate)->NewInstance(context).ToLocalChecked();
+  const std::vector<Eternal<String>> &names = object_shapes->names[shape];
 
-        // Skip detailed channels and SRAM channels (they're sub-components)
-        bool isDetailedChannel = (strstr(name, "DTL") != NULL);
-        bool isSramChannel = (strstr(name, "SRAM") != NULL);
-        bool isIndividualCore = (strncmp(name, "ECPU", 4) == 0 || strncmp(name, "PCPU", 4) == 0) &&
-                               (strlen(name) <= 5);  // ECPU0-5, PCPU0-5
+  for (size_t i = 0; i < names.size(); i++) {
+    result->Set(context, names[i].Get(isolate), values[i]).Check();
+  }
+  return result;
+}
 
-        // Match macmon's logic exactly
-        if (strcmp(name, "GPU Energy") == 0) {
-          totalMetrics.gpu += power;
-          if (!isDetailedChannel && !isSramChannel) {
-            totalMetrics.total += power;
-          }
-        } else if (strstr(name, "CPU Energy") != NULL &&
-                   (strcmp(name + strlen(name) - 10, "CPU Energy") == 0)) {
-          // ends_with "CPU Energy": "CPU Energy" for Basic/Max, "DIE_0_CPU Energy" for Ultra
-          totalMetrics.cpu += power;
-          if (!isDetailedChannel && !isSramChannel) {
-            totalMetrics.total += power;
-          }
-        } else if (strncmp(name, "ANE", 3) == 0) {
-          // ANE, ANE0, ANE0_{} patterns - starts with "ANE"
-          totalMetrics.ane += power;
-          if (!isDetailedChannel && !isSramChannel) {
-            totalMetrics.total += power;
-          }
-        } else if (strncmp(name, "DRAM", 4) == 0) {
-          // Starts with "DRAM"
-          totalMetrics.ram += power;
-          if (!isDetailedChannel && !isSramChannel) {
-            totalMetrics.total += power;
-          }
-        } else if (strncmp(name, "GPU SRAM", 8) == 0) {
-          // Starts with "GPU SRAM"
-          totalMetrics.gpu_ram += power;
-          if (!isDetailedChannel && !isSramChannel) {
-            totalMetrics.total += power;
-          }
-        } else if (!isDetailedChannel && !isSramChannel && !isIndividualCore) {
-          // Add all other non-detailed, non-SRAM channels to total
-          // This includes: AMCC, DCS, DISP, DISPEXT, ISP, AVE, MSR, GPU, PCIe, etc.
-          totalMetrics.total += power;
-        }
-      }
-    }
+// Float64Array output mode. A getter called as getter(out, offset?) writes its
+// values to out from offset on, in the order metricsSchema() lists them,
+// instead of returning a new object, so polling allocates nothing on the JS
+// heap. Returns NULL when no array was passed, or after throwing a RangeError
+// when fewer than count values fit (*thrown is set). *capacity is the number
+// of values that fit.
+static double *OutputValues(const FunctionCallbackInfo<Value> &args, size_t count,
+                            size_t *capacity, bool *thrown) {
+  *thrown = false;
+  if (args.Length() < 1 || !args[0]->IsFloat64Array()) {
+    return NULL;
+  }
 
-    CFRelease(delta);
+  Local<Float64Array> out = args[0].As<Float64Array>();
+  size_t offset = 0;
+  if (args.Length() > 1 && args[1]->IsNumber() && args[1].As<Number>()->Value() > 0) {
+    offset = (size_t)args[1].As<Number>()->Value();
   }
 
-  // Average across samples
-  metrics.cpu = totalMetrics.cpu / numSamples;
-  metrics.gpu = totalMetrics.gpu / numSamples;
-  metrics.ane = totalMetrics.ane / numSamples;
-  metrics.ram = totalMetrics.ram / numSamples;
-  metrics.gpu_ram = totalMetrics.gpu_ram / numSamples;
-  metrics.total = totalMetrics.total / numSamples;
+  size_t length = out->Length();
+  if (offset > length || length - offset < count) {
+    Isolate *isolate = args.GetIsolate();
+    isolate->ThrowException(Exception::RangeError(
+        String::NewFromUtf8(isolate, "Output array is too short for the metric layout").ToLocalChecked()));
+    *thrown = true;
+    return NULL;
+  }
 
-  return metrics;
+  *capacity = length - offset;
+  return (double *)((char *)out->Buffer()->Data() + out->ByteOffset()) + offset;
 }
 
-// Get all power metrics in a single call (more efficient and consistent)
-void GetAllPower(const FunctionCallbackInfo<Value> &args) {
-  Isolate *isolate = Isolate::GetCurrent();
-  HandleScope scope(isolate);
+// Names of a layout as a JS array, for metricsSchema()
+static Local<Array> FieldArray(Isolate *isolate, const char *const *names, size_t count) {
+  Local<Array> result = Array::New(isolate, count);
+  for (size_t i = 0; i < count; i++) {
+    result->Set(isolate->GetCurrentContext(), i,
+                String::NewFromUtf8(isolate, names[i]).ToLocalChecked()).Check();
+  }
+  return result;
+}
 
-  // Get all IOReport power metrics in one call
-  PowerMetrics metrics = GetAllPowerMetrics();
+static void WritePower(double *out, const PowerMetrics &metrics, double systemPower) {
+  out[0] = metrics.cpu;
+  out[1] = metrics.gpu;
+  out[2] = metrics.ane;
+  out[3] = metrics.cpu + metrics.gpu + metrics.ane;
+  out[4] = systemPower;
+  out[5] = metrics.ram;
+  out[6] = metrics.gpu_ram;
+}
 
-  // Get system power from SMC
+// System power from the SMC
+static double GetSystemPower() {
   SMCOpen();
-  SMCVal_t val;
-  kern_return_t result = SMCReadKey((char *)"PSTR", &val);
-  double systemPower = 0.0;
-  if (result == kIOReturnSuccess && val.dataSize == 4) {
-    float floatValue;
-    memcpy(&floatValue, val.bytes, sizeof(float));
-    systemPower = (double)floatValue;
-  }
+  double systemPower = SMCGetPower(SMC_FOURCC('P', 'S', 'T', 'R'));
   SMCClose();
+  return systemPower;
+}
 
+// IOReport power metrics plus SMC system power as a JS object
+static Local<Object> PowerObject(Isolate *isolate, const PowerMetrics &metrics, double systemPower) {
   // Calculate all_power (like macmon does)
   double allPower = metrics.cpu + metrics.gpu + metrics.ane;
 
-  // Create JavaScript object with all power values
-  Local<Object> obj = Object::New(isolate);
-  Local<v8::Context> context = isolate->GetCurrentContext();
+  Local<Value> values[] = {
+    Number::New(isolate, metrics.cpu),
+    Number::New(isolate, metrics.gpu),
+    Number::New(isolate, metrics.ane),
+    Number::New(isolate, allPower),
+    Number::New(isolate, systemPower),
+    Number::New(isolate, metrics.ram),
+    Number::New(isolate, metrics.gpu_ram)
+  };
+  return ShapedObject(isolate, SHAPE_POWER, values);
+}
+
+// Get all power metrics in a single call (more efficient and consistent)
+void GetAllPower(const FunctionCallbackInfo<Value> &args) {
+  Isolate *isolate = Isolate::GetCurrent();
+  HandleScope scope(isolate);
+
+  size_t capacity;
+  bool thrown;
+  double *out = OutputValues(args, POWER_FIELD_COUNT, &capacity, &thrown);
+  if (thrown) {
+    return;
+  }
 
-  obj->Set(context,
-           String::NewFromUtf8(isolate, "cpu").ToLocalChecked(),
-           Number::New(isolate, metrics.cpu)).Check();
-  obj->Set(context,
-           String::NewFromUtf8(isolate, "gpu").ToLocalChecked(),
-           Number::New(isolate, metrics.gpu)).Check();
-  obj->Set(context,
-           String::NewFromUtf8(isolate, "ane").ToLocalChecked(),
-           Number::New(isolate, metrics.ane)).Check();
-  obj->Set(context,
-           String::NewFromUtf8(isolate, "all").ToLocalChecked(),
-           Number::New(isolate, allPower)).Check();
-  obj->Set(context,
-           String::NewFromUtf8(isolate, "system").ToLocalChecked(),
-           Number::New(isolate, systemPower)).Check();
-  obj->Set(context,
-           String::NewFromUtf8(isolate, "ram").ToLocalChecked(),
-           Number::New(isolate, metrics.ram)).Check();
-  obj->Set(context,
-           String::NewFromUtf8(isolate, "gpu_ram").ToLocalChecked(),
-           Number::New(isolate, metrics.gpu_ram)).Check();
-
-  args.GetReturnValue().Set(obj);
+  // Get all IOReport power metrics in one call
+  PowerMetrics metrics = GetAllPowerMetrics();
+  if (out) {
+    WritePower(out, metrics, GetSystemPower());
+    return;
+  }
+  args.GetReturnValue().Set(PowerObject(isolate, metrics, GetSystemPower()));
 }
 
 void CpuVoltage(const FunctionCallbackInfo<Value> &args) {
   Isolate *isolate = Isolate::GetCurrent();
   HandleScope scope(isolate);
   SMCOpen();
-  double voltage = SMCGetVoltage("VC0C");
+  double voltage = SMCGetVoltage(SMC_FOURCC('V', 'C', '0', 'C'));
   SMCClose();
   args.GetReturnValue().Set(Number::New(isolate, voltage));
 }
@@ -1358,7 +1560,7 @@ void GpuVoltage(const FunctionCallbackInfo<Value> &args) {
   Isolate *isolate = Isolate::GetCurrent();
   HandleScope scope(isolate);
   SMCOpen();
-  double voltage = SMCGetVoltage("VG0C");
+  double voltage = SMCGetVoltage(SMC_FOURCC('V', 'G', '0', 'C'));
   SMCClose();
   args.GetReturnValue().Set(Number::New(isolate, voltage));
 }
@@ -1367,7 +1569,7 @@ void MemoryVoltage(const FunctionCallbackInfo<Value> &args) {
   Isolate *isolate = Isolate::GetCurrent();
   HandleScope scope(isolate);
   SMCOpen();
-  double voltage = SMCGetVoltage("VM0R");
+  double voltage = SMCGetVoltage(SMC_FOURCC('V', 'M', '0', 'R'));
   SMCClose();
   args.GetReturnValue().Set(Number::New(isolate, voltage));
 }
@@ -1375,11 +1577,8 @@ void MemoryVoltage(const FunctionCallbackInfo<Value> &args) {
 // Helper function for sensor callbacks
 typedef IOKitSensorList (*SensorGetterFunc)();
 
-void SensorCallback(const FunctionCallbackInfo<Value> &args, SensorGetterFunc getter) {
-  Isolate *isolate = Isolate::GetCurrent();
-  HandleScope scope(isolate);
-
-  IOKitSensorList sensors = getter();
+// Sensor list as a JS array of {name, value}; frees the list
+static Local<Array> SensorArray(Isolate *isolate, IOKitSensorList sensors) {
   Local<Array> result = Array::New(isolate, sensors.count);
 
   for (int i = 0; i < sensors.count; i++) {
@@ -1394,7 +1593,59 @@ void SensorCallback(const FunctionCallbackInfo<Value> &args, SensorGetterFunc ge
   }
 
   FreeIOKitSensorList(sensors);
-  args.GetReturnValue().Set(result);
+  return result;
+}
+
+static int CompareSensorNames(const void *a, const void *b) {
+  return strcmp(((const IOKitSensor *)a)->name, ((const IOKitSensor *)b)->name);
+}
+
+// HID service order is not guaranteed between enumerations, so the output
+// mode and its schema list sensors by name
+static void SortSensors(IOKitSensorList &sensors) {
+  if (sensors.count > 1) {
+    qsort(sensors.sensors, sensors.count, sizeof(IOKitSensor), CompareSensorNames);
+  }
+}
+
+// Sensor names in output order for metricsSchema(); frees the list
+static Local<Array> SensorNameArray(Isolate *isolate, IOKitSensorList sensors) {
+  SortSensors(sensors);
+  Local<Array> result = Array::New(isolate, sensors.count);
+  for (int i = 0; i < sensors.count; i++) {
+    result->Set(isolate->GetCurrentContext(), i,
+                String::NewFromUtf8(isolate, sensors.sensors[i].name).ToLocalChecked()).Check();
+  }
+
+  FreeIOKitSensorList(sensors);
+  return result;
+}
+
+// getter() -> [{name, value}], or getter(out, offset?) -> sensor count, with
+// the values that fit written in schema order. A count other than the schema
+// length means sensors came or went and the schema should be read again.
+void SensorCallback(const FunctionCallbackInfo<Value> &args, SensorGetterFunc getter) {
+  Isolate *isolate = Isolate::GetCurrent();
+  HandleScope scope(isolate);
+
+  size_t capacity;
+  bool thrown;
+  double *out = OutputValues(args, 0, &capacity, &thrown);
+  if (thrown) {
+    return;
+  }
+  if (!out) {
+    args.GetReturnValue().Set(SensorArray(isolate, getter()));
+    return;
+  }
+
+  IOKitSensorList sensors = getter();
+  SortSensors(sensors);
+  for (int i = 0; i < sensors.count && (size_t)i < capacity; i++) {
+    out[i] = sensors.sensors[i].value;
+  }
+  args.GetReturnValue().Set(sensors.count);
+  FreeIOKitSensorList(sensors);
 }
 
 void GetAllTemperatureSensors(const FunctionCallbackInfo<Value> &args) {
@@ -1409,55 +1660,110 @@ void GetAllCurrentSensors(const FunctionCallbackInfo<Value> &args) {
   SensorCallback(args, GetIOKitCurrentSensors);
 }
 
-// Helper function to get integer value from CFDictionary
-int GetIntValue(CFDictionaryRef dict, CFStringRef key, int defaultValue = 0) {
-  CFNumberRef value = (CFNumberRef)CFDictionaryGetValue(dict, key);
-  if (value && CFGetTypeID(value) == CFNumberGetTypeID()) {
-    int result;
-    CFNumberGetValue(value, kCFNumberIntType, &result);
-    return result;
+// Battery fields and their refresh policies. The design values never change
+// and the wear values move over weeks, so by default only the live values
+// are read on every call.
+typedef enum { BATTERY_INT, BATTERY_BOOL, BATTERY_MINUTES } BatteryFieldKind;
+
+typedef struct {
+  const char *name;
+  CFStringRef property;
+  BatteryFieldKind kind;
+  int defaultValue;
+  size_t offset;
+  SMCRefreshState refresh;
+} BatteryField;
+
+static BatteryField battery_fields[] = {
+  {"external_connected", CFSTR("ExternalConnected"), BATTERY_BOOL, 0,
+   offsetof(BatteryInfo, external_connected), {SMC_REFRESH_FAST}},
+  {"battery_installed", CFSTR("BatteryInstalled"), BATTERY_BOOL, 0,
+   offsetof(BatteryInfo, battery_installed), {SMC_REFRESH_SLOW}},
+  {"is_charging", CFSTR("IsCharging"), BATTERY_BOOL, 0, offsetof(BatteryInfo, is_charging), {SMC_REFRESH_FAST}},
+  {"fully_charged", CFSTR("FullyCharged"), BATTERY_BOOL, 0, offsetof(BatteryInfo, fully_charged), {SMC_REFRESH_FAST}},
+  {"voltage", CFSTR("Voltage"), BATTERY_INT, 0, offsetof(BatteryInfo, voltage), {SMC_REFRESH_FAST}},
+  {"cycle_count", CFSTR("CycleCount"), BATTERY_INT, 0, offsetof(BatteryInfo, cycle_count), {SMC_REFRESH_SLOW}},
+  {"design_capacity", CFSTR("DesignCapacity"), BATTERY_INT, 0,
+   offsetof(BatteryInfo, design_capacity), {SMC_REFRESH_STATIC}},
+  // AppleRaw* are mAh; MaxCapacity and CurrentCapacity are percentages
+  {"max_capacity", CFSTR("AppleRawMaxCapacity"), BATTERY_INT, 0,
+   offsetof(BatteryInfo, max_capacity), {SMC_REFRESH_SLOW}},
+  {"current_capacity", CFSTR("AppleRawCurrentCapacity"), BATTERY_INT, 0,
+   offsetof(BatteryInfo, current_capacity), {SMC_REFRESH_FAST}},
+  {"design_cycle_count", CFSTR("DesignCycleCount9C"), BATTERY_INT, 1000,
+   offsetof(BatteryInfo, design_cycle_count), {SMC_REFRESH_STATIC}},
+  {"time_remaining", CFSTR("TimeRemaining"), BATTERY_MINUTES, 0,
+   offsetof(BatteryInfo, time_remaining), {SMC_REFRESH_FAST}},
+  {"temperature", CFSTR("Temperature"), BATTERY_INT, 0, offsetof(BatteryInfo, temperature), {SMC_REFRESH_FAST}},
+  {"amperage", CFSTR("Amperage"), BATTERY_INT, 0, offsetof(BatteryInfo, amperage), {SMC_REFRESH_FAST}},
+  // The percentages macOS shows
+  {"charge_percent", CFSTR("CurrentCapacity"), BATTERY_INT, 0,
+   offsetof(BatteryInfo, charge_percent), {SMC_REFRESH_FAST}},
+  {"health_percent", CFSTR("MaxCapacity"), BATTERY_INT, 0,
+   offsetof(BatteryInfo, health_percent), {SMC_REFRESH_SLOW}},
+};
+
+static const size_t battery_field_count = sizeof(battery_fields) / sizeof(battery_fields[0]);
+
+static BatteryInfo DefaultBatteryInfo() {
+  BatteryInfo info = {};
+  info.design_cycle_count = 1000;
+  return info;
+}
+
+// Last values read, defaults until the first successful read, and the
+// counters for requestRefresh()/refreshStats()
+static BatteryInfo battery_cache = DefaultBatteryInfo();
+static SMCRefreshStats battery_refresh_stats = {};
+static std::mutex battery_lock;
+
+static BatteryField *FindBatteryField(const char *name) {
+  for (size_t i = 0; i < battery_field_count; i++) {
+    if (strcmp(battery_fields[i].name, name) == 0) {
+      return &battery_fields[i];
+    }
   }
-  return defaultValue;
+  return NULL;
 }
 
-// Helper function to get boolean value from CFDictionary
-bool GetBoolValue(CFDictionaryRef dict, CFStringRef key, bool defaultValue = false) {
-  CFBooleanRef value = (CFBooleanRef)CFDictionaryGetValue(dict, key);
-  if (value && CFGetTypeID(value) == CFBooleanGetTypeID()) {
-    return CFBooleanGetValue(value);
+static void SetBatteryField(BatteryInfo *info, const BatteryField &field, CFTypeRef value) {
+  char *target = (char *)info + field.offset;
+
+  if (field.kind == BATTERY_BOOL) {
+    bool result = field.defaultValue != 0;
+    if (value && CFGetTypeID(value) == CFBooleanGetTypeID()) {
+      result = CFBooleanGetValue((CFBooleanRef)value);
+    }
+    *(bool *)target = result;
+    return;
+  }
+
+  int result = field.defaultValue;
+  if (value && CFGetTypeID(value) == CFNumberGetTypeID()) {
+    CFNumberGetValue((CFNumberRef)value, kCFNumberIntType, &result);
+  }
+
+  if (field.kind == BATTERY_MINUTES) {
+    // 65535 means "calculating"
+    result = result != 65535 ? result * 60 : 0;
   }
-  return defaultValue;
+  *(int *)target = result;
 }
 
-// Get battery information from IOKit
+// Get battery information from IOKit. Only the fields whose refresh policy
+// says they are due are read; the rest keep their last value.
 BatteryInfo GetBatteryInfo() {
-  BatteryInfo info = {};
-  info.external_connected = false;
-  info.battery_installed = false;
-  info.is_charging = false;
-  info.fully_charged = false;
-  info.voltage = 0;
-  info.cycle_count = 0;
-  info.design_capacity = 0;
-  info.max_capacity = 0;
-  info.current_capacity = 0;
-  info.design_cycle_count = 1000;
-  info.time_remaining = 0;
-  info.temperature = 0;
-  info.amperage = 0;
-  info.charge_percent = 0;
-  info.health_percent = 0;
-
   // Get IOPowerSources info
   CFTypeRef powerSourcesInfo = IOPSCopyPowerSourcesInfo();
   if (!powerSourcesInfo) {
-    return info;
+    return DefaultBatteryInfo();
   }
 
   CFArrayRef powerSourcesList = IOPSCopyPowerSourcesList(powerSourcesInfo);
   if (!powerSourcesList || CFArrayGetCount(powerSourcesList) == 0) {
+    if (powerSourcesList) CFRelease(powerSourcesList);
     CFRelease(powerSourcesInfo);
-    return info;
+    return DefaultBatteryInfo();
   }
 
   CFRelease(powerSourcesList);
@@ -1466,42 +1772,46 @@ BatteryInfo GetBatteryInfo() {
   // Get detailed battery info from AppleSmartBattery service
   io_service_t service = IOServiceGetMatchingService(kIOMainPortDefault,
                                                       IOServiceMatching("AppleSmartBattery"));
-  if (service) {
+  if (!service) {
+    return DefaultBatteryInfo();
+  }
+
+  std::lock_guard<std::mutex> lock(battery_lock);
+  int64_t now = SMCRefreshNow();
+
+  bool due[battery_field_count];
+  uint32_t dueCount = 0;
+  for (size_t i = 0; i < battery_field_count; i++) {
+    due[i] = SMCRefreshDue(&battery_fields[i].refresh, now);
+    if (due[i]) dueCount++;
+  }
+
+  if (dueCount == battery_field_count) {
+    // Everything at once: one copy of the whole property table
     CFMutableDictionaryRef properties = NULL;
     if (IORegistryEntryCreateCFProperties(service, &properties, kCFAllocatorDefault, 0) == KERN_SUCCESS) {
-      info.voltage = GetIntValue(properties, CFSTR("Voltage"), 0);
-      info.cycle_count = GetIntValue(properties, CFSTR("CycleCount"), 0);
-      info.design_capacity = GetIntValue(properties, CFSTR("DesignCapacity"), 0);
-      info.design_cycle_count = GetIntValue(properties, CFSTR("DesignCycleCount9C"), 1000);
-      info.temperature = GetIntValue(properties, CFSTR("Temperature"), 0);
-      info.amperage = GetIntValue(properties, CFSTR("Amperage"), 0);
-      info.external_connected = GetBoolValue(properties, CFSTR("ExternalConnected"), false);
-      info.battery_installed = GetBoolValue(properties, CFSTR("BatteryInstalled"), false);
-      info.is_charging = GetBoolValue(properties, CFSTR("IsCharging"), false);
-      info.fully_charged = GetBoolValue(properties, CFSTR("FullyCharged"), false);
-
-      // Use AppleRaw* values for actual mAh (MaxCapacity and CurrentCapacity are percentages)
-      info.max_capacity = GetIntValue(properties, CFSTR("AppleRawMaxCapacity"), 0);
-      info.current_capacity = GetIntValue(properties, CFSTR("AppleRawCurrentCapacity"), 0);
-
-      // Get the actual percentages that macOS uses
-      info.charge_percent = GetIntValue(properties, CFSTR("CurrentCapacity"), 0);
-      info.health_percent = GetIntValue(properties, CFSTR("MaxCapacity"), 0);
-
-      // Get TimeRemaining from properties
-      int timeRemaining = GetIntValue(properties, CFSTR("TimeRemaining"), 0);
-      if (timeRemaining != 65535) {  // 65535 means "calculating"
-        info.time_remaining = timeRemaining * 60;  // Convert minutes to seconds
-      } else {
-        info.time_remaining = 0;
+      for (size_t i = 0; i < battery_field_count; i++) {
+        SetBatteryField(&battery_cache, battery_fields[i],
+                        CFDictionaryGetValue(properties, battery_fields[i].property));
+        SMCRefreshDone(&battery_fields[i].refresh, now);
       }
-
       CFRelease(properties);
     }
-    IOObjectRelease(service);
+  } else {
+    // Only the due properties
+    for (size_t i = 0; i < battery_field_count; i++) {
+      if (!due[i]) continue;
+      CFTypeRef value = IORegistryEntryCreateCFProperty(service, battery_fields[i].property,
+                                                        kCFAllocatorDefault, 0);
+      SetBatteryField(&battery_cache, battery_fields[i], value);
+      SMCRefreshDone(&battery_fields[i].refresh, now);
+      if (value) CFRelease(value);
+    }
   }
+  IOObjectRelease(service);
 
-  return info;
+  SMCRefreshCountTick(&battery_refresh_stats, dueCount, (uint32_t)(battery_field_count - dueCount));
+  return battery_cache;
 }
 
 // Get system information
@@ -1647,11 +1957,8 @@ SystemInfo GetSystemInfo() {
   return info;
 }
 
-void GetSystemData(const FunctionCallbackInfo<Value> &args) {
-  Isolate *isolate = Isolate::GetCurrent();
-  HandleScope scope(isolate);
-
-  SystemInfo info = GetSystemInfo();
+// System information as a JS object, shared by the sync and async getters
+static Local<Object> SystemInfoObject(Isolate *isolate, const SystemInfo &info) {
   Local<Object> result = Object::New(isolate);
 
   result->Set(isolate->GetCurrentContext(),
@@ -1682,7 +1989,13 @@ void GetSystemData(const FunctionCallbackInfo<Value> &args) {
               String::NewFromUtf8(isolate, "release_year").ToLocalChecked(),
               String::NewFromUtf8(isolate, info.release_year).ToLocalChecked()).Check();
 
-  args.GetReturnValue().Set(result);
+  return result;
+}
+
+void GetSystemData(const FunctionCallbackInfo<Value> &args) {
+  Isolate *isolate = Isolate::GetCurrent();
+  HandleScope scope(isolate);
+  args.GetReturnValue().Set(SystemInfoObject(isolate, GetSystemInfo()));
 }
 
 // Get RAM usage information
@@ -1735,121 +2048,104 @@ RAMUsage GetRAMUsage() {
   return usage;
 }
 
+// RAM usage as a JS object, shared by the sync and async getters
+static Local<Object> RAMUsageObject(Isolate *isolate, const RAMUsage &usage) {
+  Local<Value> values[] = {
+    Number::New(isolate, static_cast<double>(usage.total)),
+    Number::New(isolate, static_cast<double>(usage.used)),
+    Number::New(isolate, static_cast<double>(usage.free)),
+    Number::New(isolate, static_cast<double>(usage.active)),
+    Number::New(isolate, static_cast<double>(usage.inactive)),
+    Number::New(isolate, static_cast<double>(usage.wired)),
+    Number::New(isolate, static_cast<double>(usage.compressed)),
+    Number::New(isolate, static_cast<double>(usage.app)),
+    Number::New(isolate, static_cast<double>(usage.cache)),
+    Number::New(isolate, static_cast<double>(usage.swap_total)),
+    Number::New(isolate, static_cast<double>(usage.swap_used)),
+    Number::New(isolate, static_cast<double>(usage.swap_free)),
+    Number::New(isolate, usage.pressure_level)
+  };
+  return ShapedObject(isolate, SHAPE_RAM_USAGE, values);
+}
+
+static void WriteRAMUsage(double *out, const RAMUsage &usage) {
+  out[0] = static_cast<double>(usage.total);
+  out[1] = static_cast<double>(usage.used);
+  out[2] = static_cast<double>(usage.free);
+  out[3] = static_cast<double>(usage.active);
+  out[4] = static_cast<double>(usage.inactive);
+  out[5] = static_cast<double>(usage.wired);
+  out[6] = static_cast<double>(usage.compressed);
+  out[7] = static_cast<double>(usage.app);
+  out[8] = static_cast<double>(usage.cache);
+  out[9] = static_cast<double>(usage.swap_total);
+  out[10] = static_cast<double>(usage.swap_used);
+  out[11] = static_cast<double>(usage.swap_free);
+  out[12] = usage.pressure_level;
+}
+
 void GetRAMUsageData(const FunctionCallbackInfo<Value> &args) {
   Isolate *isolate = Isolate::GetCurrent();
   HandleScope scope(isolate);
 
-  RAMUsage usage = GetRAMUsage();
-  Local<Object> result = Object::New(isolate);
-
-  result->Set(isolate->GetCurrentContext(),
-              String::NewFromUtf8(isolate, "total").ToLocalChecked(),
-              Number::New(isolate, static_cast<double>(usage.total))).Check();
-  result->Set(isolate->GetCurrentContext(),
-              String::NewFromUtf8(isolate, "used").ToLocalChecked(),
-              Number::New(isolate, static_cast<double>(usage.used))).Check();
-  result->Set(isolate->GetCurrentContext(),
-              String::NewFromUtf8(isolate, "free").ToLocalChecked(),
-              Number::New(isolate, static_cast<double>(usage.free))).Check();
-  result->Set(isolate->GetCurrentContext(),
-              String::NewFromUtf8(isolate, "active").ToLocalChecked(),
-              Number::New(isolate, static_cast<double>(usage.active))).Check();
-  result->Set(isolate->GetCurrentContext(),
-              String::NewFromUtf8(isolate, "inactive").ToLocalChecked(),
-              Number::New(isolate, static_cast<double>(usage.inactive))).Check();
-  result->Set(isolate->GetCurrentContext(),
-              String::NewFromUtf8(isolate, "wired").ToLocalChecked(),
-              Number::New(isolate, static_cast<double>(usage.wired))).Check();
-  result->Set(isolate->GetCurrentContext(),
-              String::NewFromUtf8(isolate, "compressed").ToLocalChecked(),
-              Number::New(isolate, static_cast<double>(usage.compressed))).Check();
-  result->Set(isolate->GetCurrentContext(),
-              String::NewFromUtf8(isolate, "app").ToLocalChecked(),
-              Number::New(isolate, static_cast<double>(usage.app))).Check();
-  result->Set(isolate->GetCurrentContext(),
-              String::NewFromUtf8(isolate, "cache").ToLocalChecked(),
-              Number::New(isolate, static_cast<double>(usage.cache))).Check();
-  result->Set(isolate->GetCurrentContext(),
-              String::NewFromUtf8(isolate, "swap_total").ToLocalChecked(),
-              Number::New(isolate, static_cast<double>(usage.swap_total))).Check();
-  result->Set(isolate->GetCurrentContext(),
-              String::NewFromUtf8(isolate, "swap_used").ToLocalChecked(),
-              Number::New(isolate, static_cast<double>(usage.swap_used))).Check();
-  result->Set(isolate->GetCurrentContext(),
-              String::NewFromUtf8(isolate, "swap_free").ToLocalChecked(),
-              Number::New(isolate, static_cast<double>(usage.swap_free))).Check();
-  result->Set(isolate->GetCurrentContext(),
-              String::NewFromUtf8(isolate, "pressure_level").ToLocalChecked(),
-              Number::New(isolate, usage.pressure_level)).Check();
+  size_t capacity;
+  bool thrown;
+  double *out = OutputValues(args, RAM_USAGE_FIELD_COUNT, &capacity, &thrown);
+  if (thrown) {
+    return;
+  }
+  if (out) {
+    WriteRAMUsage(out, GetRAMUsage());
+    return;
+  }
+  args.GetReturnValue().Set(RAMUsageObject(isolate, GetRAMUsage()));
+}
 
-  args.GetReturnValue().Set(result);
+// Battery information as a JS object, shared by the sync and async getters
+static Local<Object> BatteryObject(Isolate *isolate, const BatteryInfo &info) {
+  Local<Value> values[] = {
+    v8::Boolean::New(isolate, info.external_connected),
+    v8::Boolean::New(isolate, info.battery_installed),
+    v8::Boolean::New(isolate, info.is_charging),
+    v8::Boolean::New(isolate, info.fully_charged),
+    Number::New(isolate, info.voltage),
+    Number::New(isolate, info.cycle_count),
+    Number::New(isolate, info.design_capacity),
+    Number::New(isolate, info.max_capacity),
+    Number::New(isolate, info.current_capacity),
+    Number::New(isolate, info.design_cycle_count),
+    Number::New(isolate, info.time_remaining),
+    Number::New(isolate, info.temperature),
+    Number::New(isolate, info.amperage),
+    Number::New(isolate, info.charge_percent),
+    Number::New(isolate, info.health_percent)
+  };
+  return ShapedObject(isolate, SHAPE_BATTERY_INFO, values);
 }
 
 void GetBatteryData(const FunctionCallbackInfo<Value> &args) {
   Isolate *isolate = Isolate::GetCurrent();
   HandleScope scope(isolate);
-
-  BatteryInfo info = GetBatteryInfo();
-  Local<Object> result = Object::New(isolate);
-
-  result->Set(isolate->GetCurrentContext(),
-              String::NewFromUtf8(isolate, "external_connected").ToLocalChecked(),
-              v8::Boolean::New(isolate, info.external_connected)).Check();
-  result->Set(isolate->GetCurrentContext(),
-              String::NewFromUtf8(isolate, "battery_installed").ToLocalChecked(),
-              v8::Boolean::New(isolate, info.battery_installed)).Check();
-  result->Set(isolate->GetCurrentContext(),
-              String::NewFromUtf8(isolate, "is_charging").ToLocalChecked(),
-              v8::Boolean::New(isolate, info.is_charging)).Check();
-  result->Set(isolate->GetCurrentContext(),
-              String::NewFromUtf8(isolate, "fully_charged").ToLocalChecked(),
-              v8::Boolean::New(isolate, info.fully_charged)).Check();
-  result->Set(isolate->GetCurrentContext(),
-              String::NewFromUtf8(isolate, "voltage").ToLocalChecked(),
-              Number::New(isolate, info.voltage)).Check();
-  result->Set(isolate->GetCurrentContext(),
-              String::NewFromUtf8(isolate, "cycle_count").ToLocalChecked(),
-              Number::New(isolate, info.cycle_count)).Check();
-  result->Set(isolate->GetCurrentContext(),
-              String::NewFromUtf8(isolate, "design_capacity").ToLocalChecked(),
-              Number::New(isolate, info.design_capacity)).Check();
-  result->Set(isolate->GetCurrentContext(),
-              String::NewFromUtf8(isolate, "max_capacity").ToLocalChecked(),
-              Number::New(isolate, info.max_capacity)).Check();
-  result->Set(isolate->GetCurrentContext(),
-              String::NewFromUtf8(isolate, "current_capacity").ToLocalChecked(),
-              Number::New(isolate, info.current_capacity)).Check();
-  result->Set(isolate->GetCurrentContext(),
-              String::NewFromUtf8(isolate, "design_cycle_count").ToLocalChecked(),
-              Number::New(isolate, info.design_cycle_count)).Check();
-  result->Set(isolate->GetCurrentContext(),
-              String::NewFromUtf8(isolate, "time_remaining").ToLocalChecked(),
-              Number::New(isolate, info.time_remaining)).Check();
-  result->Set(isolate->GetCurrentContext(),
-              String::NewFromUtf8(isolate, "temperature").ToLocalChecked(),
-              Number::New(isolate, info.temperature)).Check();
-  result->Set(isolate->GetCurrentContext(),
-              String::NewFromUtf8(isolate, "amperage").ToLocalChecked(),
-              Number::New(isolate, info.amperage)).Check();
-  result->Set(isolate->GetCurrentContext(),
-              String::NewFromUtf8(isolate, "charge_percent").ToLocalChecked(),
-              Number::New(isolate, info.charge_percent)).Check();
-  result->Set(isolate->GetCurrentContext(),
-              String::NewFromUtf8(isolate, "health_percent").ToLocalChecked(),
-              Number::New(isolate, info.health_percent)).Check();
-
-  args.GetReturnValue().Set(result);
+  args.GetReturnValue().Set(BatteryObject(isolate, GetBatteryInfo()));
 }
 
-// Static variables to track previous CPU ticks for delta calculation
-static unsigned long long prev_user_ticks = 0;
-static unsigned long long prev_system_ticks = 0;
-static unsigned long long prev_idle_ticks = 0;
-static unsigned long long prev_nice_ticks = 0;
-static bool first_call = true;
-
-// Get CPU usage information
-CPUUsage GetCPUUsage() {
+// CPU ticks at a consumer's previous read, for delta calculation
+typedef struct {
+  unsigned long long user;
+  unsigned long long system;
+  unsigned long long idle;
+  unsigned long long nice;
+  bool valid;
+} CPUTicks;
+
+// Baseline of getCPUUsage() and one-off snapshots; subscriptions keep their own
+static CPUTicks prev_ticks = {0, 0, 0, 0, false};
+static std::mutex cpu_ticks_lock;
+
+// CPU usage since *previous, which is then advanced. The load is over the
+// time between the two reads, so every consumer polling on its own schedule
+// needs its own baseline.
+static CPUUsage CPUUsageSince(CPUTicks *previous) {
   CPUUsage usage = {};
 
   // Get load averages
@@ -1865,110 +2161,255 @@ CPUUsage GetCPUUsage() {
   mach_msg_type_number_t count = HOST_CPU_LOAD_INFO_COUNT;
 
   if (host_statistics(mach_host_self(), HOST_CPU_LOAD_INFO, (host_info_t)&cpuinfo, &count) == KERN_SUCCESS) {
-    unsigned long long user_ticks = cpuinfo.cpu_ticks[CPU_STATE_USER];
-    unsigned long long system_ticks = cpuinfo.cpu_ticks[CPU_STATE_SYSTEM];
-    unsigned long long idle_ticks = cpuinfo.cpu_ticks[CPU_STATE_IDLE];
-    unsigned long long nice_ticks = cpuinfo.cpu_ticks[CPU_STATE_NICE];
-
-    // On first call, just store the values and return zeros
-    if (first_call) {
-      prev_user_ticks = user_ticks;
-      prev_system_ticks = system_ticks;
-      prev_idle_ticks = idle_ticks;
-      prev_nice_ticks = nice_ticks;
-      first_call = false;
+    CPUTicks ticks = {
+      cpuinfo.cpu_ticks[CPU_STATE_USER],
+      cpuinfo.cpu_ticks[CPU_STATE_SYSTEM],
+      cpuinfo.cpu_ticks[CPU_STATE_IDLE],
+      cpuinfo.cpu_ticks[CPU_STATE_NICE],
+      true
+    };
+
+    // Calculate deltas; on the first read there are none
+    unsigned long long delta_user = 0, delta_system = 0, delta_idle = 0, delta_nice = 0;
+    if (previous->valid) {
+      delta_user = ticks.user - previous->user;
+      delta_system = ticks.system - previous->system;
+      delta_idle = ticks.idle - previous->idle;
+      delta_nice = ticks.nice - previous->nice;
+    }
+
+    unsigned long long total_delta = delta_user + delta_system + delta_idle + delta_nice;
+
+    if (total_delta > 0) {
+      usage.user_load = (double)delta_user / (double)total_delta;
+      usage.system_load = (double)delta_system / (double)total_delta;
+      usage.idle_load = (double)delta_idle / (double)total_delta;
+      usage.total_usage = 1.0 - usage.idle_load;
+    } else {
+      // First read or no change in ticks
       usage.user_load = 0.0;
       usage.system_load = 0.0;
       usage.idle_load = 1.0;
       usage.total_usage = 0.0;
-    } else {
-      // Calculate deltas
-      unsigned long long delta_user = user_ticks - prev_user_ticks;
-      unsigned long long delta_system = system_ticks - prev_system_ticks;
-      unsigned long long delta_idle = idle_ticks - prev_idle_ticks;
-      unsigned long long delta_nice = nice_ticks - prev_nice_ticks;
-
-      unsigned long long total_delta = delta_user + delta_system + delta_idle + delta_nice;
-
-      if (total_delta > 0) {
-        usage.user_load = (double)delta_user / (double)total_delta;
-        usage.system_load = (double)delta_system / (double)total_delta;
-        usage.idle_load = (double)delta_idle / (double)total_delta;
-        usage.total_usage = 1.0 - usage.idle_load;
-      } else {
-        // No change in ticks, maintain previous state
-        usage.user_load = 0.0;
-        usage.system_load = 0.0;
-        usage.idle_load = 1.0;
-        usage.total_usage = 0.0;
-      }
-
-      // Update previous values for next call
-      prev_user_ticks = user_ticks;
-      prev_system_ticks = system_ticks;
-      prev_idle_ticks = idle_ticks;
-      prev_nice_ticks = nice_ticks;
     }
+
+    // Update previous values for next call
+    *previous = ticks;
   }
 
   return usage;
 }
 
+// Get CPU usage information
+CPUUsage GetCPUUsage() {
+  std::lock_guard<std::mutex> lock(cpu_ticks_lock);
+  return CPUUsageSince(&prev_ticks);
+}
+
+// CPU usage as a JS object, shared by the sync and async getters
+static Local<Object> CPUUsageObject(Isolate *isolate, const CPUUsage &usage) {
+  Local<Value> values[] = {
+    Number::New(isolate, usage.user_load),
+    Number::New(isolate, usage.system_load),
+    Number::New(isolate, usage.idle_load),
+    Number::New(isolate, usage.total_usage),
+    Number::New(isolate, usage.load_avg_1),
+    Number::New(isolate, usage.load_avg_5),
+    Number::New(isolate, usage.load_avg_15)
+  };
+  return ShapedObject(isolate, SHAPE_CPU_USAGE, values);
+}
+
+static void WriteCPUUsage(double *out, const CPUUsage &usage) {
+  out[0] = usage.user_load;
+  out[1] = usage.system_load;
+  out[2] = usage.idle_load;
+  out[3] = usage.total_usage;
+  out[4] = usage.load_avg_1;
+  out[5] = usage.load_avg_5;
+  out[6] = usage.load_avg_15;
+}
+
 void GetCPUUsageData(const FunctionCallbackInfo<Value> &args) {
   Isolate *isolate = Isolate::GetCurrent();
   HandleScope scope(isolate);
 
-  CPUUsage usage = GetCPUUsage();
-  Local<Object> result = Object::New(isolate);
+  size_t capacity;
+  bool thrown;
+  double *out = OutputValues(args, CPU_USAGE_FIELD_COUNT, &capacity, &thrown);
+  if (thrown) {
+    return;
+  }
+  if (out) {
+    WriteCPUUsage(out, GetCPUUsage());
+    return;
+  }
+  args.GetReturnValue().Set(CPUUsageObject(isolate, GetCPUUsage()));
+}
 
-  result->Set(isolate->GetCurrentContext(),
-              String::NewFromUtf8(isolate, "user_load").ToLocalChecked(),
-              Number::New(isolate, usage.user_load)).Check();
-  result->Set(isolate->GetCurrentContext(),
-              String::NewFromUtf8(isolate, "system_load").ToLocalChecked(),
-              Number::New(isolate, usage.system_load)).Check();
-  result->Set(isolate->GetCurrentContext(),
-              String::NewFromUtf8(isolate, "idle_load").ToLocalChecked(),
-              Number::New(isolate, usage.idle_load)).Check();
-  result->Set(isolate->GetCurrentContext(),
-              String::NewFromUtf8(isolate, "total_usage").ToLocalChecked(),
-              Number::New(isolate, usage.total_usage)).Check();
-  result->Set(isolate->GetCurrentContext(),
-              String::NewFromUtf8(isolate, "load_avg_1").ToLocalChecked(),
-              Number::New(isolate, usage.load_avg_1)).Check();
-  result->Set(isolate->GetCurrentContext(),
-              String::NewFromUtf8(isolate, "load_avg_5").ToLocalChecked(),
-              Number::New(isolate, usage.load_avg_5)).Check();
-  result->Set(isolate->GetCurrentContext(),
-              String::NewFromUtf8(isolate, "load_avg_15").ToLocalChecked(),
-              Number::New(isolate, usage.load_avg_15)).Check();
+// cpuFrequencies(): every CPU cluster and core of the IOReport CPU Stats
+// group, with its mean frequency while active and its idle share over the
+// latest sampler window. The first call subscribes to CPU Stats and waits
+// for a sample; an empty array if there is none.
+void CpuFrequencies(const FunctionCallbackInfo<Value> &args) {
+  Isolate *isolate = Isolate::GetCurrent();
+  HandleScope scope(isolate);
+  Local<v8::Context> context = isolate->GetCurrentContext();
 
+  std::vector<SMCCpuFrequency> frequencies;
+  SMCGetCpuFrequencies(&frequencies, SMCGetPowerSamplerPeriod() * 3 + 100);
+
+  Local<Array> result = Array::New(isolate, frequencies.size());
+  for (size_t i = 0; i < frequencies.size(); i++) {
+    const SMCCpuFrequency &frequency = frequencies[i];
+    char cluster[16];
+    snprintf(cluster, sizeof(cluster), "%c%d", frequency.cluster_type, frequency.cluster);
+
+    Local<Value> values[] = {
+      String::NewFromUtf8(isolate, frequency.name.c_str()).ToLocalChecked(),
+      String::NewFromUtf8(isolate, cluster).ToLocalChecked(),
+      frequency.core >= 0 ? Local<Value>(Number::New(isolate, frequency.core)) : Local<Value>(v8::Null(isolate)),
+      Number::New(isolate, frequency.die),
+      Number::New(isolate, frequency.residency.active_mhz),
+      Number::New(isolate, frequency.residency.active_ratio),
+      Number::New(isolate, frequency.residency.idle_ratio),
+      Number::New(isolate, frequency.max_mhz)
+    };
+    result->Set(context, i, ShapedObject(isolate, SHAPE_CPU_FREQUENCY, values)).Check();
+  }
   args.GetReturnValue().Set(result);
 }
 
-// Get disk information
-DiskList GetDiskInfo() {
-  DiskList diskList = {};
-  diskList.disks = nullptr;
-  diskList.count = 0;
+// gpuFrequency(): the GPU's mean frequency while active, its active and idle
+// shares and the share of each operating point over the latest sampler
+// window, from IOReport GPU Stats. The first call subscribes to GPU Stats and
+// waits for a sample; null if there is none.
+void GpuFrequency(const FunctionCallbackInfo<Value> &args) {
+  Isolate *isolate = Isolate::GetCurrent();
+  HandleScope scope(isolate);
+  Local<v8::Context> context = isolate->GetCurrentContext();
 
-  // Get number of mounted file systems
-  int numfs = getfsstat(NULL, 0, MNT_NOWAIT);
-  if (numfs <= 0) {
-    return diskList;
+  SMCGpuFrequency gpu;
+  if (!SMCGetGpuFrequency(&gpu, SMCGetPowerSamplerPeriod() * 3 + 100)) {
+    args.GetReturnValue().Set(v8::Null(isolate));
+    return;
   }
 
-  // Allocate buffer for file system stats
-  struct statfs* mounts = (struct statfs*)malloc(numfs * sizeof(struct statfs));
-  if (!mounts) {
-    return diskList;
+  Local<Array> states = Array::New(isolate, gpu.state_mhz.size());
+  for (size_t i = 0; i < gpu.state_mhz.size(); i++) {
+    Local<Value> values[] = {Number::New(isolate, gpu.state_mhz[i]), Number::New(isolate, gpu.state_ratio[i])};
+    states->Set(context, i, ShapedObject(isolate, SHAPE_GPU_STATE, values)).Check();
   }
 
-  // Get file system stats
-  numfs = getfsstat(mounts, numfs * sizeof(struct statfs), MNT_NOWAIT);
-  if (numfs <= 0) {
-    free(mounts);
-    return diskList;
+  Local<Value> values[] = {
+    String::NewFromUtf8(isolate, gpu.name.c_str()).ToLocalChecked(),
+    Number::New(isolate, gpu.residency.active_mhz),
+    Number::New(isolate, gpu.residency.active_ratio),
+    Number::New(isolate, gpu.residency.idle_ratio),
+    Number::New(isolate, gpu.max_mhz),
+    states
+  };
+  args.GetReturnValue().Set(ShapedObject(isolate, SHAPE_GPU_FREQUENCY, values));
+}
+
+// gpuMemory(): bytes of memory the GPU has in use and allocated, from the
+// cached accelerator's PerformanceStatistics; null without an accelerator
+void GpuMemory(const FunctionCallbackInfo<Value> &args) {
+  Isolate *isolate = Isolate::GetCurrent();
+  HandleScope scope(isolate);
+
+  CFDictionaryRef stats = CopyAcceleratorStatistics();
+  if (!stats) {
+    args.GetReturnValue().Set(v8::Null(isolate));
+    return;
+  }
+  // Unified memory reports system memory; discrete GPUs report VRAM
+  static const char *const in_use_keys[] = {"In use system memory", "vramUsedBytes"};
+  static const char *const allocated_keys[] = {"Alloc system memory", "vramTotalBytes"};
+  int64_t in_use = 0;
+  int64_t allocated = 0;
+  AcceleratorStatistic(stats, in_use_keys, sizeof(in_use_keys) / sizeof(in_use_keys[0]), &in_use);
+  AcceleratorStatistic(stats, allocated_keys, sizeof(allocated_keys) / sizeof(allocated_keys[0]), &allocated);
+  CFRelease(stats);
+
+  Local<Value> values[] = {Number::New(isolate, (double)in_use), Number::New(isolate, (double)allocated)};
+  args.GetReturnValue().Set(ShapedObject(isolate, SHAPE_GPU_MEMORY, values));
+}
+
+// Shared metrics block values (see smc_block.cc): sample number, time and
+// interval, then RAM usage, CPU usage and power in their output mode order
+static const char *const block_fields[] = {"samples", "timestamp", "interval_ms"};
+static const size_t BLOCK_FIELD_COUNT = sizeof(block_fields) / sizeof(block_fields[0]);
+static const size_t BLOCK_RAM_USAGE = BLOCK_FIELD_COUNT;
+static const size_t BLOCK_CPU_USAGE = BLOCK_RAM_USAGE + RAM_USAGE_FIELD_COUNT;
+static const size_t BLOCK_POWER = BLOCK_CPU_USAGE + CPU_USAGE_FIELD_COUNT;
+static const size_t BLOCK_VALUE_COUNT = BLOCK_POWER + POWER_FIELD_COUNT;
+static const uint32_t BLOCK_VERSION = 1;
+
+// Block value names, prefixed with their metric
+static Local<Array> BlockFieldArray(Isolate *isolate) {
+  std::vector<std::string> names(block_fields, block_fields + BLOCK_FIELD_COUNT);
+  for (size_t i = 0; i < RAM_USAGE_FIELD_COUNT; i++) names.push_back(std::string("ram.") + ram_usage_fields[i]);
+  for (size_t i = 0; i < CPU_USAGE_FIELD_COUNT; i++) names.push_back(std::string("cpu_usage.") + cpu_usage_fields[i]);
+  for (size_t i = 0; i < POWER_FIELD_COUNT; i++) names.push_back(std::string("power.") + power_fields[i]);
+
+  Local<Array> result = Array::New(isolate, (int)names.size());
+  for (size_t i = 0; i < names.size(); i++) {
+    result->Set(isolate->GetCurrentContext(), i,
+                String::NewFromUtf8(isolate, names[i].c_str()).ToLocalChecked()).Check();
+  }
+  return result;
+}
+
+// Layouts of the Float64Array output mode, read once by the caller:
+// {ram, cpu_usage, power, temperatures, voltages, currents}, each a list of
+// names whose indices are the value offsets, and the shared block's values
+void MetricsSchema(const FunctionCallbackInfo<Value> &args) {
+  Isolate *isolate = Isolate::GetCurrent();
+  HandleScope scope(isolate);
+
+  Local<v8::Context> context = isolate->GetCurrentContext();
+  Local<Object> result = Object::New(isolate);
+  result->Set(context, String::NewFromUtf8(isolate, "ram").ToLocalChecked(),
+              FieldArray(isolate, ram_usage_fields, RAM_USAGE_FIELD_COUNT)).Check();
+  result->Set(context, String::NewFromUtf8(isolate, "cpu_usage").ToLocalChecked(),
+              FieldArray(isolate, cpu_usage_fields, CPU_USAGE_FIELD_COUNT)).Check();
+  result->Set(context, String::NewFromUtf8(isolate, "power").ToLocalChecked(),
+              FieldArray(isolate, power_fields, POWER_FIELD_COUNT)).Check();
+  result->Set(context, String::NewFromUtf8(isolate, "temperatures").ToLocalChecked(),
+              SensorNameArray(isolate, GetIOKitTemperatureSensors())).Check();
+  result->Set(context, String::NewFromUtf8(isolate, "voltages").ToLocalChecked(),
+              SensorNameArray(isolate, GetIOKitVoltageSensors())).Check();
+  result->Set(context, String::NewFromUtf8(isolate, "currents").ToLocalChecked(),
+              SensorNameArray(isolate, GetIOKitCurrentSensors())).Check();
+  result->Set(context, String::NewFromUtf8(isolate, "block").ToLocalChecked(),
+              BlockFieldArray(isolate)).Check();
+  args.GetReturnValue().Set(result);
+}
+
+// Get disk information
+DiskList GetDiskInfo() {
+  DiskList diskList = {};
+  diskList.disks = nullptr;
+  diskList.count = 0;
+
+  // Get number of mounted file systems
+  int numfs = getfsstat(NULL, 0, MNT_NOWAIT);
+  if (numfs <= 0) {
+    return diskList;
+  }
+
+  // Allocate buffer for file system stats
+  struct statfs* mounts = (struct statfs*)malloc(numfs * sizeof(struct statfs));
+  if (!mounts) {
+    return diskList;
+  }
+
+  // Get file system stats
+  numfs = getfsstat(mounts, numfs * sizeof(struct statfs), MNT_NOWAIT);
+  if (numfs <= 0) {
+    free(mounts);
+    return diskList;
   }
 
   // Allocate disk array
@@ -2077,41 +2518,23 @@ DiskList GetDiskInfo() {
   return diskList;
 }
 
-void GetDiskData(const FunctionCallbackInfo<Value> &args) {
-  Isolate *isolate = Isolate::GetCurrent();
-  HandleScope scope(isolate);
-
-  DiskList diskList = GetDiskInfo();
+// Disk list as a JS array; frees the list
+static Local<Array> DiskListArray(Isolate *isolate, DiskList diskList) {
   Local<Array> result = Array::New(isolate, diskList.count);
 
   for (int i = 0; i < diskList.count; i++) {
     DiskInfo* disk = &diskList.disks[i];
-    Local<Object> diskObj = Object::New(isolate);
-
-    diskObj->Set(isolate->GetCurrentContext(),
-                String::NewFromUtf8(isolate, "name").ToLocalChecked(),
-                String::NewFromUtf8(isolate, disk->name).ToLocalChecked()).Check();
-    diskObj->Set(isolate->GetCurrentContext(),
-                String::NewFromUtf8(isolate, "mount_point").ToLocalChecked(),
-                String::NewFromUtf8(isolate, disk->mount_point).ToLocalChecked()).Check();
-    diskObj->Set(isolate->GetCurrentContext(),
-                String::NewFromUtf8(isolate, "file_system").ToLocalChecked(),
-                String::NewFromUtf8(isolate, disk->file_system).ToLocalChecked()).Check();
-    diskObj->Set(isolate->GetCurrentContext(),
-                String::NewFromUtf8(isolate, "total_size").ToLocalChecked(),
-                Number::New(isolate, disk->total_size)).Check();
-    diskObj->Set(isolate->GetCurrentContext(),
-                String::NewFromUtf8(isolate, "free_size").ToLocalChecked(),
-                Number::New(isolate, disk->free_size)).Check();
-    diskObj->Set(isolate->GetCurrentContext(),
-                String::NewFromUtf8(isolate, "used_size").ToLocalChecked(),
-                Number::New(isolate, disk->used_size)).Check();
-    diskObj->Set(isolate->GetCurrentContext(),
-                String::NewFromUtf8(isolate, "bsd_name").ToLocalChecked(),
-                String::NewFromUtf8(isolate, disk->bsd_name).ToLocalChecked()).Check();
-    diskObj->Set(isolate->GetCurrentContext(),
-                String::NewFromUtf8(isolate, "is_removable").ToLocalChecked(),
-                v8::Boolean::New(isolate, disk->is_removable)).Check();
+    Local<Value> values[] = {
+      String::NewFromUtf8(isolate, disk->name).ToLocalChecked(),
+      String::NewFromUtf8(isolate, disk->mount_point).ToLocalChecked(),
+      String::NewFromUtf8(isolate, disk->file_system).ToLocalChecked(),
+      Number::New(isolate, disk->total_size),
+      Number::New(isolate, disk->free_size),
+      Number::New(isolate, disk->used_size),
+      String::NewFromUtf8(isolate, disk->bsd_name).ToLocalChecked(),
+      v8::Boolean::New(isolate, disk->is_removable)
+    };
+    Local<Object> diskObj = ShapedObject(isolate, SHAPE_DISK_INFO, values);
 
     result->Set(isolate->GetCurrentContext(), i, diskObj).Check();
   }
@@ -2121,30 +2544,1910 @@ void GetDiskData(const FunctionCallbackInfo<Value> &args) {
     free(diskList.disks);
   }
 
+  return result;
+}
+
+void GetDiskData(const FunctionCallbackInfo<Value> &args) {
+  Isolate *isolate = Isolate::GetCurrent();
+  HandleScope scope(isolate);
+  args.GetReturnValue().Set(DiskListArray(isolate, GetDiskInfo()));
+}
+
+// Parse an array of key names ("F0Ac", "Tp01", ...) into numeric FourCCs
+static bool ParseKeyNames(Isolate *isolate, Local<Array> names, std::vector<UInt32> *keys) {
+  Local<v8::Context> context = isolate->GetCurrentContext();
+
+  keys->resize(names->Length());
+  for (uint32_t i = 0; i < names->Length(); i++) {
+    Local<Value> name;
+    if (!names->Get(context, i).ToLocal(&name) || !name->IsString()) {
+      return false;
+    }
+    String::Utf8Value keyName(isolate, name);
+    if (keyName.length() < 1 || keyName.length() > 4) {
+      return false;
+    }
+    (*keys)[i] = SMCKeyFromString(*keyName);
+  }
+  return true;
+}
+
+// Compile key names once into a Uint32Array of FourCCs that readKeys() takes as is
+void CompileKeys(const FunctionCallbackInfo<Value> &args) {
+  Isolate *isolate = Isolate::GetCurrent();
+  HandleScope scope(isolate);
+
+  std::vector<UInt32> keys;
+  if (args.Length() < 1 || !args[0]->IsArray() || !ParseKeyNames(isolate, args[0].As<Array>(), &keys)) {
+    isolate->ThrowException(Exception::TypeError(
+        String::NewFromUtf8(isolate, "Keys must be an array of 1-4 character SMC key names").ToLocalChecked()));
+    return;
+  }
+
+  Local<ArrayBuffer> buffer = ArrayBuffer::New(isolate, keys.size() * sizeof(UInt32));
+  if (!keys.empty()) {
+    memcpy(buffer->Data(), keys.data(), keys.size() * sizeof(UInt32));
+  }
+  args.GetReturnValue().Set(Uint32Array::New(buffer, 0, keys.size()));
+}
+
+// Read many SMC keys in one call: readKeys(keys, values?, status?) -> {values, status}
+// keys is an array of names or a compiled Uint32Array. values/status may be passed in
+// to be filled in place.
+void ReadKeys(const FunctionCallbackInfo<Value> &args) {
+  Isolate *isolate = Isolate::GetCurrent();
+  HandleScope scope(isolate);
+  Local<v8::Context> context = isolate->GetCurrentContext();
+
+  std::vector<UInt32> parsed;
+  const UInt32 *keys = NULL;
+  size_t count = 0;
+
+  if (args.Length() > 0 && args[0]->IsUint32Array()) {
+    Local<Uint32Array> compiled = args[0].As<Uint32Array>();
+    keys = (const UInt32 *)((char *)compiled->Buffer()->Data() + compiled->ByteOffset());
+    count = compiled->Length();
+  } else if (args.Length() > 0 && args[0]->IsArray() && ParseKeyNames(isolate, args[0].As<Array>(), &parsed)) {
+    keys = parsed.data();
+    count = parsed.size();
+  } else {
+    isolate->ThrowException(Exception::TypeError(
+        String::NewFromUtf8(isolate, "Keys must be an array of SMC key names or a compiled key list").ToLocalChecked()));
+    return;
+  }
+
+  Local<Float64Array> values;
+  if (args.Length() > 1 && args[1]->IsFloat64Array() && args[1].As<Float64Array>()->Length() >= count) {
+    values = args[1].As<Float64Array>();
+  } else {
+    values = Float64Array::New(ArrayBuffer::New(isolate, count * sizeof(double)), 0, count);
+  }
+
+  Local<Int32Array> status;
+  if (args.Length() > 2 && args[2]->IsInt32Array() && args[2].As<Int32Array>()->Length() >= count) {
+    status = args[2].As<Int32Array>();
+  } else {
+    status = Int32Array::New(ArrayBuffer::New(isolate, count * sizeof(int32_t)), 0, count);
+  }
+
+  if (count > 0) {
+    SMCReadKeys(keys, count,
+                (double *)((char *)values->Buffer()->Data() + values->ByteOffset()),
+                (int32_t *)((char *)status->Buffer()->Data() + status->ByteOffset()));
+  }
+
+  Local<Object> result = Object::New(isolate);
+  result->Set(context, String::NewFromUtf8(isolate, "values").ToLocalChecked(), values).Check();
+  result->Set(context, String::NewFromUtf8(isolate, "status").ToLocalChecked(), status).Check();
   args.GetReturnValue().Set(result);
 }
 
-void Init(v8::Local<Object> exports, v8::Local<v8::Value> module, void* priv) {
-  NODE_SET_METHOD(exports, "temperature", Temperature);
-  NODE_SET_METHOD(exports, "cpuTemperatureDie", CpuTemperatureDie);
-  NODE_SET_METHOD(exports, "gpuTemperature", GpuTemperature);
-  NODE_SET_METHOD(exports, "gpuUsage", GpuUsage);
-  NODE_SET_METHOD(exports, "fans", Fans);
-  NODE_SET_METHOD(exports, "fanRpm", FanRpm);
-  NODE_SET_METHOD(exports, "fanMin", FanMin);
-  NODE_SET_METHOD(exports, "fanMax", FanMax);
-  NODE_SET_METHOD(exports, "getAllPower", GetAllPower);
-  NODE_SET_METHOD(exports, "cpuVoltage", CpuVoltage);
-  NODE_SET_METHOD(exports, "gpuVoltage", GpuVoltage);
-  NODE_SET_METHOD(exports, "memoryVoltage", MemoryVoltage);
-  NODE_SET_METHOD(exports, "getAllTemperatureSensors", GetAllTemperatureSensors);
-  NODE_SET_METHOD(exports, "getAllVoltageSensors", GetAllVoltageSensors);
-  NODE_SET_METHOD(exports, "getAllCurrentSensors", GetAllCurrentSensors);
-  NODE_SET_METHOD(exports, "getBatteryData", GetBatteryData);
-  NODE_SET_METHOD(exports, "getSystemData", GetSystemData);
-  NODE_SET_METHOD(exports, "getRAMUsageData", GetRAMUsageData);
-  NODE_SET_METHOD(exports, "getCPUUsageData", GetCPUUsageData);
-  NODE_SET_METHOD(exports, "getDiskData", GetDiskData);
+// Transports installed through setTransport(), freed when replaced. Shared by
+// every environment; taken before the connection and key locks.
+static std::mutex transport_config_lock;  // Guards these and the power stand-ins
+static SMCSimDevice *sim_device = NULL;
+static SMCTraceRecorder *trace_recorder = NULL;
+static SMCTraceReplay *trace_replay = NULL;
+
+// SMC connection and key-info cache counters for diagnostics and tests
+void SmcStats(const FunctionCallbackInfo<Value> &args) {
+  Isolate *isolate = Isolate::GetCurrent();
+  HandleScope scope(isolate);
+
+  SMCConnectionStats stats = SMCGetConnectionStats();
+  SMCKeyInfoCacheStats keyInfo = SMCGetKeyInfoCacheStats();
+  const SMCTransport *transport = SMCGetTransport();
+  Local<Object> result = Object::New(isolate);
+
+  result->Set(isolate->GetCurrentContext(),
+              String::NewFromUtf8(isolate, "transport").ToLocalChecked(),
+              String::NewFromUtf8(isolate, transport ? transport->name : "none").ToLocalChecked()).Check();
+  result->Set(isolate->GetCurrentContext(),
+              String::NewFromUtf8(isolate, "connected").ToLocalChecked(),
+              v8::Boolean::New(isolate, stats.connected)).Check();
+  result->Set(isolate->GetCurrentContext(),
+              String::NewFromUtf8(isolate, "refs").ToLocalChecked(),
+              Number::New(isolate, stats.refs)).Check();
+  result->Set(isolate->GetCurrentContext(),
+              String::NewFromUtf8(isolate, "opens").ToLocalChecked(),
+              Number::New(isolate, static_cast<double>(stats.opens))).Check();
+  result->Set(isolate->GetCurrentContext(),
+              String::NewFromUtf8(isolate, "reconnects").ToLocalChecked(),
+              Number::New(isolate, static_cast<double>(stats.reconnects))).Check();
+  result->Set(isolate->GetCurrentContext(),
+              String::NewFromUtf8(isolate, "failed_opens").ToLocalChecked(),
+              Number::New(isolate, static_cast<double>(stats.failed_opens))).Check();
+  result->Set(isolate->GetCurrentContext(),
+              String::NewFromUtf8(isolate, "calls").ToLocalChecked(),
+              Number::New(isolate, static_cast<double>(stats.calls))).Check();
+  result->Set(isolate->GetCurrentContext(),
+              String::NewFromUtf8(isolate, "errors").ToLocalChecked(),
+              Number::New(isolate, static_cast<double>(stats.errors))).Check();
+  result->Set(isolate->GetCurrentContext(),
+              String::NewFromUtf8(isolate, "key_info_hits").ToLocalChecked(),
+              Number::New(isolate, static_cast<double>(keyInfo.hits))).Check();
+  result->Set(isolate->GetCurrentContext(),
+              String::NewFromUtf8(isolate, "key_info_misses").ToLocalChecked(),
+              Number::New(isolate, static_cast<double>(keyInfo.misses))).Check();
+  result->Set(isolate->GetCurrentContext(),
+              String::NewFromUtf8(isolate, "key_info_entries").ToLocalChecked(),
+              Number::New(isolate, static_cast<double>(keyInfo.entries))).Check();
+  result->Set(isolate->GetCurrentContext(),
+              String::NewFromUtf8(isolate, "catalog_keys").ToLocalChecked(),
+              Number::New(isolate, static_cast<double>(keyInfo.catalog_keys))).Check();
+  result->Set(isolate->GetCurrentContext(),
+              String::NewFromUtf8(isolate, "key_cache").ToLocalChecked(),
+              String::NewFromUtf8(isolate, key_cache_state).ToLocalChecked()).Check();
+
+  // Record/replay transports and the simulated device
+  uint64_t traceRecords = 0;
+  SMCTraceReplayStats replayStats = {};
+  SMCSimStats simStats = {};
+  {
+    std::lock_guard<std::mutex> config(transport_config_lock);
+    if (trace_recorder) {
+      traceRecords = SMCTraceRecordCount(trace_recorder);
+    }
+    if (trace_replay) {
+      replayStats = SMCTraceReplayGetStats(trace_replay);
+      traceRecords = replayStats.records;
+    }
+    if (sim_device) {
+      simStats = SMCSimGetStats(sim_device);
+    }
+  }
+  result->Set(isolate->GetCurrentContext(),
+              String::NewFromUtf8(isolate, "trace_records").ToLocalChecked(),
+              Number::New(isolate, static_cast<double>(traceRecords))).Check();
+  result->Set(isolate->GetCurrentContext(),
+              String::NewFromUtf8(isolate, "replay_served").ToLocalChecked(),
+              Number::New(isolate, static_cast<double>(replayStats.served))).Check();
+  result->Set(isolate->GetCurrentContext(),
+              String::NewFromUtf8(isolate, "replay_misses").ToLocalChecked(),
+              Number::New(isolate, static_cast<double>(replayStats.misses))).Check();
+
+  result->Set(isolate->GetCurrentContext(),
+              String::NewFromUtf8(isolate, "sim_calls").ToLocalChecked(),
+              Number::New(isolate, static_cast<double>(simStats.calls))).Check();
+  result->Set(isolate->GetCurrentContext(),
+              String::NewFromUtf8(isolate, "sim_errors").ToLocalChecked(),
+              Number::New(isolate, static_cast<double>(simStats.errors))).Check();
+
+  args.GetReturnValue().Set(result);
+}
+
+// Every key the SMC knows: [{key, type, size, attributes}], or an empty array
+// if the SMC cannot enumerate its keys
+void SmcKeys(const FunctionCallbackInfo<Value> &args) {
+  Isolate *isolate = Isolate::GetCurrent();
+  HandleScope scope(isolate);
+  Local<v8::Context> context = isolate->GetCurrentContext();
+
+  std::vector<SMCKeyEntry> catalog;
+  SMCGetKeyCatalog(&catalog);
+  Local<Array> result = Array::New(isolate, (int)catalog.size());
+
+  for (size_t i = 0; i < catalog.size(); i++) {
+    const SMCKeyEntry &entry = catalog[i];
+    char key[5];
+    char type[5];
+    SMCKeyToString(entry.key, key);
+    SMCKeyToString(entry.dataType, type);
+
+    // Types shorter than four characters are space padded ("flt ")
+    for (int j = 3; j >= 0 && type[j] == ' '; j--) {
+      type[j] = '\0';
+    }
+
+    Local<Object> obj = Object::New(isolate);
+    obj->Set(context, String::NewFromUtf8(isolate, "key").ToLocalChecked(),
+             String::NewFromUtf8(isolate, key).ToLocalChecked()).Check();
+    obj->Set(context, String::NewFromUtf8(isolate, "type").ToLocalChecked(),
+             String::NewFromUtf8(isolate, type).ToLocalChecked()).Check();
+    obj->Set(context, String::NewFromUtf8(isolate, "size").ToLocalChecked(),
+             Number::New(isolate, entry.dataSize)).Check();
+    obj->Set(context, String::NewFromUtf8(isolate, "attributes").ToLocalChecked(),
+             Number::New(isolate, entry.attributes)).Check();
+    result->Set(context, (uint32_t)i, obj).Check();
+  }
+
+  args.GetReturnValue().Set(result);
+}
+
+// Helper to read an optional integer property from a JS object
+static int GetIntProperty(Isolate *isolate, Local<Object> obj, const char *name, int defaultValue) {
+  Local<Value> value;
+  if (!obj->Get(isolate->GetCurrentContext(),
+                String::NewFromUtf8(isolate, name).ToLocalChecked()).ToLocal(&value) ||
+      !value->IsNumber()) {
+    return defaultValue;
+  }
+  return value->Int32Value(isolate->GetCurrentContext()).ToChecked();
+}
+
+// Helper to read an optional floating point property from a JS object
+static double GetDoubleProperty(Isolate *isolate, Local<Object> obj, const char *name, double defaultValue) {
+  Local<Value> value;
+  if (!obj->Get(isolate->GetCurrentContext(),
+                String::NewFromUtf8(isolate, name).ToLocalChecked()).ToLocal(&value) ||
+      !value->IsNumber()) {
+    return defaultValue;
+  }
+  return value->NumberValue(isolate->GetCurrentContext()).ToChecked();
+}
+
+// Helper to read an optional string property from a JS object
+static std::string GetStringProperty(Isolate *isolate, Local<Object> obj, const char *name) {
+  Local<Value> value;
+  if (!obj->Get(isolate->GetCurrentContext(),
+                String::NewFromUtf8(isolate, name).ToLocalChecked()).ToLocal(&value) ||
+      !value->IsString()) {
+    return std::string();
+  }
+  String::Utf8Value str(isolate, value);
+  return std::string(*str);
+}
+
+static ChipGeneration ParseChipGeneration(const std::string &name) {
+  if (name == "Intel") return CHIP_INTEL;
+  if (name == "M1") return CHIP_M1;
+  if (name == "M2") return CHIP_M2;
+  if (name == "M3") return CHIP_M3;
+  if (name == "M4") return CHIP_M4;
+  if (name == "M5") return CHIP_M5;
+  return CHIP_UNKNOWN;
+}
+
+static SMCSimWaveShape ParseWaveShape(const std::string &name) {
+  if (name == "sine") return SMC_SIM_SINE;
+  if (name == "ramp") return SMC_SIM_RAMP;
+  if (name == "square") return SMC_SIM_SQUARE;
+  if (name == "noise") return SMC_SIM_NOISE;
+  return SMC_SIM_CONSTANT;
+}
+
+// Build a stand-in device from {type: 'simulated', chip, keys: [{key, type, bytes | value, wave}],
+// fail_opens, fail_calls, error_rate, latency_us, seed, time_step_ms}
+static SMCSimDevice *CreateSimDevice(Isolate *isolate, Local<Object> spec) {
+  Local<v8::Context> context = isolate->GetCurrentContext();
+
+  if (GetStringProperty(isolate, spec, "type") != "simulated") {
+    return NULL;
+  }
+
+  SMCSimDevice *device = SMCSimCreate();
+  device->fail_opens = GetIntProperty(isolate, spec, "fail_opens", 0);
+  device->fail_calls = GetIntProperty(isolate, spec, "fail_calls", 0);
+  device->error_rate = GetDoubleProperty(isolate, spec, "error_rate", 0);
+  device->latency_us = (uint32_t)GetIntProperty(isolate, spec, "latency_us", 0);
+  device->time_step_ms = GetDoubleProperty(isolate, spec, "time_step_ms", 0);
+  SMCSimSeed(device, (uint64_t)GetDoubleProperty(isolate, spec, "seed", 1));
+
+  // Chip presets go in first so explicit keys can override them
+  std::string chip = GetStringProperty(isolate, spec, "chip");
+  if (!chip.empty()) {
+    ChipGeneration gen = ParseChipGeneration(chip);
+    if (gen == CHIP_UNKNOWN) {
+      SMCSimDestroy(device);
+      isolate->ThrowException(Exception::TypeError(
+          String::NewFromUtf8(isolate, "Unknown chip generation").ToLocalChecked()));
+      return NULL;
+    }
+    SMCSimAddChipKeys(device, gen);
+  }
+
+  Local<Value> keys;
+  if (spec->Get(context, String::NewFromUtf8(isolate, "keys").ToLocalChecked()).ToLocal(&keys) &&
+      keys->IsArray()) {
+    Local<Array> keyArray = keys.As<Array>();
+    for (uint32_t i = 0; i < keyArray->Length(); i++) {
+      Local<Value> entry;
+      if (!keyArray->Get(context, i).ToLocal(&entry) || !entry->IsObject()) continue;
+      Local<Object> keyObj = entry.As<Object>();
+
+      std::string keyName = GetStringProperty(isolate, keyObj, "key");
+      std::string dataTypeName = GetStringProperty(isolate, keyObj, "type");
+      if (keyName.empty() || dataTypeName.empty()) continue;
+
+      Local<Value> bytes, value, wave;
+      keyObj->Get(context, String::NewFromUtf8(isolate, "bytes").ToLocalChecked()).ToLocal(&bytes);
+      keyObj->Get(context, String::NewFromUtf8(isolate, "value").ToLocalChecked()).ToLocal(&value);
+      keyObj->Get(context, String::NewFromUtf8(isolate, "wave").ToLocalChecked()).ToLocal(&wave);
+
+      bool hasWave = !wave.IsEmpty() && wave->IsObject();
+      if (!value.IsEmpty() && value->IsNumber()) {
+        SMCSimAddValue(device, keyName.c_str(), dataTypeName.c_str(),
+                       value->NumberValue(context).ToChecked());
+      } else if (hasWave && (bytes.IsEmpty() || !bytes->IsArray())) {
+        // The wave supplies the value; only the size is needed
+        SMCSimAddValue(device, keyName.c_str(), dataTypeName.c_str(), 0);
+      } else {
+        UInt8 data[sizeof(SMCBytes_t)] = {0};
+        UInt32 size = 0;
+        if (!bytes.IsEmpty() && bytes->IsArray()) {
+          Local<Array> byteArray = bytes.As<Array>();
+          for (uint32_t j = 0; j < byteArray->Length() && j < sizeof(data); j++) {
+            Local<Value> byte;
+            if (byteArray->Get(context, j).ToLocal(&byte)) {
+              data[j] = (UInt8)byte->Uint32Value(context).FromMaybe(0);
+            }
+            size++;
+          }
+        }
+        SMCSimAddKey(device, keyName.c_str(), dataTypeName.c_str(), data, size);
+      }
+
+      if (hasWave) {
+        Local<Object> waveObj = wave.As<Object>();
+        SMCSimWave simWave;
+        simWave.shape = ParseWaveShape(GetStringProperty(isolate, waveObj, "shape"));
+        simWave.min = GetDoubleProperty(isolate, waveObj, "min", 0);
+        simWave.max = GetDoubleProperty(isolate, waveObj, "max", 0);
+        simWave.period_ms = GetDoubleProperty(isolate, waveObj, "period_ms", 1000);
+        SMCSimSetWave(device, keyName.c_str(), simWave);
+      }
+    }
+  }
+
+  return device;
+}
+
+static void ThrowTransportError(Isolate *isolate, const char *message) {
+  isolate->ThrowException(Exception::Error(String::NewFromUtf8(isolate, message).ToLocalChecked()));
+}
+
+// Swap the SMC transport:
+//   setTransport()                                          restore IOKit
+//   setTransport({type: 'simulated', ...})                  stand-in device
+//   setTransport({type: 'record', path, source?})           record IOKit (or a simulated source) to a trace
+//   setTransport({type: 'replay', path, latency?})          serve a recorded trace
+void SetTransport(const FunctionCallbackInfo<Value> &args) {
+  Isolate *isolate = Isolate::GetCurrent();
+  HandleScope scope(isolate);
+  Local<v8::Context> context = isolate->GetCurrentContext();
+
+  SMCSimDevice *device = NULL;
+  SMCTraceRecorder *recorder = NULL;
+  SMCTraceReplay *replay = NULL;
+  const SMCTransport *transport = NULL;
+
+  if (args.Length() > 0 && !args[0]->IsNullOrUndefined()) {
+    std::string type;
+    if (args[0]->IsObject()) {
+      type = GetStringProperty(isolate, args[0].As<Object>(), "type");
+    }
+
+    if (type == "simulated") {
+      device = CreateSimDevice(isolate, args[0].As<Object>());
+      if (!device) return;
+      transport = &device->transport;
+    } else if (type == "record" || type == "replay") {
+      Local<Object> spec = args[0].As<Object>();
+      std::string path = GetStringProperty(isolate, spec, "path");
+      if (path.empty()) {
+        isolate->ThrowException(Exception::TypeError(
+            String::NewFromUtf8(isolate, "Trace path required").ToLocalChecked()));
+        return;
+      }
+
+      if (type == "record") {
+        const SMCTransport *source = &iokit_transport;
+        Local<Value> sourceSpec;
+        if (spec->Get(context, String::NewFromUtf8(isolate, "source").ToLocalChecked()).ToLocal(&sourceSpec) &&
+            sourceSpec->IsObject()) {
+          if (GetStringProperty(isolate, sourceSpec.As<Object>(), "type") != "simulated") {
+            isolate->ThrowException(Exception::TypeError(
+                String::NewFromUtf8(isolate, "Unknown SMC transport").ToLocalChecked()));
+            return;
+          }
+          device = CreateSimDevice(isolate, sourceSpec.As<Object>());
+          if (!device) return;
+          source = &device->transport;
+        }
+
+        recorder = SMCTraceRecordCreate(path.c_str(), source);
+        if (!recorder) {
+          if (device) SMCSimDestroy(device);
+          ThrowTransportError(isolate, "Cannot create SMC trace file");
+          return;
+        }
+        transport = SMCTraceRecordTransport(recorder);
+      } else {
+        Local<Value> latency;
+        bool replayLatency =
+            spec->Get(context, String::NewFromUtf8(isolate, "latency").ToLocalChecked()).ToLocal(&latency) &&
+            latency->BooleanValue(isolate);
+
+        replay = SMCTraceReplayCreate(path.c_str(), replayLatency);
+        if (!replay) {
+          ThrowTransportError(isolate, "Cannot read SMC trace file");
+          return;
+        }
+        transport = SMCTraceReplayTransport(replay);
+      }
+    } else {
+      isolate->ThrowException(Exception::TypeError(
+          String::NewFromUtf8(isolate, "Unknown SMC transport").ToLocalChecked()));
+      return;
+    }
+  }
+
+  std::lock_guard<std::mutex> config(transport_config_lock);
+  SMCSetTransport(transport);
+  ResetTemperatureKeys();
+  chip_override = device ? device->chip : CHIP_UNKNOWN;
+
+  // The previous transport is closed now
+  if (trace_recorder) {
+    SMCTraceRecordDestroy(trace_recorder);
+  }
+  if (trace_replay) {
+    SMCTraceReplayDestroy(trace_replay);
+  }
+  if (sim_device) {
+    SMCSimDestroy(sim_device);
+  }
+  sim_device = device;
+  trace_recorder = recorder;
+  trace_replay = replay;
+}
+
+static bool ParseRefreshPolicy(const std::string &name, SMCRefreshPolicy *policy) {
+  if (name == "fast") *policy = SMC_REFRESH_FAST;
+  else if (name == "slow") *policy = SMC_REFRESH_SLOW;
+  else if (name == "static") *policy = SMC_REFRESH_STATIC;
+  else if (name == "on-demand") *policy = SMC_REFRESH_ON_DEMAND;
+  else return false;
+  return true;
+}
+
+// Metrics are SMC keys ("F0Mn") or battery fields ("battery.cycle_count")
+static bool IsBatteryMetric(const std::string &name) {
+  return name.compare(0, 8, "battery.") == 0;
+}
+
+static bool IsKeyMetric(const std::string &name) {
+  return !name.empty() && name.size() <= 4;
+}
+
+static void ThrowUnknownMetric(Isolate *isolate, const std::string &name) {
+  std::string message = "Unknown metric: " + name;
+  isolate->ThrowException(Exception::TypeError(
+      String::NewFromUtf8(isolate, message.c_str()).ToLocalChecked()));
+}
+
+// setRefreshPolicy({F0Ac: 'fast', 'battery.cycle_count': 'on-demand', ...})
+void SetRefreshPolicy(const FunctionCallbackInfo<Value> &args) {
+  Isolate *isolate = Isolate::GetCurrent();
+  HandleScope scope(isolate);
+  Local<v8::Context> context = isolate->GetCurrentContext();
+
+  if (args.Length() < 1 || !args[0]->IsObject()) {
+    isolate->ThrowException(Exception::TypeError(
+        String::NewFromUtf8(isolate, "Expected an object of metric policies").ToLocalChecked()));
+    return;
+  }
+
+  Local<Object> policies = args[0].As<Object>();
+  Local<Array> names = policies->GetOwnPropertyNames(context).ToLocalChecked();
+  for (uint32_t i = 0; i < names->Length(); i++) {
+    Local<Value> name = names->Get(context, i).ToLocalChecked();
+    String::Utf8Value metricName(isolate, name);
+    std::string metric(*metricName);
+    std::string policyName = GetStringProperty(isolate, policies, metric.c_str());
+
+    SMCRefreshPolicy policy;
+    if (!ParseRefreshPolicy(policyName, &policy)) {
+      std::string message = "Unknown refresh policy: " + policyName;
+      isolate->ThrowException(Exception::TypeError(
+          String::NewFromUtf8(isolate, message.c_str()).ToLocalChecked()));
+      return;
+    }
+
+    if (IsBatteryMetric(metric)) {
+      std::lock_guard<std::mutex> lock(battery_lock);
+      BatteryField *field = FindBatteryField(metric.c_str() + 8);
+      if (!field) {
+        ThrowUnknownMetric(isolate, metric);
+        return;
+      }
+      field->refresh.policy = policy;
+    } else if (IsKeyMetric(metric)) {
+      SMCSetKeyRefreshPolicy(SMCKeyFromString(metric.c_str()), policy);
+    } else {
+      ThrowUnknownMetric(isolate, metric);
+      return;
+    }
+  }
+}
+
+// setRefreshIntervals({fast_ms, slow_ms}); omitted values are kept
+void SetRefreshIntervals(const FunctionCallbackInfo<Value> &args) {
+  Isolate *isolate = Isolate::GetCurrent();
+  HandleScope scope(isolate);
+
+  SMCRefreshIntervals intervals = SMCGetRefreshIntervals();
+  if (args.Length() > 0 && args[0]->IsObject()) {
+    Local<Object> spec = args[0].As<Object>();
+    intervals.fast_ms = (uint32_t)GetIntProperty(isolate, spec, "fast_ms", (int)intervals.fast_ms);
+    intervals.slow_ms = (uint32_t)GetIntProperty(isolate, spec, "slow_ms", (int)intervals.slow_ms);
+  }
+  SMCSetRefreshIntervals(intervals);
 }
 
-NODE_MODULE(smc, Init)
+// requestRefresh(metrics?): re-read slow and on-demand metrics on their next
+// read; without an argument, every metric
+void RequestRefresh(const FunctionCallbackInfo<Value> &args) {
+  Isolate *isolate = Isolate::GetCurrent();
+  HandleScope scope(isolate);
+  Local<v8::Context> context = isolate->GetCurrentContext();
+
+  if (args.Length() < 1 || args[0]->IsNullOrUndefined()) {
+    SMCRequestKeyRefresh(NULL, 0);
+    std::lock_guard<std::mutex> lock(battery_lock);
+    for (size_t i = 0; i < battery_field_count; i++) {
+      battery_fields[i].refresh.requested = true;
+    }
+    return;
+  }
+
+  if (!args[0]->IsArray()) {
+    isolate->ThrowException(Exception::TypeError(
+        String::NewFromUtf8(isolate, "Expected an array of metric names").ToLocalChecked()));
+    return;
+  }
+
+  Local<Array> names = args[0].As<Array>();
+  for (uint32_t i = 0; i < names->Length(); i++) {
+    Local<Value> name;
+    if (!names->Get(context, i).ToLocal(&name) || !name->IsString()) {
+      isolate->ThrowException(Exception::TypeError(
+          String::NewFromUtf8(isolate, "Metric names must be strings").ToLocalChecked()));
+      return;
+    }
+    String::Utf8Value metricName(isolate, name);
+    std::string metric(*metricName);
+
+    if (IsBatteryMetric(metric)) {
+      std::lock_guard<std::mutex> lock(battery_lock);
+      BatteryField *field = FindBatteryField(metric.c_str() + 8);
+      if (!field) {
+        ThrowUnknownMetric(isolate, metric);
+        return;
+      }
+      field->refresh.requested = true;
+    } else if (IsKeyMetric(metric)) {
+      UInt32 key = SMCKeyFromString(metric.c_str());
+      SMCRequestKeyRefresh(&key, 1);
+    } else {
+      ThrowUnknownMetric(isolate, metric);
+      return;
+    }
+  }
+}
+
+static Local<Object> RefreshStatsObject(Isolate *isolate, const SMCRefreshStats &stats) {
+  Local<v8::Context> context = isolate->GetCurrentContext();
+  Local<Object> result = Object::New(isolate);
+
+  result->Set(context, String::NewFromUtf8(isolate, "ticks").ToLocalChecked(),
+              Number::New(isolate, static_cast<double>(stats.ticks))).Check();
+  result->Set(context, String::NewFromUtf8(isolate, "reads").ToLocalChecked(),
+              Number::New(isolate, static_cast<double>(stats.reads))).Check();
+  result->Set(context, String::NewFromUtf8(isolate, "skipped").ToLocalChecked(),
+              Number::New(isolate, static_cast<double>(stats.skipped))).Check();
+  result->Set(context, String::NewFromUtf8(isolate, "last_reads").ToLocalChecked(),
+              Number::New(isolate, stats.last_reads)).Check();
+  result->Set(context, String::NewFromUtf8(isolate, "last_skipped").ToLocalChecked(),
+              Number::New(isolate, stats.last_skipped)).Check();
+  return result;
+}
+
+// Reads done and skipped under the refresh policies, for SMC keys and battery
+void RefreshStats(const FunctionCallbackInfo<Value> &args) {
+  Isolate *isolate = Isolate::GetCurrent();
+  HandleScope scope(isolate);
+  Local<v8::Context> context = isolate->GetCurrentContext();
+
+  SMCRefreshStats batteryStats;
+  {
+    std::lock_guard<std::mutex> lock(battery_lock);
+    batteryStats = battery_refresh_stats;
+  }
+
+  Local<Object> result = Object::New(isolate);
+  result->Set(context, String::NewFromUtf8(isolate, "smc").ToLocalChecked(),
+              RefreshStatsObject(isolate, SMCGetKeyRefreshStats())).Check();
+  result->Set(context, String::NewFromUtf8(isolate, "battery").ToLocalChecked(),
+              RefreshStatsObject(isolate, batteryStats)).Check();
+  args.GetReturnValue().Set(result);
+}
+
+// Integer values of a JS array, appended to values; false if it is not one
+static bool AppendIntegers(Isolate *isolate, Local<Value> list, std::vector<int64_t> *values) {
+  Local<v8::Context> context = isolate->GetCurrentContext();
+  if (!list->IsArray()) {
+    return false;
+  }
+
+  Local<Array> array = list.As<Array>();
+  for (uint32_t i = 0; i < array->Length(); i++) {
+    Local<Value> value;
+    if (array->Get(context, i).ToLocal(&value)) {
+      values->push_back(value->IntegerValue(context).FromMaybe(0));
+    }
+  }
+  return true;
+}
+
+// Numbers of an optional array property; empty if it is missing
+static std::vector<double> GetNumberArray(Isolate *isolate, Local<Object> obj, const char *name) {
+  Local<v8::Context> context = isolate->GetCurrentContext();
+  std::vector<double> numbers;
+  Local<Value> value;
+  if (!obj->Get(context, String::NewFromUtf8(isolate, name).ToLocalChecked()).ToLocal(&value) ||
+      !value->IsArray()) {
+    return numbers;
+  }
+
+  Local<Array> array = value.As<Array>();
+  for (uint32_t i = 0; i < array->Length(); i++) {
+    Local<Value> item;
+    if (array->Get(context, i).ToLocal(&item)) {
+      numbers.push_back(item->NumberValue(context).FromMaybe(0.0));
+    }
+  }
+  return numbers;
+}
+
+// Build a canned source from {type: 'canned', channels: [{name, unit, values}]}.
+// values are raw integer channel deltas in unit (mJ by default), played one
+// per sample and repeated. A channel may name another group and subgroup
+// than the Energy Model; with states, it is a state channel and each of its
+// values is an array of residencies, one per state. Throws and returns NULL
+// on an unknown energy unit or residencies that do not match the states.
+static SMCPowerCanned *CreatePowerCanned(Isolate *isolate, Local<Object> spec) {
+  Local<v8::Context> context = isolate->GetCurrentContext();
+  SMCPowerCanned *canned = SMCPowerCannedCreate();
+
+  Local<Value> channels;
+  if (!spec->Get(context, String::NewFromUtf8(isolate, "channels").ToLocalChecked()).ToLocal(&channels) ||
+      !channels->IsArray()) {
+    return canned;
+  }
+
+  Local<Array> channelArray = channels.As<Array>();
+  for (uint32_t i = 0; i < channelArray->Length(); i++) {
+    Local<Value> entry;
+    if (!channelArray->Get(context, i).ToLocal(&entry) || !entry->IsObject()) continue;
+    Local<Object> channelObj = entry.As<Object>();
+
+    SMCReportChannelInfo info;
+    info.group = GetStringProperty(isolate, channelObj, "group");
+    info.subgroup = GetStringProperty(isolate, channelObj, "subgroup");
+    info.name = GetStringProperty(isolate, channelObj, "name");
+    info.unit = GetStringProperty(isolate, channelObj, "unit");
+    info.format = SMC_REPORT_SIMPLE;
+    info.offset = 0;
+    if (info.name.empty()) continue;
+
+    Local<Value> states;
+    if (channelObj->Get(context, String::NewFromUtf8(isolate, "states").ToLocalChecked()).ToLocal(&states) &&
+        states->IsArray()) {
+      info.format = SMC_REPORT_STATE;
+      Local<Array> stateArray = states.As<Array>();
+      for (uint32_t j = 0; j < stateArray->Length(); j++) {
+        Local<Value> state;
+        if (stateArray->Get(context, j).ToLocal(&state)) {
+          String::Utf8Value stateName(isolate, state);
+          info.states.push_back(*stateName ? *stateName : "");
+        }
+      }
+    }
+
+    // A state channel's samples are arrays of residencies; they are laid end to end
+    std::vector<int64_t> values;
+    Local<Value> valueList;
+    if (channelObj->Get(context, String::NewFromUtf8(isolate, "values").ToLocalChecked()).ToLocal(&valueList) &&
+        valueList->IsArray()) {
+      Local<Array> valueArray = valueList.As<Array>();
+      for (uint32_t j = 0; j < valueArray->Length(); j++) {
+        Local<Value> value;
+        if (!valueArray->Get(context, j).ToLocal(&value)) continue;
+        if (info.format != SMC_REPORT_STATE) {
+          values.push_back(value->IntegerValue(context).FromMaybe(0));
+        } else if (!AppendIntegers(isolate, value, &values)) {
+          values.push_back(0);  // Leaves the residencies ragged
+        }
+      }
+    }
+
+    bool energy = info.format == SMC_REPORT_SIMPLE && (info.group.empty() || info.group == "Energy Model");
+    bool added;
+    const char *error;
+    if (energy) {
+      added = SMCPowerCannedAddChannel(canned, info.name.c_str(), info.unit.empty() ? "mJ" : info.unit.c_str(), values);
+      error = "Unknown energy unit";
+    } else {
+      added = SMCPowerCannedAddReportChannel(canned, info, values);
+      error = "Residencies do not match the states";
+    }
+    if (!added) {
+      SMCPowerCannedDestroy(canned);
+      isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(isolate, error).ToLocalChecked()));
+      return NULL;
+    }
+  }
+
+  return canned;
+}
+
+// setPowerSource(spec?): sample power from a stand-in; without a spec, from
+// IOReport again. spec: {type: 'fake', cpu, gpu, ane, ram, gpu_ram, total,
+// fail_samples, fail_starts} or {type: 'canned', channels, dvfs}. dvfs: {ecpu, pcpu, gpu},
+// recorded DVFS tables in MHz standing in for this machine's.
+void SetPowerSource(const FunctionCallbackInfo<Value> &args) {
+  Isolate *isolate = Isolate::GetCurrent();
+  HandleScope scope(isolate);
+
+  SMCPowerFake *fake = NULL;
+  SMCPowerCanned *canned = NULL;
+  SMCDvfsTables dvfs = machine_dvfs;
+  if (args.Length() > 0 && !args[0]->IsNullOrUndefined()) {
+    std::string type = args[0]->IsObject() ? GetStringProperty(isolate, args[0].As<Object>(), "type") : "";
+    if (type != "fake" && type != "canned") {
+      isolate->ThrowException(Exception::TypeError(
+          String::NewFromUtf8(isolate, "Unknown power source").ToLocalChecked()));
+      return;
+    }
+
+    Local<Object> spec = args[0].As<Object>();
+    if (type == "canned") {
+      canned = CreatePowerCanned(isolate, spec);
+      if (!canned) {
+        return;
+      }
+
+      Local<Value> tables;
+      if (spec->Get(isolate->GetCurrentContext(), String::NewFromUtf8(isolate, "dvfs").ToLocalChecked()).ToLocal(&tables) &&
+          tables->IsObject()) {
+        dvfs.ecpu = GetNumberArray(isolate, tables.As<Object>(), "ecpu");
+        dvfs.pcpu = GetNumberArray(isolate, tables.As<Object>(), "pcpu");
+        dvfs.gpu = GetNumberArray(isolate, tables.As<Object>(), "gpu");
+      }
+    } else {
+      PowerMetrics watts;
+      watts.cpu = GetDoubleProperty(isolate, spec, "cpu", 0.0);
+      watts.gpu = GetDoubleProperty(isolate, spec, "gpu", 0.0);
+      watts.ane = GetDoubleProperty(isolate, spec, "ane", 0.0);
+      watts.ram = GetDoubleProperty(isolate, spec, "ram", 0.0);
+      watts.gpu_ram = GetDoubleProperty(isolate, spec, "gpu_ram", 0.0);
+      watts.total = GetDoubleProperty(isolate, spec, "total",
+                                      watts.cpu + watts.gpu + watts.ane + watts.ram + watts.gpu_ram);
+
+      fake = SMCPowerFakeCreate(watts);
+      fake->fail_samples = GetIntProperty(isolate, spec, "fail_samples", 0);
+      fake->fail_starts = GetIntProperty(isolate, spec, "fail_starts", 0);
+    }
+  }
+
+  // Stops the sampler, so the previous stand-in is no longer in use
+  std::lock_guard<std::mutex> config(transport_config_lock);
+  SMCSetPowerSource(fake ? &fake->source : canned ? &canned->source : NULL);
+  SMCSetDvfsTables(dvfs);
+  if (power_fake) {
+    SMCPowerFakeDestroy(power_fake);
+  }
+  if (power_canned) {
+    SMCPowerCannedDestroy(power_canned);
+  }
+  power_fake = fake;
+  power_canned = canned;
+}
+
+void SetPowerSamplerPeriod(const FunctionCallbackInfo<Value> &args) {
+  Isolate *isolate = Isolate::GetCurrent();
+  HandleScope scope(isolate);
+
+  uint32_t period = 0;
+  if (args.Length() > 0 && args[0]->IsNumber()) {
+    period = args[0]->Uint32Value(isolate->GetCurrentContext()).FromMaybe(0);
+  }
+  SMCSetPowerSamplerPeriod(period);
+}
+
+void StopPowerSampler(const FunctionCallbackInfo<Value> & /*args*/) {
+  SMCPowerSamplerStop();
+}
+
+// Sampler state and counters, with the age and window of the latest sample
+void PowerSamplerStats(const FunctionCallbackInfo<Value> &args) {
+  Isolate *isolate = Isolate::GetCurrent();
+  HandleScope scope(isolate);
+  Local<v8::Context> context = isolate->GetCurrentContext();
+
+  SMCPowerSamplerStats stats = SMCGetPowerSamplerStats();
+  bool sampled = stats.latest.samples > 0;
+  const char *source;
+  {
+    std::lock_guard<std::mutex> config(transport_config_lock);
+    source = power_fake ? "fake" : power_canned ? "canned" : "ioreport";
+  }
+
+  Local<Object> result = Object::New(isolate);
+  result->Set(context, String::NewFromUtf8(isolate, "running").ToLocalChecked(),
+              v8::Boolean::New(isolate, stats.running)).Check();
+  result->Set(context, String::NewFromUtf8(isolate, "source").ToLocalChecked(),
+              String::NewFromUtf8(isolate, source).ToLocalChecked()).Check();
+  result->Set(context, String::NewFromUtf8(isolate, "unavailable").ToLocalChecked(),
+              v8::Boolean::New(isolate, stats.unavailable)).Check();
+  result->Set(context, String::NewFromUtf8(isolate, "period_ms").ToLocalChecked(),
+              Number::New(isolate, stats.period_ms)).Check();
+  result->Set(context, String::NewFromUtf8(isolate, "samples").ToLocalChecked(),
+              Number::New(isolate, static_cast<double>(stats.samples))).Check();
+  result->Set(context, String::NewFromUtf8(isolate, "errors").ToLocalChecked(),
+              Number::New(isolate, static_cast<double>(stats.errors))).Check();
+  result->Set(context, String::NewFromUtf8(isolate, "reads").ToLocalChecked(),
+              Number::New(isolate, static_cast<double>(stats.reads))).Check();
+  result->Set(context, String::NewFromUtf8(isolate, "waits").ToLocalChecked(),
+              Number::New(isolate, static_cast<double>(stats.waits))).Check();
+  result->Set(context, String::NewFromUtf8(isolate, "sample_us").ToLocalChecked(),
+              Number::New(isolate, stats.sample_us)).Check();
+  result->Set(context, String::NewFromUtf8(isolate, "open_regions").ToLocalChecked(),
+              Number::New(isolate, static_cast<double>(SMCOpenEnergyRegions()))).Check();
+  Local<Array> groups = Array::New(isolate, (int)stats.groups.size());
+  for (size_t i = 0; i < stats.groups.size(); i++) {
+    groups->Set(context, (uint32_t)i, String::NewFromUtf8(isolate, stats.groups[i].c_str()).ToLocalChecked()).Check();
+  }
+  result->Set(context, String::NewFromUtf8(isolate, "groups").ToLocalChecked(), groups).Check();
+  result->Set(context, String::NewFromUtf8(isolate, "window_ms").ToLocalChecked(),
+              Number::New(isolate, sampled ? stats.latest.window_ms : 0.0)).Check();
+  result->Set(context, String::NewFromUtf8(isolate, "age_ms").ToLocalChecked(),
+              Number::New(isolate, sampled ? static_cast<double>(SMCRefreshNow() - stats.latest.sampled_at) : -1.0)).Check();
+  args.GetReturnValue().Set(result);
+}
+
+static const char *EnergyComponentName(SMCEnergyComponent component) {
+  switch (component) {
+    case ENERGY_CPU: return "cpu";
+    case ENERGY_GPU: return "gpu";
+    case ENERGY_ANE: return "ane";
+    case ENERGY_DRAM: return "ram";
+    case ENERGY_GPU_SRAM: return "gpu_ram";
+    case ENERGY_OTHER: break;
+  }
+  return "other";
+}
+
+// powerChannels(): every Energy Model channel seen since the power source
+// was installed, with its classification, the power of the latest window and
+// its energy so far. Like getAllPower(), the first call waits for a sample.
+void PowerChannels(const FunctionCallbackInfo<Value> &args) {
+  Isolate *isolate = Isolate::GetCurrent();
+  HandleScope scope(isolate);
+  Local<v8::Context> context = isolate->GetCurrentContext();
+
+  SMCPowerSnapshot snapshot;
+  SMCReadPowerSnapshot(&snapshot, SMCGetPowerSamplerPeriod() * 2 + 100);
+  std::vector<SMCEnergyChannel> channels = SMCGetEnergyChannels();
+
+  Local<Array> result = Array::New(isolate, channels.size());
+  for (size_t i = 0; i < channels.size(); i++) {
+    const SMCEnergyChannel &channel = channels[i];
+    const SMCEnergyClass &cls = channel.cls;
+
+    Local<Value> cluster = v8::Null(isolate);
+    if (cls.cluster_type) {
+      char label[16];
+      snprintf(label, sizeof(label), "%c%d", cls.cluster_type, cls.cluster);
+      cluster = String::NewFromUtf8(isolate, label).ToLocalChecked();
+    }
+
+    Local<Value> values[] = {
+      String::NewFromUtf8(isolate, channel.name.c_str()).ToLocalChecked(),
+      String::NewFromUtf8(isolate, EnergyComponentName(cls.component)).ToLocalChecked(),
+      cluster,
+      cls.core >= 0 ? Local<Value>(Number::New(isolate, cls.core)) : Local<Value>(v8::Null(isolate)),
+      Number::New(isolate, cls.die),
+      v8::Boolean::New(isolate, (cls.flags & SMC_ENERGY_IN_COMPONENT) != 0),
+      v8::Boolean::New(isolate, (cls.flags & SMC_ENERGY_IN_TOTAL) != 0),
+      v8::Boolean::New(isolate, (cls.flags & SMC_ENERGY_SRAM) != 0),
+      v8::Boolean::New(isolate, (cls.flags & SMC_ENERGY_DETAIL) != 0),
+      Number::New(isolate, channel.watts),
+      Number::New(isolate, channel.joules)
+    };
+    result->Set(context, i, ShapedObject(isolate, SHAPE_ENERGY_CHANNEL, values)).Check();
+  }
+  args.GetReturnValue().Set(result);
+}
+
+// energyCounters(): joules used by each component since power sampling first
+// started, and the steady-clock time in ms they were measured at. The counters
+// never go down; (b - a) / (b.time_ms - a.time_ms) is the mean power between
+// two reads. Like getAllPower(), the first call waits for a sample.
+void EnergyCounters(const FunctionCallbackInfo<Value> &args) {
+  Isolate *isolate = Isolate::GetCurrent();
+  HandleScope scope(isolate);
+
+  SMCPowerSnapshot snapshot;
+  SMCReadPowerSnapshot(&snapshot, SMCGetPowerSamplerPeriod() * 2 + 100);
+
+  Local<Value> values[] = {
+    Number::New(isolate, snapshot.joules.cpu),
+    Number::New(isolate, snapshot.joules.gpu),
+    Number::New(isolate, snapshot.joules.ane),
+    Number::New(isolate, snapshot.joules.ram),
+    Number::New(isolate, snapshot.joules.gpu_ram),
+    Number::New(isolate, snapshot.joules.total),
+    Number::New(isolate, snapshot.measured_us / 1000.0)
+  };
+  args.GetReturnValue().Set(ShapedObject(isolate, SHAPE_ENERGY_COUNTERS, values));
+}
+
+// beginEnergyRegion(): start measuring the energy of a stretch of work and
+// return its handle. Regions cost next to nothing and can overlap freely.
+void BeginEnergyRegion(const FunctionCallbackInfo<Value> &args) {
+  Isolate *isolate = Isolate::GetCurrent();
+  HandleScope scope(isolate);
+
+  uint64_t id = SMCBeginEnergyRegion();
+  if (id == 0) {
+    isolate->ThrowException(Exception::Error(
+        String::NewFromUtf8(isolate, "No power sample to begin an energy region from").ToLocalChecked()));
+    return;
+  }
+  args.GetReturnValue().Set(Number::New(isolate, static_cast<double>(id)));
+}
+
+static Local<Object> EnergyRegionMetrics(Isolate *isolate, const PowerMetrics &metrics) {
+  Local<Value> values[] = {
+    Number::New(isolate, metrics.cpu),
+    Number::New(isolate, metrics.gpu),
+    Number::New(isolate, metrics.ane),
+    Number::New(isolate, metrics.ram),
+    Number::New(isolate, metrics.gpu_ram),
+    Number::New(isolate, metrics.total)
+  };
+  return ShapedObject(isolate, SHAPE_ENERGY_REGION_METRICS, values);
+}
+
+// endEnergyRegion(handle): {joules, mean_watts, peak_watts, duration_ms,
+// samples} of a region; each region can be ended once
+void EndEnergyRegion(const FunctionCallbackInfo<Value> &args) {
+  Isolate *isolate = Isolate::GetCurrent();
+  HandleScope scope(isolate);
+
+  SMCEnergyRegionResult result;
+  uint64_t id = 0;
+  if (args.Length() > 0 && args[0]->IsNumber()) {
+    double handle = args[0]->NumberValue(isolate->GetCurrentContext()).FromMaybe(0);
+    id = handle >= 1 ? static_cast<uint64_t>(handle) : 0;
+  }
+  if (id == 0 || !SMCEndEnergyRegion(id, &result)) {
+    isolate->ThrowException(Exception::TypeError(
+        String::NewFromUtf8(isolate, "Unknown energy region").ToLocalChecked()));
+    return;
+  }
+
+  Local<Value> values[] = {
+    EnergyRegionMetrics(isolate, result.joules),
+    EnergyRegionMetrics(isolate, result.mean_watts),
+    EnergyRegionMetrics(isolate, result.peak_watts),
+    Number::New(isolate, result.duration_ms),
+    Number::New(isolate, static_cast<double>(result.samples))
+  };
+  args.GetReturnValue().Set(ShapedObject(isolate, SHAPE_ENERGY_REGION, values));
+}
+
+// Async getters
+//
+// Every getter above blocks the calling thread: SMC calls go through the
+// kernel, and the first getAllPower() waits for the power sampler's first
+// IOReport window. The *Async variants collect the same data on the libuv threadpool and build
+// the JS value and settle the promise back on the main thread, so the event
+// loop keeps running while the hardware is read.
+
+template <typename T>
+struct AsyncGetter {
+  uv_work_t request;
+  Isolate *isolate;
+  Global<v8::Context> context;
+  Global<Promise::Resolver> resolver;
+  std::function<T()> collect;
+  Local<Value> (*build)(Isolate *, T &);
+  T result;
+};
+
+template <typename T>
+static void AsyncGetterWork(uv_work_t *request) {
+  AsyncGetter<T> *work = static_cast<AsyncGetter<T> *>(request->data);
+  work->result = work->collect();
+}
+
+template <typename T>
+static void AsyncGetterDone(uv_work_t *request, int status) {
+  AsyncGetter<T> *work = static_cast<AsyncGetter<T> *>(request->data);
+  Isolate *isolate = work->isolate;
+  HandleScope scope(isolate);
+  Local<v8::Context> context = work->context.Get(isolate);
+  Context::Scope contextScope(context);
+
+  // Runs the promise reactions before returning to the loop
+  node::CallbackScope callbackScope(isolate, Object::New(isolate), {0, 0});
+
+  Local<Promise::Resolver> resolver = work->resolver.Get(isolate);
+  if (status == UV_ECANCELED) {
+    resolver->Reject(context, Exception::Error(
+        String::NewFromUtf8(isolate, "Request was cancelled").ToLocalChecked())).Check();
+  } else {
+    resolver->Resolve(context, work->build(isolate, work->result)).Check();
+  }
+
+  delete work;
+}
+
+template <typename T, typename Collect>
+static void QueueAsyncGetter(const FunctionCallbackInfo<Value> &args, Collect collect,
+                             Local<Value> (*build)(Isolate *, T &)) {
+  Isolate *isolate = Isolate::GetCurrent();
+  HandleScope scope(isolate);
+  Local<v8::Context> context = isolate->GetCurrentContext();
+  Local<Promise::Resolver> resolver = Promise::Resolver::New(context).ToLocalChecked();
+
+  AsyncGetter<T> *work = new AsyncGetter<T>();
+  work->request.data = work;
+  work->isolate = isolate;
+  work->context.Reset(isolate, context);
+  work->resolver.Reset(isolate, resolver);
+  work->collect = collect;
+  work->build = build;
+
+  uv_queue_work(node::GetCurrentEventLoop(isolate), &work->request,
+                AsyncGetterWork<T>, AsyncGetterDone<T>);
+  args.GetReturnValue().Set(resolver->GetPromise());
+}
+
+static void SetNumber(Isolate *isolate, Local<Object> obj, const char *name, double value) {
+  obj->Set(isolate->GetCurrentContext(), String::NewFromUtf8(isolate, name).ToLocalChecked(),
+           Number::New(isolate, value)).Check();
+}
+
+static void SetValue(Isolate *isolate, Local<Object> obj, const char *name, Local<Value> value) {
+  obj->Set(isolate->GetCurrentContext(), String::NewFromUtf8(isolate, name).ToLocalChecked(), value).Check();
+}
+
+typedef struct {
+  double temperature;
+  double temperature_die;
+  double voltage;
+} CpuReading;
+
+static CpuReading GetCpuReading() {
+  CpuReading reading;
+  SMCOpen();
+  reading.temperature = SMCGetTemperature();
+  reading.temperature_die = SMCGetCpuDieTemperature();
+  reading.voltage = SMCGetVoltage(SMC_FOURCC('V', 'C', '0', 'C'));
+  SMCClose();
+  return reading;
+}
+
+static Local<Value> CpuReadingObject(Isolate *isolate, CpuReading &reading) {
+  Local<Object> obj = Object::New(isolate);
+  SetNumber(isolate, obj, "temperature", reading.temperature);
+  SetNumber(isolate, obj, "temperature_die", reading.temperature_die);
+  SetNumber(isolate, obj, "voltage", reading.voltage);
+  return obj;
+}
+
+typedef struct {
+  double temperature;
+  double voltage;
+  double usage;
+} GpuReading;
+
+static GpuReading GetGpuReading() {
+  GpuReading reading;
+  reading.temperature = GetGpuTemperature();
+  SMCOpen();
+  reading.voltage = SMCGetVoltage(SMC_FOURCC('V', 'G', '0', 'C'));
+  SMCClose();
+  reading.usage = GetGpuUsage();
+  return reading;
+}
+
+static Local<Value> GpuReadingObject(Isolate *isolate, GpuReading &reading) {
+  Local<Object> obj = Object::New(isolate);
+  SetNumber(isolate, obj, "temperature", reading.temperature);
+  SetNumber(isolate, obj, "voltage", reading.voltage);
+  SetNumber(isolate, obj, "usage", reading.usage);
+  return obj;
+}
+
+static double GetMemoryVoltage() {
+  SMCOpen();
+  double voltage = SMCGetVoltage(SMC_FOURCC('V', 'M', '0', 'R'));
+  SMCClose();
+  return voltage;
+}
+
+static Local<Value> NumberValue(Isolate *isolate, double &value) {
+  return Number::New(isolate, value);
+}
+
+// F<n>Ac, F<n>Mn and F<n>Mx for every fan, in one batch
+typedef struct {
+  int count;
+  std::vector<double> values;
+} FanReading;
+
+static FanReading GetFanReading() {
+  FanReading reading;
+  SMCOpen();
+  reading.count = SMCGetFanNumber();
+
+  std::vector<UInt32> keys;
+  for (int i = 0; i < reading.count; i++) {
+    keys.push_back(SMC_FAN_KEY(i, 'A', 'c'));
+    keys.push_back(SMC_FAN_KEY(i, 'M', 'n'));
+    keys.push_back(SMC_FAN_KEY(i, 'M', 'x'));
+  }
+  reading.values.resize(keys.size());
+  std::vector<int32_t> status(keys.size());
+  if (!keys.empty()) {
+    SMCReadKeys(keys.data(), keys.size(), reading.values.data(), status.data());
+  }
+  SMCClose();
+  return reading;
+}
+
+static Local<Value> FanReadingObject(Isolate *isolate, FanReading &reading) {
+  size_t count = reading.values.size();
+  Local<Float64Array> values = Float64Array::New(ArrayBuffer::New(isolate, count * sizeof(double)), 0, count);
+  if (count > 0) {
+    memcpy(values->Buffer()->Data(), reading.values.data(), count * sizeof(double));
+  }
+
+  Local<Object> obj = Object::New(isolate);
+  SetNumber(isolate, obj, "count", reading.count);
+  SetValue(isolate, obj, "values", values);
+  return obj;
+}
+
+typedef struct {
+  PowerMetrics metrics;
+  double system;
+} PowerReading;
+
+static PowerReading GetPowerReading() {
+  PowerReading reading;
+  reading.metrics = GetAllPowerMetrics();
+  reading.system = GetSystemPower();
+  return reading;
+}
+
+static Local<Value> PowerReadingObject(Isolate *isolate, PowerReading &reading) {
+  return PowerObject(isolate, reading.metrics, reading.system);
+}
+
+typedef struct {
+  IOKitSensorList temperatures;
+  IOKitSensorList voltages;
+  IOKitSensorList currents;
+} SensorReading;
+
+static SensorReading GetSensorReading() {
+  SensorReading reading;
+  reading.temperatures = GetIOKitTemperatureSensors();
+  reading.voltages = GetIOKitVoltageSensors();
+  reading.currents = GetIOKitCurrentSensors();
+  return reading;
+}
+
+static Local<Value> SensorReadingObject(Isolate *isolate, SensorReading &reading) {
+  Local<Object> obj = Object::New(isolate);
+  SetValue(isolate, obj, "temperatures", SensorArray(isolate, reading.temperatures));
+  SetValue(isolate, obj, "voltages", SensorArray(isolate, reading.voltages));
+  SetValue(isolate, obj, "currents", SensorArray(isolate, reading.currents));
+  return obj;
+}
+
+static Local<Value> SystemInfoValue(Isolate *isolate, SystemInfo &info) {
+  return SystemInfoObject(isolate, info);
+}
+
+static Local<Value> RAMUsageValue(Isolate *isolate, RAMUsage &usage) {
+  return RAMUsageObject(isolate, usage);
+}
+
+static Local<Value> BatteryValue(Isolate *isolate, BatteryInfo &info) {
+  return BatteryObject(isolate, info);
+}
+
+static Local<Value> CPUUsageValue(Isolate *isolate, CPUUsage &usage) {
+  return CPUUsageObject(isolate, usage);
+}
+
+static Local<Value> DiskListValue(Isolate *isolate, DiskList &diskList) {
+  return DiskListArray(isolate, diskList);
+}
+
+void GetCpuDataAsync(const FunctionCallbackInfo<Value> &args) {
+  QueueAsyncGetter(args, GetCpuReading, CpuReadingObject);
+}
+
+void GetGpuDataAsync(const FunctionCallbackInfo<Value> &args) {
+  QueueAsyncGetter(args, GetGpuReading, GpuReadingObject);
+}
+
+void MemoryVoltageAsync(const FunctionCallbackInfo<Value> &args) {
+  QueueAsyncGetter(args, GetMemoryVoltage, NumberValue);
+}
+
+void GetFanDataAsync(const FunctionCallbackInfo<Value> &args) {
+  QueueAsyncGetter(args, GetFanReading, FanReadingObject);
+}
+
+void GetAllPowerAsync(const FunctionCallbackInfo<Value> &args) {
+  QueueAsyncGetter(args, GetPowerReading, PowerReadingObject);
+}
+
+void GetSensorDataAsync(const FunctionCallbackInfo<Value> &args) {
+  QueueAsyncGetter(args, GetSensorReading, SensorReadingObject);
+}
+
+void GetSystemDataAsync(const FunctionCallbackInfo<Value> &args) {
+  QueueAsyncGetter(args, GetSystemInfo, SystemInfoValue);
+}
+
+void GetRAMUsageDataAsync(const FunctionCallbackInfo<Value> &args) {
+  QueueAsyncGetter(args, GetRAMUsage, RAMUsageValue);
+}
+
+void GetBatteryDataAsync(const FunctionCallbackInfo<Value> &args) {
+  QueueAsyncGetter(args, GetBatteryInfo, BatteryValue);
+}
+
+void GetCPUUsageDataAsync(const FunctionCallbackInfo<Value> &args) {
+  QueueAsyncGetter(args, GetCPUUsage, CPUUsageValue);
+}
+
+void GetDiskDataAsync(const FunctionCallbackInfo<Value> &args) {
+  QueueAsyncGetter(args, GetDiskInfo, DiskListValue);
+}
+
+// snapshot(mask): every requested subsystem in one native call, sharing one
+// SMC connection and one HID event system client, as one object. Bits match
+// SnapshotMetric in src/snapshot.ts.
+enum SnapshotMetric {
+  SNAPSHOT_SYSTEM = 1 << 0,
+  SNAPSHOT_CPU = 1 << 1,
+  SNAPSHOT_CPU_USAGE = 1 << 2,
+  SNAPSHOT_GPU = 1 << 3,
+  SNAPSHOT_MEMORY = 1 << 4,
+  SNAPSHOT_RAM = 1 << 5,
+  SNAPSHOT_BATTERY = 1 << 6,
+  SNAPSHOT_SENSORS = 1 << 7,
+  SNAPSHOT_FANS = 1 << 8,
+  SNAPSHOT_DISKS = 1 << 9,
+  SNAPSHOT_POWER = 1 << 10,
+  SNAPSHOT_ALL = (1 << 11) - 1
+};
+
+typedef struct {
+  uint32_t mask;
+  SystemInfo system;
+  CpuReading cpu;
+  CPUUsage cpu_usage;
+  GpuReading gpu;
+  double memory_voltage;
+  RAMUsage ram;
+  BatteryInfo battery;
+  SensorReading sensors;
+  FanReading fans;
+  DiskList disks;
+  PowerReading power;
+} Snapshot;
+
+// ticks is the caller's own CPU usage baseline; NULL uses getCPUUsage()'s
+static Snapshot CollectSnapshot(uint32_t mask, CPUTicks *ticks = NULL) {
+  Snapshot snapshot = {};
+  snapshot.mask = mask;
+
+  // Held open across every SMC read below
+  SMCOpen();
+
+  if (mask & SNAPSHOT_SENSORS) {
+    IOHIDEventSystemClientRef system = IOHIDEventSystemClientCreate(kCFAllocatorDefault);
+    if (system) {
+      // kHIDPage_AppleVendor temperature, kHIDPage_AppleVendorPowerSensor voltage and current
+      snapshot.sensors.temperatures = CopyIOKitSensors(system, 0xff00, 5, kIOHIDEventTypeTemperature);
+      snapshot.sensors.voltages = CopyIOKitSensors(system, 0xff08, 3, kIOHIDEventTypePower);
+      snapshot.sensors.currents = CopyIOKitSensors(system, 0xff08, 2, kIOHIDEventTypePower);
+      CFRelease(system);
+    }
+  }
+
+  if (mask & SNAPSHOT_CPU) {
+    snapshot.cpu = GetCpuReading();
+  }
+  if (mask & SNAPSHOT_GPU) {
+    // The temperature sensors were just read for the sensor list
+    double temperature = 0.0;
+    if (mask & SNAPSHOT_SENSORS) {
+      temperature = GpuSensorTemperature(snapshot.sensors.temperatures);
+    } else {
+      IOKitSensorList temperatures = GetIOKitTemperatureSensors();
+      temperature = GpuSensorTemperature(temperatures);
+      FreeIOKitSensorList(temperatures);
+    }
+    snapshot.gpu.temperature = temperature > 0.0 ? temperature : SMCGetGpuTemperature();
+    snapshot.gpu.voltage = SMCGetVoltage(SMC_FOURCC('V', 'G', '0', 'C'));
+    snapshot.gpu.usage = GetGpuUsage();
+  }
+  if (mask & SNAPSHOT_MEMORY) {
+    snapshot.memory_voltage = GetMemoryVoltage();
+  }
+  if (mask & SNAPSHOT_FANS) {
+    snapshot.fans = GetFanReading();
+  }
+  if (mask & SNAPSHOT_POWER) {
+    snapshot.power = GetPowerReading();
+  }
+
+  SMCClose();
+
+  if (mask & SNAPSHOT_SYSTEM) {
+    snapshot.system = GetSystemInfo();
+  }
+  if (mask & SNAPSHOT_CPU_USAGE) {
+    snapshot.cpu_usage = ticks ? CPUUsageSince(ticks) : GetCPUUsage();
+  }
+  if (mask & SNAPSHOT_RAM) {
+    snapshot.ram = GetRAMUsage();
+  }
+  if (mask & SNAPSHOT_BATTERY) {
+    snapshot.battery = GetBatteryInfo();
+  }
+  if (mask & SNAPSHOT_DISKS) {
+    snapshot.disks = GetDiskInfo();
+  }
+
+  return snapshot;
+}
+
+static Local<Value> SnapshotObject(Isolate *isolate, Snapshot &snapshot) {
+  Local<Object> obj = Object::New(isolate);
+  uint32_t mask = snapshot.mask;
+
+  if (mask & SNAPSHOT_SYSTEM) {
+    SetValue(isolate, obj, "system", SystemInfoObject(isolate, snapshot.system));
+  }
+  if (mask & SNAPSHOT_CPU) {
+    SetValue(isolate, obj, "cpu", CpuReadingObject(isolate, snapshot.cpu));
+  }
+  if (mask & SNAPSHOT_CPU_USAGE) {
+    SetValue(isolate, obj, "cpu_usage", CPUUsageObject(isolate, snapshot.cpu_usage));
+  }
+  if (mask & SNAPSHOT_GPU) {
+    SetValue(isolate, obj, "gpu", GpuReadingObject(isolate, snapshot.gpu));
+  }
+  if (mask & SNAPSHOT_MEMORY) {
+    SetNumber(isolate, obj, "memory_voltage", snapshot.memory_voltage);
+  }
+  if (mask & SNAPSHOT_RAM) {
+    SetValue(isolate, obj, "ram", RAMUsageObject(isolate, snapshot.ram));
+  }
+  if (mask & SNAPSHOT_BATTERY) {
+    SetValue(isolate, obj, "battery", BatteryObject(isolate, snapshot.battery));
+  }
+  if (mask & SNAPSHOT_SENSORS) {
+    SetValue(isolate, obj, "sensors", SensorReadingObject(isolate, snapshot.sensors));
+  }
+  if (mask & SNAPSHOT_FANS) {
+    SetValue(isolate, obj, "fans", FanReadingObject(isolate, snapshot.fans));
+  }
+  if (mask & SNAPSHOT_DISKS) {
+    SetValue(isolate, obj, "disks", DiskListArray(isolate, snapshot.disks));
+  }
+  if (mask & SNAPSHOT_POWER) {
+    SetValue(isolate, obj, "power", PowerReadingObject(isolate, snapshot.power));
+  }
+  return obj;
+}
+
+// Mask from the first argument; every subsystem without one
+static bool SnapshotMask(const FunctionCallbackInfo<Value> &args, uint32_t *mask) {
+  Isolate *isolate = Isolate::GetCurrent();
+  *mask = SNAPSHOT_ALL;
+
+  if (args.Length() > 0 && !args[0]->IsUndefined()) {
+    if (!args[0]->IsUint32() || (args[0].As<Uint32>()->Value() & ~SNAPSHOT_ALL)) {
+      isolate->ThrowException(Exception::TypeError(
+          String::NewFromUtf8(isolate, "Snapshot mask must be a combination of SnapshotMetric bits").ToLocalChecked()));
+      return false;
+    }
+    *mask = args[0].As<Uint32>()->Value();
+  }
+  return true;
+}
+
+void TakeSnapshot(const FunctionCallbackInfo<Value> &args) {
+  Isolate *isolate = Isolate::GetCurrent();
+  HandleScope scope(isolate);
+
+  uint32_t mask;
+  if (!SnapshotMask(args, &mask)) return;
+
+  Snapshot snapshot = CollectSnapshot(mask);
+  args.GetReturnValue().Set(SnapshotObject(isolate, snapshot));
+}
+
+void TakeSnapshotAsync(const FunctionCallbackInfo<Value> &args) {
+  uint32_t mask;
+  if (!SnapshotMask(args, &mask)) return;
+
+  QueueAsyncGetter(args, [mask] { return CollectSnapshot(mask); }, SnapshotObject);
+}
+
+// Frees what a snapshot collected but SnapshotObject() did not consume
+static void FreeSnapshot(Snapshot &snapshot) {
+  if (snapshot.mask & SNAPSHOT_SENSORS) {
+    FreeIOKitSensorList(snapshot.sensors.temperatures);
+    FreeIOKitSensorList(snapshot.sensors.voltages);
+    FreeIOKitSensorList(snapshot.sensors.currents);
+  }
+  if ((snapshot.mask & SNAPSHOT_DISKS) && snapshot.disks.disks) {
+    free(snapshot.disks.disks);
+  }
+}
+
+// Subscriptions
+//
+// subscribe(mask, interval_ms, capacity, coalesce, callback): a thread per
+// subscription takes a snapshot every interval_ms and pushes it into a
+// bounded ring; a uv_async handle wakes the JS thread, which drains the ring
+// and calls back with every pending sample as one batch. When JS falls
+// behind, a full ring drops its oldest sample; with coalesce, only the newest
+// pending sample is delivered and the others are counted as coalesced.
+
+typedef struct {
+  double timestamp;  // ms since the epoch
+  Snapshot snapshot;
+} SubscriptionSample;
+
+struct Subscription {
+  uint32_t id;
+  uint32_t mask;
+  uint32_t interval_ms;
+  bool coalesce;
+  SMCRing *ring;
+  uv_async_t async;
+  Isolate *isolate;
+  Global<v8::Context> context;
+  Global<Function> callback;
+  std::thread *thread;
+  std::mutex lock;
+  std::condition_variable wake;
+  bool stopping;
+  CPUTicks ticks;                   // CPU usage baseline, sampling thread only
+  std::atomic<uint64_t> samples;    // Taken by the sampling thread
+  std::atomic<uint64_t> dropped;    // Evicted from a full ring
+  std::atomic<uint64_t> coalesced;  // Replaced by a newer pending sample
+  uint64_t delivered;               // Passed to the callback
+  uint64_t batches;                 // Callback invocations
+};
+
+// Per environment, on its JS thread: the delivery handles are on its loop
+static thread_local std::unordered_map<uint32_t, Subscription *> subscriptions;
+static thread_local uint32_t next_subscription_id = 1;
+
+static void FreeSubscriptionSample(SubscriptionSample *sample) {
+  FreeSnapshot(sample->snapshot);
+  delete sample;
+}
+
+static void SubscriptionLoop(Subscription *sub) {
+  std::chrono::steady_clock::time_point next = std::chrono::steady_clock::now();
+
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(sub->lock);
+      // Keep a fixed schedule; after an overrun, start again from now
+      next += std::chrono::milliseconds(sub->interval_ms);
+      if (next < std::chrono::steady_clock::now()) {
+        next = std::chrono::steady_clock::now();
+      }
+      sub->wake.wait_until(lock, next, [sub] { return sub->stopping; });
+      if (sub->stopping) {
+        return;
+      }
+    }
+
+    SubscriptionSample *sample = new SubscriptionSample();
+    sample->timestamp = std::chrono::duration<double, std::milli>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    sample->snapshot = CollectSnapshot(sub->mask, &sub->ticks);
+    sub->samples++;
+
+    SubscriptionSample *evicted = (SubscriptionSample *)SMCRingPush(sub->ring, sample);
+    if (evicted) {
+      (sub->coalesce ? sub->coalesced : sub->dropped)++;
+      FreeSubscriptionSample(evicted);
+    }
+    uv_async_send(&sub->async);
+  }
+}
+
+static void DeliverSamples(uv_async_t *handle) {
+  Subscription *sub = (Subscription *)handle->data;
+  Isolate *isolate = sub->isolate;
+  HandleScope scope(isolate);
+  Local<v8::Context> context = sub->context.Get(isolate);
+  Context::Scope contextScope(context);
+
+  std::vector<SubscriptionSample *> pending;
+  SubscriptionSample *sample;
+  while ((sample = (SubscriptionSample *)SMCRingPop(sub->ring)) != NULL) {
+    pending.push_back(sample);
+  }
+  if (pending.empty()) {
+    return;
+  }
+
+  if (sub->coalesce && pending.size() > 1) {
+    for (size_t i = 0; i + 1 < pending.size(); i++) {
+      FreeSubscriptionSample(pending[i]);
+    }
+    sub->coalesced += pending.size() - 1;
+    pending.erase(pending.begin(), pending.end() - 1);
+  }
+
+  Local<Array> batch = Array::New(isolate, (int)pending.size());
+  for (size_t i = 0; i < pending.size(); i++) {
+    Local<Object> obj = SnapshotObject(isolate, pending[i]->snapshot).As<Object>();
+    SetNumber(isolate, obj, "timestamp", pending[i]->timestamp);
+    batch->Set(context, (uint32_t)i, obj).Check();
+    delete pending[i];  // SnapshotObject() consumed the lists
+  }
+  sub->delivered += pending.size();
+  sub->batches++;
+
+  Local<Value> argv[] = {batch};
+  node::MakeCallback(isolate, context->Global(), sub->callback.Get(isolate), 1, argv, {0, 0});
+}
+
+static void CloseSubscription(uv_handle_t *handle) {
+  Subscription *sub = (Subscription *)handle->data;
+  SubscriptionSample *sample;
+  while ((sample = (SubscriptionSample *)SMCRingPop(sub->ring)) != NULL) {
+    FreeSubscriptionSample(sample);
+  }
+  SMCRingDestroy(sub->ring);
+  delete sub;
+}
+
+static void StopSubscription(Subscription *sub) {
+  {
+    std::lock_guard<std::mutex> lock(sub->lock);
+    sub->stopping = true;
+  }
+  sub->wake.notify_all();
+  sub->thread->join();
+  delete sub->thread;
+  sub->thread = NULL;
+
+  subscriptions.erase(sub->id);
+  uv_close((uv_handle_t *)&sub->async, CloseSubscription);
+}
+
+void Subscribe(const FunctionCallbackInfo<Value> &args) {
+  Isolate *isolate = Isolate::GetCurrent();
+  HandleScope scope(isolate);
+  Local<v8::Context> context = isolate->GetCurrentContext();
+
+  uint32_t mask;
+  if (!SnapshotMask(args, &mask)) return;
+  if (args.Length() < 5 || !args[1]->IsUint32() || !args[2]->IsUint32() || !args[4]->IsFunction() ||
+      args[1].As<Uint32>()->Value() == 0 || args[2].As<Uint32>()->Value() == 0) {
+    isolate->ThrowException(Exception::TypeError(
+        String::NewFromUtf8(isolate, "Expected (mask, interval_ms, capacity, coalesce, callback)").ToLocalChecked()));
+    return;
+  }
+
+  Subscription *sub = new Subscription();
+  sub->id = next_subscription_id++;
+  sub->mask = mask;
+  sub->interval_ms = args[1].As<Uint32>()->Value();
+  sub->coalesce = args[3]->BooleanValue(isolate);
+  sub->ring = SMCRingCreate(args[2].As<Uint32>()->Value());
+  sub->isolate = isolate;
+  sub->context.Reset(isolate, context);
+  sub->callback.Reset(isolate, args[4].As<Function>());
+  sub->stopping = false;
+  // Primed so the first sample's usage covers the first interval
+  sub->ticks = {0, 0, 0, 0, false};
+  CPUUsageSince(&sub->ticks);
+  sub->samples = 0;
+  sub->dropped = 0;
+  sub->coalesced = 0;
+  sub->delivered = 0;
+  sub->batches = 0;
+
+  uv_async_init(node::GetCurrentEventLoop(isolate), &sub->async, DeliverSamples);
+  sub->async.data = sub;
+  sub->thread = new std::thread(SubscriptionLoop, sub);
+  subscriptions[sub->id] = sub;
+
+  args.GetReturnValue().Set(Number::New(isolate, sub->id));
+}
+
+static Subscription *FindSubscription(const FunctionCallbackInfo<Value> &args) {
+  if (args.Length() < 1 || !args[0]->IsUint32()) {
+    return NULL;
+  }
+  auto found = subscriptions.find(args[0].As<Uint32>()->Value());
+  return found != subscriptions.end() ? found->second : NULL;
+}
+
+// Samples still queued are discarded
+void Unsubscribe(const FunctionCallbackInfo<Value> &args) {
+  Subscription *sub = FindSubscription(args);
+  if (sub) {
+    StopSubscription(sub);
+  }
+}
+
+void SubscriptionStats(const FunctionCallbackInfo<Value> &args) {
+  Isolate *isolate = Isolate::GetCurrent();
+  HandleScope scope(isolate);
+
+  Subscription *sub = FindSubscription(args);
+  if (!sub) {
+    args.GetReturnValue().Set(Undefined(isolate));
+    return;
+  }
+
+  Local<Object> result = Object::New(isolate);
+  SetNumber(isolate, result, "samples", static_cast<double>(sub->samples.load()));
+  SetNumber(isolate, result, "delivered", static_cast<double>(sub->delivered));
+  SetNumber(isolate, result, "dropped", static_cast<double>(sub->dropped.load()));
+  SetNumber(isolate, result, "coalesced", static_cast<double>(sub->coalesced.load()));
+  SetNumber(isolate, result, "batches", static_cast<double>(sub->batches));
+  SetNumber(isolate, result, "pending", static_cast<double>(SMCRingSize(sub->ring)));
+  args.GetReturnValue().Set(result);
+}
+
+// Shared metrics block: one writer thread samples RAM usage, CPU usage and
+// power every interval_ms into a block that every environment maps as the
+// same SharedArrayBuffer, so any number of consumers on any thread read the
+// latest sample without calling in.
+static std::mutex block_lock;  // Guards everything below
+static std::condition_variable block_wake;
+static SMCBlock *metrics_block = NULL;  // Never freed: buffers on other threads may outlive a stop
+static std::shared_ptr<BackingStore> block_store;
+static std::thread *block_thread = NULL;
+static bool block_stopping = false;
+static uint32_t block_interval_ms = 1000;
+
+static void BlockWriterLoop() {
+  CPUTicks ticks = {0, 0, 0, 0, false};
+  CPUUsageSince(&ticks);
+  std::vector<double> values(BLOCK_VALUE_COUNT, 0.0);
+  uint64_t samples = 0;
+  std::chrono::steady_clock::time_point next = std::chrono::steady_clock::now();
+
+  std::unique_lock<std::mutex> lock(block_lock);
+  while (!block_stopping) {
+    uint32_t interval_ms = block_interval_ms;
+    lock.unlock();
+
+    // CPU usage covers the time since the previous sample
+    RAMUsage ram = GetRAMUsage();
+    CPUUsage cpu = CPUUsageSince(&ticks);
+    PowerMetrics power = GetAllPowerMetrics();
+    double systemPower = GetSystemPower();
+
+    values[0] = (double)++samples;
+    values[1] = std::chrono::duration<double, std::milli>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    values[2] = interval_ms;
+    WriteRAMUsage(&values[BLOCK_RAM_USAGE], ram);
+    WriteCPUUsage(&values[BLOCK_CPU_USAGE], cpu);
+    WritePower(&values[BLOCK_POWER], power, systemPower);
+    SMCBlockWrite(metrics_block, values.data());
+
+    lock.lock();
+    // Keep a fixed schedule; after an overrun, start again from now
+    next += std::chrono::milliseconds(interval_ms);
+    if (next < std::chrono::steady_clock::now()) {
+      next = std::chrono::steady_clock::now();
+    }
+    block_wake.wait_until(lock, next, [] { return block_stopping; });
+  }
+}
+
+static void KeepBlockMemory(void * /*data*/, size_t /*length*/, void * /*deleter_data*/) {
+}
+
+static void StopBlockWriter() {
+  std::unique_lock<std::mutex> lock(block_lock);
+  if (!block_thread) {
+    return;
+  }
+
+  block_stopping = true;
+  block_wake.notify_all();
+  std::thread *thread = block_thread;
+  block_thread = NULL;
+  lock.unlock();
+  thread->join();
+  delete thread;
+}
+
+// metricsBlock(interval_ms?) -> SharedArrayBuffer with the latest sample;
+// starts the writer or changes its interval
+void MetricsBlock(const FunctionCallbackInfo<Value> &args) {
+  Isolate *isolate = Isolate::GetCurrent();
+  HandleScope scope(isolate);
+
+  std::lock_guard<std::mutex> lock(block_lock);
+  if (args.Length() > 0 && args[0]->IsUint32() && args[0].As<Uint32>()->Value() > 0) {
+    block_interval_ms = args[0].As<Uint32>()->Value();
+    block_wake.notify_all();
+  }
+
+  if (!metrics_block) {
+    metrics_block = SMCBlockCreate(BLOCK_VALUE_COUNT, BLOCK_VERSION);
+    block_store = SharedArrayBuffer::NewBackingStore(metrics_block->memory, metrics_block->bytes,
+                                                     KeepBlockMemory, NULL);
+  }
+  if (!block_thread) {
+    block_stopping = false;
+    block_thread = new std::thread(BlockWriterLoop);
+  }
+
+  args.GetReturnValue().Set(SharedArrayBuffer::New(isolate, block_store));
+}
+
+// The block keeps its last sample
+void StopMetricsBlock(const FunctionCallbackInfo<Value> & /*args*/) {
+  StopBlockWriter();
+}
+
+// Environments with the addon loaded: the main thread and any workers. They
+// share the SMC connection, the caches and the power sampler, which the last
+// one to exit shuts down.
+static std::mutex environments_lock;
+static int environments = 0;
+
+static void Cleanup(void * /*arg*/) {
+  while (!subscriptions.empty()) {
+    StopSubscription(subscriptions.begin()->second);
+  }
+
+  // The handles themselves go with the isolate
+  delete object_shapes;
+  object_shapes = NULL;
+
+  std::lock_guard<std::mutex> lock(environments_lock);
+  if (--environments > 0) {
+    return;
+  }
+
+  StopBlockWriter();
+  SMCPowerSamplerStop();
+  SMCShutdown();
+
+  // Flush and close a trace still being recorded
+  std::lock_guard<std::mutex> config(transport_config_lock);
+  if (trace_recorder) {
+    SMCSetTransport(NULL);
+    SMCTraceRecordDestroy(trace_recorder);
+    trace_recorder = NULL;
+  }
+}
+
+static void Init(Local<Object> exports, Local<v8::Context> context) {
+  NODE_SET_METHOD(exports, "temperature", Temperature);
+  NODE_SET_METHOD(exports, "cpuTemperatureDie", CpuTemperatureDie);
+  NODE_SET_METHOD(exports, "gpuTemperature", GpuTemperature);
+  NODE_SET_METHOD(exports, "gpuUsage", GpuUsage);
+  NODE_SET_METHOD(exports, "fans", Fans);
+  NODE_SET_METHOD(exports, "fanRpm", FanRpm);
+  NODE_SET_METHOD(exports, "fanMin", FanMin);
+  NODE_SET_METHOD(exports, "fanMax", FanMax);
+  NODE_SET_METHOD(exports, "getAllPower", GetAllPower);
+  NODE_SET_METHOD(exports, "cpuVoltage", CpuVoltage);
+  NODE_SET_METHOD(exports, "gpuVoltage", GpuVoltage);
+  NODE_SET_METHOD(exports, "memoryVoltage", MemoryVoltage);
+  NODE_SET_METHOD(exports, "getAllTemperatureSensors", GetAllTemperatureSensors);
+  NODE_SET_METHOD(exports, "getAllVoltageSensors", GetAllVoltageSensors);
+  NODE_SET_METHOD(exports, "getAllCurrentSensors", GetAllCurrentSensors);
+  NODE_SET_METHOD(exports, "getBatteryData", GetBatteryData);
+  NODE_SET_METHOD(exports, "getSystemData", GetSystemData);
+  NODE_SET_METHOD(exports, "getRAMUsageData", GetRAMUsageData);
+  NODE_SET_METHOD(exports, "getCPUUsageData", GetCPUUsageData);
+  NODE_SET_METHOD(exports, "cpuFrequencies", CpuFrequencies);
+  NODE_SET_METHOD(exports, "gpuFrequency", GpuFrequency);
+  NODE_SET_METHOD(exports, "gpuMemory", GpuMemory);
+  NODE_SET_METHOD(exports, "getDiskData", GetDiskData);
+  NODE_SET_METHOD(exports, "metricsSchema", MetricsSchema);
+  NODE_SET_METHOD(exports, "metricsBlock", MetricsBlock);
+  NODE_SET_METHOD(exports, "stopMetricsBlock", StopMetricsBlock);
+  NODE_SET_METHOD(exports, "compileKeys", CompileKeys);
+  NODE_SET_METHOD(exports, "readKeys", ReadKeys);
+  NODE_SET_METHOD(exports, "smcStats", SmcStats);
+  NODE_SET_METHOD(exports, "smcKeys", SmcKeys);
+  NODE_SET_METHOD(exports, "setTransport", SetTransport);
+  NODE_SET_METHOD(exports, "setRefreshPolicy", SetRefreshPolicy);
+  NODE_SET_METHOD(exports, "setRefreshIntervals", SetRefreshIntervals);
+  NODE_SET_METHOD(exports, "requestRefresh", RequestRefresh);
+  NODE_SET_METHOD(exports, "refreshStats", RefreshStats);
+  NODE_SET_METHOD(exports, "setPowerSource", SetPowerSource);
+  NODE_SET_METHOD(exports, "setPowerSamplerPeriod", SetPowerSamplerPeriod);
+  NODE_SET_METHOD(exports, "stopPowerSampler", StopPowerSampler);
+  NODE_SET_METHOD(exports, "powerSamplerStats", PowerSamplerStats);
+  NODE_SET_METHOD(exports, "powerChannels", PowerChannels);
+  NODE_SET_METHOD(exports, "energyCounters", EnergyCounters);
+  NODE_SET_METHOD(exports, "beginEnergyRegion", BeginEnergyRegion);
+  NODE_SET_METHOD(exports, "endEnergyRegion", EndEnergyRegion);
+  NODE_SET_METHOD(exports, "snapshot", TakeSnapshot);
+  NODE_SET_METHOD(exports, "snapshotAsync", TakeSnapshotAsync);
+  NODE_SET_METHOD(exports, "subscribe", Subscribe);
+  NODE_SET_METHOD(exports, "unsubscribe", Unsubscribe);
+  NODE_SET_METHOD(exports, "subscriptionStats", SubscriptionStats);
+  NODE_SET_METHOD(exports, "getCpuDataAsync", GetCpuDataAsync);
+  NODE_SET_METHOD(exports, "getGpuDataAsync", GetGpuDataAsync);
+  NODE_SET_METHOD(exports, "memoryVoltageAsync", MemoryVoltageAsync);
+  NODE_SET_METHOD(exports, "getFanDataAsync", GetFanDataAsync);
+  NODE_SET_METHOD(exports, "getAllPowerAsync", GetAllPowerAsync);
+  NODE_SET_METHOD(exports, "getSensorDataAsync", GetSensorDataAsync);
+  NODE_SET_METHOD(exports, "getSystemDataAsync", GetSystemDataAsync);
+  NODE_SET_METHOD(exports, "getRAMUsageDataAsync", GetRAMUsageDataAsync);
+  NODE_SET_METHOD(exports, "getBatteryDataAsync", GetBatteryDataAsync);
+  NODE_SET_METHOD(exports, "getCPUUsageDataAsync", GetCPUUsageDataAsync);
+  NODE_SET_METHOD(exports, "getDiskDataAsync", GetDiskDataAsync);
+
+  // Loaded again in the same environment: its state and cleanup hook exist
+  if (object_shapes) {
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(environments_lock);
+    if (environments++ == 0) {
+      SMCSetDefaultTransport(&iokit_transport);
+      SMCSetDefaultPowerSource(&report_source);
+      machine_dvfs = ReadDvfsTables();
+      SMCSetDvfsTables(machine_dvfs);
+    }
+  }
+  InitObjectShapes(context->GetIsolate());
+  node::AddEnvironmentCleanupHook(context->GetIsolate(), Cleanup, NULL);
+}
+
+// Context-aware, so the main thread and worker threads can each load it
+NODE_MODULE_INIT() {
+  Init(exports, context);
+}
@@ -19,6 +19,35 @@
 
 #ifndef __SMC_H__
 #define __SMC_H__
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#ifdef __APPLE__
+#include <IOKit/IOKitLib.h>
+#else
+// Minimal IOKit vocabulary so the hardware-independent parts of the SMC layer
+// (connection manager, stand-in transports) also build off-Mac.
+typedef uint8_t UInt8;
+typedef uint16_t UInt16;
+typedef uint32_t UInt32;
+typedef int kern_return_t;
+
+#define kIOReturnSuccess 0
+#define kIOReturnError ((kern_return_t)0xe00002bc)
+#define kIOReturnIPCError ((kern_return_t)0xe00002bf)
+#define kIOReturnNoDevice ((kern_return_t)0xe00002c0)
+#define kIOReturnBadArgument ((kern_return_t)0xe00002c2)
+#define kIOReturnNotOpen ((kern_return_t)0xe00002cd)
+#define kIOReturnOffline ((kern_return_t)0xe00002d7)
+#define kIOReturnAborted ((kern_return_t)0xe00002eb)
+#define kIOReturnNotResponding ((kern_return_t)0xe00002ed)
+#define kIOReturnNotFound ((kern_return_t)0xe00002f0)
+#define MACH_SEND_INVALID_DEST 0x10000003
 #endif
 
 #define VERSION "0.01"
@@ -27,13 +56,34 @@
 
 // SMC Commands
 #define SMC_CMD_READ_BYTES 5
+#define SMC_CMD_READ_INDEX 8
 #define SMC_CMD_READ_KEYINFO 9
 
-// SMC Data Types
-#define DATATYPE_FPE2 "fpe2"
-#define DATATYPE_UINT8 "ui8 "
-#define DATATYPE_SP78 "sp78"
-#define DATATYPE_FLT "flt "
+// Build a numeric FourCC key or type at compile time: SMC_FOURCC('F', 'N', 'u', 'm')
+#define SMC_FOURCC(a, b, c, d) \
+  (((UInt32)(a) << 24) | ((UInt32)(b) << 16) | ((UInt32)(c) << 8) | (UInt32)(d))
+
+// SMC result codes (SMCKeyData_t.result)
+#define SMC_RESULT_SUCCESS 0
+#define SMC_RESULT_KEY_NOT_FOUND 132
+#define SMC_RESULT_KEY_INDEX_RANGE 184
+
+// Key holding the number of keys the SMC knows (ui32), for index enumeration
+#define SMC_KEY_COUNT SMC_FOURCC('#', 'K', 'E', 'Y')
+
+// SMC data types
+#define SMC_TYPE_SP78 SMC_FOURCC('s', 'p', '7', '8')
+#define SMC_TYPE_SP87 SMC_FOURCC('s', 'p', '8', '7')
+#define SMC_TYPE_SP96 SMC_FOURCC('s', 'p', '9', '6')
+#define SMC_TYPE_FPE2 SMC_FOURCC('f', 'p', 'e', '2')
+#define SMC_TYPE_FP88 SMC_FOURCC('f', 'p', '8', '8')
+#define SMC_TYPE_FLT SMC_FOURCC('f', 'l', 't', ' ')
+#define SMC_TYPE_UI8 SMC_FOURCC('u', 'i', '8', ' ')
+#define SMC_TYPE_UI16 SMC_FOURCC('u', 'i', '1', '6')
+#define SMC_TYPE_UI32 SMC_FOURCC('u', 'i', '3', '2')
+#define SMC_TYPE_SI8 SMC_FOURCC('s', 'i', '8', ' ')
+#define SMC_TYPE_SI16 SMC_FOURCC('s', 'i', '1', '6')
+#define SMC_TYPE_FLAG SMC_FOURCC('f', 'l', 'a', 'g')
 
 // Chip generations for SMC key selection
 enum ChipGeneration {
@@ -47,9 +97,9 @@ enum ChipGeneration {
 };
 
 // Common SMC keys (work across all platforms)
-#define SMC_PKEY_FAN_RPM "F%dAc"
-#define SMC_PKEY_FAN_MIN "F%dMn"
-#define SMC_PKEY_FAN_MAX "F%dMx"
+#define SMC_KEY_FAN_COUNT SMC_FOURCC('F', 'N', 'u', 'm')
+// Per-fan keys: SMC_FAN_KEY(0, 'A', 'c') is "F0Ac"
+#define SMC_FAN_KEY(n, c, d) SMC_FOURCC('F', '0' + (n), c, d)
 
 typedef struct
 {
@@ -101,6 +151,176 @@ typedef struct
   SMCBytes_t bytes;
 } SMCVal_t;
 
+// SMC transport: how SMCCall() requests reach the SMC. The addon installs the
+// IOKit transport (AppleSMC user client) as the default on macOS; stand-in
+// transports replace it in tests.
+typedef struct {
+  const char* name;
+  kern_return_t (*open)(void* ctx);
+  void (*close)(void* ctx);
+  kern_return_t (*call)(void* ctx, int index, SMCKeyData_t* inputStructure, SMCKeyData_t* outputStructure);
+  void* ctx;
+} SMCTransport;
+
+// SMC connection counters
+typedef struct {
+  uint64_t opens;         // Successful transport opens
+  uint64_t reconnects;    // Opens that replaced a connection dropped after an error
+  uint64_t failed_opens;  // Transport opens that failed
+  uint64_t calls;         // SMCCall() round-trips issued
+  uint64_t errors;        // SMCCall() round-trips that failed
+  int refs;               // Callers between SMCOpen() and SMCClose()
+  bool connected;         // Transport currently open
+} SMCConnectionStats;
+
+// SMC key catalog entry, as enumerated by index
+typedef struct {
+  UInt32 key;
+  UInt32 dataSize;
+  UInt32 dataType;
+  UInt8 attributes;
+} SMCKeyEntry;
+
+// Per-key status reported by SMCReadKeys()
+enum SMCReadStatus {
+  SMC_READ_OK = 0,
+  SMC_READ_NOT_FOUND = 1,         // The SMC does not know the key
+  SMC_READ_UNSUPPORTED_TYPE = 2,  // Read fine, but the data type cannot be decoded
+  SMC_READ_ERROR = 3              // The SMC call failed
+};
+
+// Decoder table entry; smc_decoders[SMCFindDecoder(type, size)] decodes a
+// value of that type, entry 0 (SMC_DECODER_NONE) returns NaN. encode is the
+// inverse, used by the simulated device.
+typedef double (*SMCDecodeFn)(const UInt8 *bytes);
+typedef void (*SMCEncodeFn)(double value, UInt8 *bytes);
+
+typedef struct {
+  UInt32 dataType;
+  UInt32 dataSize;
+  SMCDecodeFn decode;
+  SMCEncodeFn encode;
+} SMCDecoder;
+
+#define SMC_DECODER_NONE 0
+
+extern const SMCDecoder smc_decoders[];
+
+static inline double SMCDecode(UInt8 decoder, const UInt8 *bytes) {
+  return smc_decoders[decoder].decode(bytes);
+}
+
+// Key-info cache counters
+typedef struct {
+  uint64_t hits;          // Reads that reused cached size/type
+  uint64_t misses;        // Reads that had to ask the SMC (READ_KEYINFO)
+  uint64_t entries;       // Keys cached, including keys the SMC does not know
+  uint64_t catalog_keys;  // Keys in the enumerated catalog (0 until built)
+} SMCKeyInfoCacheStats;
+
+// SMC call trace files, see smc_trace.cc
+#define SMC_TRACE_VERSION 1
+#define SMC_TRACE_RECORD_SIZE 80
+
+typedef struct SMCTraceRecorder SMCTraceRecorder;
+typedef struct SMCTraceReplay SMCTraceReplay;
+
+typedef struct {
+  uint64_t records;  // Calls in the trace
+  uint64_t served;   // Calls answered from the trace
+  uint64_t misses;   // Calls the trace had no answer for
+} SMCTraceReplayStats;
+
+// Discovered sensor keys persisted between processes, tied to the machine
+// and OS they were discovered on
+#define SMC_KEY_CACHE_VERSION 1
+
+typedef struct {
+  std::string hw_model;
+  std::string os_version;
+  bool has_cpu_temp_keys;             // Set once the key set was discovered,
+  std::vector<UInt32> cpu_temp_keys;  // even if it came up empty
+  bool has_gpu_temp_keys;
+  std::vector<UInt32> gpu_temp_keys;
+} SMCKeyCacheFile;
+
+// Refresh policies (smc_refresh.cc): how often a metric is re-read
+enum SMCRefreshPolicy {
+  SMC_REFRESH_FAST = 0,       // Every tick, or once fast_ms has passed
+  SMC_REFRESH_SLOW = 1,       // Once slow_ms has passed
+  SMC_REFRESH_STATIC = 2,     // Once; again only after the transport changes
+  SMC_REFRESH_ON_DEMAND = 3   // Once; again only when a refresh is requested
+};
+
+typedef struct {
+  SMCRefreshPolicy policy;
+  bool valid;         // Read at least once
+  bool requested;     // Refresh requested since the last read
+  int64_t read_at;    // SMCRefreshNow() of the last read
+} SMCRefreshState;
+
+typedef struct {
+  uint32_t fast_ms;
+  uint32_t slow_ms;
+} SMCRefreshIntervals;
+
+typedef struct {
+  uint64_t ticks;         // Batches read
+  uint64_t reads;         // Metrics read
+  uint64_t skipped;       // Metrics served from their last value
+  uint32_t last_reads;    // Same, for the latest tick
+  uint32_t last_skipped;
+} SMCRefreshStats;
+
+// Simulated SMC device (smc_sim.cc): a key table per chip generation,
+// programmable value waveforms, injected latency and errors
+
+enum SMCSimWaveShape {
+  SMC_SIM_CONSTANT = 0,   // Raw bytes as added
+  SMC_SIM_SINE = 1,       // min..max sine
+  SMC_SIM_RAMP = 2,       // min to max, then jump back
+  SMC_SIM_SQUARE = 3,     // max for the first half period, min for the second
+  SMC_SIM_NOISE = 4       // Uniform random in min..max
+};
+
+typedef struct {
+  SMCSimWaveShape shape;
+  double min;
+  double max;
+  double period_ms;
+} SMCSimWave;
+
+typedef struct {
+  UInt32 key;
+  UInt32 dataType;
+  UInt32 dataSize;
+  SMCBytes_t bytes;
+  SMCSimWave wave;
+} SMCSimKey;
+
+typedef struct {
+  uint64_t calls;         // Calls the device answered or failed
+  uint64_t errors;        // Calls failed by fail_calls or error_rate
+} SMCSimStats;
+
+typedef struct {
+  std::vector<SMCSimKey> keys;
+  std::unordered_map<UInt32, size_t> index;  // Key -> position in keys
+  ChipGeneration chip;    // Generation to report, CHIP_UNKNOWN for the host's
+  int fail_opens;         // Fail this many opens before succeeding
+  int fail_calls;         // Fail this many calls (as a dropped connection) before succeeding
+  double error_rate;      // Probability (0-1) that a call fails as a dropped connection
+  uint32_t latency_us;    // Delay added to every call
+  double time_step_ms;    // Waveform time advanced per value read; 0 uses the wall clock
+  uint64_t rng;           // xorshift state for error_rate and noise
+  uint64_t reads;
+  std::chrono::steady_clock::time_point start;
+  // Bumped by calls under the connection lock, read by SMCSimGetStats() without it
+  std::atomic<uint64_t> calls;
+  std::atomic<uint64_t> errors;
+  SMCTransport transport;
+} SMCSimDevice;
+
 // IOKit HID Sensor structures and functions
 typedef struct {
   char name[128];
@@ -122,11 +342,86 @@ typedef struct {
 } MacModelInfo;
 
 // Function prototypes
+// SMC connection manager: one connection for the life of the addon, opened on
+// first use and reopened lazily after a failed call
+void SMCSetDefaultTransport(const SMCTransport* transport);
+void SMCSetTransport(const SMCTransport* transport);  // NULL restores the default
+const SMCTransport* SMCGetTransport();
+kern_return_t SMCOpen(void);
+kern_return_t SMCClose(void);
+kern_return_t SMCCall(int index, SMCKeyData_t* inputStructure, SMCKeyData_t* outputStructure);
+void SMCShutdown(void);
+SMCConnectionStats SMCGetConnectionStats();
+
+// SMC key reads
+kern_return_t SMCReadKey(UInt32Char_t key, SMCVal_t *val);
+kern_return_t SMCReadKeyInfo(UInt32Char_t key, SMCKeyData_keyInfo_t *keyInfo);
+kern_return_t SMCLookupKeyInfo(UInt32 key, SMCKeyData_keyInfo_t *keyInfo);
+int32_t SMCReadKeyValue(UInt32 key, double *value);
+void SMCReadKeys(const UInt32 *keys, size_t count, double *values, int32_t *status);
+bool SMCGetKeyCatalog(std::vector<SMCKeyEntry> *catalog);
+bool SMCFindKeys(const char *const *prefixes, int prefixCount, UInt32 dataType, UInt32 dataSize,
+                 std::vector<UInt32> *keys);
+void SMCFlushKeyCaches();
+SMCKeyInfoCacheStats SMCGetKeyInfoCacheStats();
+
+// FourCC keys and types
+UInt32 SMCKeyFromString(const char *str);
+void SMCKeyToString(UInt32 key, char *str);  // str holds 5 chars
+UInt8 SMCFindDecoder(UInt32 dataType, UInt32 dataSize);
+bool SMCDecodeValue(UInt32 dataType, const char *bytes, UInt32 dataSize, double *value);
+bool SMCEncodeValue(UInt32 dataType, UInt32 dataSize, double value, UInt8 *bytes);
+UInt32 SMCTypeSize(UInt32 dataType);
+
+// Refresh policies; SMCReadKeys() applies the per-key ones
+int64_t SMCRefreshNow();  // Monotonic milliseconds
+void SMCSetRefreshIntervals(SMCRefreshIntervals intervals);
+SMCRefreshIntervals SMCGetRefreshIntervals();
+bool SMCRefreshDue(const SMCRefreshState* state, int64_t now);
+void SMCRefreshDone(SMCRefreshState* state, int64_t now);
+void SMCRefreshCountTick(SMCRefreshStats* stats, uint32_t reads, uint32_t skipped);
+void SMCSetKeyRefreshPolicy(UInt32 key, SMCRefreshPolicy policy);
+SMCRefreshPolicy SMCGetKeyRefreshPolicy(UInt32 key);
+void SMCRequestKeyRefresh(const UInt32* keys, size_t count);  // NULL for every key
+bool SMCRefreshLookup(UInt32 key, int64_t now, double* value, int32_t* status);
+void SMCRefreshStore(UInt32 key, int64_t now, double value, int32_t status);
+void SMCRefreshCountKeyTick(uint32_t reads, uint32_t skipped);
+void SMCFlushRefreshCache();
+SMCRefreshStats SMCGetKeyRefreshStats();
+
+// On-disk discovered key cache
+bool SMCKeyCacheLoad(const char *path, SMCKeyCacheFile *cache);
+bool SMCKeyCacheSave(const char *path, const SMCKeyCacheFile *cache);
+bool SMCKeyCacheValidate(const SMCKeyCacheFile *cache, const char *hw_model, const char *os_version);
+
+// Stand-in SMC device
+SMCSimDevice* SMCSimCreate();
+void SMCSimDestroy(SMCSimDevice* device);
+void SMCSimAddKey(SMCSimDevice* device, const char* key, const char* type, const UInt8* bytes, UInt32 size);
+bool SMCSimAddValue(SMCSimDevice* device, const char* key, const char* type, double value);
+bool SMCSimSetWave(SMCSimDevice* device, const char* key, SMCSimWave wave);
+void SMCSimAddChipKeys(SMCSimDevice* device, ChipGeneration chip);
+void SMCSimSeed(SMCSimDevice* device, uint64_t seed);
+SMCSimStats SMCSimGetStats(const SMCSimDevice* device);
+
+// Record/replay transports
+SMCTraceRecorder* SMCTraceRecordCreate(const char* path, const SMCTransport* source);
+const SMCTransport* SMCTraceRecordTransport(SMCTraceRecorder* recorder);
+uint64_t SMCTraceRecordCount(SMCTraceRecorder* recorder);
+void SMCTraceRecordDestroy(SMCTraceRecorder* recorder);
+SMCTraceReplay* SMCTraceReplayCreate(const char* path, bool latency);
+const SMCTransport* SMCTraceReplayTransport(SMCTraceReplay* replay);
+SMCTraceReplayStats SMCTraceReplayGetStats(SMCTraceReplay* replay);
+void SMCTraceReplayDestroy(SMCTraceReplay* replay);
+
 ChipGeneration GetChipGeneration();
 bool IsAppleSilicon();
 const MacModelInfo* LookupMacModel(const char* hw_model);
 double SMCGetTemperature();
-double SMCGetTemperatureKey(const char *key);
+double SMCGetTemperatureKey(UInt32 key);
+double SMCGetCpuDieTemperature();
+double GetGpuTemperature();
+double GetGpuUsage();
 
 // IOKit HID sensor functions (for Apple Silicon)
 IOKitSensorList GetIOKitTemperatureSensors();
@@ -166,6 +461,8 @@ typedef struct {
   char release_year[32];     // Release year and month (e.g., "Nov 2023")
 } SystemInfo;
 
+SystemInfo GetSystemInfo();
+
 // RAM usage structure
 typedef struct {
   uint64_t total;            // Total RAM in bytes
@@ -221,3 +518,300 @@ typedef struct {
   double gpu_ram;            // GPU RAM power in Watts
   double total;              // Total measured power (cpu + gpu + ane + ram + gpu_ram)
 } PowerMetrics;
+
+// What an IOReport Energy Model channel measures (smc_energy.cc)
+typedef enum {
+  ENERGY_OTHER,
+  ENERGY_CPU,
+  ENERGY_GPU,
+  ENERGY_ANE,
+  ENERGY_DRAM,
+  ENERGY_GPU_SRAM
+} SMCEnergyComponent;
+
+enum {
+  SMC_ENERGY_IN_COMPONENT = 1 << 0,  // Summed into its component's PowerMetrics field
+  SMC_ENERGY_IN_TOTAL = 1 << 1,      // Summed into PowerMetrics.total
+  SMC_ENERGY_SRAM = 1 << 2,
+  SMC_ENERGY_DETAIL = 1 << 3,        // Breakdown of another channel (DTL)
+  SMC_ENERGY_CLUSTER = 1 << 4,       // A whole CPU cluster
+  SMC_ENERGY_CORE = 1 << 5           // One CPU core
+};
+
+typedef struct {
+  SMCEnergyComponent component;
+  uint32_t flags;
+  char cluster_type;         // 'E' or 'P' for CPU cluster and core channels, else 0
+  int cluster;               // Cluster index within its type
+  int core;                  // Core index within its cluster, -1 if not a core
+  int die;                   // Die of multi-die chips (DIE_<n>_ prefix), else 0
+} SMCEnergyClass;
+
+SMCEnergyClass SMCClassifyEnergyChannel(const char* name);
+double SMCEnergyUnitScale(const char* unit);  // Joules per unit (mJ, uJ, nJ); 0 if unknown
+void SMCAddEnergy(const SMCEnergyClass& cls, double joules, PowerMetrics* metrics);
+
+// IOReport channel formats the sampler reads (smc_report.cc)
+typedef enum {
+  SMC_REPORT_SIMPLE,         // One integer counter, such as Energy Model energy
+  SMC_REPORT_STATE           // Time spent in each of a list of states, such as CPU Stats
+} SMCReportFormat;
+
+// A group, or one subgroup of it, read by a sampler consumer
+typedef struct {
+  const char* group;         // "Energy Model", "CPU Stats", "GPU Stats"...
+  const char* subgroup;      // NULL for the whole group
+} SMCReportGroup;
+
+// A source channel, as described when the source starts
+typedef struct {
+  std::string group;
+  std::string subgroup;
+  std::string name;
+  std::string unit;          // Energy Model: mJ, uJ or nJ
+  SMCReportFormat format;
+  std::vector<std::string> states;  // State channels: state names, in value order
+  uint32_t offset;           // Position of its first value in a sample; set by SMCLayOutReport()
+} SMCReportChannelInfo;
+
+bool SMCReportGroupMatches(const SMCReportGroup& group, const std::string& name, const std::string& subgroup);
+// Distinct groups of a list, a whole group covering its subgroups
+std::vector<SMCReportGroup> SMCMergeReportGroups(const std::vector<SMCReportGroup>& groups);
+// Set every channel's offset; returns the number of values in a sample
+size_t SMCLayOutReport(std::vector<SMCReportChannelInfo>* channels);
+
+// Compact per-channel entry built once per subscription, so a sample is
+// summed by position without looking at names or units again
+typedef struct {
+  uint32_t channel;          // Position of the channel's value in a sample
+  uint8_t component;         // SMCEnergyComponent
+  uint8_t flags;             // SMC_ENERGY_* flags
+  double scale;              // Joules per unit
+} SMCEnergyIndexEntry;
+
+// Entries for the channels with a known unit
+std::vector<SMCEnergyIndexEntry> SMCBuildEnergyIndex(const std::vector<SMCReportChannelInfo>& channels);
+void SMCSumEnergy(const SMCEnergyIndexEntry* index, size_t count, const int64_t* values,
+                  PowerMetrics* joules);
+
+// Power source: where the background sampler gets its IOReport readings.
+// start() subscribes to the groups the sampler's consumers read and describes
+// their channels; sample() then fills values with the raw delta of every
+// channel since the previous sample() or since start(), at the offsets
+// SMCLayOutReport() gave them: one integer per simple channel, one residency
+// per state for state channels. The addon installs the IOReport source, one
+// subscription to every group, as the default on macOS; fake and canned
+// sources replace it in tests.
+typedef struct {
+  const char* name;
+  bool (*start)(void* ctx, const std::vector<SMCReportGroup>& groups,
+                std::vector<SMCReportChannelInfo>* channels);
+  void (*stop)(void* ctx);
+  bool (*sample)(void* ctx, int64_t* values, size_t count);
+  void* ctx;
+} SMCPowerSource;
+
+// Reader of one group's channels from every sample. The sampler sums the
+// Energy Model itself; other groups are read by consumers added here.
+typedef struct {
+  const char* name;
+  SMCReportGroup group;
+  // The channels of its group, called on every start before the first sample
+  void (*describe)(void* ctx, const std::vector<SMCReportChannelInfo>& channels);
+  // A whole sample, read at the offsets describe() was given; window_us is
+  // the time measured since the previous sample
+  void (*sample)(void* ctx, const int64_t* values, int64_t now_us, int64_t window_us);
+  void* ctx;
+} SMCReportConsumer;
+
+// Per-channel view kept by the sampler
+typedef struct {
+  std::string name;
+  SMCEnergyClass cls;
+  double watts;              // Mean power over the latest window
+  double joules;             // Energy since the source was installed
+} SMCEnergyChannel;
+
+// Latest sampler result, published after every sample
+typedef struct {
+  PowerMetrics watts;        // Mean power over the latest window
+  double window_ms;          // Measured length of that window
+  int64_t sampled_at;        // SMCRefreshNow() time of the sample
+  uint64_t samples;          // Samples published since the sampler started
+  PowerMetrics joules;       // Energy counters: every delta so far, never reset
+  int64_t measured_us;       // Steady-clock time the counters were measured at
+} SMCPowerSnapshot;
+
+typedef struct {
+  bool running;
+  bool unavailable;          // The source failed to start; reads do not wait
+  uint32_t period_ms;
+  uint64_t samples;          // Samples published, over every run
+  uint64_t errors;           // Samples the source failed to take
+  uint64_t reads;            // Snapshots served to readers
+  uint64_t waits;            // Reads that had to wait for a first sample
+  double sample_us;          // Mean time to take and sum one sample
+  std::vector<std::string> groups;  // Groups subscribed to, "group" or "group/subgroup"
+  SMCPowerSnapshot latest;   // samples is 0 until the current run's first sample
+} SMCPowerSamplerStats;
+
+// Stand-in power source drawing constant power, reported through one
+// channel per component
+typedef struct {
+  PowerMetrics watts;        // Power to report
+  int fail_samples;          // Fail this many samples before succeeding
+  int fail_starts;           // Fail this many starts before succeeding
+  int64_t last_us;           // Time of the previous sample
+  SMCPowerSource source;
+} SMCPowerFake;
+
+// Recorded channels played back one sample at a time, looping. Only the
+// channels of the groups asked for at start are reported, as IOReport would.
+typedef struct {
+  std::vector<SMCReportChannelInfo> channels;
+  std::vector<std::vector<int64_t>> values;  // Per channel: every sample's values in turn
+  std::vector<SMCReportChannelInfo> started;  // Channels reported since start
+  std::vector<size_t> started_from;  // Index in channels of each of those
+  size_t next;
+  SMCPowerSource source;
+} SMCPowerCanned;
+
+// Background power sampler: one thread samples the source every period_ms,
+// started on the first read and stopped by SMCPowerSamplerStop()
+void SMCSetDefaultPowerSource(const SMCPowerSource* source);
+void SMCSetPowerSource(const SMCPowerSource* source);  // NULL restores the default
+void SMCSetPowerSamplerPeriod(uint32_t period_ms);  // 0 restores the default
+uint32_t SMCGetPowerSamplerPeriod();
+bool SMCReadPowerSnapshot(SMCPowerSnapshot* snapshot, uint32_t wait_ms);
+bool SMCPowerSourceUnavailable();  // The source failed to start and has not since
+void SMCPowerSamplerStop();
+SMCPowerSamplerStats SMCGetPowerSamplerStats();
+std::vector<SMCEnergyChannel> SMCGetEnergyChannels();  // In the order the source describes them
+// Consumers are called on the sampler thread from its next tick on. A group
+// not subscribed yet takes a new subscription, and that tick has no sample.
+void SMCAddReportConsumer(const SMCReportConsumer* consumer);
+void SMCRemoveReportConsumer(const SMCReportConsumer* consumer);
+
+// Scoped energy measurement (smc_region.cc). A region's energy is the
+// counter difference between its begin and end, interpolated within the
+// sampler windows they fall in; its peak is the highest window power among
+// the windows it overlaps.
+typedef struct {
+  PowerMetrics joules;       // Energy used in the region
+  PowerMetrics mean_watts;   // joules over duration
+  PowerMetrics peak_watts;   // Highest window power, per field
+  double duration_ms;
+  uint64_t samples;          // Sampler windows completed during the region
+} SMCEnergyRegionResult;
+
+uint64_t SMCBeginEnergyRegion();  // Starts the sampler if needed; 0 if it has no sample
+bool SMCEndEnergyRegion(uint64_t id, SMCEnergyRegionResult* result);  // false for an unknown id
+size_t SMCOpenEnergyRegions();
+// Called by the sampler after every sample, with the counters it published
+void SMCRegionsSampled(uint64_t index, int64_t now_us, int64_t window_us,
+                       const PowerMetrics& totals, const PowerMetrics& watts);
+SMCPowerFake* SMCPowerFakeCreate(PowerMetrics watts);
+void SMCPowerFakeDestroy(SMCPowerFake* fake);
+SMCPowerCanned* SMCPowerCannedCreate();
+bool SMCPowerCannedAddChannel(SMCPowerCanned* canned, const char* name, const char* unit,
+                              const std::vector<int64_t>& values);  // false if the unit is unknown
+// Any group and format; values holds one sample's values after another
+bool SMCPowerCannedAddReportChannel(SMCPowerCanned* canned, const SMCReportChannelInfo& channel,
+                                    const std::vector<int64_t>& values);  // false if values is ragged
+void SMCPowerCannedDestroy(SMCPowerCanned* canned);
+
+// DVFS operating point frequencies in MHz, slowest first (smc_residency.cc).
+// The addon reads the machine's from the pmgr device on macOS.
+typedef struct {
+  std::vector<double> ecpu;
+  std::vector<double> pcpu;
+  std::vector<double> gpu;
+} SMCDvfsTables;
+
+// A state channel's states matched to frequencies once per subscription
+typedef struct {
+  std::vector<double> mhz;       // Per state: its frequency, 0 if inactive or unknown
+  std::vector<uint8_t> active;   // Per state: 0 for IDLE, DOWN and OFF
+} SMCResidencyIndex;
+
+typedef struct {
+  double active_mhz;         // Residency-weighted mean frequency while active
+  double active_ratio;       // Share of the window in active states
+  double idle_ratio;         // Share of the window in IDLE, DOWN or OFF
+} SMCResidencySummary;
+
+// A CPU cluster or core from the IOReport CPU Stats group
+typedef struct {
+  std::string name;          // IOReport channel, e.g. "PCPU" or "PCPU3"
+  char cluster_type;         // 'E' or 'P'
+  int cluster;               // Cluster index within its type
+  int core;                  // Core index within its cluster, -1 for a whole cluster
+  int die;
+  double max_mhz;            // Top of the cluster's DVFS table, 0 if unknown
+  SMCResidencySummary residency;  // Over the latest window
+} SMCCpuFrequency;
+
+// The GPU from the IOReport GPU Stats group
+typedef struct {
+  std::string name;          // IOReport channel, "GPUPH"
+  double max_mhz;            // Top of the GPU's DVFS table, 0 if unknown
+  SMCResidencySummary residency;  // Over the latest window; active_ratio is the utilization
+  std::vector<double> state_mhz;    // Active states' frequencies, 0 if unknown
+  std::vector<double> state_ratio;  // Share of the latest window in each of those
+} SMCGpuFrequency;
+
+void SMCSetDvfsTables(const SMCDvfsTables& tables);
+SMCDvfsTables SMCGetDvfsTables();
+SMCResidencyIndex SMCBuildResidencyIndex(const std::vector<std::string>& states, const std::vector<double>& mhz);
+SMCResidencySummary SMCSummarizeResidency(const SMCResidencyIndex& index, const int64_t* residencies);
+// Clusters and cores of the latest window. The first call subscribes the
+// sampler to CPU Stats and waits up to wait_ms for a sample; false if none.
+// Returns at once, without subscribing, while the power source is unavailable.
+bool SMCGetCpuFrequencies(std::vector<SMCCpuFrequency>* frequencies, uint32_t wait_ms);
+// Likewise for GPU Stats; false without a sample or a GPUPH channel
+bool SMCGetGpuFrequency(SMCGpuFrequency* gpu, uint32_t wait_ms);
+
+// Bounded lock-free ring of pointers between one producer and one consumer.
+// A push into a full ring evicts the oldest item and hands it back.
+typedef struct {
+  std::atomic<void*>* slots;
+  size_t capacity;
+  std::atomic<uint64_t> head;  // Next push, written by the producer only
+  std::atomic<uint64_t> tail;  // Next pop, advanced by pops and evictions
+} SMCRing;
+
+SMCRing* SMCRingCreate(size_t capacity);
+void SMCRingDestroy(SMCRing* ring);  // Items still queued are not freed
+void* SMCRingPush(SMCRing* ring, void* item);  // Returns the evicted item or NULL
+void* SMCRingPop(SMCRing* ring);  // NULL when empty
+size_t SMCRingSize(SMCRing* ring);
+
+// Seqlock-published block of float64 values for readers that cannot call in,
+// such as JS on any thread through a SharedArrayBuffer. Memory layout:
+//   bytes 0-3    sequence, odd while a sample is written
+//   bytes 4-7    layout version
+//   bytes 8-11   value count
+//   bytes 12-15  reserved
+//   bytes 16-    values
+#define SMC_BLOCK_HEADER_BYTES 16
+
+typedef struct {
+  std::atomic<uint32_t> sequence;
+  uint32_t version;
+  uint32_t count;
+  uint32_t reserved;
+} SMCBlockHeader;
+
+typedef struct {
+  void* memory;              // Header then values, 16-byte aligned
+  size_t bytes;
+  SMCBlockHeader* header;
+  std::atomic<double>* values;
+} SMCBlock;
+
+SMCBlock* SMCBlockCreate(uint32_t count, uint32_t version);
+void SMCBlockDestroy(SMCBlock* block);
+void SMCBlockWrite(SMCBlock* block, const double* values);  // One writer at a time
+uint32_t SMCBlockRead(const SMCBlock* block, double* values);  // Returns the sequence read
+
+#endif
@@ -0,0 +1,78 @@
+/*
+ * Shared value block
+ *
+ * The latest sample of a fixed set of values, published for readers that
+ * copy it without a lock or a call into native code: JS maps the same
+ * memory as a SharedArrayBuffer on every thread.
+ *
+ * One writer publishes with a seqlock. The sequence is odd while values are
+ * written and advances by two per sample; a reader copies the values between
+ * two reads of the same even sequence and retries otherwise, so it never
+ * sees half of one sample and half of the next. Readers in JS must make the
+ * closing read a compare-exchange of the sequence with itself: unlike a plain
+ * atomic load, it cannot be reordered before the copies on weakly ordered
+ * CPUs.
+ *
+ * Natively the values are stored with release and loaded with acquire rather
+ * than fenced: a reader that sees any value of the next sample then also sees
+ * its odd sequence. Fences would do the same, but ThreadSanitizer does not
+ * model them and could not check the protocol.
+ */
+
+#include <stdlib.h>
+#include <new>
+
+#include "smc.h"
+
+static_assert(sizeof(SMCBlockHeader) == SMC_BLOCK_HEADER_BYTES, "block header layout");
+static_assert(sizeof(std::atomic<double>) == sizeof(double) && std::atomic<double>::is_always_lock_free,
+              "block values must be plain float64 to JS");
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t) && std::atomic<uint32_t>::is_always_lock_free,
+              "block sequence must be a plain uint32 to JS");
+
+SMCBlock* SMCBlockCreate(uint32_t count, uint32_t version) {
+  SMCBlock* block = new SMCBlock();
+  block->bytes = SMC_BLOCK_HEADER_BYTES + count * sizeof(double);
+  block->memory = calloc(1, block->bytes);
+
+  block->header = new (block->memory) SMCBlockHeader();
+  block->header->sequence.store(0, std::memory_order_relaxed);
+  block->header->version = version;
+  block->header->count = count;
+  block->header->reserved = 0;
+
+  block->values = (std::atomic<double>*)((char*)block->memory + SMC_BLOCK_HEADER_BYTES);
+  for (uint32_t i = 0; i < count; i++) {
+    new (&block->values[i]) std::atomic<double>(0.0);
+  }
+  return block;
+}
+
+void SMCBlockDestroy(SMCBlock* block) {
+  free(block->memory);
+  delete block;
+}
+
+void SMCBlockWrite(SMCBlock* block, const double* values) {
+  uint32_t seq = block->header->sequence.load(std::memory_order_relaxed);
+  block->header->sequence.store(seq + 1, std::memory_order_relaxed);
+
+  for (uint32_t i = 0; i < block->header->count; i++) {
+    block->values[i].store(values[i], std::memory_order_release);
+  }
+
+  block->header->sequence.store(seq + 2, std::memory_order_release);
+}
+
+uint32_t SMCBlockRead(const SMCBlock* block, double* values) {
+  uint32_t before, after;
+  do {
+    before = block->header->sequence.load(std::memory_order_acquire);
+    for (uint32_t i = 0; i < block->header->count; i++) {
+      values[i] = block->values[i].load(std::memory_order_acquire);
+    }
+    after = block->header->sequence.load(std::memory_order_relaxed);
+  } while (before != after || (before & 1));
+
+  return before;
+}
@@ -0,0 +1,162 @@
+/*
+ * SMC connection manager
+ *
+ * Opening the SMC means walking IOServiceGetMatchingServices for the
+ * AppleSMCKeysEndpoint and calling IOServiceOpen, which costs far more than
+ * the reads that follow. The connection is therefore opened once, on first
+ * use, and kept for the life of the addon. SMCOpen()/SMCClose() only count
+ * the callers currently using it. A call that fails at the connection level
+ * drops the connection and the next caller reopens it.
+ *
+ * Nothing in here touches IOKit directly: all requests go through the active
+ * SMCTransport, so the same code runs against the stand-in transports.
+ *
+ * Any thread may read: the connection state and every transport call are
+ * serialized by one lock, so concurrent readers share the connection and
+ * transports never see overlapping calls. SMCClose() only drops a reference,
+ * so one reader finishing cannot close the connection under another.
+ */
+
+#include <mutex>
+#include <string.h>
+
+#include "smc.h"
+
+static const SMCTransport* default_transport = NULL;
+static const SMCTransport* active_transport = NULL;  // NULL means default_transport
+
+static bool connected = false;
+static bool dropped = false;  // Connection was closed after a failed call
+static SMCConnectionStats stats = {};
+static std::mutex connection_lock;  // Guards everything above and serializes transport calls
+
+static const SMCTransport* CurrentTransport() {
+  return active_transport ? active_transport : default_transport;
+}
+
+// Errors that mean the user client is gone, as opposed to a bad request
+static bool IsConnectionError(kern_return_t result) {
+  switch (result) {
+    case MACH_SEND_INVALID_DEST:
+    case kIOReturnIPCError:
+    case kIOReturnNoDevice:
+    case kIOReturnNotOpen:
+    case kIOReturnOffline:
+    case kIOReturnAborted:
+    case kIOReturnNotResponding:
+      return true;
+    default:
+      return false;
+  }
+}
+
+static kern_return_t Connect() {
+  if (connected) {
+    return kIOReturnSuccess;
+  }
+
+  const SMCTransport* transport = CurrentTransport();
+  if (!transport) {
+    return kIOReturnNoDevice;
+  }
+
+  kern_return_t result = transport->open(transport->ctx);
+  if (result != kIOReturnSuccess) {
+    stats.failed_opens++;
+    return result;
+  }
+
+  connected = true;
+  stats.opens++;
+  if (dropped) {
+    stats.reconnects++;
+    dropped = false;
+  }
+
+  return kIOReturnSuccess;
+}
+
+static void Disconnect() {
+  if (!connected) {
+    return;
+  }
+
+  const SMCTransport* transport = CurrentTransport();
+  transport->close(transport->ctx);
+  connected = false;
+}
+
+void SMCSetDefaultTransport(const SMCTransport* transport) {
+  std::lock_guard<std::mutex> lock(connection_lock);
+  if (!active_transport) {
+    Disconnect();
+  }
+  default_transport = transport;
+}
+
+void SMCSetTransport(const SMCTransport* transport) {
+  {
+    std::lock_guard<std::mutex> lock(connection_lock);
+    Disconnect();
+    dropped = false;
+    active_transport = transport;
+  }
+
+  // Key info and the key catalog belong to the device behind the transport
+  SMCFlushKeyCaches();
+}
+
+const SMCTransport* SMCGetTransport() {
+  std::lock_guard<std::mutex> lock(connection_lock);
+  return CurrentTransport();
+}
+
+kern_return_t SMCOpen(void) {
+  std::lock_guard<std::mutex> lock(connection_lock);
+  stats.refs++;
+  return Connect();
+}
+
+kern_return_t SMCClose(void) {
+  // The connection stays open for the next caller; see SMCShutdown()
+  std::lock_guard<std::mutex> lock(connection_lock);
+  if (stats.refs > 0) {
+    stats.refs--;
+  }
+  return kIOReturnSuccess;
+}
+
+kern_return_t SMCCall(int index, SMCKeyData_t *inputStructure,
+                      SMCKeyData_t *outputStructure) {
+  std::lock_guard<std::mutex> lock(connection_lock);
+  kern_return_t result = Connect();
+  if (result != kIOReturnSuccess) {
+    return result;
+  }
+
+  const SMCTransport* transport = CurrentTransport();
+  stats.calls++;
+  result = transport->call(transport->ctx, index, inputStructure, outputStructure);
+  if (result != kIOReturnSuccess) {
+    stats.errors++;
+    if (IsConnectionError(result)) {
+      Disconnect();
+      dropped = true;
+    }
+  }
+
+  return result;
+}
+
+void SMCShutdown(void) {
+  std::lock_guard<std::mutex> lock(connection_lock);
+  Disconnect();
+  dropped = false;
+}
+
+SMCConnectionStats SMCGetConnectionStats() {
+  std::lock_guard<std::mutex> lock(connection_lock);
+  SMCConnectionStats result = stats;
+  result.connected = connected;
+  return result;
+}
@@ -0,0 +1,194 @@
+/*
+ * Energy Model channels
+ *
+ * The IOReport "Energy Model" group reports one energy counter per power
+ * domain. Channel names differ between chips: "CPU Energy" on most, a
+ * "DIE_<n>_" prefix per die on Ultra parts, clusters as "ECPU"/"PCPU" on M1
+ * and "EACC_CPU"/"PACC<k>_CPU" on the Pro and Max chips, with a core number
+ * appended for the per-core channels and "SRAM" or "DTL" suffixes for
+ * sub-domains of a channel that is already counted.
+ *
+ * SMCClassifyEnergyChannel() works out what a channel measures from its
+ * name alone, so it can be tested on recorded channel lists. The aggregate
+ * rules match macmon: only whole-component channels feed the cpu/gpu/ane/
+ * ram/gpu_ram fields, and total leaves out sub-domains and per-core channels
+ * so nothing is counted twice. Cluster and core channels are still
+ * classified, for the per-channel breakdown.
+ *
+ * Names and units are only looked at when a source starts: SMCBuildEnergyIndex()
+ * turns them into a compact array of position, component, flags and unit
+ * scale, and every sample after that is summed by position from the raw
+ * integer values.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "smc.h"
+
+static bool StartsWith(const char* name, const char* prefix) {
+  return strncmp(name, prefix, strlen(prefix)) == 0;
+}
+
+static bool EndsWith(const char* name, const char* suffix) {
+  size_t length = strlen(name);
+  size_t suffix_length = strlen(suffix);
+  return length >= suffix_length && strcmp(name + length - suffix_length, suffix) == 0;
+}
+
+// Parse an optional run of digits at *p; -1 if there is none
+static int ParseIndex(const char** p) {
+  if (**p < '0' || **p > '9') {
+    return -1;
+  }
+  char* end;
+  long value = strtol(*p, &end, 10);
+  *p = end;
+  return (int)value;
+}
+
+// Fill in cluster and core from a CPU cluster channel name (without its die
+// prefix): ECPU, PCPU3, EACC_CPU, PACC1_CPU2. False if it is not one.
+static bool ParseCluster(const char* name, SMCEnergyClass* cls) {
+  const char* p;
+  char type;
+  int cluster = 0;
+
+  if (StartsWith(name, "ECPU") || StartsWith(name, "PCPU")) {
+    type = name[0];
+    p = name + 4;
+  } else if (StartsWith(name, "EACC") || StartsWith(name, "PACC")) {
+    type = name[0];
+    p = name + 4;
+    int index = ParseIndex(&p);
+    if (index >= 0) {
+      cluster = index;
+    }
+    if (!StartsWith(p, "_CPU")) {
+      return false;
+    }
+    p += 4;
+  } else {
+    return false;
+  }
+
+  int core = ParseIndex(&p);
+  // Anything else after the name must be a sub-domain suffix
+  if (*p != '\0' && *p != '_' && *p != ' ') {
+    return false;
+  }
+
+  cls->component = ENERGY_CPU;
+  cls->cluster_type = type;
+  cls->cluster = cluster;
+  cls->core = core;
+  cls->flags |= core >= 0 ? SMC_ENERGY_CORE : SMC_ENERGY_CLUSTER;
+  return true;
+}
+
+SMCEnergyClass SMCClassifyEnergyChannel(const char* name) {
+  SMCEnergyClass cls = {ENERGY_OTHER, 0, 0, 0, -1, 0};
+
+  bool detail = strstr(name, "DTL") != NULL;
+  bool sram = strstr(name, "SRAM") != NULL;
+  if (detail) {
+    cls.flags |= SMC_ENERGY_DETAIL;
+  }
+  if (sram) {
+    cls.flags |= SMC_ENERGY_SRAM;
+  }
+
+  const char* local = name;
+  if (StartsWith(local, "DIE_")) {
+    const char* p = local + 4;
+    int die = ParseIndex(&p);
+    if (die >= 0 && *p == '_') {
+      cls.die = die;
+      local = p + 1;
+    }
+  }
+
+  bool cluster = ParseCluster(local, &cls);
+  bool individual_core = (StartsWith(name, "ECPU") || StartsWith(name, "PCPU")) && strlen(name) <= 5;
+
+  if (strcmp(name, "GPU Energy") == 0) {
+    cls.component = ENERGY_GPU;
+    cls.flags |= SMC_ENERGY_IN_COMPONENT;
+  } else if (EndsWith(name, "CPU Energy")) {
+    // "CPU Energy", or "DIE_0_CPU Energy" on Ultra
+    cls.component = ENERGY_CPU;
+    cls.flags |= SMC_ENERGY_IN_COMPONENT;
+  } else if (StartsWith(name, "ANE")) {
+    cls.component = ENERGY_ANE;
+    cls.flags |= SMC_ENERGY_IN_COMPONENT;
+  } else if (StartsWith(name, "DRAM")) {
+    cls.component = ENERGY_DRAM;
+    cls.flags |= SMC_ENERGY_IN_COMPONENT;
+  } else if (StartsWith(name, "GPU SRAM")) {
+    cls.component = ENERGY_GPU_SRAM;
+    cls.flags |= SMC_ENERGY_IN_COMPONENT;
+  } else if (individual_core) {
+    // ECPU, PCPU and their cores up to 9 on M1: already in "CPU Energy"
+    return cls;
+  } else if (!cluster) {
+    // AMCC, DCS, DISP, ISP, AVE, PCIe and the like
+    cls.component = ENERGY_OTHER;
+  }
+
+  if (!detail && !sram) {
+    cls.flags |= SMC_ENERGY_IN_TOTAL;
+  }
+  return cls;
+}
+
+double SMCEnergyUnitScale(const char* unit) {
+  if (strcmp(unit, "mJ") == 0) return 1e-3;
+  if (strcmp(unit, "uJ") == 0) return 1e-6;
+  if (strcmp(unit, "nJ") == 0) return 1e-9;
+  return 0.0;
+}
+
+static inline void AddEnergy(int component, uint32_t flags, double joules, PowerMetrics* metrics) {
+  if (flags & SMC_ENERGY_IN_COMPONENT) {
+    switch (component) {
+      case ENERGY_CPU: metrics->cpu += joules; break;
+      case ENERGY_GPU: metrics->gpu += joules; break;
+      case ENERGY_ANE: metrics->ane += joules; break;
+      case ENERGY_DRAM: metrics->ram += joules; break;
+      case ENERGY_GPU_SRAM: metrics->gpu_ram += joules; break;
+      default: break;
+    }
+  }
+  if (flags & SMC_ENERGY_IN_TOTAL) {
+    metrics->total += joules;
+  }
+}
+
+void SMCAddEnergy(const SMCEnergyClass& cls, double joules, PowerMetrics* metrics) {
+  AddEnergy(cls.component, cls.flags, joules, metrics);
+}
+
+std::vector<SMCEnergyIndexEntry> SMCBuildEnergyIndex(const std::vector<SMCReportChannelInfo>& channels) {
+  std::vector<SMCEnergyIndexEntry> index;
+  for (size_t i = 0; i < channels.size(); i++) {
+    double scale = SMCEnergyUnitScale(channels[i].unit.c_str());
+    if (scale == 0.0 || channels[i].format != SMC_REPORT_SIMPLE) continue;
+
+    SMCEnergyClass cls = SMCClassifyEnergyChannel(channels[i].name.c_str());
+    SMCEnergyIndexEntry entry;
+    entry.channel = channels[i].offset;
+    entry.component = (uint8_t)cls.component;
+    entry.flags = (uint8_t)cls.flags;
+    entry.scale = scale;
+    index.push_back(entry);
+  }
+  return index;
+}
+
+void SMCSumEnergy(const SMCEnergyIndexEntry* index, size_t count, const int64_t* values,
+                  PowerMetrics* joules) {
+  for (size_t i = 0; i < count; i++) {
+    const SMCEnergyIndexEntry& entry = index[i];
+    AddEnergy(entry.component, entry.flags, values[entry.channel] * entry.scale, joules);
+  }
+}
@@ -0,0 +1,170 @@
+/*
+ * On-disk cache of discovered sensor keys
+ *
+ * Finding the temperature keys of an Apple Silicon SMC takes a catalog walk
+ * or a few hundred probes, which short-lived processes such as a single
+ * `macstats` run would otherwise pay every time. The keys found are written
+ * to a small text file together with the hardware model and OS version they
+ * were found on:
+ *
+ *   macstats-smc-keys 1
+ *   model Mac14,6
+ *   os macOS 14.1.1
+ *   cpu Tp01 Tp05 Tp09
+ *   gpu Tg0f Tg0j
+ *
+ * A cache is only used if it has the current version, model and OS and a few
+ * of its keys still read back as temperature sensors.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "smc.h"
+
+static const char *const CACHE_MAGIC = "macstats-smc-keys";
+
+// Split "cpu Tp01 Tp05" style values into keys
+static void ParseKeyList(const char *value, std::vector<UInt32> *keys) {
+  keys->clear();
+  while (*value) {
+    while (*value == ' ') value++;
+    const char *start = value;
+    while (*value && *value != ' ') value++;
+    if (value - start == 4) {
+      keys->push_back(SMC_FOURCC(start[0], start[1], start[2], start[3]));
+    }
+  }
+}
+
+static void WriteKeyList(FILE *file, const char *name, const std::vector<UInt32> &keys) {
+  fputs(name, file);
+  for (UInt32 key : keys) {
+    char str[5];
+    SMCKeyToString(key, str);
+    fprintf(file, " %s", str);
+  }
+  fputc('\n', file);
+}
+
+bool SMCKeyCacheLoad(const char *path, SMCKeyCacheFile *cache) {
+  FILE *file = fopen(path, "r");
+  if (!file) {
+    return false;
+  }
+
+  cache->hw_model.clear();
+  cache->os_version.clear();
+  cache->has_cpu_temp_keys = false;
+  cache->cpu_temp_keys.clear();
+  cache->has_gpu_temp_keys = false;
+  cache->gpu_temp_keys.clear();
+
+  char line[1024];
+  bool valid = false;
+  if (fgets(line, sizeof(line), file)) {
+    char magic[32];
+    int version = 0;
+    valid = sscanf(line, "%31s %d", magic, &version) == 2 &&
+            strcmp(magic, CACHE_MAGIC) == 0 && version == SMC_KEY_CACHE_VERSION;
+  }
+
+  while (valid && fgets(line, sizeof(line), file)) {
+    line[strcspn(line, "\r\n")] = '\0';
+
+    const char *value = strchr(line, ' ');
+    size_t nameLength = value ? (size_t)(value - line) : strlen(line);
+    value = value ? value + 1 : "";
+
+    if (nameLength == 5 && strncmp(line, "model", 5) == 0) {
+      cache->hw_model = value;
+    } else if (nameLength == 2 && strncmp(line, "os", 2) == 0) {
+      cache->os_version = value;
+    } else if (nameLength == 3 && strncmp(line, "cpu", 3) == 0) {
+      cache->has_cpu_temp_keys = true;
+      ParseKeyList(value, &cache->cpu_temp_keys);
+    } else if (nameLength == 3 && strncmp(line, "gpu", 3) == 0) {
+      cache->has_gpu_temp_keys = true;
+      ParseKeyList(value, &cache->gpu_temp_keys);
+    }
+  }
+
+  fclose(file);
+  return valid;
+}
+
+bool SMCKeyCacheSave(const char *path, const SMCKeyCacheFile *cache) {
+  // Create the cache directory if needed (one level, e.g. ~/Library/Caches/macstats)
+  std::string dir(path);
+  size_t slash = dir.rfind('/');
+  if (slash != std::string::npos && slash > 0) {
+    dir.resize(slash);
+    if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) {
+      return false;
+    }
+  }
+
+  // Write a temporary file and rename it over the cache so concurrent
+  // processes never see a partial file
+  char tmpPath[1024];
+  snprintf(tmpPath, sizeof(tmpPath), "%s.%ld.tmp", path, (long)getpid());
+
+  FILE *file = fopen(tmpPath, "w");
+  if (!file) {
+    return false;
+  }
+
+  fprintf(file, "%s %d\n", CACHE_MAGIC, SMC_KEY_CACHE_VERSION);
+  fprintf(file, "model %s\n", cache->hw_model.c_str());
+  fprintf(file, "os %s\n", cache->os_version.c_str());
+  if (cache->has_cpu_temp_keys) {
+    WriteKeyList(file, "cpu", cache->cpu_temp_keys);
+  }
+  if (cache->has_gpu_temp_keys) {
+    WriteKeyList(file, "gpu", cache->gpu_temp_keys);
+  }
+
+  bool written = ferror(file) == 0;
+  if (fclose(file) != 0) {
+    written = false;
+  }
+  if (!written || rename(tmpPath, path) != 0) {
+    remove(tmpPath);
+    return false;
+  }
+
+  return true;
+}
+
+// A cached key is still good if the SMC reports it as a 4 byte flt
+static bool SpotCheckKey(UInt32 key) {
+  SMCKeyData_keyInfo_t keyInfo;
+  if (SMCLookupKeyInfo(key, &keyInfo) != kIOReturnSuccess) {
+    return false;
+  }
+  return keyInfo.dataSize == 4 && keyInfo.dataType == SMC_TYPE_FLT;
+}
+
+// Check the first, middle and last key of a set
+static bool SpotCheckKeys(const std::vector<UInt32> &keys) {
+  if (keys.empty()) {
+    return true;
+  }
+  return SpotCheckKey(keys.front()) && SpotCheckKey(keys[keys.size() / 2]) &&
+         SpotCheckKey(keys.back());
+}
+
+bool SMCKeyCacheValidate(const SMCKeyCacheFile *cache, const char *hw_model, const char *os_version) {
+  if (cache->hw_model != hw_model || cache->os_version != os_version) {
+    return false;
+  }
+
+  SMCOpen();
+  bool valid = SpotCheckKeys(cache->cpu_temp_keys) && SpotCheckKeys(cache->gpu_temp_keys);
+  SMCClose();
+
+  return valid;
+}
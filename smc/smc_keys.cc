@@ -0,0 +1,344 @@
+/*
+ * SMC key reads
+ *
+ * A read is two SMC round-trips: READ_KEYINFO for the key's size and type,
+ * then READ_BYTES for the value. Size and type never change for a given key,
+ * so the key info and the decoder for its type are cached by numeric FourCC
+ * and warm reads only need READ_BYTES. Keys the SMC does not know are cached
+ * too, which makes repeat probes during sensor discovery free.
+ *
+ * The key catalog lists every key the SMC knows: "#KEY" holds the count and
+ * READ_INDEX returns the key at a given index. Building it costs two calls
+ * per key once; sensor discovery then filters the catalog instead of probing
+ * guessed key names.
+ *
+ * Both caches have their own lock, which is never held across an SMC call:
+ * two threads missing on the same key both ask the SMC and store the same
+ * answer. Readers get copies of cached key info, so a flush cannot pull an
+ * entry out from under them. The catalog is built outside its lock and
+ * published under it, unless a flush came in meanwhile; lookups filter it
+ * under that lock and listings get a copy, for the same reason.
+ */
+
+#include <math.h>
+#include <mutex>
+#include <string.h>
+#include <unordered_map>
+
+#include "smc.h"
+
+// Cached key info plus the decoder index resolved from its type
+typedef struct {
+  SMCKeyData_keyInfo_t info;
+  UInt8 decoder;
+} KeyInfoEntry;
+
+static std::unordered_map<UInt32, KeyInfoEntry> key_info_cache;
+static SMCKeyInfoCacheStats key_info_stats = {};
+static std::mutex key_info_lock;
+
+enum CatalogState { CATALOG_EMPTY, CATALOG_BUILT, CATALOG_UNSUPPORTED };
+static std::vector<SMCKeyEntry> key_catalog;
+static CatalogState key_catalog_state = CATALOG_EMPTY;
+static std::mutex key_catalog_lock;
+static uint64_t key_catalog_generation = 0;  // Bumped by every flush
+
+// Look up size, type and decoder for a key, asking the SMC only on a cache
+// miss. Keys the SMC does not know are cached with dataSize 0.
+static kern_return_t LookupKey(UInt32 key, KeyInfoEntry *entry) {
+  {
+    std::lock_guard<std::mutex> lock(key_info_lock);
+    auto cached = key_info_cache.find(key);
+    if (cached != key_info_cache.end()) {
+      key_info_stats.hits++;
+      *entry = cached->second;
+      return entry->info.dataSize > 0 ? kIOReturnSuccess : kIOReturnNotFound;
+    }
+  }
+
+  SMCKeyData_t inputStructure;
+  SMCKeyData_t outputStructure;
+
+  memset(&inputStructure, 0, sizeof(SMCKeyData_t));
+  memset(&outputStructure, 0, sizeof(SMCKeyData_t));
+
+  inputStructure.key = key;
+  inputStructure.data8 = SMC_CMD_READ_KEYINFO;
+
+  kern_return_t result = SMCCall(KERNEL_INDEX_SMC, &inputStructure, &outputStructure);
+  if (result != kIOReturnSuccess) {
+    // Not cached: the key may well exist once the connection is back
+    return result;
+  }
+
+  if ((UInt8)outputStructure.result == SMC_RESULT_KEY_NOT_FOUND) {
+    memset(&outputStructure.keyInfo, 0, sizeof(SMCKeyData_keyInfo_t));
+  }
+
+  entry->info = outputStructure.keyInfo;
+  entry->decoder = SMCFindDecoder(entry->info.dataType, entry->info.dataSize);
+
+  {
+    std::lock_guard<std::mutex> lock(key_info_lock);
+    key_info_stats.misses++;
+    key_info_cache[key] = *entry;
+  }
+
+  return entry->info.dataSize > 0 ? kIOReturnSuccess : kIOReturnNotFound;
+}
+
+kern_return_t SMCLookupKeyInfo(UInt32 key, SMCKeyData_keyInfo_t *keyInfo) {
+  KeyInfoEntry entry;
+  kern_return_t result = LookupKey(key, &entry);
+  if (result == kIOReturnSuccess || result == kIOReturnNotFound) {
+    *keyInfo = entry.info;
+  }
+  return result;
+}
+
+// Read a key by numeric FourCC: size/type from the cache, value from the SMC
+static kern_return_t ReadKey(UInt32 key, KeyInfoEntry *entry, SMCBytes_t bytes) {
+  kern_return_t result;
+  SMCKeyData_t inputStructure;
+  SMCKeyData_t outputStructure;
+
+  memset(&inputStructure, 0, sizeof(SMCKeyData_t));
+  memset(&outputStructure, 0, sizeof(SMCKeyData_t));
+
+  inputStructure.key = key;
+
+  result = LookupKey(key, entry);
+  if (result != kIOReturnSuccess)
+    return result;
+
+  inputStructure.keyInfo.dataSize = entry->info.dataSize;
+  inputStructure.data8 = SMC_CMD_READ_BYTES;
+
+  result = SMCCall(KERNEL_INDEX_SMC, &inputStructure, &outputStructure);
+  if (result != kIOReturnSuccess)
+    return result;
+
+  memcpy(bytes, outputStructure.bytes, sizeof(outputStructure.bytes));
+
+  return kIOReturnSuccess;
+}
+
+kern_return_t SMCReadKey(UInt32Char_t key, SMCVal_t *val) {
+  KeyInfoEntry entry;
+
+  memset(val, 0, sizeof(SMCVal_t));
+
+  kern_return_t result = ReadKey(SMCKeyFromString(key), &entry, val->bytes);
+  if (result != kIOReturnSuccess)
+    return result;
+
+  val->dataSize = entry.info.dataSize;
+  SMCKeyToString(entry.info.dataType, val->dataType);
+
+  return kIOReturnSuccess;
+}
+
+kern_return_t SMCReadKeyInfo(UInt32Char_t key, SMCKeyData_keyInfo_t *keyInfo) {
+  return SMCLookupKeyInfo(SMCKeyFromString(key), keyInfo);
+}
+
+// Read and decode one key. Returns an SMCReadStatus; value is NaN unless OK.
+int32_t SMCReadKeyValue(UInt32 key, double *value) {
+  KeyInfoEntry entry;
+  SMCBytes_t bytes;
+
+  *value = NAN;
+  kern_return_t result = ReadKey(key, &entry, bytes);
+  if (result == kIOReturnNotFound) {
+    return SMC_READ_NOT_FOUND;
+  }
+  if (result != kIOReturnSuccess) {
+    return SMC_READ_ERROR;
+  }
+  if (entry.decoder == SMC_DECODER_NONE) {
+    return SMC_READ_UNSUPPORTED_TYPE;
+  }
+
+  *value = SMCDecode(entry.decoder, (const UInt8 *)bytes);
+  return SMC_READ_OK;
+}
+
+// Read and decode a list of keys in one pass over a single SMC connection.
+// Keys whose refresh policy says they are not due keep their last value (see
+// smc_refresh.cc). Failed keys get NaN and a non-zero status.
+void SMCReadKeys(const UInt32 *keys, size_t count, double *values, int32_t *status) {
+  int64_t now = SMCRefreshNow();
+  uint32_t reads = 0;
+  uint32_t skipped = 0;
+
+  SMCOpen();
+
+  for (size_t i = 0; i < count; i++) {
+    if (SMCRefreshLookup(keys[i], now, &values[i], &status[i])) {
+      skipped++;
+      continue;
+    }
+    status[i] = SMCReadKeyValue(keys[i], &values[i]);
+    SMCRefreshStore(keys[i], now, values[i], status[i]);
+    reads++;
+  }
+
+  SMCClose();
+  SMCRefreshCountKeyTick(reads, skipped);
+}
+
+// Read the key at a catalog index
+static kern_return_t ReadKeyAtIndex(UInt32 index, UInt32 *key) {
+  SMCKeyData_t inputStructure;
+  SMCKeyData_t outputStructure;
+
+  memset(&inputStructure, 0, sizeof(SMCKeyData_t));
+  memset(&outputStructure, 0, sizeof(SMCKeyData_t));
+
+  inputStructure.data8 = SMC_CMD_READ_INDEX;
+  inputStructure.data32 = index;
+
+  kern_return_t result = SMCCall(KERNEL_INDEX_SMC, &inputStructure, &outputStructure);
+  if (result != kIOReturnSuccess)
+    return result;
+  if (outputStructure.result != SMC_RESULT_SUCCESS)
+    return kIOReturnNotFound;
+
+  *key = outputStructure.key;
+  return kIOReturnSuccess;
+}
+
+// Enumerate the SMC's keys into *catalog. Returns CATALOG_EMPTY on transport
+// trouble, so the next lookup tries again.
+static CatalogState BuildKeyCatalog(std::vector<SMCKeyEntry> *catalog) {
+  double count = 0;
+
+  SMCOpen();
+  int32_t status = SMCReadKeyValue(SMC_KEY_COUNT, &count);
+  SMCClose();
+  if (status == SMC_READ_NOT_FOUND || status == SMC_READ_UNSUPPORTED_TYPE) {
+    return CATALOG_UNSUPPORTED;
+  }
+  if (status != SMC_READ_OK) {
+    return CATALOG_EMPTY;
+  }
+
+  catalog->reserve((size_t)count);
+
+  SMCOpen();
+  for (UInt32 index = 0; index < (UInt32)count; index++) {
+    UInt32 key;
+    kern_return_t result = ReadKeyAtIndex(index, &key);
+    if (result == kIOReturnNotFound) {
+      // The SMC returned fewer keys than #KEY announced
+      break;
+    }
+    if (result != kIOReturnSuccess) {
+      SMCClose();
+      return CATALOG_EMPTY;
+    }
+
+    SMCKeyData_keyInfo_t keyInfo;
+    result = SMCLookupKeyInfo(key, &keyInfo);
+    if (result == kIOReturnNotFound) {
+      continue;
+    }
+    if (result != kIOReturnSuccess) {
+      SMCClose();
+      return CATALOG_EMPTY;
+    }
+
+    SMCKeyEntry entry;
+    entry.key = key;
+    entry.dataSize = keyInfo.dataSize;
+    entry.dataType = keyInfo.dataType;
+    entry.attributes = (UInt8)keyInfo.dataAttributes;
+    catalog->push_back(entry);
+  }
+  SMCClose();
+
+  return CATALOG_BUILT;
+}
+
+// Build the catalog on first use. Caller holds key_catalog_lock, which is
+// released around the build.
+static bool KeyCatalogReady(std::unique_lock<std::mutex> &lock) {
+  if (key_catalog_state == CATALOG_EMPTY) {
+    uint64_t generation = key_catalog_generation;
+    std::vector<SMCKeyEntry> catalog;
+    lock.unlock();
+    CatalogState state = BuildKeyCatalog(&catalog);
+    lock.lock();
+    // Another thread may have published first, or a flush made this stale
+    if (key_catalog_state == CATALOG_EMPTY && key_catalog_generation == generation) {
+      key_catalog.swap(catalog);
+      key_catalog_state = state;
+    }
+  }
+  return key_catalog_state == CATALOG_BUILT;
+}
+
+// Copy of every key the SMC knows, enumerated on first use. False if the SMC
+// does not support enumeration or the catalog could not be read.
+bool SMCGetKeyCatalog(std::vector<SMCKeyEntry> *catalog) {
+  std::unique_lock<std::mutex> lock(key_catalog_lock);
+  if (!KeyCatalogReady(lock)) {
+    return false;
+  }
+  *catalog = key_catalog;
+  return true;
+}
+
+// Collect catalog keys starting with one of the prefixes and having the given
+// type and size. Returns false when no catalog is available.
+bool SMCFindKeys(const char *const *prefixes, int prefixCount, UInt32 dataType, UInt32 dataSize,
+                 std::vector<UInt32> *keys) {
+  std::unique_lock<std::mutex> lock(key_catalog_lock);
+  if (!KeyCatalogReady(lock)) {
+    return false;
+  }
+
+  for (const SMCKeyEntry &entry : key_catalog) {
+    if (entry.dataType != dataType || entry.dataSize != dataSize) {
+      continue;
+    }
+
+    char name[5];
+    SMCKeyToString(entry.key, name);
+    for (int p = 0; p < prefixCount; p++) {
+      if (strncmp(name, prefixes[p], strlen(prefixes[p])) == 0) {
+        keys->push_back(entry.key);
+        break;
+      }
+    }
+  }
+
+  return true;
+}
+
+void SMCFlushKeyCaches() {
+  SMCFlushRefreshCache();
+
+  {
+    std::lock_guard<std::mutex> lock(key_info_lock);
+    key_info_cache.clear();
+  }
+
+  std::lock_guard<std::mutex> lock(key_catalog_lock);
+  key_catalog.clear();
+  key_catalog_state = CATALOG_EMPTY;
+  key_catalog_generation++;
+}
+
+SMCKeyInfoCacheStats SMCGetKeyInfoCacheStats() {
+  SMCKeyInfoCacheStats result;
+  {
+    std::lock_guard<std::mutex> lock(key_info_lock);
+    result = key_info_stats;
+    result.entries = key_info_cache.size();
+  }
+
+  std::lock_guard<std::mutex> lock(key_catalog_lock);
+  result.catalog_keys = key_catalog.size();
+  return result;
+}
@@ -0,0 +1,597 @@
+/*
+ * Background power sampler
+ *
+ * Power is energy over time, so one reading needs two samples and the time
+ * between them. Taking both inside getAllPower() made every call block for
+ * the whole window and missed the energy used between calls. Instead one
+ * thread samples the power source every period_ms, keeps the source's
+ * previous sample so each delta is computed once, and publishes the mean
+ * power of the latest window.
+ *
+ * The latest snapshot sits behind a seqlock: the sampler is the only writer,
+ * readers copy it without taking a lock and retry if a sample was published
+ * meanwhile. Only a read before the first sample has to wait.
+ *
+ * The thread is also the one IOReport tick for every other reader: the source
+ * subscribes once to the groups of all consumers (smc_report.cc), and each
+ * sample is handed to each consumer in turn. The Energy Model consumer below
+ * is always there; consumers added or removed take effect on the next tick.
+ *
+ * Energy Model channels are classified once when the source starts
+ * (smc_energy.cc); each sample is then a run of raw integer values summed
+ * into the PowerMetrics fields by position, and also added to per-channel
+ * counters for the cluster and core breakdown.
+ *
+ * Every delta is also added to cumulative energy counters, stamped with the
+ * time it was measured at. They are never reset, so the mean power between
+ * any two reads is the difference in joules over the difference in time,
+ * whatever the sampling period or the gaps between reads. The counters only
+ * advance while the thread runs; a failed sample's energy lands in the next.
+ *
+ * The thread starts on the first read and runs until SMCPowerSamplerStop()
+ * or a source change.
+ *
+ * A source that fails to start (IOReport on Intel Macs, or a subscription
+ * refused) marks itself unavailable until a start succeeds or the source
+ * changes. Reads then return at once rather than wait for a sample that is
+ * not coming, and the thread retries with a doubling backoff.
+ */
+
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#include "smc.h"
+
+static const uint32_t DEFAULT_PERIOD_MS = 250;
+static const uint32_t MAX_RETRY_MS = 30000;  // Longest wait between start attempts
+
+static const SMCPowerSource* default_source = NULL;
+static const SMCPowerSource* active_source = NULL;  // Set by SMCSetPowerSource()
+
+static std::mutex sampler_lock;  // Guards the thread, its source and stop flag
+static std::condition_variable sampler_wake;
+static std::thread* sampler_thread = NULL;  // Left running at exit rather than destroyed joinable
+static bool sampler_running = false;
+static bool sampler_stopping = false;
+static std::atomic<uint32_t> period_ms(DEFAULT_PERIOD_MS);
+static std::atomic<bool> source_unavailable(false);  // The source failed to start
+
+// Seqlock-protected snapshot; sequence is odd while a sample is written
+enum {
+  FIELD_CPU, FIELD_GPU, FIELD_ANE, FIELD_RAM, FIELD_GPU_RAM, FIELD_TOTAL, FIELD_WINDOW,
+  FIELD_JOULES_CPU, FIELD_JOULES_GPU, FIELD_JOULES_ANE, FIELD_JOULES_RAM, FIELD_JOULES_GPU_RAM,
+  FIELD_JOULES_TOTAL, FIELD_COUNT
+};
+
+static std::atomic<uint64_t> sequence(0);
+static std::atomic<double> fields[FIELD_COUNT];
+static std::atomic<int64_t> sampled_at(0);
+static std::atomic<uint64_t> published(0);
+static std::atomic<int64_t> measured_at(0);
+
+// Energy counters, written by the sampler thread only (and by Publish()
+// callers that started or joined it)
+static PowerMetrics energy_totals = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+static int64_t energy_measured_us = 0;
+
+// Energy Model channels summed by position, rebuilt on every start; only
+// touched under readers_lock
+static std::vector<SMCEnergyIndexEntry> energy_index;
+
+// Per-channel counters in each channel's unit, reset when the source changes
+static std::mutex channels_lock;
+static std::vector<SMCEnergyChannel> channels;  // Name and class; watts and joules filled on read
+static std::vector<uint32_t> channel_offsets;
+static std::vector<double> channel_scales;
+static std::vector<int64_t> channel_totals;
+static std::vector<int64_t> channel_latest;
+static double channel_window_s = 0.0;
+
+static std::mutex first_sample_lock;
+static std::condition_variable first_sample;
+
+static std::atomic<uint64_t> stat_samples(0);
+static std::atomic<uint64_t> stat_errors(0);
+static std::atomic<uint64_t> stat_reads(0);
+static std::atomic<uint64_t> stat_waits(0);
+static std::atomic<uint64_t> stat_sample_ns(0);
+
+static int64_t NowMicros() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void Publish(const PowerMetrics& watts, double window_ms, uint64_t count) {
+  uint64_t seq = sequence.load(std::memory_order_relaxed);
+  sequence.store(seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  fields[FIELD_CPU].store(watts.cpu, std::memory_order_relaxed);
+  fields[FIELD_GPU].store(watts.gpu, std::memory_order_relaxed);
+  fields[FIELD_ANE].store(watts.ane, std::memory_order_relaxed);
+  fields[FIELD_RAM].store(watts.ram, std::memory_order_relaxed);
+  fields[FIELD_GPU_RAM].store(watts.gpu_ram, std::memory_order_relaxed);
+  fields[FIELD_TOTAL].store(watts.total, std::memory_order_relaxed);
+  fields[FIELD_WINDOW].store(window_ms, std::memory_order_relaxed);
+  fields[FIELD_JOULES_CPU].store(energy_totals.cpu, std::memory_order_relaxed);
+  fields[FIELD_JOULES_GPU].store(energy_totals.gpu, std::memory_order_relaxed);
+  fields[FIELD_JOULES_ANE].store(energy_totals.ane, std::memory_order_relaxed);
+  fields[FIELD_JOULES_RAM].store(energy_totals.ram, std::memory_order_relaxed);
+  fields[FIELD_JOULES_GPU_RAM].store(energy_totals.gpu_ram, std::memory_order_relaxed);
+  fields[FIELD_JOULES_TOTAL].store(energy_totals.total, std::memory_order_relaxed);
+  measured_at.store(energy_measured_us, std::memory_order_relaxed);
+  sampled_at.store(SMCRefreshNow(), std::memory_order_relaxed);
+  published.store(count, std::memory_order_relaxed);
+
+  sequence.store(seq + 2, std::memory_order_release);
+}
+
+// Copy the latest snapshot; false if nothing was published yet
+static bool ReadSnapshot(SMCPowerSnapshot* snapshot) {
+  uint64_t before, after;
+  do {
+    before = sequence.load(std::memory_order_acquire);
+    snapshot->watts.cpu = fields[FIELD_CPU].load(std::memory_order_relaxed);
+    snapshot->watts.gpu = fields[FIELD_GPU].load(std::memory_order_relaxed);
+    snapshot->watts.ane = fields[FIELD_ANE].load(std::memory_order_relaxed);
+    snapshot->watts.ram = fields[FIELD_RAM].load(std::memory_order_relaxed);
+    snapshot->watts.gpu_ram = fields[FIELD_GPU_RAM].load(std::memory_order_relaxed);
+    snapshot->watts.total = fields[FIELD_TOTAL].load(std::memory_order_relaxed);
+    snapshot->window_ms = fields[FIELD_WINDOW].load(std::memory_order_relaxed);
+    snapshot->joules.cpu = fields[FIELD_JOULES_CPU].load(std::memory_order_relaxed);
+    snapshot->joules.gpu = fields[FIELD_JOULES_GPU].load(std::memory_order_relaxed);
+    snapshot->joules.ane = fields[FIELD_JOULES_ANE].load(std::memory_order_relaxed);
+    snapshot->joules.ram = fields[FIELD_JOULES_RAM].load(std::memory_order_relaxed);
+    snapshot->joules.gpu_ram = fields[FIELD_JOULES_GPU_RAM].load(std::memory_order_relaxed);
+    snapshot->joules.total = fields[FIELD_JOULES_TOTAL].load(std::memory_order_relaxed);
+    snapshot->measured_us = measured_at.load(std::memory_order_relaxed);
+    snapshot->sampled_at = sampled_at.load(std::memory_order_relaxed);
+    snapshot->samples = published.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    after = sequence.load(std::memory_order_relaxed);
+  } while (before != after || (before & 1));
+
+  return snapshot->samples > 0;
+}
+
+static int64_t NowNanos() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Lay out the channel table for a source that just started. A restart of the
+// same source keeps the counters of the channels it still reports.
+static void DescribeChannels(void* /*ctx*/, const std::vector<SMCReportChannelInfo>& infos) {
+  energy_index = SMCBuildEnergyIndex(infos);
+
+  std::lock_guard<std::mutex> lock(channels_lock);
+  std::unordered_map<std::string, int64_t> previous;
+  for (size_t i = 0; i < channels.size(); i++) {
+    previous[channels[i].name] = channel_totals[i];
+  }
+
+  channels.assign(infos.size(), SMCEnergyChannel());
+  channel_offsets.assign(infos.size(), 0);
+  channel_scales.assign(infos.size(), 0.0);
+  channel_totals.assign(infos.size(), 0);
+  channel_latest.assign(infos.size(), 0);
+  for (size_t i = 0; i < infos.size(); i++) {
+    channels[i].name = infos[i].name;
+    channels[i].cls = SMCClassifyEnergyChannel(infos[i].name.c_str());
+    channel_offsets[i] = infos[i].offset;
+    channel_scales[i] = SMCEnergyUnitScale(infos[i].unit.c_str());
+    auto it = previous.find(infos[i].name);
+    if (it != previous.end()) {
+      channel_totals[i] = it->second;
+    }
+  }
+}
+
+static void CountChannels(const int64_t* values, double window_s) {
+  std::lock_guard<std::mutex> lock(channels_lock);
+  for (size_t i = 0; i < channel_totals.size(); i++) {
+    int64_t value = values[channel_offsets[i]];
+    channel_totals[i] += value;
+    channel_latest[i] = value;
+  }
+  channel_window_s = window_s;
+}
+
+// Sum the Energy Model channels into the counters and publish the window's power
+static void SampleEnergy(void* /*ctx*/, const int64_t* values, int64_t now_us, int64_t window_us) {
+  double window_s = window_us / 1e6;
+  PowerMetrics joules = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+  SMCSumEnergy(energy_index.data(), energy_index.size(), values, &joules);
+  CountChannels(values, window_s);
+  energy_totals.cpu += joules.cpu;
+  energy_totals.gpu += joules.gpu;
+  energy_totals.ane += joules.ane;
+  energy_totals.ram += joules.ram;
+  energy_totals.gpu_ram += joules.gpu_ram;
+  energy_totals.total += joules.total;
+  energy_measured_us = now_us;
+  PowerMetrics watts = {joules.cpu / window_s, joules.gpu / window_s, joules.ane / window_s,
+                        joules.ram / window_s, joules.gpu_ram / window_s, joules.total / window_s};
+  // Regions first, so a reader woken by the publish can begin one
+  SMCRegionsSampled(++stat_samples, now_us, window_us, energy_totals, watts);
+  uint64_t count = published.load(std::memory_order_relaxed) + 1;
+  Publish(watts, window_s * 1000.0, count);
+
+  if (count == 1) {
+    std::lock_guard<std::mutex> first(first_sample_lock);
+    first_sample.notify_all();
+  }
+}
+
+static const SMCReportConsumer energy_consumer = {
+  "energy", {"Energy Model", NULL}, DescribeChannels, SampleEnergy, NULL
+};
+
+// Consumers in the order they are sampled, the power sampler's own first.
+// The sampler holds readers_lock through every tick, so a removed consumer
+// is never called after SMCRemoveReportConsumer() returns.
+static std::mutex readers_lock;  // Guards the three below
+static std::vector<const SMCReportConsumer*> readers(1, &energy_consumer);
+static uint64_t readers_version = 0;
+static std::vector<std::string> subscribed;  // Groups of the running subscription
+
+// Groups of every consumer. Caller holds readers_lock.
+static std::vector<SMCReportGroup> ReaderGroups() {
+  std::vector<SMCReportGroup> groups;
+  for (const SMCReportConsumer* reader : readers) {
+    groups.push_back(reader->group);
+  }
+  return SMCMergeReportGroups(groups);
+}
+
+static bool SameGroups(const std::vector<SMCReportGroup>& a, const std::vector<SMCReportGroup>& b) {
+  if (a.size() != b.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < a.size(); i++) {
+    if (strcmp(a[i].group, b[i].group) != 0 ||
+        (a[i].subgroup == NULL) != (b[i].subgroup == NULL) ||
+        (a[i].subgroup && strcmp(a[i].subgroup, b[i].subgroup) != 0)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void SamplerLoop(const SMCPowerSource* source) {
+  std::vector<SMCReportGroup> groups;
+  std::vector<SMCReportChannelInfo> infos;
+  std::vector<int64_t> values;
+  bool started = false;
+  int64_t last_us = 0;
+  uint64_t version = 0;
+  uint32_t retry_ms = 0;
+  int64_t retry_at_us = 0;
+
+  // Hand every consumer the channels of its group. Caller holds readers_lock.
+  auto route = [&]() {
+    for (const SMCReportConsumer* reader : readers) {
+      std::vector<SMCReportChannelInfo> own;
+      for (const SMCReportChannelInfo& info : infos) {
+        if (SMCReportGroupMatches(reader->group, info.group, info.subgroup)) {
+          own.push_back(info);
+        }
+      }
+      reader->describe(reader->ctx, own);
+    }
+  };
+
+  // Subscribe to every consumer's group and describe the channels once per
+  // subscription. Caller holds readers_lock.
+  auto start = [&]() {
+    infos.clear();
+    started = source->start(source->ctx, groups, &infos);
+    last_us = NowMicros();
+    if (started) {
+      values.assign(SMCLayOutReport(&infos), 0);
+      route();
+      retry_ms = 0;
+      source_unavailable = false;
+      return;
+    }
+
+    // Wake readers waiting for a first sample; the next attempt backs off
+    retry_ms = retry_ms == 0 ? period_ms.load() : std::min(retry_ms * 2, MAX_RETRY_MS);
+    retry_at_us = last_us + (int64_t)retry_ms * 1000;
+    source_unavailable = true;
+    std::lock_guard<std::mutex> first(first_sample_lock);
+    first_sample.notify_all();
+  };
+
+  // Follow consumers added or removed since the last tick: a new group set
+  // means a new subscription, and the counters miss the tick it takes.
+  // Caller holds readers_lock.
+  auto update = [&]() {
+    if (started && version == readers_version) {
+      return;
+    }
+    std::vector<SMCReportGroup> wanted = ReaderGroups();
+    if (!started || !SameGroups(wanted, groups)) {
+      if (started) {
+        source->stop(source->ctx);
+      }
+      groups = wanted;
+      subscribed.clear();
+      for (const SMCReportGroup& group : groups) {
+        subscribed.push_back(group.subgroup ? std::string(group.group) + "/" + group.subgroup : group.group);
+      }
+      start();
+    } else {
+      route();
+    }
+    version = readers_version;
+  };
+
+  {
+    std::lock_guard<std::mutex> tick(readers_lock);
+    update();
+  }
+
+  std::unique_lock<std::mutex> lock(sampler_lock);
+  while (!sampler_stopping) {
+    sampler_wake.wait_for(lock, std::chrono::milliseconds(period_ms.load()));
+    if (sampler_stopping) {
+      break;
+    }
+    lock.unlock();
+
+    {
+      std::lock_guard<std::mutex> tick(readers_lock);
+      int64_t began_ns = NowNanos();
+      if (!started && NowMicros() < retry_at_us) {
+        // Backing off after a failed start
+      } else if (!started || version != readers_version) {
+        // Subscribing can fail while the system is still coming up; keep trying
+        update();
+        if (!started) {
+          stat_errors++;
+        }
+      } else if (!source->sample(source->ctx, values.data(), values.size())) {
+        // The source keeps its previous sample, so the next delta spans this window too
+        stat_errors++;
+      } else {
+        int64_t now_us = NowMicros();
+        int64_t window_us = now_us - last_us;
+        last_us = now_us;
+
+        if (window_us > 0) {
+          for (const SMCReportConsumer* reader : readers) {
+            reader->sample(reader->ctx, values.data(), now_us, window_us);
+          }
+          stat_sample_ns += NowNanos() - began_ns;
+        }
+      }
+    }
+
+    lock.lock();
+  }
+  lock.unlock();
+
+  std::lock_guard<std::mutex> tick(readers_lock);
+  subscribed.clear();
+  if (started) {
+    source->stop(source->ctx);
+  }
+}
+
+// Caller holds sampler_lock
+static void StartLocked() {
+  const SMCPowerSource* source = active_source ? active_source : default_source;
+  if (sampler_running || !source) {
+    return;
+  }
+
+  Publish(PowerMetrics{0.0, 0.0, 0.0, 0.0, 0.0, 0.0}, 0.0, 0);
+  sampler_stopping = false;
+  sampler_running = true;
+  sampler_thread = new std::thread(SamplerLoop, source);
+}
+
+static void StopLocked(std::unique_lock<std::mutex>& lock) {
+  if (!sampler_running) {
+    return;
+  }
+
+  sampler_stopping = true;
+  sampler_wake.notify_all();
+  std::thread* thread = sampler_thread;
+  sampler_thread = NULL;
+  lock.unlock();
+  thread->join();
+  delete thread;
+  lock.lock();
+
+  sampler_running = false;
+  Publish(PowerMetrics{0.0, 0.0, 0.0, 0.0, 0.0, 0.0}, 0.0, 0);
+}
+
+void SMCSetDefaultPowerSource(const SMCPowerSource* source) {
+  std::lock_guard<std::mutex> lock(sampler_lock);
+  default_source = source;
+}
+
+// Stops the sampler; the next read starts it on the new source
+void SMCSetPowerSource(const SMCPowerSource* source) {
+  std::unique_lock<std::mutex> lock(sampler_lock);
+  StopLocked(lock);
+  active_source = source;
+  source_unavailable = false;
+
+  // Nothing is described until the new source starts
+  std::lock_guard<std::mutex> tick(readers_lock);
+  std::vector<SMCReportChannelInfo> none;
+  for (const SMCReportConsumer* reader : readers) {
+    reader->describe(reader->ctx, none);
+  }
+}
+
+// Takes effect from the next sample
+void SMCSetPowerSamplerPeriod(uint32_t value) {
+  period_ms = value > 0 ? value : DEFAULT_PERIOD_MS;
+  sampler_wake.notify_all();
+}
+
+// Latest snapshot. Before the first sample, waits up to wait_ms for it; false
+// if there is none by then, or at once while the source is unavailable.
+bool SMCReadPowerSnapshot(SMCPowerSnapshot* snapshot, uint32_t wait_ms) {
+  stat_reads++;
+  if (ReadSnapshot(snapshot)) {
+    return true;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(sampler_lock);
+    StartLocked();
+  }
+  if (source_unavailable) {
+    return false;
+  }
+
+  stat_waits++;
+  std::unique_lock<std::mutex> lock(first_sample_lock);
+  first_sample.wait_for(lock, std::chrono::milliseconds(wait_ms),
+                        [snapshot] { return ReadSnapshot(snapshot) || source_unavailable; });
+  return ReadSnapshot(snapshot);
+}
+
+bool SMCPowerSourceUnavailable() {
+  return source_unavailable;
+}
+
+void SMCPowerSamplerStop() {
+  std::unique_lock<std::mutex> lock(sampler_lock);
+  StopLocked(lock);
+}
+
+uint32_t SMCGetPowerSamplerPeriod() {
+  return period_ms;
+}
+
+SMCPowerSamplerStats SMCGetPowerSamplerStats() {
+  SMCPowerSamplerStats stats;
+  {
+    std::lock_guard<std::mutex> lock(sampler_lock);
+    stats.running = sampler_running;
+  }
+  stats.unavailable = source_unavailable;
+  stats.period_ms = period_ms;
+  stats.samples = stat_samples;
+  stats.errors = stat_errors;
+  stats.reads = stat_reads;
+  stats.waits = stat_waits;
+  stats.sample_us = stats.samples > 0 ? stat_sample_ns / 1000.0 / stats.samples : 0.0;
+  {
+    std::lock_guard<std::mutex> lock(readers_lock);
+    stats.groups = subscribed;
+  }
+  ReadSnapshot(&stats.latest);
+  return stats;
+}
+
+std::vector<SMCEnergyChannel> SMCGetEnergyChannels() {
+  std::lock_guard<std::mutex> lock(channels_lock);
+  std::vector<SMCEnergyChannel> result = channels;
+  for (size_t i = 0; i < result.size(); i++) {
+    result[i].joules = channel_totals[i] * channel_scales[i];
+    result[i].watts = channel_window_s > 0 ? channel_latest[i] * channel_scales[i] / channel_window_s : 0.0;
+  }
+  return result;
+}
+
+void SMCAddReportConsumer(const SMCReportConsumer* consumer) {
+  std::lock_guard<std::mutex> lock(readers_lock);
+  readers.push_back(consumer);
+  readers_version++;
+}
+
+void SMCRemoveReportConsumer(const SMCReportConsumer* consumer) {
+  std::lock_guard<std::mutex> lock(readers_lock);
+  for (size_t i = 0; i < readers.size(); i++) {
+    if (readers[i] == consumer) {
+      readers.erase(readers.begin() + i);
+      readers_version++;
+      break;
+    }
+  }
+}
+
+// Named like the Energy Model channels they stand in for. GPU SRAM is not
+// part of total, so "Other" carries whatever total has beyond the rest.
+static const char* const fake_channels[] = {"CPU Energy", "GPU Energy", "ANE", "DRAM", "GPU SRAM", "Other"};
+static const size_t FAKE_CHANNEL_COUNT = sizeof(fake_channels) / sizeof(fake_channels[0]);
+
+// Reports its channels whatever the groups, so they sit at offsets 0 to 5
+static bool FakeStart(void* ctx, const std::vector<SMCReportGroup>& /*groups*/,
+                      std::vector<SMCReportChannelInfo>* channels) {
+  SMCPowerFake* fake = (SMCPowerFake*)ctx;
+  if (fake->fail_starts > 0) {
+    fake->fail_starts--;
+    return false;
+  }
+  fake->last_us = NowMicros();
+  for (size_t i = 0; i < FAKE_CHANNEL_COUNT; i++) {
+    SMCReportChannelInfo channel;
+    channel.group = "Energy Model";
+    channel.name = fake_channels[i];
+    channel.unit = "nJ";
+    channel.format = SMC_REPORT_SIMPLE;
+    channel.offset = 0;
+    channels->push_back(channel);
+  }
+  return true;
+}
+
+static void FakeStop(void* /*ctx*/) {
+}
+
+static bool FakeSample(void* ctx, int64_t* values, size_t count) {
+  SMCPowerFake* fake = (SMCPowerFake*)ctx;
+  if (fake->fail_samples > 0) {
+    fake->fail_samples--;
+    return false;
+  }
+
+  int64_t now_us = NowMicros();
+  double elapsed_ns = (now_us - fake->last_us) * 1e3;
+  fake->last_us = now_us;
+
+  const PowerMetrics& watts = fake->watts;
+  double channel_watts[FAKE_CHANNEL_COUNT] = {
+    watts.cpu, watts.gpu, watts.ane, watts.ram, watts.gpu_ram,
+    watts.total - watts.cpu - watts.gpu - watts.ane - watts.ram
+  };
+  for (size_t i = 0; i < count && i < FAKE_CHANNEL_COUNT; i++) {
+    values[i] = llround(channel_watts[i] * elapsed_ns);
+  }
+  return true;
+}
+
+SMCPowerFake* SMCPowerFakeCreate(PowerMetrics watts) {
+  SMCPowerFake* fake = new SMCPowerFake();
+  fake->watts = watts;
+  fake->fail_samples = 0;
+  fake->fail_starts = 0;
+  fake->last_us = 0;
+  fake->source.name = "fake";
+  fake->source.start = FakeStart;
+  fake->source.stop = FakeStop;
+  fake->source.sample = FakeSample;
+  fake->source.ctx = fake;
+  return fake;
+}
+
+void SMCPowerFakeDestroy(SMCPowerFake* fake) {
+  delete fake;
+}
@@ -0,0 +1,184 @@
+/*
+ * Refresh policies
+ *
+ * Many values hardly ever change: fan limits, the battery's design capacity,
+ * its cycle count. Reading them on every tick is wasted SMC and IORegistry
+ * round-trips, so every metric has a refresh policy:
+ *
+ *   fast       re-read on every tick, or once fast_ms has passed
+ *   slow       re-read once slow_ms has passed
+ *   static     read once, again only after the transport changes
+ *   on-demand  read once, again only after a refresh is requested
+ *
+ * For SMC keys a tick is one SMCReadKeys() batch. Keys that are not due are
+ * served from their last value and counted as skipped. Failed reads are not
+ * kept, so the key is read again on the next tick. Fan limits and the fan
+ * count default to static, everything else to fast.
+ *
+ * The battery reader in smc.cc uses the same states and counters for its
+ * fields.
+ */
+
+#include <chrono>
+#include <mutex>
+#include <unordered_map>
+
+#include "smc.h"
+
+typedef struct {
+  SMCRefreshState state;
+  double value;
+  int32_t status;
+} KeyValue;
+
+static SMCRefreshIntervals intervals = {0, 10000};
+static std::unordered_map<UInt32, SMCRefreshPolicy> key_policies;  // Set by SMCSetKeyRefreshPolicy()
+static std::unordered_map<UInt32, KeyValue> key_values;
+static SMCRefreshStats key_stats = {};
+static std::mutex refresh_lock;
+
+int64_t SMCRefreshNow() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void SMCSetRefreshIntervals(SMCRefreshIntervals value) {
+  std::lock_guard<std::mutex> lock(refresh_lock);
+  intervals = value;
+}
+
+SMCRefreshIntervals SMCGetRefreshIntervals() {
+  std::lock_guard<std::mutex> lock(refresh_lock);
+  return intervals;
+}
+
+static bool IsDue(const SMCRefreshState* state, int64_t now, const SMCRefreshIntervals& limits) {
+  if (!state->valid) {
+    return true;
+  }
+
+  switch (state->policy) {
+    case SMC_REFRESH_FAST:
+      return now - state->read_at >= limits.fast_ms;
+    case SMC_REFRESH_SLOW:
+      return state->requested || now - state->read_at >= limits.slow_ms;
+    case SMC_REFRESH_ON_DEMAND:
+      return state->requested;
+    default:
+      return false;
+  }
+}
+
+bool SMCRefreshDue(const SMCRefreshState* state, int64_t now) {
+  return IsDue(state, now, SMCGetRefreshIntervals());
+}
+
+void SMCRefreshDone(SMCRefreshState* state, int64_t now) {
+  state->valid = true;
+  state->requested = false;
+  state->read_at = now;
+}
+
+void SMCRefreshCountTick(SMCRefreshStats* stats, uint32_t reads, uint32_t skipped) {
+  stats->ticks++;
+  stats->reads += reads;
+  stats->skipped += skipped;
+  stats->last_reads = reads;
+  stats->last_skipped = skipped;
+}
+
+// Fan limits ("F0Mn", "F0Mx") and the fan count are fixed by the hardware
+static SMCRefreshPolicy DefaultKeyPolicy(UInt32 key) {
+  char name[5];
+  SMCKeyToString(key, name);
+
+  if (key == SMC_KEY_FAN_COUNT) {
+    return SMC_REFRESH_STATIC;
+  }
+  if (name[0] == 'F' && name[1] >= '0' && name[1] <= '9' &&
+      ((name[2] == 'M' && name[3] == 'n') || (name[2] == 'M' && name[3] == 'x'))) {
+    return SMC_REFRESH_STATIC;
+  }
+  return SMC_REFRESH_FAST;
+}
+
+static SMCRefreshPolicy KeyPolicy(UInt32 key) {
+  auto found = key_policies.find(key);
+  return found != key_policies.end() ? found->second : DefaultKeyPolicy(key);
+}
+
+void SMCSetKeyRefreshPolicy(UInt32 key, SMCRefreshPolicy policy) {
+  std::lock_guard<std::mutex> lock(refresh_lock);
+  key_policies[key] = policy;
+
+  auto cached = key_values.find(key);
+  if (cached != key_values.end()) {
+    cached->second.state.policy = policy;
+  }
+}
+
+SMCRefreshPolicy SMCGetKeyRefreshPolicy(UInt32 key) {
+  std::lock_guard<std::mutex> lock(refresh_lock);
+  return KeyPolicy(key);
+}
+
+// Make slow and on-demand keys due on the next tick
+void SMCRequestKeyRefresh(const UInt32* keys, size_t count) {
+  std::lock_guard<std::mutex> lock(refresh_lock);
+  if (!keys) {
+    for (auto& entry : key_values) {
+      entry.second.state.requested = true;
+    }
+    return;
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    auto cached = key_values.find(keys[i]);
+    if (cached != key_values.end()) {
+      cached->second.state.requested = true;
+    }
+  }
+}
+
+// Serve a key that is not due from its last value. Returns false when the
+// key has to be read.
+bool SMCRefreshLookup(UInt32 key, int64_t now, double* value, int32_t* status) {
+  std::lock_guard<std::mutex> lock(refresh_lock);
+  auto cached = key_values.find(key);
+  if (cached == key_values.end() || IsDue(&cached->second.state, now, intervals)) {
+    return false;
+  }
+
+  *value = cached->second.value;
+  *status = cached->second.status;
+  return true;
+}
+
+void SMCRefreshStore(UInt32 key, int64_t now, double value, int32_t status) {
+  if (status == SMC_READ_ERROR) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(refresh_lock);
+  KeyValue& entry = key_values[key];
+  entry.state.policy = KeyPolicy(key);
+  SMCRefreshDone(&entry.state, now);
+  entry.value = value;
+  entry.status = status;
+}
+
+void SMCRefreshCountKeyTick(uint32_t reads, uint32_t skipped) {
+  std::lock_guard<std::mutex> lock(refresh_lock);
+  SMCRefreshCountTick(&key_stats, reads, skipped);
+}
+
+// Values belong to the device behind the transport; policies are kept
+void SMCFlushRefreshCache() {
+  std::lock_guard<std::mutex> lock(refresh_lock);
+  key_values.clear();
+}
+
+SMCRefreshStats SMCGetKeyRefreshStats() {
+  std::lock_guard<std::mutex> lock(refresh_lock);
+  return key_stats;
+}
@@ -0,0 +1,195 @@
+/*
+ * Energy regions
+ *
+ * beginEnergyRegion()/endEnergyRegion() measure the energy of a stretch of
+ * work from the power sampler's cumulative counters, so a region costs a
+ * hash-map entry and never adds work per sample for each open region.
+ *
+ * Region bounds rarely fall on a sample. The counters at begin are
+ * interpolated from the first window that ends after it: that window's
+ * counters, less its mean power over the part of it after begin. Until that
+ * window arrives the region is pending and is resolved by the sampler, which
+ * only touches the regions begun since the previous sample. At end, the
+ * latest counters are extended by the latest window's power up to the end
+ * time.
+ *
+ * Peaks come from one monotonic queue per power field: window powers in
+ * sample order, each smaller than those before it, since a window followed
+ * by a higher one can never be a peak again. The highest window from sample
+ * n on is the first entry at or after n, found by binary search. Entries
+ * older than the oldest open region are dropped, and the queues are only fed
+ * while regions are open.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+#include "smc.h"
+
+static double PowerMetrics::*const metric_fields[] = {
+  &PowerMetrics::cpu, &PowerMetrics::gpu, &PowerMetrics::ane,
+  &PowerMetrics::ram, &PowerMetrics::gpu_ram, &PowerMetrics::total
+};
+static const size_t METRIC_FIELD_COUNT = sizeof(metric_fields) / sizeof(metric_fields[0]);
+
+typedef struct {
+  int64_t begin_us;
+  uint64_t first_index;      // First sample whose window ends after begin
+  bool resolved;             // begin_joules is known
+  PowerMetrics begin_joules; // Counters interpolated at begin_us
+} Region;
+
+typedef struct {
+  uint64_t index;
+  double watts;
+} PeakEntry;
+
+static std::mutex regions_lock;  // Guards everything below
+static std::unordered_map<uint64_t, Region> regions;
+static std::vector<uint64_t> pending;  // Begun since the latest sample, some maybe ended
+static std::multiset<uint64_t> open_from;  // first_index of every open region
+static std::deque<PeakEntry> peaks[METRIC_FIELD_COUNT];
+static uint64_t next_id = 1;
+
+// Latest sample, as handed over by the sampler
+static uint64_t latest_index = 0;
+static int64_t latest_us = 0;
+static PowerMetrics latest_totals = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+static PowerMetrics latest_watts = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+
+static int64_t NowMicros() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Caller holds regions_lock
+static void PushPeaks(uint64_t index, const PowerMetrics& watts) {
+  for (size_t f = 0; f < METRIC_FIELD_COUNT; f++) {
+    double value = watts.*metric_fields[f];
+    std::deque<PeakEntry>& queue = peaks[f];
+    while (!queue.empty() && queue.back().watts <= value) {
+      queue.pop_back();
+    }
+    queue.push_back({index, value});
+  }
+}
+
+// Drop the entries no open region can see. Caller holds regions_lock.
+static void PrunePeaks() {
+  for (size_t f = 0; f < METRIC_FIELD_COUNT; f++) {
+    if (open_from.empty()) {
+      peaks[f].clear();
+      continue;
+    }
+    uint64_t oldest = *open_from.begin();
+    while (!peaks[f].empty() && peaks[f].front().index < oldest) {
+      peaks[f].pop_front();
+    }
+  }
+}
+
+// Highest window power from sample index on; 0 if there is none
+static double PeakSince(size_t field, uint64_t index) {
+  const std::deque<PeakEntry>& queue = peaks[field];
+  auto it = std::lower_bound(queue.begin(), queue.end(), index,
+                             [](const PeakEntry& entry, uint64_t value) { return entry.index < value; });
+  return it == queue.end() ? 0.0 : it->watts;
+}
+
+void SMCRegionsSampled(uint64_t index, int64_t now_us, int64_t window_us,
+                       const PowerMetrics& totals, const PowerMetrics& watts) {
+  std::lock_guard<std::mutex> lock(regions_lock);
+  latest_index = index;
+  latest_us = now_us;
+  latest_totals = totals;
+  latest_watts = watts;
+
+  if (regions.empty()) {
+    pending.clear();
+    return;
+  }
+
+  for (uint64_t id : pending) {
+    auto it = regions.find(id);
+    if (it == regions.end()) continue;
+
+    Region& region = it->second;
+    double after_s = std::min(now_us - region.begin_us, window_us) / 1e6;
+    for (size_t f = 0; f < METRIC_FIELD_COUNT; f++) {
+      region.begin_joules.*metric_fields[f] = totals.*metric_fields[f] - watts.*metric_fields[f] * after_s;
+    }
+    region.resolved = true;
+  }
+  pending.clear();
+  PushPeaks(index, watts);
+}
+
+uint64_t SMCBeginEnergyRegion() {
+  // Make sure there is a sample to extend from
+  SMCPowerSnapshot snapshot;
+  SMCReadPowerSnapshot(&snapshot, SMCGetPowerSamplerPeriod() * 2 + 100);
+
+  std::lock_guard<std::mutex> lock(regions_lock);
+  if (latest_index == 0) {
+    return 0;
+  }
+
+  uint64_t id = next_id++;
+  Region& region = regions[id];
+  region.begin_us = NowMicros();
+  region.first_index = latest_index + 1;
+  region.resolved = false;
+  pending.push_back(id);
+  open_from.insert(region.first_index);
+  return id;
+}
+
+bool SMCEndEnergyRegion(uint64_t id, SMCEnergyRegionResult* result) {
+  int64_t end_us = NowMicros();
+  std::lock_guard<std::mutex> lock(regions_lock);
+  auto it = regions.find(id);
+  if (it == regions.end()) {
+    return false;
+  }
+
+  Region& region = it->second;
+  double duration_s = (end_us - region.begin_us) / 1e6;
+  result->duration_ms = duration_s * 1000.0;
+
+  if (region.resolved) {
+    // Counters at end: the latest ones plus the latest power since
+    double tail_s = std::max<int64_t>(end_us - latest_us, 0) / 1e6;
+    result->samples = latest_index - region.first_index + 1;
+    for (size_t f = 0; f < METRIC_FIELD_COUNT; f++) {
+      double end_joules = latest_totals.*metric_fields[f] + latest_watts.*metric_fields[f] * tail_s;
+      result->joules.*metric_fields[f] = end_joules - region.begin_joules.*metric_fields[f];
+      result->peak_watts.*metric_fields[f] = PeakSince(f, region.first_index);
+    }
+  } else {
+    // Begun and ended within one window: all we know is its power
+    result->samples = 0;
+    for (size_t f = 0; f < METRIC_FIELD_COUNT; f++) {
+      result->joules.*metric_fields[f] = latest_watts.*metric_fields[f] * duration_s;
+      result->peak_watts.*metric_fields[f] = latest_watts.*metric_fields[f];
+    }
+  }
+
+  for (size_t f = 0; f < METRIC_FIELD_COUNT; f++) {
+    result->mean_watts.*metric_fields[f] = duration_s > 0 ? result->joules.*metric_fields[f] / duration_s : 0.0;
+  }
+
+  open_from.erase(open_from.find(region.first_index));
+  regions.erase(it);
+  PrunePeaks();
+  return true;
+}
+
+size_t SMCOpenEnergyRegions() {
+  std::lock_guard<std::mutex> lock(regions_lock);
+  return regions.size();
+}
@@ -0,0 +1,141 @@
+/*
+ * IOReport groups and sample layout
+ *
+ * IOReport samples every channel of a subscription in one call, whatever
+ * group it belongs to, so the background sampler keeps one subscription to
+ * the union of the groups its consumers read (the Energy Model for power,
+ * CPU Stats and GPU Stats for residencies) and samples it once per tick.
+ * Each consumer is handed the channels of its own group and reads them out
+ * of the shared sample by offset.
+ *
+ * A sample is one flat run of integers: one per simple channel, and one per
+ * state for a state channel, in channel order. SMCLayOutReport() gives every
+ * channel its offset once per subscription.
+ *
+ * The canned source plays recorded channels of any group back through the
+ * same path as the IOReport source.
+ */
+
+#include <string.h>
+
+#include "smc.h"
+
+bool SMCReportGroupMatches(const SMCReportGroup& group, const std::string& name, const std::string& subgroup) {
+  return name == group.group && (!group.subgroup || subgroup == group.subgroup);
+}
+
+static bool Covers(const SMCReportGroup& outer, const SMCReportGroup& inner) {
+  if (strcmp(outer.group, inner.group) != 0) {
+    return false;
+  }
+  return !outer.subgroup || (inner.subgroup && strcmp(outer.subgroup, inner.subgroup) == 0);
+}
+
+std::vector<SMCReportGroup> SMCMergeReportGroups(const std::vector<SMCReportGroup>& groups) {
+  std::vector<SMCReportGroup> merged;
+  for (size_t i = 0; i < groups.size(); i++) {
+    bool covered = false;
+    for (size_t j = 0; j < groups.size() && !covered; j++) {
+      // A whole group covers its subgroups; of equal entries the first stays
+      covered = j != i && Covers(groups[j], groups[i]) && (!Covers(groups[i], groups[j]) || j < i);
+    }
+    if (!covered) {
+      merged.push_back(groups[i]);
+    }
+  }
+  return merged;
+}
+
+static size_t ValueCount(const SMCReportChannelInfo& channel) {
+  return channel.format == SMC_REPORT_STATE ? channel.states.size() : 1;
+}
+
+size_t SMCLayOutReport(std::vector<SMCReportChannelInfo>* channels) {
+  size_t offset = 0;
+  for (size_t i = 0; i < channels->size(); i++) {
+    (*channels)[i].offset = (uint32_t)offset;
+    offset += ValueCount((*channels)[i]);
+  }
+  return offset;
+}
+
+static bool CannedStart(void* ctx, const std::vector<SMCReportGroup>& groups,
+                        std::vector<SMCReportChannelInfo>* channels) {
+  SMCPowerCanned* canned = (SMCPowerCanned*)ctx;
+  canned->started.clear();
+  canned->started_from.clear();
+  for (size_t i = 0; i < canned->channels.size(); i++) {
+    const SMCReportChannelInfo& channel = canned->channels[i];
+    for (size_t g = 0; g < groups.size(); g++) {
+      if (SMCReportGroupMatches(groups[g], channel.group, channel.subgroup)) {
+        canned->started.push_back(channel);
+        canned->started_from.push_back(i);
+        break;
+      }
+    }
+  }
+  SMCLayOutReport(&canned->started);
+  *channels = canned->started;
+  return true;
+}
+
+static void CannedStop(void* /*ctx*/) {
+}
+
+static bool CannedSample(void* ctx, int64_t* values, size_t count) {
+  SMCPowerCanned* canned = (SMCPowerCanned*)ctx;
+  for (size_t i = 0; i < canned->started.size(); i++) {
+    const SMCReportChannelInfo& channel = canned->started[i];
+    const std::vector<int64_t>& recorded = canned->values[canned->started_from[i]];
+    size_t width = ValueCount(channel);
+    size_t samples = recorded.size() / width;
+    for (size_t v = 0; v < width && channel.offset + v < count; v++) {
+      values[channel.offset + v] = samples == 0 ? 0 : recorded[(canned->next % samples) * width + v];
+    }
+  }
+  canned->next++;
+  return true;
+}
+
+SMCPowerCanned* SMCPowerCannedCreate() {
+  SMCPowerCanned* canned = new SMCPowerCanned();
+  canned->next = 0;
+  canned->source.name = "canned";
+  canned->source.start = CannedStart;
+  canned->source.stop = CannedStop;
+  canned->source.sample = CannedSample;
+  canned->source.ctx = canned;
+  return canned;
+}
+
+// values are raw channel deltas in unit, as IOReport reports them
+bool SMCPowerCannedAddChannel(SMCPowerCanned* canned, const char* name, const char* unit,
+                              const std::vector<int64_t>& values) {
+  if (SMCEnergyUnitScale(unit) == 0.0) {
+    return false;
+  }
+
+  SMCReportChannelInfo channel;
+  channel.group = "Energy Model";
+  channel.name = name;
+  channel.unit = unit;
+  channel.format = SMC_REPORT_SIMPLE;
+  channel.offset = 0;
+  return SMCPowerCannedAddReportChannel(canned, channel, values);
+}
+
+bool SMCPowerCannedAddReportChannel(SMCPowerCanned* canned, const SMCReportChannelInfo& channel,
+                                    const std::vector<int64_t>& values) {
+  size_t width = ValueCount(channel);
+  if (width == 0 || values.size() % width != 0) {
+    return false;
+  }
+
+  canned->channels.push_back(channel);
+  canned->values.push_back(values);
+  return true;
+}
+
+void SMCPowerCannedDestroy(SMCPowerCanned* canned) {
+  delete canned;
+}
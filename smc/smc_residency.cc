@@ -0,0 +1,272 @@
+/*
+ * CPU and GPU frequency from state residency
+ *
+ * The IOReport "CPU Stats" group has one state channel per CPU cluster
+ * ("CPU Complex Performance States") and per core ("CPU Core Performance
+ * States"), and "GPU Stats" one for the GPU (GPUPH, "GPU Performance
+ * States"). Each reports the time spent in every performance state since
+ * the previous sample: first the inactive ones (IDLE, DOWN, OFF), then one
+ * state per DVFS operating point, slowest first. Weighting each active
+ * state's residency by the frequency of its operating point gives the mean
+ * frequency the cluster, core or GPU actually ran at while active, so
+ * throttling and boost show up where tick-based utilization only sees
+ * "busy". The GPU's active share is its utilization.
+ *
+ * The operating point frequencies are the DVFS tables of the pmgr device,
+ * read by the addon; the states do not carry them. State names and tables
+ * are matched once per subscription (SMCBuildResidencyIndex()), so a sample
+ * is a weighted sum over integers by position.
+ *
+ * CPU Stats and GPU Stats are only subscribed to once something asks for
+ * them: the first read adds the consumer below to the sampler, which keeps
+ * it from then on.
+ */
+
+#include <string.h>
+#include <condition_variable>
+#include <mutex>
+
+#include "smc.h"
+
+static const char* const CPU_STATS_GROUP = "CPU Stats";
+static const char* const CPU_COMPLEX_SUBGROUP = "CPU Complex Performance States";
+static const char* const CPU_CORE_SUBGROUP = "CPU Core Performance States";
+static const char* const GPU_STATS_GROUP = "GPU Stats";
+static const char* const GPU_SUBGROUP = "GPU Performance States";
+static const char* const GPU_CHANNEL = "GPUPH";
+
+static std::mutex dvfs_lock;
+static SMCDvfsTables dvfs_tables;
+
+void SMCSetDvfsTables(const SMCDvfsTables& tables) {
+  std::lock_guard<std::mutex> lock(dvfs_lock);
+  dvfs_tables = tables;
+}
+
+SMCDvfsTables SMCGetDvfsTables() {
+  std::lock_guard<std::mutex> lock(dvfs_lock);
+  return dvfs_tables;
+}
+
+static bool InactiveState(const std::string& state) {
+  return state == "IDLE" || state == "DOWN" || state == "OFF";
+}
+
+// Active states take the table's frequencies in order. Any beyond the end of
+// the table count as active time at an unknown frequency.
+SMCResidencyIndex SMCBuildResidencyIndex(const std::vector<std::string>& states, const std::vector<double>& mhz) {
+  SMCResidencyIndex index;
+  size_t operating_point = 0;
+  for (size_t i = 0; i < states.size(); i++) {
+    bool active = !InactiveState(states[i]);
+    index.active.push_back(active ? 1 : 0);
+    index.mhz.push_back(active && operating_point < mhz.size() ? mhz[operating_point] : 0.0);
+    if (active) {
+      operating_point++;
+    }
+  }
+  return index;
+}
+
+SMCResidencySummary SMCSummarizeResidency(const SMCResidencyIndex& index, const int64_t* residencies) {
+  double total = 0.0;
+  double active = 0.0;
+  double weighted = 0.0;
+  double known = 0.0;  // Active residency at a known frequency
+  for (size_t i = 0; i < index.mhz.size(); i++) {
+    double residency = (double)residencies[i];
+    total += residency;
+    if (!index.active[i]) continue;
+
+    active += residency;
+    if (index.mhz[i] > 0) {
+      weighted += residency * index.mhz[i];
+      known += residency;
+    }
+  }
+
+  SMCResidencySummary summary;
+  summary.active_mhz = known > 0 ? weighted / known : 0.0;
+  summary.active_ratio = total > 0 ? active / total : 0.0;
+  summary.idle_ratio = total > 0 ? 1.0 - summary.active_ratio : 0.0;
+  return summary;
+}
+
+typedef struct {
+  SMCCpuFrequency frequency;
+  SMCResidencyIndex index;
+  uint32_t offset;
+} CpuChannel;
+
+static std::mutex residency_lock;  // Guards everything below
+static std::condition_variable residency_sampled;
+static std::vector<CpuChannel> cpu_channels;
+static bool cpu_has_sample = false;  // Since the latest describe
+static bool cpu_consumer_added = false;
+static SMCGpuFrequency gpu;
+static SMCResidencyIndex gpu_index;
+static uint32_t gpu_offset = 0;
+static bool gpu_has_channel = false;
+static bool gpu_has_sample = false;
+static bool gpu_consumer_added = false;
+
+// Add consumer to the sampler on first use, start the sampler and wait up to
+// wait_ms in all for *sampled. Neither happens while the power source is
+// unavailable. Returns holding residency_lock.
+static std::unique_lock<std::mutex> WaitForSample(const SMCReportConsumer* consumer, bool* added,
+                                                  const bool* sampled, uint32_t wait_ms) {
+  if (SMCPowerSourceUnavailable()) {
+    return std::unique_lock<std::mutex>(residency_lock);
+  }
+
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(wait_ms);
+  bool add;
+  {
+    std::lock_guard<std::mutex> lock(residency_lock);
+    add = !*added;
+    *added = true;
+  }
+  if (add) {
+    SMCAddReportConsumer(consumer);
+  }
+
+  // Starts the sampler if it is not running; no point waiting if it has nothing
+  SMCPowerSnapshot snapshot;
+  bool sampling = SMCReadPowerSnapshot(&snapshot, wait_ms);
+
+  std::unique_lock<std::mutex> lock(residency_lock);
+  if (sampling) {
+    residency_sampled.wait_until(lock, deadline, [sampled] { return *sampled; });
+  }
+  return lock;
+}
+
+// Cluster and core of a CPU Stats channel. Names follow the Energy Model's
+// (ECPU, PCPU1, PACC0_CPU2, DIE_1_ prefixes), but a number right after
+// ECPU/PCPU is a core in the core subgroup and a cluster in the complex one.
+static bool ParseCpuChannel(const SMCReportChannelInfo& info, SMCCpuFrequency* frequency) {
+  bool complex = info.subgroup == CPU_COMPLEX_SUBGROUP;
+  if (info.format != SMC_REPORT_STATE || (!complex && info.subgroup != CPU_CORE_SUBGROUP)) {
+    return false;
+  }
+
+  SMCEnergyClass cls = SMCClassifyEnergyChannel(info.name.c_str());
+  if (!cls.cluster_type) {
+    return false;
+  }
+
+  frequency->name = info.name;
+  frequency->cluster_type = cls.cluster_type;
+  frequency->cluster = cls.cluster;
+  frequency->core = cls.core;
+  frequency->die = cls.die;
+  if (complex && cls.core >= 0) {
+    frequency->cluster = cls.core;
+    frequency->core = -1;
+  } else if (!complex && cls.core < 0) {
+    return false;
+  }
+  return true;
+}
+
+static void DescribeCpuStats(void* /*ctx*/, const std::vector<SMCReportChannelInfo>& infos) {
+  SMCDvfsTables tables = SMCGetDvfsTables();
+  std::vector<CpuChannel> described;
+  for (const SMCReportChannelInfo& info : infos) {
+    CpuChannel channel;
+    if (!ParseCpuChannel(info, &channel.frequency)) continue;
+
+    const std::vector<double>& mhz = channel.frequency.cluster_type == 'E' ? tables.ecpu : tables.pcpu;
+    channel.frequency.max_mhz = mhz.empty() ? 0.0 : mhz.back();
+    channel.frequency.residency = SMCResidencySummary{0.0, 0.0, 0.0};
+    channel.index = SMCBuildResidencyIndex(info.states, mhz);
+    channel.offset = info.offset;
+    described.push_back(channel);
+  }
+
+  std::lock_guard<std::mutex> lock(residency_lock);
+  cpu_channels.swap(described);
+  cpu_has_sample = false;
+}
+
+static void SampleCpuStats(void* /*ctx*/, const int64_t* values, int64_t /*now_us*/, int64_t /*window_us*/) {
+  std::lock_guard<std::mutex> lock(residency_lock);
+  for (CpuChannel& channel : cpu_channels) {
+    channel.frequency.residency = SMCSummarizeResidency(channel.index, values + channel.offset);
+  }
+  cpu_has_sample = true;
+  residency_sampled.notify_all();
+}
+
+static const SMCReportConsumer cpu_consumer = {
+  "cpu frequency", {CPU_STATS_GROUP, NULL}, DescribeCpuStats, SampleCpuStats, NULL
+};
+
+bool SMCGetCpuFrequencies(std::vector<SMCCpuFrequency>* frequencies, uint32_t wait_ms) {
+  std::unique_lock<std::mutex> lock = WaitForSample(&cpu_consumer, &cpu_consumer_added, &cpu_has_sample, wait_ms);
+  frequencies->clear();
+  for (const CpuChannel& channel : cpu_channels) {
+    frequencies->push_back(channel.frequency);
+  }
+  return cpu_has_sample;
+}
+
+static void DescribeGpuStats(void* /*ctx*/, const std::vector<SMCReportChannelInfo>& infos) {
+  SMCDvfsTables tables = SMCGetDvfsTables();
+  std::lock_guard<std::mutex> lock(residency_lock);
+  gpu_has_channel = false;
+  gpu_has_sample = false;
+  for (const SMCReportChannelInfo& info : infos) {
+    if (info.format != SMC_REPORT_STATE || info.name != GPU_CHANNEL) continue;
+
+    gpu.name = info.name;
+    gpu.max_mhz = tables.gpu.empty() ? 0.0 : tables.gpu.back();
+    gpu.residency = SMCResidencySummary{0.0, 0.0, 0.0};
+    gpu_index = SMCBuildResidencyIndex(info.states, tables.gpu);
+    gpu_offset = info.offset;
+    gpu.state_mhz.clear();
+    for (size_t i = 0; i < gpu_index.mhz.size(); i++) {
+      if (gpu_index.active[i]) {
+        gpu.state_mhz.push_back(gpu_index.mhz[i]);
+      }
+    }
+    gpu.state_ratio.assign(gpu.state_mhz.size(), 0.0);
+    gpu_has_channel = true;
+    break;
+  }
+}
+
+static void SampleGpuStats(void* /*ctx*/, const int64_t* values, int64_t /*now_us*/, int64_t /*window_us*/) {
+  std::lock_guard<std::mutex> lock(residency_lock);
+  if (!gpu_has_channel) {
+    return;
+  }
+
+  const int64_t* residencies = values + gpu_offset;
+  gpu.residency = SMCSummarizeResidency(gpu_index, residencies);
+
+  double total = 0.0;
+  for (size_t i = 0; i < gpu_index.mhz.size(); i++) {
+    total += (double)residencies[i];
+  }
+  for (size_t i = 0, state = 0; i < gpu_index.mhz.size(); i++) {
+    if (gpu_index.active[i]) {
+      gpu.state_ratio[state++] = total > 0 ? residencies[i] / total : 0.0;
+    }
+  }
+  gpu_has_sample = true;
+  residency_sampled.notify_all();
+}
+
+static const SMCReportConsumer gpu_consumer = {
+  "gpu frequency", {GPU_STATS_GROUP, GPU_SUBGROUP}, DescribeGpuStats, SampleGpuStats, NULL
+};
+
+bool SMCGetGpuFrequency(SMCGpuFrequency* frequency, uint32_t wait_ms) {
+  std::unique_lock<std::mutex> lock = WaitForSample(&gpu_consumer, &gpu_consumer_added, &gpu_has_sample, wait_ms);
+  if (!gpu_has_sample || !gpu_has_channel) {
+    return false;
+  }
+  *frequency = gpu;
+  return true;
+}
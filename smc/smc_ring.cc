@@ -0,0 +1,70 @@
+/*
+ * Sample ring
+ *
+ * Carries samples from a sampling thread to the JS thread without locks.
+ * The producer writes a slot and then publishes it by advancing head; the
+ * consumer reads the slot at tail and claims it by advancing tail with a
+ * compare-and-swap. When the ring is full the producer claims the oldest
+ * slot the same way, so a slow consumer loses its oldest samples instead of
+ * stalling the producer or growing the queue. Positions only ever grow, so
+ * a claim that lost the race simply retries.
+ */
+
+#include "smc.h"
+
+SMCRing* SMCRingCreate(size_t capacity) {
+  SMCRing* ring = new SMCRing();
+  ring->capacity = capacity > 0 ? capacity : 1;
+  ring->slots = new std::atomic<void*>[ring->capacity];
+  for (size_t i = 0; i < ring->capacity; i++) {
+    ring->slots[i].store(NULL, std::memory_order_relaxed);
+  }
+  ring->head.store(0, std::memory_order_relaxed);
+  ring->tail.store(0, std::memory_order_relaxed);
+  return ring;
+}
+
+void SMCRingDestroy(SMCRing* ring) {
+  delete[] ring->slots;
+  delete ring;
+}
+
+void* SMCRingPush(SMCRing* ring, void* item) {
+  void* evicted = NULL;
+  uint64_t head = ring->head.load(std::memory_order_relaxed);
+  uint64_t tail = ring->tail.load(std::memory_order_acquire);
+
+  while (head - tail >= ring->capacity) {
+    void* oldest = ring->slots[tail % ring->capacity].load(std::memory_order_acquire);
+    if (ring->tail.compare_exchange_weak(tail, tail + 1, std::memory_order_acq_rel, std::memory_order_acquire)) {
+      evicted = oldest;
+      break;
+    }
+  }
+
+  ring->slots[head % ring->capacity].store(item, std::memory_order_release);
+  ring->head.store(head + 1, std::memory_order_release);
+  return evicted;
+}
+
+void* SMCRingPop(SMCRing* ring) {
+  uint64_t tail = ring->tail.load(std::memory_order_acquire);
+
+  for (;;) {
+    uint64_t head = ring->head.load(std::memory_order_acquire);
+    if (tail >= head) {
+      return NULL;
+    }
+
+    void* item = ring->slots[tail % ring->capacity].load(std::memory_order_acquire);
+    if (ring->tail.compare_exchange_weak(tail, tail + 1, std::memory_order_acq_rel, std::memory_order_acquire)) {
+      return item;
+    }
+  }
+}
+
+size_t SMCRingSize(SMCRing* ring) {
+  uint64_t tail = ring->tail.load(std::memory_order_acquire);
+  uint64_t head = ring->head.load(std::memory_order_acquire);
+  return head > tail ? (size_t)(head - tail) : 0;
+}
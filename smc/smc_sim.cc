@@ -0,0 +1,325 @@
+/*
+ * Simulated SMC device
+ *
+ * Answers SMCCall() requests from an in-memory key table the same way the
+ * AppleSMC user client does: READ_KEYINFO returns the key's size and type,
+ * READ_BYTES returns its value, and unknown keys come back with
+ * SMC_RESULT_KEY_NOT_FOUND. READ_INDEX walks the table in order and "#KEY"
+ * reports its size, so key enumeration works too.
+ *
+ * For load and selection tests the table can be seeded with the keys a
+ * given chip generation exposes, key values can follow a waveform instead of
+ * fixed bytes, and every call can be delayed or failed at a given rate.
+ * Opens and calls can also be made to fail a set number of times so the
+ * connection manager's reconnect path can be exercised without hardware.
+ */
+
+#include <math.h>
+#include <string.h>
+#include <thread>
+
+#include "smc.h"
+
+typedef struct {
+  const char* key;
+  const char* type;
+  double value;
+} SimPresetKey;
+
+// Representative keys per generation: the ones the addon selects by chip
+// (die temperature, fans, voltages, system power) plus CPU/GPU sensors
+static const SimPresetKey intel_keys[] = {
+  {"TC0P", "sp78", 52.5}, {"TC0D", "sp78", 58.25}, {"TG0D", "sp78", 49.75},
+  {"FNum", "ui8 ", 2},
+  {"F0Ac", "fpe2", 1800}, {"F0Mn", "fpe2", 1200}, {"F0Mx", "fpe2", 6000},
+  {"F1Ac", "fpe2", 1750}, {"F1Mn", "fpe2", 1200}, {"F1Mx", "fpe2", 5800},
+  {"VC0C", "fpe2", 1100}, {"VG0C", "fpe2", 900}, {"VM0R", "fpe2", 1200},
+  {"PSTR", "sp96", 14.5},
+  {NULL, NULL, 0}
+};
+
+static const SimPresetKey m1_keys[] = {
+  {"Tp01", "flt ", 45.5}, {"Tp05", "flt ", 46.0}, {"Tp09", "flt ", 47.5}, {"Tp0T", "flt ", 44.0},
+  {"Te05", "flt ", 40.0}, {"Te0L", "flt ", 41.0},
+  {"Tg05", "flt ", 38.0}, {"Tg0D", "flt ", 39.0},
+  {"FNum", "ui8 ", 1},
+  {"F0Ac", "flt ", 1350}, {"F0Mn", "flt ", 1200}, {"F0Mx", "flt ", 5800},
+  {"VC0C", "flt ", 0.95}, {"VG0C", "flt ", 0.85}, {"VM0R", "flt ", 1.1},
+  {"PSTR", "flt ", 9.5},
+  {NULL, NULL, 0}
+};
+
+static const SimPresetKey m2_keys[] = {
+  {"Tp01", "flt ", 46.5}, {"Tp05", "flt ", 47.0}, {"Tp0D", "flt ", 48.0}, {"Tp0H", "flt ", 46.0},
+  {"Te05", "flt ", 41.0}, {"Te0S", "flt ", 42.0},
+  {"Tg0f", "flt ", 39.0}, {"Tg0j", "flt ", 40.0},
+  {"FNum", "ui8 ", 1},
+  {"F0Ac", "flt ", 1400}, {"F0Mn", "flt ", 1200}, {"F0Mx", "flt ", 5900},
+  {"VC0C", "flt ", 0.97}, {"VG0C", "flt ", 0.86}, {"VM0R", "flt ", 1.1},
+  {"PSTR", "flt ", 10.5},
+  {NULL, NULL, 0}
+};
+
+static const SimPresetKey m3_keys[] = {
+  {"Tf04", "flt ", 51.0}, {"Tf09", "flt ", 50.0},
+  {"Tp01", "flt ", 48.0}, {"Tp09", "flt ", 49.0}, {"Tp0f", "flt ", 47.0},
+  {"Te05", "flt ", 42.0}, {"Te09", "flt ", 43.0},
+  {"Tg0f", "flt ", 40.0}, {"Tg1k", "flt ", 41.0},
+  {"FNum", "ui8 ", 2},
+  {"F0Ac", "flt ", 1500}, {"F0Mn", "flt ", 1200}, {"F0Mx", "flt ", 6000},
+  {"F1Ac", "flt ", 1550}, {"F1Mn", "flt ", 1200}, {"F1Mx", "flt ", 6000},
+  {"VC0C", "flt ", 0.98}, {"VG0C", "flt ", 0.88}, {"VM0R", "flt ", 1.1},
+  {"PSTR", "flt ", 12.0},
+  {NULL, NULL, 0}
+};
+
+static const SimPresetKey m4_keys[] = {
+  {"Tp01", "flt ", 49.0}, {"Tp05", "flt ", 50.0}, {"Tp0V", "flt ", 51.0}, {"Tp1h", "flt ", 48.5},
+  {"Te05", "flt ", 43.0}, {"Te0R", "flt ", 44.0},
+  {"Tg0G", "flt ", 41.0}, {"Tg0H", "flt ", 42.0},
+  {"FNum", "ui8 ", 1},
+  {"F0Ac", "flt ", 1450}, {"F0Mn", "flt ", 1200}, {"F0Mx", "flt ", 6200},
+  {"VC0C", "flt ", 0.99}, {"VG0C", "flt ", 0.9}, {"VM0R", "flt ", 1.1},
+  {"PSTR", "flt ", 11.0},
+  {NULL, NULL, 0}
+};
+
+static const SimPresetKey* PresetKeys(ChipGeneration chip) {
+  switch (chip) {
+    case CHIP_INTEL: return intel_keys;
+    case CHIP_M1: return m1_keys;
+    case CHIP_M2: return m2_keys;
+    case CHIP_M3: return m3_keys;
+    case CHIP_M4:
+    case CHIP_M5: return m4_keys;  // M5 keeps the M4 layout as far as the addon knows
+    default: return NULL;
+  }
+}
+
+static SMCSimKey* FindKey(SMCSimDevice* device, UInt32 key) {
+  auto found = device->index.find(key);
+  return found != device->index.end() ? &device->keys[found->second] : NULL;
+}
+
+// xorshift64*, uniform in [0, 1)
+static double NextRandom(SMCSimDevice* device) {
+  uint64_t x = device->rng;
+  x ^= x >> 12;
+  x ^= x << 25;
+  x ^= x >> 27;
+  device->rng = x;
+  return ((x * 0x2545F4914F6CDD1DULL) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// Fill in a key's bytes, sampling its waveform at the current time
+static void Sample(SMCSimDevice* device, const SMCSimKey* val, SMCBytes_t bytes) {
+  const SMCSimWave& wave = val->wave;
+  if (wave.shape == SMC_SIM_CONSTANT) {
+    memcpy(bytes, val->bytes, sizeof(SMCBytes_t));
+    return;
+  }
+
+  double t;
+  if (device->time_step_ms > 0) {
+    t = device->reads * device->time_step_ms;
+  } else {
+    t = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - device->start).count();
+  }
+  device->reads++;
+
+  double phase = wave.period_ms > 0 ? fmod(t, wave.period_ms) / wave.period_ms : 0;
+  double value;
+  switch (wave.shape) {
+    case SMC_SIM_SINE:
+      value = wave.min + (wave.max - wave.min) * (0.5 + 0.5 * sin(2 * M_PI * phase));
+      break;
+    case SMC_SIM_RAMP:
+      value = wave.min + (wave.max - wave.min) * phase;
+      break;
+    case SMC_SIM_SQUARE:
+      value = phase < 0.5 ? wave.max : wave.min;
+      break;
+    default:
+      value = wave.min + (wave.max - wave.min) * NextRandom(device);
+      break;
+  }
+
+  memset(bytes, 0, sizeof(SMCBytes_t));
+  SMCEncodeValue(val->dataType, val->dataSize, value, (UInt8*)bytes);
+}
+
+static kern_return_t SimOpen(void* ctx) {
+  SMCSimDevice* device = (SMCSimDevice*)ctx;
+  if (device->fail_opens > 0) {
+    device->fail_opens--;
+    return kIOReturnNoDevice;
+  }
+  return kIOReturnSuccess;
+}
+
+static void SimClose(void* /*ctx*/) {}
+
+static kern_return_t SimCall(void* ctx, int index, SMCKeyData_t* inputStructure,
+                             SMCKeyData_t* outputStructure) {
+  SMCSimDevice* device = (SMCSimDevice*)ctx;
+  device->calls++;
+
+  if (device->latency_us > 0) {
+    std::this_thread::sleep_for(std::chrono::microseconds(device->latency_us));
+  }
+
+  if (device->fail_calls > 0) {
+    device->fail_calls--;
+    device->errors++;
+    return kIOReturnNotResponding;
+  }
+
+  if (device->error_rate > 0 && NextRandom(device) < device->error_rate) {
+    device->errors++;
+    return kIOReturnNotResponding;
+  }
+
+  if (index != KERNEL_INDEX_SMC) {
+    return kIOReturnBadArgument;
+  }
+
+  memset(outputStructure, 0, sizeof(SMCKeyData_t));
+  outputStructure->key = inputStructure->key;
+
+  if (inputStructure->data8 == SMC_CMD_READ_INDEX) {
+    if (inputStructure->data32 >= device->keys.size()) {
+      outputStructure->result = (char)SMC_RESULT_KEY_INDEX_RANGE;
+      return kIOReturnSuccess;
+    }
+    outputStructure->key = device->keys[inputStructure->data32].key;
+    return kIOReturnSuccess;
+  }
+
+  const SMCSimKey* val = FindKey(device, inputStructure->key);
+  SMCSimKey count;
+  if (!val && inputStructure->key == SMC_KEY_COUNT) {
+    UInt32 size = (UInt32)device->keys.size();
+    memset(&count, 0, sizeof(count));
+    count.key = SMC_KEY_COUNT;
+    count.dataType = SMC_TYPE_UI32;
+    count.dataSize = 4;
+    count.bytes[0] = (char)(size >> 24);
+    count.bytes[1] = (char)(size >> 16);
+    count.bytes[2] = (char)(size >> 8);
+    count.bytes[3] = (char)size;
+    val = &count;
+  }
+  if (!val) {
+    outputStructure->result = (char)SMC_RESULT_KEY_NOT_FOUND;
+    return kIOReturnSuccess;
+  }
+
+  switch (inputStructure->data8) {
+    case SMC_CMD_READ_KEYINFO:
+      outputStructure->keyInfo.dataSize = val->dataSize;
+      outputStructure->keyInfo.dataType = val->dataType;
+      outputStructure->keyInfo.dataAttributes = 0x80;  // Readable
+      break;
+    case SMC_CMD_READ_BYTES: {
+      SMCBytes_t bytes;
+      Sample(device, val, bytes);
+      UInt32 size = inputStructure->keyInfo.dataSize;
+      if (size > sizeof(SMCBytes_t)) size = sizeof(SMCBytes_t);
+      memcpy(outputStructure->bytes, bytes, size);
+      break;
+    }
+    default:
+      return kIOReturnBadArgument;
+  }
+
+  return kIOReturnSuccess;
+}
+
+SMCSimDevice* SMCSimCreate() {
+  SMCSimDevice* device = new SMCSimDevice();
+  device->chip = CHIP_UNKNOWN;
+  device->fail_opens = 0;
+  device->fail_calls = 0;
+  device->error_rate = 0;
+  device->latency_us = 0;
+  device->time_step_ms = 0;
+  device->reads = 0;
+  device->start = std::chrono::steady_clock::now();
+  device->calls = 0;
+  device->errors = 0;
+  device->transport.name = "simulated";
+  device->transport.open = SimOpen;
+  device->transport.close = SimClose;
+  device->transport.call = SimCall;
+  device->transport.ctx = device;
+  SMCSimSeed(device, 1);
+  return device;
+}
+
+void SMCSimDestroy(SMCSimDevice* device) {
+  delete device;
+}
+
+// Add a key, or replace the one with the same name
+void SMCSimAddKey(SMCSimDevice* device, const char* key, const char* type, const UInt8* bytes, UInt32 size) {
+  SMCSimKey val;
+  memset(&val, 0, sizeof(val));
+
+  val.key = SMCKeyFromString(key);
+  val.dataType = SMCKeyFromString(type);
+  if (size > sizeof(val.bytes)) size = sizeof(val.bytes);
+  val.dataSize = size;
+  memcpy(val.bytes, bytes, size);
+  val.wave.shape = SMC_SIM_CONSTANT;
+
+  auto found = device->index.find(val.key);
+  if (found != device->index.end()) {
+    device->keys[found->second] = val;
+    return;
+  }
+  device->index[val.key] = device->keys.size();
+  device->keys.push_back(val);
+}
+
+// Add a key from a number, encoded according to its type
+bool SMCSimAddValue(SMCSimDevice* device, const char* key, const char* type, double value) {
+  UInt32 dataType = SMCKeyFromString(type);
+  UInt32 size = SMCTypeSize(dataType);
+  UInt8 bytes[sizeof(SMCBytes_t)] = {0};
+  if (!SMCEncodeValue(dataType, size, value, bytes)) {
+    return false;
+  }
+  SMCSimAddKey(device, key, type, bytes, size);
+  return true;
+}
+
+// Make a key's value follow a waveform. Only types with a decoder qualify.
+bool SMCSimSetWave(SMCSimDevice* device, const char* key, SMCSimWave wave) {
+  SMCSimKey* val = FindKey(device, SMCKeyFromString(key));
+  if (!val || SMCFindDecoder(val->dataType, val->dataSize) == SMC_DECODER_NONE) {
+    return false;
+  }
+  val->wave = wave;
+  return true;
+}
+
+// Seed the table with a chip generation's keys and report that generation
+void SMCSimAddChipKeys(SMCSimDevice* device, ChipGeneration chip) {
+  device->chip = chip;
+
+  const SimPresetKey* preset = PresetKeys(chip);
+  for (; preset && preset->key; preset++) {
+    SMCSimAddValue(device, preset->key, preset->type, preset->value);
+  }
+}
+
+void SMCSimSeed(SMCSimDevice* device, uint64_t seed) {
+  device->rng = seed ? seed : 1;
+}
+
+SMCSimStats SMCSimGetStats(const SMCSimDevice* device) {
+  SMCSimStats stats;
+  stats.calls = device->calls;
+  stats.errors = device->errors;
+  return stats;
+}
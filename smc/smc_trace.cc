@@ -0,0 +1,333 @@
+/*
+ * Record/replay SMC transports
+ *
+ * The recorder wraps another transport and appends every SMCCall() request
+ * and response, with timestamps, to a binary trace file. The replayer serves
+ * such a trace without hardware, so key discovery, caching and averaging can
+ * run off-Mac against what a real machine answered.
+ *
+ * Trace file layout, all integers little-endian:
+ *
+ *   header  8 bytes  "SMCTRACE"
+ *           u32      version (SMC_TRACE_VERSION)
+ *           u32      record size in bytes (SMC_TRACE_RECORD_SIZE)
+ *   record  u64      start of the call, ns since the trace began
+ *           u32      duration of the call in ns
+ *           i32      SMCCall index
+ *           i32      kern_return_t of the call
+ *           u32 u8 u32 u32        request key, data8, data32, keyInfo.dataSize
+ *           u32 u8 u8             response key, result, status
+ *           u32 u32 u8            response keyInfo dataSize, dataType, dataAttributes
+ *           32 bytes              response bytes
+ *
+ * Replay answers a request with the recorded responses for the same index,
+ * command, key and data32, in recorded order, repeating the last one once
+ * they run out. Requests the trace never saw get SMC_RESULT_KEY_NOT_FOUND.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+#include <unordered_map>
+
+#include "smc.h"
+
+static const char TRACE_MAGIC[8] = {'S', 'M', 'C', 'T', 'R', 'A', 'C', 'E'};
+
+typedef struct {
+  uint64_t time;
+  uint32_t duration;
+  int32_t index;
+  int32_t result;
+  SMCKeyData_t in;
+  SMCKeyData_t out;
+} TraceRecord;
+
+struct SMCTraceRecorder {
+  FILE* file;
+  const SMCTransport* source;
+  SMCTransport transport;
+  std::chrono::steady_clock::time_point start;
+  std::atomic<uint64_t> records;  // Read by SMCTraceRecordCount() without the connection lock
+};
+
+// Requests are matched on index, command, key and data32 (the READ_INDEX
+// position); everything else in SMCKeyData_t is derived from those
+typedef struct {
+  int32_t index;
+  UInt8 command;
+  UInt32 key;
+  UInt32 data32;
+} RequestId;
+
+static bool operator==(const RequestId& a, const RequestId& b) {
+  return a.index == b.index && a.command == b.command && a.key == b.key && a.data32 == b.data32;
+}
+
+struct RequestIdHash {
+  size_t operator()(const RequestId& id) const {
+    uint64_t h = ((uint64_t)id.key << 32) | id.data32;
+    h ^= ((uint64_t)id.command << 8 | (UInt8)id.index) * 0x9e3779b97f4a7c15ULL;
+    return (size_t)(h ^ (h >> 29));
+  }
+};
+
+static RequestId MakeRequestId(int index, const SMCKeyData_t* in) {
+  RequestId id;
+  id.index = index;
+  id.command = (UInt8)in->data8;
+  id.key = in->key;
+  id.data32 = id.command == SMC_CMD_READ_INDEX ? in->data32 : 0;
+  return id;
+}
+
+struct SMCTraceReplay {
+  std::vector<TraceRecord> records;
+  // Request -> indices of its records, and the next one to serve
+  std::unordered_map<RequestId, std::vector<size_t>, RequestIdHash> responses;
+  std::unordered_map<RequestId, size_t, RequestIdHash> cursors;
+  bool latency;
+  SMCTransport transport;
+  // Bumped by calls under the connection lock, read by SMCTraceReplayGetStats() without it
+  std::atomic<uint64_t> served;
+  std::atomic<uint64_t> misses;
+};
+
+// Little-endian (de)serialization
+
+static void PutU8(UInt8** p, UInt8 v) {
+  *(*p)++ = v;
+}
+
+static void PutU32(UInt8** p, uint32_t v) {
+  for (int i = 0; i < 4; i++) *(*p)++ = (UInt8)(v >> (8 * i));
+}
+
+static void PutU64(UInt8** p, uint64_t v) {
+  for (int i = 0; i < 8; i++) *(*p)++ = (UInt8)(v >> (8 * i));
+}
+
+static UInt8 GetU8(const UInt8** p) {
+  return *(*p)++;
+}
+
+static uint32_t GetU32(const UInt8** p) {
+  uint32_t v = 0;
+  for (int i = 0; i < 4; i++) v |= (uint32_t)*(*p)++ << (8 * i);
+  return v;
+}
+
+static uint64_t GetU64(const UInt8** p) {
+  uint64_t v = 0;
+  for (int i = 0; i < 8; i++) v |= (uint64_t)*(*p)++ << (8 * i);
+  return v;
+}
+
+static void EncodeRecord(const TraceRecord& record, UInt8* buffer) {
+  UInt8* p = buffer;
+  PutU64(&p, record.time);
+  PutU32(&p, record.duration);
+  PutU32(&p, (uint32_t)record.index);
+  PutU32(&p, (uint32_t)record.result);
+  PutU32(&p, record.in.key);
+  PutU8(&p, (UInt8)record.in.data8);
+  PutU32(&p, record.in.data32);
+  PutU32(&p, record.in.keyInfo.dataSize);
+  PutU32(&p, record.out.key);
+  PutU8(&p, (UInt8)record.out.result);
+  PutU8(&p, (UInt8)record.out.status);
+  PutU32(&p, record.out.keyInfo.dataSize);
+  PutU32(&p, record.out.keyInfo.dataType);
+  PutU8(&p, (UInt8)record.out.keyInfo.dataAttributes);
+  memcpy(p, record.out.bytes, sizeof(SMCBytes_t));
+}
+
+static void DecodeRecord(const UInt8* buffer, TraceRecord* record) {
+  const UInt8* p = buffer;
+  memset(record, 0, sizeof(TraceRecord));
+  record->time = GetU64(&p);
+  record->duration = GetU32(&p);
+  record->index = (int32_t)GetU32(&p);
+  record->result = (int32_t)GetU32(&p);
+  record->in.key = GetU32(&p);
+  record->in.data8 = (char)GetU8(&p);
+  record->in.data32 = GetU32(&p);
+  record->in.keyInfo.dataSize = GetU32(&p);
+  record->out.key = GetU32(&p);
+  record->out.result = (char)GetU8(&p);
+  record->out.status = (char)GetU8(&p);
+  record->out.keyInfo.dataSize = GetU32(&p);
+  record->out.keyInfo.dataType = GetU32(&p);
+  record->out.keyInfo.dataAttributes = (char)GetU8(&p);
+  memcpy(record->out.bytes, p, sizeof(SMCBytes_t));
+}
+
+// Recorder
+
+static kern_return_t RecordOpen(void* ctx) {
+  SMCTraceRecorder* recorder = (SMCTraceRecorder*)ctx;
+  return recorder->source->open(recorder->source->ctx);
+}
+
+static void RecordClose(void* ctx) {
+  SMCTraceRecorder* recorder = (SMCTraceRecorder*)ctx;
+  recorder->source->close(recorder->source->ctx);
+  fflush(recorder->file);
+}
+
+static kern_return_t RecordCall(void* ctx, int index, SMCKeyData_t* inputStructure,
+                                SMCKeyData_t* outputStructure) {
+  SMCTraceRecorder* recorder = (SMCTraceRecorder*)ctx;
+
+  auto begin = std::chrono::steady_clock::now();
+  kern_return_t result = recorder->source->call(recorder->source->ctx, index, inputStructure,
+                                                outputStructure);
+  auto end = std::chrono::steady_clock::now();
+
+  TraceRecord record;
+  record.time = std::chrono::duration_cast<std::chrono::nanoseconds>(begin - recorder->start).count();
+  record.duration = (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+  record.index = index;
+  record.result = result;
+  record.in = *inputStructure;
+  record.out = *outputStructure;
+
+  UInt8 buffer[SMC_TRACE_RECORD_SIZE];
+  EncodeRecord(record, buffer);
+  fwrite(buffer, sizeof(buffer), 1, recorder->file);
+  recorder->records++;
+
+  return result;
+}
+
+SMCTraceRecorder* SMCTraceRecordCreate(const char* path, const SMCTransport* source) {
+  FILE* file = fopen(path, "wb");
+  if (!file) {
+    return NULL;
+  }
+
+  UInt8 header[16];
+  UInt8* p = header + sizeof(TRACE_MAGIC);
+  memcpy(header, TRACE_MAGIC, sizeof(TRACE_MAGIC));
+  PutU32(&p, SMC_TRACE_VERSION);
+  PutU32(&p, SMC_TRACE_RECORD_SIZE);
+  fwrite(header, sizeof(header), 1, file);
+
+  SMCTraceRecorder* recorder = new SMCTraceRecorder();
+  recorder->file = file;
+  recorder->source = source;
+  recorder->start = std::chrono::steady_clock::now();
+  recorder->records = 0;
+  recorder->transport.name = "record";
+  recorder->transport.open = RecordOpen;
+  recorder->transport.close = RecordClose;
+  recorder->transport.call = RecordCall;
+  recorder->transport.ctx = recorder;
+  return recorder;
+}
+
+const SMCTransport* SMCTraceRecordTransport(SMCTraceRecorder* recorder) {
+  return &recorder->transport;
+}
+
+uint64_t SMCTraceRecordCount(SMCTraceRecorder* recorder) {
+  return recorder->records;
+}
+
+void SMCTraceRecordDestroy(SMCTraceRecorder* recorder) {
+  fclose(recorder->file);
+  delete recorder;
+}
+
+// Replayer
+
+static kern_return_t ReplayOpen(void* /*ctx*/) {
+  return kIOReturnSuccess;
+}
+
+static void ReplayClose(void* /*ctx*/) {}
+
+static kern_return_t ReplayCall(void* ctx, int index, SMCKeyData_t* inputStructure,
+                                SMCKeyData_t* outputStructure) {
+  SMCTraceReplay* replay = (SMCTraceReplay*)ctx;
+  RequestId id = MakeRequestId(index, inputStructure);
+
+  memset(outputStructure, 0, sizeof(SMCKeyData_t));
+
+  auto found = replay->responses.find(id);
+  if (found == replay->responses.end()) {
+    replay->misses++;
+    outputStructure->key = inputStructure->key;
+    outputStructure->result = (char)SMC_RESULT_KEY_NOT_FOUND;
+    return kIOReturnSuccess;
+  }
+
+  size_t& cursor = replay->cursors[id];
+  const TraceRecord& record = replay->records[found->second[cursor]];
+  if (cursor + 1 < found->second.size()) {
+    cursor++;
+  }
+
+  replay->served++;
+  if (replay->latency && record.duration > 0) {
+    std::this_thread::sleep_for(std::chrono::nanoseconds(record.duration));
+  }
+
+  *outputStructure = record.out;
+  return record.result;
+}
+
+SMCTraceReplay* SMCTraceReplayCreate(const char* path, bool latency) {
+  FILE* file = fopen(path, "rb");
+  if (!file) {
+    return NULL;
+  }
+
+  UInt8 header[16];
+  const UInt8* p = header + sizeof(TRACE_MAGIC);
+  if (fread(header, sizeof(header), 1, file) != 1 ||
+      memcmp(header, TRACE_MAGIC, sizeof(TRACE_MAGIC)) != 0 ||
+      GetU32(&p) != SMC_TRACE_VERSION || GetU32(&p) != SMC_TRACE_RECORD_SIZE) {
+    fclose(file);
+    return NULL;
+  }
+
+  SMCTraceReplay* replay = new SMCTraceReplay();
+  replay->latency = latency;
+  replay->served = 0;
+  replay->misses = 0;
+
+  UInt8 buffer[SMC_TRACE_RECORD_SIZE];
+  while (fread(buffer, sizeof(buffer), 1, file) == 1) {
+    TraceRecord record;
+    DecodeRecord(buffer, &record);
+    replay->responses[MakeRequestId(record.index, &record.in)].push_back(replay->records.size());
+    replay->records.push_back(record);
+  }
+  fclose(file);
+
+  replay->transport.name = "replay";
+  replay->transport.open = ReplayOpen;
+  replay->transport.close = ReplayClose;
+  replay->transport.call = ReplayCall;
+  replay->transport.ctx = replay;
+  return replay;
+}
+
+const SMCTransport* SMCTraceReplayTransport(SMCTraceReplay* replay) {
+  return &replay->transport;
+}
+
+SMCTraceReplayStats SMCTraceReplayGetStats(SMCTraceReplay* replay) {
+  SMCTraceReplayStats stats;
+  stats.records = replay->records.size();
+  stats.served = replay->served;
+  stats.misses = replay->misses;
+  return stats;
+}
+
+void SMCTraceReplayDestroy(SMCTraceReplay* replay) {
+  delete replay;
+}
@@ -0,0 +1,156 @@
+/*
+ * SMC data type decoders
+ *
+ * Every type the SMC reports is a FourCC with a fixed value size. The table
+ * below maps each one to a decoder; keys resolve their decoder index once,
+ * when their key info is cached, so decoding a value is a single indexed
+ * call with no string compares.
+ *
+ * Integers and fixed point values are big-endian. spXY is signed with X
+ * integer and Y fraction bits, fpXY unsigned (fpe2 is 14.2). flt is a
+ * little-endian float on Apple Silicon.
+ *
+ * Each entry also has the matching encoder, which the simulated device uses
+ * to turn programmed values back into raw SMC bytes.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "smc.h"
+
+static inline UInt32 BE16(const UInt8 *b) {
+  return ((UInt32)b[0] << 8) | b[1];
+}
+
+static double DecodeNone(const UInt8 * /*b*/) { return NAN; }
+static double DecodeSP78(const UInt8 *b) { return (int16_t)BE16(b) / 256.0; }
+static double DecodeSP87(const UInt8 *b) { return (int16_t)BE16(b) / 128.0; }
+static double DecodeSP96(const UInt8 *b) { return (int16_t)BE16(b) / 64.0; }
+static double DecodeFPE2(const UInt8 *b) { return BE16(b) / 4.0; }
+static double DecodeFP88(const UInt8 *b) { return BE16(b) / 256.0; }
+static double DecodeUI8(const UInt8 *b) { return b[0]; }
+static double DecodeUI16(const UInt8 *b) { return BE16(b); }
+static double DecodeSI8(const UInt8 *b) { return (int8_t)b[0]; }
+static double DecodeSI16(const UInt8 *b) { return (int16_t)BE16(b); }
+static double DecodeFlag(const UInt8 *b) { return b[0] ? 1 : 0; }
+
+static double DecodeUI32(const UInt8 *b) {
+  return ((UInt32)b[0] << 24) | ((UInt32)b[1] << 16) | ((UInt32)b[2] << 8) | b[3];
+}
+
+static double DecodeFLT(const UInt8 *b) {
+  float f;
+  memcpy(&f, b, sizeof(float));
+  return f;
+}
+
+static inline void PutBE16(UInt8 *b, UInt32 v) {
+  b[0] = (UInt8)(v >> 8);
+  b[1] = (UInt8)v;
+}
+
+// Clamp to the range of the raw integer before converting
+static inline long Raw(double value, double scale, double min, double max) {
+  double raw = round(value * scale);
+  return (long)(raw < min ? min : raw > max ? max : raw);
+}
+
+static void EncodeNone(double /*v*/, UInt8 * /*b*/) {}
+static void EncodeSP78(double v, UInt8 *b) { PutBE16(b, (UInt32)Raw(v, 256, -32768, 32767)); }
+static void EncodeSP87(double v, UInt8 *b) { PutBE16(b, (UInt32)Raw(v, 128, -32768, 32767)); }
+static void EncodeSP96(double v, UInt8 *b) { PutBE16(b, (UInt32)Raw(v, 64, -32768, 32767)); }
+static void EncodeFPE2(double v, UInt8 *b) { PutBE16(b, (UInt32)Raw(v, 4, 0, 65535)); }
+static void EncodeFP88(double v, UInt8 *b) { PutBE16(b, (UInt32)Raw(v, 256, 0, 65535)); }
+static void EncodeUI8(double v, UInt8 *b) { b[0] = (UInt8)Raw(v, 1, 0, 255); }
+static void EncodeUI16(double v, UInt8 *b) { PutBE16(b, (UInt32)Raw(v, 1, 0, 65535)); }
+static void EncodeSI8(double v, UInt8 *b) { b[0] = (UInt8)Raw(v, 1, -128, 127); }
+static void EncodeSI16(double v, UInt8 *b) { PutBE16(b, (UInt32)Raw(v, 1, -32768, 32767)); }
+static void EncodeFlag(double v, UInt8 *b) { b[0] = v != 0 ? 1 : 0; }
+
+static void EncodeUI32(double v, UInt8 *b) {
+  UInt32 raw = (UInt32)Raw(v, 1, 0, 4294967295.0);
+  PutBE16(b, raw >> 16);
+  PutBE16(b + 2, raw);
+}
+
+static void EncodeFLT(double v, UInt8 *b) {
+  float f = (float)v;
+  memcpy(b, &f, sizeof(float));
+}
+
+const SMCDecoder smc_decoders[] = {
+  {0, 0, DecodeNone, EncodeNone},  // SMC_DECODER_NONE
+  {SMC_TYPE_SP78, 2, DecodeSP78, EncodeSP78},
+  {SMC_TYPE_SP87, 2, DecodeSP87, EncodeSP87},
+  {SMC_TYPE_SP96, 2, DecodeSP96, EncodeSP96},
+  {SMC_TYPE_FPE2, 2, DecodeFPE2, EncodeFPE2},
+  {SMC_TYPE_FP88, 2, DecodeFP88, EncodeFP88},
+  {SMC_TYPE_FLT, 4, DecodeFLT, EncodeFLT},
+  {SMC_TYPE_UI8, 1, DecodeUI8, EncodeUI8},
+  {SMC_TYPE_UI16, 2, DecodeUI16, EncodeUI16},
+  {SMC_TYPE_UI32, 4, DecodeUI32, EncodeUI32},
+  {SMC_TYPE_SI8, 1, DecodeSI8, EncodeSI8},
+  {SMC_TYPE_SI16, 2, DecodeSI16, EncodeSI16},
+  {SMC_TYPE_FLAG, 1, DecodeFlag, EncodeFlag},
+};
+
+static const UInt8 decoder_count = sizeof(smc_decoders) / sizeof(smc_decoders[0]);
+
+// Resolve the decoder for a type; a size that does not match the type
+// cannot be decoded either
+UInt8 SMCFindDecoder(UInt32 dataType, UInt32 dataSize) {
+  for (UInt8 i = 1; i < decoder_count; i++) {
+    if (smc_decoders[i].dataType == dataType) {
+      return smc_decoders[i].dataSize == dataSize ? i : SMC_DECODER_NONE;
+    }
+  }
+  return SMC_DECODER_NONE;
+}
+
+bool SMCDecodeValue(UInt32 dataType, const char *bytes, UInt32 dataSize, double *value) {
+  UInt8 decoder = SMCFindDecoder(dataType, dataSize);
+  if (decoder == SMC_DECODER_NONE) {
+    return false;
+  }
+  *value = SMCDecode(decoder, (const UInt8 *)bytes);
+  return true;
+}
+
+// Size of a type's values, 0 if the type is unknown
+UInt32 SMCTypeSize(UInt32 dataType) {
+  for (UInt8 i = 1; i < decoder_count; i++) {
+    if (smc_decoders[i].dataType == dataType) {
+      return smc_decoders[i].dataSize;
+    }
+  }
+  return 0;
+}
+
+bool SMCEncodeValue(UInt32 dataType, UInt32 dataSize, double value, UInt8 *bytes) {
+  UInt8 decoder = SMCFindDecoder(dataType, dataSize);
+  if (decoder == SMC_DECODER_NONE) {
+    return false;
+  }
+  smc_decoders[decoder].encode(value, bytes);
+  return true;
+}
+
+UInt32 SMCKeyFromString(const char *str) {
+  UInt32 value = 0;
+  bool end = false;
+  for (int i = 0; i < 4; i++) {
+    // Short names are space padded ("ui8" is "ui8 ")
+    if (!end && !str[i]) end = true;
+    value = (value << 8) | (UInt8)(end ? ' ' : str[i]);
+  }
+  return value;
+}
+
+void SMCKeyToString(UInt32 key, char *str) {
+  str[0] = (char)(key >> 24);
+  str[1] = (char)(key >> 16);
+  str[2] = (char)(key >> 8);
+  str[3] = (char)key;
+  str[4] = '\0';
+}
@@ -26,21 +26,16 @@ export interface Battery {
 }
 
 export async function getBatteryData(): Promise<Battery> {
-  return new Promise((resolve, reject) => {
-    try {
-      resolve(getBatteryDataSync());
-    } catch (error) {
-      reject(error);
-    }
-  });
+  const data = await smc.getBatteryDataAsync();
+  return parseBatteryData(data);
 }
 
 export function getBatteryDataSync(): Battery {
   const data = smc.getBatteryData();
-  return parseData(data);
+  return parseBatteryData(data);
 }
 
-interface RawBatteryData {
+export interface RawBatteryData {
   external_connected: boolean;
   battery_installed: boolean;
   is_charging: boolean;
@@ -58,7 +53,7 @@ interface RawBatteryData {
   health_percent: number;
 }
 
-function parseData(data: RawBatteryData): Battery {
+export function parseBatteryData(data: RawBatteryData): Battery {
   // Calculate power (Watts) = Voltage (mV) * Amperage (mA) / 1,000,000
   const power = data.voltage && data.amperage
     ? Math.abs((data.voltage * data.amperage) / 1000000)
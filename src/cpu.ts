@@ -31,17 +31,8 @@ export interface CPUUsage {
 }
 
 export async function getCpuData(): Promise<CPU> {
-  return new Promise((resolve, reject) => {
-    try {
-      resolve({
-        temperature: Math.round(smc.temperature()),
-        temperatureDie: Math.round(smc.cpuTemperatureDie()),
-        voltage: smc.cpuVoltage()
-      });
-    } catch (error) {
-      reject(error);
-    }
-  });
+  // Read on a worker thread; the event loop keeps running meanwhile
+  return parseCpuData(await smc.getCpuDataAsync());
 }
 
 export function getCpuDataSync(): CPU {
@@ -52,7 +43,21 @@ export function getCpuDataSync(): CPU {
   };
 }
 
-function parseCPUUsage(raw: RawCPUUsage): CPUUsage {
+export interface RawCPUData {
+  temperature: number;
+  temperature_die: number;
+  voltage: number;
+}
+
+export function parseCpuData(raw: RawCPUData): CPU {
+  return {
+    temperature: Math.round(raw.temperature),
+    temperatureDie: Math.round(raw.temperature_die),
+    voltage: raw.voltage
+  };
+}
+
+export function parseCPUUsage(raw: RawCPUUsage): CPUUsage {
   return {
     userLoad: raw.user_load,
     systemLoad: raw.system_load,
@@ -66,17 +71,78 @@ function parseCPUUsage(raw: RawCPUUsage): CPUUsage {
 }
 
 export async function getCPUUsage(): Promise<CPUUsage> {
-  return new Promise((resolve, reject) => {
-    try {
-      const raw: RawCPUUsage = smc.getCPUUsageData();
-      resolve(parseCPUUsage(raw));
-    } catch (error) {
-      reject(error);
-    }
-  });
+  const raw: RawCPUUsage = await smc.getCPUUsageDataAsync();
+  return parseCPUUsage(raw);
 }
 
 export function getCPUUsageSync(): CPUUsage {
   const raw: RawCPUUsage = smc.getCPUUsageData();
   return parseCPUUsage(raw);
 }
+
+// One CPU cluster or core over the latest power sampler window, from the
+// IOReport CPU Stats state residencies
+export interface CpuFrequency {
+  name: string;            // IOReport channel, e.g. 'PCPU' or 'PCPU3'; '' for a cluster made up from its cores
+  cluster: string;         // 'E0', 'P1'...
+  core: number | null;     // Core within the cluster, null for the whole cluster
+  die: number;             // Die on multi-die chips, else 0
+  active_mhz: number;      // Mean frequency while active, weighted by residency
+  active_ratio: number;    // Share of the window spent active (0.0 - 1.0)
+  idle_ratio: number;      // Share of the window idle or powered down (0.0 - 1.0)
+  max_mhz: number;         // Top of the cluster's DVFS table, 0 if unknown
+}
+
+export interface CpuClusterFrequency extends CpuFrequency {
+  cores: CpuFrequency[];
+}
+
+export interface CpuFrequencies {
+  clusters: CpuClusterFrequency[];
+  cores: CpuFrequency[];
+}
+
+// Clusters with their cores. The first call subscribes the power sampler to
+// CPU Stats and waits for a sample; both lists are empty without one.
+export function getCpuFrequencies(): CpuFrequencies {
+  const channels: CpuFrequency[] = smc.cpuFrequencies();
+  const clusters = new Map<string, CpuClusterFrequency & { measured: boolean }>();
+  const cores: CpuFrequency[] = [];
+
+  const clusterOf = (channel: CpuFrequency) => {
+    const key = `${channel.die}:${channel.cluster}`;
+    let cluster = clusters.get(key);
+    if (!cluster) {
+      cluster = { ...channel, name: '', core: null, active_mhz: 0, active_ratio: 0, idle_ratio: 0, cores: [], measured: false };
+      clusters.set(key, cluster);
+    }
+    return cluster;
+  };
+
+  for (const channel of channels) {
+    const cluster = clusterOf(channel);
+    if (channel.core === null) {
+      Object.assign(cluster, channel, { measured: true });
+    } else {
+      cluster.cores.push(channel);
+      cores.push(channel);
+    }
+  }
+
+  return {
+    clusters: [...clusters.values()].map(({ measured, ...cluster }) => {
+      if (!measured && cluster.cores.length > 0) {
+        // No cluster channel: its cores' mean, frequency weighted by active time
+        const active = cluster.cores.reduce((sum, core) => sum + core.active_ratio, 0);
+        cluster.active_ratio = active / cluster.cores.length;
+        cluster.idle_ratio = cluster.cores.reduce((sum, core) => sum + core.idle_ratio, 0) / cluster.cores.length;
+        cluster.active_mhz = active > 0
+          ? cluster.cores.reduce((sum, core) => sum + core.active_mhz * core.active_ratio, 0) / active
+          : 0;
+      }
+      cluster.cores.sort((a, b) => (a.core as number) - (b.core as number));
+      return cluster;
+    }),
+    cores
+  };
+}
@@ -33,7 +33,7 @@ function bytesToGB(bytes: number): number {
   return Math.round((bytes / (1024 * 1024 * 1024)) * 10) / 10;
 }
 
-function parseDiskInfo(raw: RawDiskInfo): DiskInfo {
+export function parseDiskInfo(raw: RawDiskInfo): DiskInfo {
   const usagePercent = raw.total_size > 0 
     ? Math.round((raw.used_size / raw.total_size) * 100)
     : 0;
@@ -55,15 +55,8 @@ function parseDiskInfo(raw: RawDiskInfo): DiskInfo {
 }
 
 export async function getDiskInfo(): Promise<DiskInfo[]> {
-  return new Promise((resolve, reject) => {
-    try {
-      const rawDisks: RawDiskInfo[] = smc.getDiskData();
-      const disks = rawDisks.map(parseDiskInfo);
-      resolve(disks);
-    } catch (error) {
-      reject(error);
-    }
-  });
+  const rawDisks: RawDiskInfo[] = await smc.getDiskDataAsync();
+  return rawDisks.map(parseDiskInfo);
 }
 
 export function getDiskInfoSync(): DiskInfo[] {
@@ -0,0 +1,48 @@
+import { createRequire } from 'node:module';
+
+const requireNative = createRequire(import.meta.url);
+const smc = requireNative('../build/Release/smc.node');
+
+// Opaque handle of an open energy region
+export type EnergyRegionHandle = number;
+
+export interface EnergyRegionMetrics {
+  cpu: number;
+  gpu: number;
+  ane: number;
+  ram: number;
+  gpu_ram: number;
+  total: number;
+}
+
+export interface EnergyRegion {
+  joules: EnergyRegionMetrics;      // Energy used between begin and end
+  mean_watts: EnergyRegionMetrics;  // joules over duration
+  peak_watts: EnergyRegionMetrics;  // Highest sampler window power, per field
+  duration_ms: number;
+  samples: number;                  // Sampler windows completed in the region, 0 if shorter than one
+}
+
+// Start measuring. Regions come from the power sampler's energy counters,
+// so any number can be open and overlap at no sampling cost. The first call
+// waits for a power sample.
+export function beginEnergyRegion(): EnergyRegionHandle {
+  return smc.beginEnergyRegion();
+}
+
+// Finish a region; each handle can be ended once
+export function endEnergyRegion(handle: EnergyRegionHandle): EnergyRegion {
+  return smc.endEnergyRegion(handle);
+}
+
+// Measure the energy of fn, which may be async
+export async function measureEnergy<T>(fn: () => T | Promise<T>): Promise<{ result: T; energy: EnergyRegion }> {
+  const handle = beginEnergyRegion();
+  try {
+    const result = await fn();
+    return { result, energy: endEnergyRegion(handle) };
+  } catch (error) {
+    endEnergyRegion(handle);
+    throw error;
+  }
+}
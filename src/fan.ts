@@ -1,4 +1,5 @@
 import { createRequire } from 'node:module';
+import { compileKeys, readKeys } from './smc.js';
 
 const requireNative = createRequire(import.meta.url);
 const smc = requireNative('../build/Release/smc.node');
@@ -14,24 +15,39 @@ export interface Fan {
 }
 
 export async function getFanData(): Promise<Fan> {
-  return new Promise((resolve, reject) => {
-    try {
-      resolve(fanData());
-    } catch (error) {
-      reject(error);
-    }
-  });
+  // Count and F<n>Ac/Mn/Mx are read in one batch on a worker thread
+  const { count, values }: { count: number; values: Float64Array } = await smc.getFanDataAsync();
+  return parseFanData(count, values);
 }
 
 export function getFanDataSync(): Fan {
   return fanData();
 }
 
+// F<n>Ac/F<n>Mn/F<n>Mx for every fan, compiled once per fan count
+let fanKeys = new Uint32Array(0);
+
+function fanKeysFor(count: number): Uint32Array {
+  if (fanKeys.length !== count * 3) {
+    fanKeys = compileKeys(Array.from(Array(count), (_, i) => [`F${i}Ac`, `F${i}Mn`, `F${i}Mx`]).flat());
+  }
+  return fanKeys;
+}
+
+function fanValue(value: number): number {
+  return Number.isNaN(value) ? 0 : Math.round(value);
+}
+
 function fanData(): Fan {
-  return Array.from(Array(smc.fans()), (_, i) => ({
-    rpm: smc.fanRpm(i),
-    min: smc.fanMin(i),
-    max: smc.fanMax(i)
+  const count: number = smc.fans();
+  return parseFanData(count, readKeys(fanKeysFor(count)).values);
+}
+
+export function parseFanData(count: number, values: Float64Array): Fan {
+  return Array.from(Array(count), (_, i) => ({
+    rpm: fanValue(values[i * 3]),
+    min: fanValue(values[i * 3 + 1]),
+    max: fanValue(values[i * 3 + 2])
   })).reduce((prev, curr, i) => {
     prev[i] = curr;
     return prev;
@@ -10,17 +10,17 @@ export interface GPU {
 }
 
 export async function getGpuData(): Promise<GPU> {
-  return new Promise((resolve, reject) => {
-    try {
-      resolve({
-        temperature: Math.round(smc.gpuTemperature()),
-        voltage: smc.gpuVoltage(),
-        usage: Math.round(smc.gpuUsage() * 100)
-      });
-    } catch (error) {
-      reject(error);
-    }
-  });
+  // Read on a worker thread; the event loop keeps running meanwhile
+  return parseGpuData(await smc.getGpuDataAsync());
+}
+
+// usage arrives as 0-1
+export function parseGpuData(raw: GPU): GPU {
+  return {
+    temperature: Math.round(raw.temperature),
+    voltage: raw.voltage,
+    usage: Math.round(raw.usage * 100)
+  };
 }
 
 export function getGpuDataSync(): GPU {
@@ -31,3 +31,33 @@ export function getGpuDataSync(): GPU {
   };
 }
 
+
+export interface GpuState {
+  mhz: number;             // Operating point frequency, 0 if unknown
+  ratio: number;           // Share of the window spent at it (0.0 - 1.0)
+}
+
+export interface GpuFrequency {
+  name: string;            // IOReport channel, 'GPUPH'
+  active_mhz: number;      // Mean frequency while active, weighted by residency
+  active_ratio: number;    // Share of the window spent active (0.0 - 1.0); the GPU's utilization
+  idle_ratio: number;      // Share of the window idle or powered down (0.0 - 1.0)
+  max_mhz: number;         // Top of the GPU's DVFS table, 0 if unknown
+  states: GpuState[];      // Active operating points, slowest first
+}
+
+export interface GpuMemory {
+  in_use: number;          // Bytes in use by the GPU
+  allocated: number;       // Bytes allocated to the GPU
+}
+
+// The first call subscribes the power sampler to GPU Stats and waits for a
+// sample; null without one.
+export function getGpuFrequency(): GpuFrequency | null {
+  return smc.gpuFrequency();
+}
+
+// null on machines without an IOAccelerator
+export function getGpuMemory(): GpuMemory | null {
+  return smc.gpuMemory();
+}
@@ -1,7 +1,13 @@
 export * from './battery.js';
 export * from './fan.js';
 export * from './cpu.js';
+export * from './energy-region.js';
 export * from './gpu.js';
 export * from './memory.js';
+export * from './metrics-block.js';
+export * from './metrics-buffer.js';
 export * from './power.js';
+export * from './refresh.js';
+export * from './smc.js';
+export * from './snapshot.js';
 export * from './system.js';
@@ -58,7 +58,7 @@ function bytesToGB(bytes: number): number {
   return Math.round((bytes / (1024 ** 3)) * 10) / 10;
 }
 
-function parseRAMUsage(raw: RawRAMUsage): RAMUsage {
+export function parseRAMUsage(raw: RawRAMUsage): RAMUsage {
   const usagePercent = raw.total > 0 ? Math.round((raw.used / raw.total) * 100) : 0;
 
   let pressureStatus = 'Normal';
@@ -100,15 +100,9 @@ function parseRAMUsage(raw: RawRAMUsage): RAMUsage {
 }
 
 export async function getMemoryData(): Promise<Memory> {
-  return new Promise((resolve, reject) => {
-    try {
-      resolve({
-        voltage: smc.memoryVoltage()
-      });
-    } catch (error) {
-      reject(error);
-    }
-  });
+  return {
+    voltage: await smc.memoryVoltageAsync()
+  };
 }
 
 export function getMemoryDataSync(): Memory {
@@ -118,14 +112,8 @@ export function getMemoryDataSync(): Memory {
 }
 
 export async function getRAMUsage(): Promise<RAMUsage> {
-  return new Promise((resolve, reject) => {
-    try {
-      const raw: RawRAMUsage = smc.getRAMUsageData();
-      resolve(parseRAMUsage(raw));
-    } catch (error) {
-      reject(error);
-    }
-  });
+  const raw: RawRAMUsage = await smc.getRAMUsageDataAsync();
+  return parseRAMUsage(raw);
 }
 
 export function getRAMUsageSync(): RAMUsage {
@@ -0,0 +1,107 @@
+import { createRequire } from 'node:module';
+import { RawCPUUsage } from './cpu.js';
+import { RawRAMUsage } from './memory.js';
+import { Power } from './power.js';
+
+const requireNative = createRequire(import.meta.url);
+const smc = requireNative('../build/Release/smc.node');
+
+// Layout of the shared metrics block, version 1. Header (Int32 words):
+// sequence, version, value count, reserved; then float64 values from byte 16.
+export const METRICS_BLOCK_VERSION = 1;
+export const METRICS_BLOCK_HEADER_BYTES = 16;
+
+// Value offsets; RAM usage, CPU usage and power follow getMetricsSchema() order
+export const MetricsBlockOffset = {
+  samples: 0,        // Samples written, 0 before the first
+  timestamp: 1,      // When the sample was taken, ms since the epoch
+  intervalMs: 2,
+  ram: 3,            // 13 values
+  cpuUsage: 16,      // 7 values
+  power: 23          // 7 values
+} as const;
+
+export const METRICS_BLOCK_VALUES = 30;
+
+export interface MetricsBlockSample {
+  samples: number;
+  timestamp: number;
+  intervalMs: number;
+  ram: RawRAMUsage;
+  cpuUsage: RawCPUUsage;
+  power: Power;
+}
+
+export interface MetricsBlockReader {
+  // Consistent copy of every value, into out if given
+  read(out?: Float64Array): Float64Array;
+  sample(): MetricsBlockSample;
+}
+
+// Start the native writer (or change its interval) and return the block. The
+// buffer can be passed to workers, which read it without calling in.
+export function openMetricsBlock(intervalMs = 1000): SharedArrayBuffer {
+  return smc.metricsBlock(intervalMs);
+}
+
+// Stop the writer; the block keeps its last sample
+export function stopMetricsBlock(): void {
+  smc.stopMetricsBlock();
+}
+
+const ramFields: (keyof RawRAMUsage)[] = [
+  'total', 'used', 'free', 'active', 'inactive', 'wired', 'compressed',
+  'app', 'cache', 'swap_total', 'swap_used', 'swap_free', 'pressure_level'
+];
+const cpuUsageFields: (keyof RawCPUUsage)[] = [
+  'user_load', 'system_load', 'idle_load', 'total_usage', 'load_avg_1', 'load_avg_5', 'load_avg_15'
+];
+const powerFields: (keyof Power)[] = ['cpu', 'gpu', 'ane', 'all', 'system', 'ram', 'gpu_ram'];
+
+function pick<T>(values: Float64Array, offset: number, fields: (keyof T)[]): T {
+  const result = {} as Record<keyof T, number>;
+  fields.forEach((field, i) => {
+    result[field] = values[offset + i];
+  });
+  return result as T;
+}
+
+export function createMetricsBlockReader(buffer: SharedArrayBuffer): MetricsBlockReader {
+  const header = new Int32Array(buffer, 0, METRICS_BLOCK_HEADER_BYTES / 4);
+  if (header[1] !== METRICS_BLOCK_VERSION) {
+    throw new Error(`Unsupported metrics block version ${header[1]}`);
+  }
+  const values = new Float64Array(buffer, METRICS_BLOCK_HEADER_BYTES, header[2]);
+  const copy = new Float64Array(header[2]);
+
+  // Seqlock read: the sequence is odd while the writer is mid-sample. The
+  // closing check is a compare-exchange rather than a load, because only a
+  // read-modify-write keeps the copy from being reordered after it.
+  const read = (out: Float64Array = new Float64Array(values.length)): Float64Array => {
+    for (;;) {
+      const before = Atomics.load(header, 0);
+      if (before & 1) {
+        continue;
+      }
+      out.set(values);
+      if (Atomics.compareExchange(header, 0, before, before) === before) {
+        return out;
+      }
+    }
+  };
+
+  return {
+    read,
+    sample: () => {
+      read(copy);
+      return {
+        samples: copy[MetricsBlockOffset.samples],
+        timestamp: copy[MetricsBlockOffset.timestamp],
+        intervalMs: copy[MetricsBlockOffset.intervalMs],
+        ram: pick<RawRAMUsage>(copy, MetricsBlockOffset.ram, ramFields),
+        cpuUsage: pick<RawCPUUsage>(copy, MetricsBlockOffset.cpuUsage, cpuUsageFields),
+        power: pick<Power>(copy, MetricsBlockOffset.power, powerFields)
+      };
+    }
+  };
+}
@@ -0,0 +1,50 @@
+import { createRequire } from 'node:module';
+
+const requireNative = createRequire(import.meta.url);
+const smc = requireNative('../build/Release/smc.node');
+
+// Value order of each metric in the Float64Array output mode: the value named
+// schema.ram[i] is written to out[offset + i]. Names are the raw native ones.
+export interface MetricsSchema {
+  ram: string[];
+  cpu_usage: string[];
+  power: string[];
+  temperatures: string[];     // Sensor names, sorted
+  voltages: string[];
+  currents: string[];
+}
+
+export type SensorKind = 'temperatures' | 'voltages' | 'currents';
+
+const sensorGetters: Record<SensorKind, (out: Float64Array, offset: number) => number> = {
+  temperatures: (out, offset) => smc.getAllTemperatureSensors(out, offset),
+  voltages: (out, offset) => smc.getAllVoltageSensors(out, offset),
+  currents: (out, offset) => smc.getAllCurrentSensors(out, offset)
+};
+
+// Read once; enumerates the HID sensors
+export function getMetricsSchema(): MetricsSchema {
+  return smc.metricsSchema();
+}
+
+// The read*Into() functions write into out instead of returning new objects,
+// so polling them allocates nothing on the JS heap. They throw a RangeError if
+// the layout does not fit in out from offset on.
+export function readRAMUsageInto(out: Float64Array, offset = 0): void {
+  smc.getRAMUsageData(out, offset);
+}
+
+export function readCPUUsageInto(out: Float64Array, offset = 0): void {
+  smc.getCPUUsageData(out, offset);
+}
+
+export function readPowerInto(out: Float64Array, offset = 0): void {
+  smc.getAllPower(out, offset);
+}
+
+// Writes the sensor values that fit and returns how many sensors there are.
+// A count other than the schema length means sensors came or went since the
+// schema was read.
+export function readSensorsInto(kind: SensorKind, out: Float64Array, offset = 0): number {
+  return sensorGetters[kind](out, offset);
+}
@@ -13,17 +13,124 @@ export interface Power {
   gpu_ram: number;     // GPU RAM power in Watts
 }
 
+// Constant draw reported by the fake power source, in Watts
+export interface FakePowerSourceSpec {
+  type: 'fake';
+  cpu?: number;
+  gpu?: number;
+  ane?: number;
+  ram?: number;
+  gpu_ram?: number;
+  total?: number;          // Defaults to the sum of the others
+  fail_samples?: number;   // Fail this many samples before succeeding
+  fail_starts?: number;    // Fail this many starts before succeeding
+}
+
+// Recorded IOReport channels, one value per sample, repeated
+export interface CannedPowerSourceSpec {
+  type: 'canned';
+  channels: CannedChannel[];
+  dvfs?: DvfsTables;       // Stand-in for this machine's tables while the source is set
+}
+
+// DVFS operating point frequencies in MHz, slowest first, as the pmgr device lists them
+export interface DvfsTables {
+  ecpu?: number[];
+  pcpu?: number[];
+  gpu?: number[];
+}
+
+export type CannedChannel = CannedEnergyChannel | CannedStateChannel;
+
+// An Energy Model channel
+export interface CannedEnergyChannel {
+  name: string;            // IOReport channel name, e.g. 'PACC0_CPU1'
+  group?: 'Energy Model';
+  unit?: 'mJ' | 'uJ' | 'nJ';  // Defaults to mJ
+  values: number[];        // Energy of each sample, in unit
+}
+
+// A state-residency channel of another group, such as 'CPU Stats'
+export interface CannedStateChannel {
+  name: string;
+  group: string;
+  subgroup?: string;
+  states: string[];
+  values: number[][];      // Residency in each state, per sample
+}
+
+export type PowerSourceSpec = FakePowerSourceSpec | CannedPowerSourceSpec;
+
+// One IOReport Energy Model channel as the sampler sees it
+export interface PowerChannel {
+  name: string;
+  component: 'cpu' | 'gpu' | 'ane' | 'ram' | 'gpu_ram' | 'other';
+  cluster: string | null;  // 'E0', 'P1'... for CPU cluster and core channels
+  core: number | null;     // Core within the cluster, for per-core channels
+  die: number;             // Die on multi-die chips, else 0
+  in_component: boolean;   // Counted in Power[component]
+  in_total: boolean;       // Counted in the Energy Model total (EnergyCounters.total), not Power.system
+  sram: boolean;           // SRAM sub-domain of another channel
+  detail: boolean;         // Detail (DTL) sub-domain of another channel
+  watts: number;           // Mean power over the latest window
+  joules: number;          // Energy since the power source was installed
+}
+
+export interface PowerCluster {
+  cluster: string;
+  die: number;
+  watts: number;           // The cluster channel, or the sum of its cores without one
+  joules: number;
+  cores: PowerChannel[];
+}
+
+export interface PowerBreakdown {
+  channels: PowerChannel[];
+  clusters: PowerCluster[];
+}
+
+// Cumulative energy in Joules since power sampling first started
+export interface EnergyCounters {
+  cpu: number;
+  gpu: number;
+  ane: number;
+  ram: number;
+  gpu_ram: number;
+  total: number;
+  time_ms: number;         // Steady-clock time the counters were measured at
+}
+
+// Mean power between two counter reads. total is the Energy Model total, not
+// the SMC whole-system reading in Power.system.
+export interface AveragePower {
+  cpu: number;
+  gpu: number;
+  ane: number;
+  all: number;             // cpu + gpu + ane
+  ram: number;
+  gpu_ram: number;
+  total: number;
+}
+
+export interface PowerSamplerStats {
+  running: boolean;
+  source: 'ioreport' | 'fake' | 'canned';
+  unavailable: boolean;    // The source failed to start; reads return zeros at once while it retries
+  period_ms: number;
+  samples: number;         // Samples published
+  errors: number;          // Samples the source failed to take
+  reads: number;           // Snapshots served
+  waits: number;           // Reads that waited for a first sample
+  sample_us: number;       // Mean time to take and sum one sample
+  open_regions: number;    // Energy regions begun and not yet ended
+  groups: string[];        // IOReport groups subscribed to, 'group' or 'group/subgroup'
+  window_ms: number;       // Length of the latest window
+  age_ms: number;          // Age of the latest sample, -1 if none yet
+}
+
 export async function getPowerData(): Promise<Power> {
-  return new Promise((resolve, reject) => {
-    try {
-      // Use getAllPower() to get all metrics in a single call
-      // This is more efficient and ensures all values are from the same measurement
-      const power = smc.getAllPower();
-      resolve(power);
-    } catch (error) {
-      reject(error);
-    }
-  });
+  // The sampler's latest window; only the first read waits, on a worker thread
+  return smc.getAllPowerAsync();
 }
 
 export function getPowerDataSync(): Power {
@@ -32,3 +139,88 @@ export function getPowerDataSync(): Power {
   return smc.getAllPower();
 }
 
+// Power is sampled by a background thread every period_ms (default 250 ms);
+// the getters return its latest window
+export function setPowerSamplerPeriod(periodMs: number): void {
+  smc.setPowerSamplerPeriod(periodMs);
+}
+
+// Stop the sampler thread; the next power read starts it again
+export function stopPowerSampler(): void {
+  smc.stopPowerSampler();
+}
+
+// Sample from a stand-in power source; without a spec, from IOReport again
+export function setPowerSource(spec?: PowerSourceSpec): void {
+  smc.setPowerSource(spec);
+}
+
+export function getPowerSamplerStats(): PowerSamplerStats {
+  return smc.powerSamplerStats();
+}
+
+// Every Energy Model channel, classified. The first call waits for a sample.
+export function getPowerChannels(): PowerChannel[] {
+  return smc.powerChannels();
+}
+
+// Channels plus CPU power per cluster and core. SRAM and DTL sub-domains
+// stay in channels only.
+export function getPowerBreakdown(): PowerBreakdown {
+  const channels = getPowerChannels();
+  const clusters = new Map<string, PowerCluster & { measured: boolean }>();
+
+  for (const channel of channels) {
+    if (channel.cluster === null || channel.sram || channel.detail) {
+      continue;
+    }
+
+    const key = `${channel.die}:${channel.cluster}`;
+    let cluster = clusters.get(key);
+    if (!cluster) {
+      cluster = { cluster: channel.cluster, die: channel.die, watts: 0, joules: 0, cores: [], measured: false };
+      clusters.set(key, cluster);
+    }
+
+    if (channel.core === null) {
+      cluster.watts = channel.watts;
+      cluster.joules = channel.joules;
+      cluster.measured = true;
+    } else {
+      cluster.cores.push(channel);
+    }
+  }
+
+  return {
+    channels,
+    clusters: [...clusters.values()].map(({ measured, ...cluster }) => {
+      if (!measured) {
+        cluster.watts = cluster.cores.reduce((sum, core) => sum + core.watts, 0);
+        cluster.joules = cluster.cores.reduce((sum, core) => sum + core.joules, 0);
+      }
+      cluster.cores.sort((a, b) => (a.core as number) - (b.core as number));
+      return cluster;
+    })
+  };
+}
+
+// Energy counters; they only go up. The first call waits for a sample.
+export function getEnergyCounters(): EnergyCounters {
+  return smc.energyCounters();
+}
+
+// Mean power between two counter reads, over the time the sampler measured
+// between them rather than the time between the calls
+export function averagePower(from: EnergyCounters, to: EnergyCounters): AveragePower {
+  const seconds = (to.time_ms - from.time_ms) / 1000;
+  const watts = (field: keyof EnergyCounters) => (seconds > 0 ? (to[field] - from[field]) / seconds : 0);
+  return {
+    cpu: watts('cpu'),
+    gpu: watts('gpu'),
+    ane: watts('ane'),
+    all: watts('cpu') + watts('gpu') + watts('ane'),
+    ram: watts('ram'),
+    gpu_ram: watts('gpu_ram'),
+    total: watts('total')
+  };
+}
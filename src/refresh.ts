@@ -0,0 +1,44 @@
+import { createRequire } from 'node:module';
+
+const requireNative = createRequire(import.meta.url);
+const smc = requireNative('../build/Release/smc.node');
+
+// fast: every read (or once fast_ms has passed), slow: once slow_ms has passed,
+// static: once, on-demand: once and then only after requestRefresh()
+export type RefreshPolicy = 'fast' | 'slow' | 'static' | 'on-demand';
+
+export interface RefreshIntervals {
+  fast_ms?: number; // Default 0: fast metrics are read every time
+  slow_ms?: number; // Default 10000
+}
+
+export interface RefreshCounters {
+  ticks: number;        // Batches read
+  reads: number;        // Metrics read
+  skipped: number;      // Metrics served from their last value
+  last_reads: number;   // Same, for the latest batch
+  last_skipped: number;
+}
+
+export interface RefreshStats {
+  smc: RefreshCounters;
+  battery: RefreshCounters;
+}
+
+// Metrics are SMC keys ("F0Mn") or battery fields ("battery.cycle_count")
+export function setRefreshPolicy(policies: Record<string, RefreshPolicy>): void {
+  smc.setRefreshPolicy(policies);
+}
+
+export function setRefreshIntervals(intervals: RefreshIntervals): void {
+  smc.setRefreshIntervals(intervals);
+}
+
+// Re-read slow and on-demand metrics on their next read; every metric without an argument
+export function requestRefresh(metrics?: string[]): void {
+  smc.requestRefresh(metrics);
+}
+
+export function getRefreshStats(): RefreshStats {
+  return smc.refreshStats();
+}
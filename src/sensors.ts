@@ -15,17 +15,7 @@ export interface SensorData {
 }
 
 export async function getSensorData(): Promise<SensorData> {
-  return new Promise((resolve, reject) => {
-    try {
-      resolve({
-        temperatures: smc.getAllTemperatureSensors() as Sensor[],
-        voltages: smc.getAllVoltageSensors() as Sensor[],
-        currents: smc.getAllCurrentSensors() as Sensor[]
-      });
-    } catch (error) {
-      reject(error);
-    }
-  });
+  return smc.getSensorDataAsync();
 }
 
 export function getSensorDataSync(): SensorData {
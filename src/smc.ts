@@ -0,0 +1,77 @@
+import { createRequire } from 'node:module';
+
+const requireNative = createRequire(import.meta.url);
+const smc = requireNative('../build/Release/smc.node');
+
+export const SMCReadStatus = {
+  OK: 0,               // Value read and decoded
+  NOT_FOUND: 1,        // The SMC does not know the key
+  UNSUPPORTED_TYPE: 2, // Read, but the data type cannot be decoded
+  ERROR: 3             // The SMC call failed
+} as const;
+
+export interface SMCReadResult {
+  values: Float64Array; // Decoded values, NaN where status is not OK
+  status: Int32Array;   // Per-key SMCReadStatus
+}
+
+export interface SMCKey {
+  key: string;        // Key name, e.g. "Tp01"
+  type: string;       // Data type, e.g. "flt", "fpe2", "ui8"
+  size: number;       // Value size in bytes
+  attributes: number; // SMC attribute flags
+}
+
+export interface SMCSimulatedWave {
+  shape: 'sine' | 'ramp' | 'square' | 'noise';
+  min: number;
+  max: number;
+  period_ms?: number; // Default 1000
+}
+
+export interface SMCSimulatedKey {
+  key: string;       // Key name, e.g. "F0Ac"
+  type: string;      // Data type, e.g. "fpe2"
+  bytes?: number[];  // Raw value as the SMC returns it
+  value?: number;    // Or a value, encoded for the type
+  wave?: SMCSimulatedWave; // Vary the value on every read
+}
+
+export type SMCChipGeneration = 'Intel' | 'M1' | 'M2' | 'M3' | 'M4' | 'M5';
+
+export interface SMCSimulatedSpec {
+  type: 'simulated';
+  chip?: SMCChipGeneration; // Preset key table; also the generation the addon reports
+  keys?: SMCSimulatedKey[]; // Added after (and replacing) the preset keys
+  fail_opens?: number;
+  fail_calls?: number;
+  error_rate?: number;      // Probability (0-1) that a call fails
+  latency_us?: number;      // Delay added to every call
+  seed?: number;            // Seed for error_rate and noise waves
+  time_step_ms?: number;    // Wave time per read; 0 uses the wall clock
+}
+
+export type SMCTransportSpec =
+  | SMCSimulatedSpec
+  | { type: 'record'; path: string; source?: SMCTransportSpec }
+  | { type: 'replay'; path: string; latency?: boolean };
+
+// Key names ("F0Ac", "Tp01", ...) or a list compiled with compileKeys()
+export type SMCKeyList = string[] | Uint32Array;
+
+export function compileKeys(keys: string[]): Uint32Array {
+  return smc.compileKeys(keys);
+}
+
+export function readKeys(keys: SMCKeyList, values?: Float64Array, status?: Int32Array): SMCReadResult {
+  return smc.readKeys(keys, values, status);
+}
+
+export function listKeys(): SMCKey[] {
+  return smc.smcKeys();
+}
+
+// Route SMC access through another transport; no argument restores IOKit
+export function setTransport(spec?: SMCTransportSpec): void {
+  smc.setTransport(spec);
+}
@@ -0,0 +1,146 @@
+import { createRequire } from 'node:module';
+import { Battery, RawBatteryData, parseBatteryData } from './battery.js';
+import { CPU, CPUUsage, RawCPUData, RawCPUUsage, parseCpuData, parseCPUUsage } from './cpu.js';
+import { DiskInfo, RawDiskInfo, parseDiskInfo } from './disk.js';
+import { Fan, parseFanData } from './fan.js';
+import { GPU, parseGpuData } from './gpu.js';
+import { Memory, RAMUsage, RawRAMUsage, parseRAMUsage } from './memory.js';
+import { Power } from './power.js';
+import { SensorData } from './sensors.js';
+import { RawSystemData, SystemInfo, parseSystemData } from './system.js';
+
+const requireNative = createRequire(import.meta.url);
+const smc = requireNative('../build/Release/smc.node');
+
+// Bits of the native snapshot mask (SnapshotMetric in smc/smc.cc)
+export const SnapshotMetric = {
+  system: 1 << 0,
+  cpu: 1 << 1,
+  cpuUsage: 1 << 2,
+  gpu: 1 << 3,
+  memory: 1 << 4,
+  ram: 1 << 5,
+  battery: 1 << 6,
+  sensors: 1 << 7,
+  fans: 1 << 8,
+  disks: 1 << 9,
+  power: 1 << 10
+} as const;
+
+export type SnapshotMetricName = keyof typeof SnapshotMetric;
+
+export interface Snapshot {
+  system?: SystemInfo;
+  cpu?: CPU;
+  cpuUsage?: CPUUsage;
+  gpu?: GPU;
+  memory?: Memory;
+  ram?: RAMUsage;
+  battery?: Battery;
+  sensors?: SensorData;
+  fans?: Fan;
+  disks?: DiskInfo[];
+  power?: Power;
+}
+
+interface RawSnapshot {
+  system?: RawSystemData;
+  cpu?: RawCPUData;
+  cpu_usage?: RawCPUUsage;
+  gpu?: GPU;
+  memory_voltage?: number;
+  ram?: RawRAMUsage;
+  battery?: RawBatteryData;
+  sensors?: SensorData;
+  fans?: { count: number; values: Float64Array };
+  disks?: RawDiskInfo[];
+  power?: Power;
+}
+
+function snapshotMask(metrics?: SnapshotMetricName[]): number | undefined {
+  if (!metrics) {
+    return undefined;
+  }
+  return metrics.reduce((mask, name) => {
+    if (!(name in SnapshotMetric)) {
+      throw new TypeError(`Unknown snapshot metric: ${name}`);
+    }
+    return mask | SnapshotMetric[name];
+  }, 0);
+}
+
+function parseSnapshot(raw: RawSnapshot): Snapshot {
+  const result: Snapshot = {};
+  if (raw.system) result.system = parseSystemData(raw.system);
+  if (raw.cpu) result.cpu = parseCpuData(raw.cpu);
+  if (raw.cpu_usage) result.cpuUsage = parseCPUUsage(raw.cpu_usage);
+  if (raw.gpu) result.gpu = parseGpuData(raw.gpu);
+  if (raw.memory_voltage !== undefined) result.memory = { voltage: raw.memory_voltage };
+  if (raw.ram) result.ram = parseRAMUsage(raw.ram);
+  if (raw.battery) result.battery = parseBatteryData(raw.battery);
+  if (raw.sensors) result.sensors = raw.sensors;
+  if (raw.fans) result.fans = parseFanData(raw.fans.count, raw.fans.values);
+  if (raw.disks) result.disks = raw.disks.map(parseDiskInfo);
+  if (raw.power) result.power = raw.power;
+  return result;
+}
+
+// Every requested metric (all by default) in one native call on a worker
+// thread, with one SMC connection and one HID client shared between them
+export async function getSnapshot(metrics?: SnapshotMetricName[]): Promise<Snapshot> {
+  return parseSnapshot(await smc.snapshotAsync(snapshotMask(metrics)));
+}
+
+export function getSnapshotSync(metrics?: SnapshotMetricName[]): Snapshot {
+  return parseSnapshot(smc.snapshot(snapshotMask(metrics)));
+}
+
+export interface SubscribeOptions {
+  metrics?: SnapshotMetricName[];        // Default: every metric
+  intervalMs?: number;                   // Default: 1000
+  bufferSize?: number;                   // Samples kept while JS is busy; default: 16
+  overflow?: 'drop-oldest' | 'coalesce'; // Default: 'drop-oldest'
+}
+
+export interface SubscriptionSample extends Snapshot {
+  timestamp: number;                     // When the sample was taken, ms since the epoch
+}
+
+export interface SubscriptionStats {
+  samples: number;                       // Taken by the sampling thread
+  delivered: number;                     // Passed to the callback
+  dropped: number;                       // Evicted from a full buffer
+  coalesced: number;                     // Replaced by a newer sample before delivery
+  batches: number;                       // Callback invocations
+  pending: number;                       // Waiting for the JS thread
+}
+
+export interface Subscription {
+  unsubscribe(): void;
+  stats(): SubscriptionStats;
+}
+
+// Sample the metrics on a native thread every intervalMs and pass them to the
+// callback in batches: every sample taken since the last call, oldest first.
+// With overflow 'coalesce', only the newest of them.
+export function subscribe(options: SubscribeOptions, callback: (samples: SubscriptionSample[]) => void): Subscription {
+  const id: number = smc.subscribe(
+    snapshotMask(options.metrics),
+    options.intervalMs ?? 1000,
+    options.bufferSize ?? 16,
+    options.overflow === 'coalesce',
+    (batch: (RawSnapshot & { timestamp: number })[]) => {
+      callback(batch.map((raw) => ({ ...parseSnapshot(raw), timestamp: raw.timestamp })));
+    }
+  );
+
+  // Counters stay readable after unsubscribing
+  let last: SubscriptionStats | undefined;
+  return {
+    unsubscribe: () => {
+      last = smc.subscriptionStats(id) ?? last;
+      smc.unsubscribe(id);
+    },
+    stats: () => smc.subscriptionStats(id) ?? (last as SubscriptionStats)
+  };
+}
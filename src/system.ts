@@ -42,7 +42,7 @@ function formatUptime(seconds: number): string {
   return parts.length > 0 ? parts.join(' ') : '0m';
 }
 
-function parseData(raw: RawSystemData): SystemInfo {
+export function parseSystemData(raw: RawSystemData): SystemInfo {
   return {
     totalMemory: raw.total_memory,
     totalMemoryGB: Math.round((raw.total_memory / (1024 ** 3)) * 10) / 10,
@@ -59,18 +59,12 @@ function parseData(raw: RawSystemData): SystemInfo {
 }
 
 export async function getSystemData(): Promise<SystemInfo> {
-  return new Promise((resolve, reject) => {
-    try {
-      const raw: RawSystemData = smc.getSystemData();
-      resolve(parseData(raw));
-    } catch (error) {
-      reject(error);
-    }
-  });
+  const raw: RawSystemData = await smc.getSystemDataAsync();
+  return parseSystemData(raw);
 }
 
 export function getSystemDataSync(): SystemInfo {
   const raw: RawSystemData = smc.getSystemData();
-  return parseData(raw);
+  return parseSystemData(raw);
 }
 
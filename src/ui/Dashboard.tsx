@@ -17,6 +17,7 @@ import { getFanData } from '../fan.js';
 import { getDiskInfo } from '../disk.js';
 import { getSensorData } from '../sensors.js';
 import { getPowerData } from '../power.js';
+import { getSnapshot, subscribe, Snapshot, SnapshotMetricName } from '../snapshot.js';
 
 interface DashboardData {
   system: Awaited<ReturnType<typeof getSystemData>>;
@@ -31,6 +32,10 @@ interface DashboardData {
   power: Awaited<ReturnType<typeof getPowerData>>;
 }
 
+const dashboardMetrics: SnapshotMetricName[] = [
+  'system', 'cpu', 'cpuUsage', 'gpu', 'ram', 'battery', 'sensors', 'fans', 'disks', 'power'
+];
+
 interface CPUHistory {
   timestamp: number;
   usage: number;
@@ -77,83 +82,81 @@ export const Dashboard: React.FC<DashboardProps> = ({
     }
   });
 
+  const applySnapshot = (snapshot: Snapshot) => {
+    const { system, cpu, cpuUsage, gpu, ram, battery, sensors, fans, disks, power } = snapshot as Required<Snapshot>;
+
+    setData({
+      system,
+      cpu,
+      cpuUsage,
+      gpu,
+      ram,
+      battery,
+      sensors,
+      fans,
+      disks,
+      power
+    });
+
+    // Update CPU history (keep last 60 data points)
+    setCpuHistory(prev => {
+      const newHistory = [
+        ...prev,
+        {
+          timestamp: Date.now(),
+          usage: cpuUsage.totalUsagePercent
+        }
+      ];
+      return newHistory.slice(-60);
+    });
+
+    // Update RAM history (keep last 60 data points)
+    setRamHistory(prev => {
+      const newHistory = [
+        ...prev,
+        {
+          timestamp: Date.now(),
+          usedPercentage: ram.usagePercent
+        }
+      ];
+      return newHistory.slice(-60);
+    });
+
+    // Update GPU history (keep last 60 data points)
+    setGpuHistory(prev => {
+      const newHistory = [
+        ...prev,
+        {
+          timestamp: Date.now(),
+          usage: gpu.usage,
+          temperature: gpu.temperature
+        }
+      ];
+      return newHistory.slice(-60);
+    });
+
+    lastUpdateRef.current = new Date();
+  };
+
   const fetchData = async () => {
     try {
-      const [system, cpu, cpuUsage, gpu, ram, battery, sensors, fans, disks, power] = await Promise.all([
-        getSystemData(),
-        getCpuData(),
-        getCPUUsage(),
-        getGpuData(),
-        getRAMUsage(),
-        getBatteryData().catch(() => null),
-        getSensorData(),
-        getFanData(),
-        getDiskInfo(),
-        getPowerData()
-      ]);
-
-      setData({
-        system,
-        cpu,
-        cpuUsage,
-        gpu,
-        ram,
-        battery,
-        sensors,
-        fans,
-        disks,
-        power
-      });
-
-      // Update CPU history (keep last 60 data points)
-      setCpuHistory(prev => {
-        const newHistory = [
-          ...prev,
-          {
-            timestamp: Date.now(),
-            usage: cpuUsage.totalUsagePercent
-          }
-        ];
-        return newHistory.slice(-60);
-      });
-
-      // Update RAM history (keep last 60 data points)
-      setRamHistory(prev => {
-        const newHistory = [
-          ...prev,
-          {
-            timestamp: Date.now(),
-            usedPercentage: ram.usagePercent
-          }
-        ];
-        return newHistory.slice(-60);
-      });
-
-      // Update GPU history (keep last 60 data points)
-      setGpuHistory(prev => {
-        const newHistory = [
-          ...prev,
-          {
-            timestamp: Date.now(),
-            usage: gpu.usage,
-            temperature: gpu.temperature
-          }
-        ];
-        return newHistory.slice(-60);
-      });
-
-      lastUpdateRef.current = new Date();
+      // One native call for every section
+      applySnapshot(await getSnapshot(dashboardMetrics));
     } catch (error) {
       console.error('Error fetching data:', error);
     }
   };
 
-  // Initial fetch and periodic updates
+  // Initial fetch, then samples pushed by a native thread. Only the newest
+  // sample matters when rendering falls behind.
   useEffect(() => {
     fetchData();
     if (refreshInterval > 0) {
-      const interval = setInterval(fetchData, refreshInterval);
-      return () => clearInterval(interval);
+      const subscription = subscribe(
+        { metrics: dashboardMetrics, intervalMs: refreshInterval, overflow: 'coalesce' },
+        (samples) => applySnapshot(samples[samples.length - 1])
+      );
+      return () => subscription.unsubscribe();
     }
   }, [refreshInterval]);
 
@@ -0,0 +1,48 @@
+import { describe, test, expect, afterEach } from 'vitest';
+import { setTransport } from '../src/smc';
+import { getCpuData, getCpuDataSync } from '../src/cpu';
+import { getFanData, getFanDataSync } from '../src/fan';
+import { getPowerData } from '../src/power';
+import { getSensorData } from '../src/sensors';
+
+describe('Async Getters', () => {
+  afterEach(() => {
+    setTransport();
+  });
+
+  test('should keep the event loop running while power is sampled', async () => {
+    let ticks = 0;
+    const timer = setInterval(() => ticks++, 10);
+    const started = Date.now();
+
+    await getPowerData();
+    clearInterval(timer);
+
+    // The IOReport sample window is several hundred ms; a blocked loop ticks at most once
+    const elapsed = Date.now() - started;
+    expect(ticks).toBeGreaterThanOrEqual(Math.floor(elapsed / 10 / 2));
+  });
+
+  test('should match the sync getters on a simulated device', async () => {
+    setTransport({ type: 'simulated', chip: 'Intel' });
+    expect(await getFanData()).toEqual(getFanDataSync());
+
+    const cpu = await getCpuData();
+    expect(cpu.temperatureDie).toBe(Math.round(getCpuDataSync().temperatureDie));
+  });
+
+  test('should serve concurrent requests', async () => {
+    setTransport({ type: 'simulated', chip: 'M3' });
+    const results = await Promise.all(Array.from({ length: 16 }, () => getFanData()));
+    for (const fans of results) {
+      expect(fans[1]).toEqual({ rpm: 1550, min: 1200, max: 6000 });
+    }
+  });
+
+  test('should resolve sensor lists in one call', async () => {
+    const data = await getSensorData();
+    expect(Array.isArray(data.temperatures)).toBe(true);
+    expect(Array.isArray(data.voltages)).toBe(true);
+    expect(Array.isArray(data.currents)).toBe(true);
+  });
+});
@@ -0,0 +1,100 @@
+import { describe, test, expect, afterEach } from 'vitest';
+import { getCpuFrequencies } from '../src/cpu';
+import { setPowerSource, setPowerSamplerPeriod, getPowerSamplerStats, type CannedChannel } from '../src/power';
+
+// DVFS tables and CPU Stats residencies as an M1 reports them
+const dvfs = { ecpu: [600, 972, 1332, 1704, 2064], pcpu: [600, 828, 1056, 3228] };
+const eStates = ['IDLE', 'V0P5', 'V1P4', 'V2P3', 'V3P2', 'V4P1'];
+const pStates = ['IDLE', 'DOWN', 'V0P8', 'V1P7', 'V2P6', 'V3P5'];
+
+const complex = (name: string, states: string[], values: number[][]): CannedChannel =>
+  ({ group: 'CPU Stats', subgroup: 'CPU Complex Performance States', name, states, values });
+const core = (name: string, states: string[], values: number[][]): CannedChannel =>
+  ({ group: 'CPU Stats', subgroup: 'CPU Core Performance States', name, states, values });
+
+const m1 = [
+  { name: 'CPU Energy', values: [900] },
+  complex('ECPU', eStates, [[50, 0, 0, 25, 0, 25]]),
+  complex('PCPU', pStates, [[10, 10, 0, 0, 20, 60]]),
+  core('PCPU0', pStates, [[0, 0, 0, 0, 0, 100]]),
+  core('PCPU1', pStates, [[100, 0, 0, 0, 0, 0]])
+];
+
+describe('CPU Frequencies', () => {
+  afterEach(() => {
+    setPowerSource();
+    setPowerSamplerPeriod(0);
+  });
+
+  test('should weight active residency by the DVFS table', () => {
+    setPowerSource({ type: 'canned', channels: m1, dvfs });
+    setPowerSamplerPeriod(10);
+
+    const { clusters, cores } = getCpuFrequencies();
+    expect(clusters.map((cluster) => cluster.cluster)).toEqual(['E0', 'P0']);
+    expect(clusters[0]).toMatchObject({ name: 'ECPU', core: null, max_mhz: 2064 });
+    expect(clusters[0].active_mhz).toBeCloseTo((1332 + 2064) / 2, 6);
+    expect(clusters[0].active_ratio).toBeCloseTo(0.5, 6);
+    expect(clusters[1].active_mhz).toBeCloseTo((20 * 1056 + 60 * 3228) / 80, 6);
+    expect(clusters[1].idle_ratio).toBeCloseTo(0.2, 6);
+
+    expect(cores.map((entry) => entry.name)).toEqual(['PCPU0', 'PCPU1']);
+    expect(clusters[1].cores[0]).toMatchObject({ core: 0, active_mhz: 3228, active_ratio: 1 });
+    expect(clusters[1].cores[1]).toMatchObject({ core: 1, active_mhz: 0, idle_ratio: 1 });
+    expect(getPowerSamplerStats().groups).toEqual(['Energy Model', 'CPU Stats']);
+  });
+
+  test('should follow throttling between windows', async () => {
+    // Full speed, then held at the second operating point
+    setPowerSource({
+      type: 'canned',
+      channels: [m1[0], complex('PCPU', pStates, [[0, 0, 0, 0, 0, 100], [0, 0, 0, 100, 0, 0]])],
+      dvfs
+    });
+    setPowerSamplerPeriod(10);
+
+    const seen = new Set<number>();
+    for (let i = 0; i < 20 && seen.size < 2; i++) {
+      seen.add(getCpuFrequencies().clusters[0].active_mhz);
+      await new Promise((resolve) => setTimeout(resolve, 10));
+    }
+    expect([...seen].sort((a, b) => a - b)).toEqual([828, 3228]);
+  });
+
+  test('should make up a cluster without its own channel from its cores', () => {
+    setPowerSource({
+      type: 'canned',
+      channels: [
+        m1[0],
+        core('DIE_1_ECPU0', eStates, [[0, 100, 0, 0, 0, 0]]),
+        core('DIE_1_ECPU1', eStates, [[50, 0, 0, 0, 0, 50]])
+      ],
+      dvfs
+    });
+    setPowerSamplerPeriod(10);
+
+    const [cluster] = getCpuFrequencies().clusters;
+    expect(cluster).toMatchObject({ cluster: 'E0', die: 1, name: '' });
+    expect(cluster.active_ratio).toBeCloseTo(0.75, 6);
+    expect(cluster.active_mhz).toBeCloseTo((1 * 600 + 0.5 * 2064) / 1.5, 6);
+  });
+
+  test('should leave states beyond the table out of the frequency', () => {
+    setPowerSource({
+      type: 'canned',
+      channels: [m1[0], complex('PCPU', [...pStates, 'V4P4'], [[0, 0, 0, 0, 0, 50, 50]])],
+      dvfs
+    });
+    setPowerSamplerPeriod(10);
+
+    const [cluster] = getCpuFrequencies().clusters;
+    expect(cluster.active_ratio).toBeCloseTo(1, 6);
+    expect(cluster.active_mhz).toBeCloseTo(3228, 6);
+  });
+
+  test('should report nothing for a source without CPU Stats', () => {
+    setPowerSource({ type: 'fake', cpu: 1 });
+    setPowerSamplerPeriod(10);
+    expect(getCpuFrequencies()).toEqual({ clusters: [], cores: [] });
+  });
+});
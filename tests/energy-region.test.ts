@@ -0,0 +1,90 @@
+import { describe, test, expect, afterEach } from 'vitest';
+import { beginEnergyRegion, endEnergyRegion, measureEnergy } from '../src/energy-region';
+import { setPowerSource, setPowerSamplerPeriod, getPowerSamplerStats } from '../src/power';
+
+const sleep = (ms: number) => new Promise((resolve) => setTimeout(resolve, ms));
+
+describe('Energy Regions', () => {
+  afterEach(() => {
+    setPowerSource();
+    setPowerSamplerPeriod(0);
+  });
+
+  test('should measure the energy of a region', async () => {
+    setPowerSource({ type: 'fake', cpu: 4, gpu: 2, ram: 1 });
+    setPowerSamplerPeriod(10);
+
+    const handle = beginEnergyRegion();
+    await sleep(150);
+    const region = endEnergyRegion(handle);
+
+    expect(region.duration_ms).toBeGreaterThanOrEqual(150);
+    expect(region.samples).toBeGreaterThanOrEqual(5);
+    expect(region.joules.cpu).toBeCloseTo(4 * region.duration_ms / 1000, 2);
+    expect(region.mean_watts.cpu).toBeCloseTo(4, 1);
+    expect(region.mean_watts.gpu).toBeCloseTo(2, 1);
+    expect(region.mean_watts.total).toBeCloseTo(7, 1);
+    expect(region.peak_watts.cpu).toBeCloseTo(4, 1);
+  });
+
+  test('should report the peak window of a varying source', async () => {
+    // One window in four draws five times the power of the others
+    setPowerSource({ type: 'canned', channels: [{ name: 'CPU Energy', values: [10, 50, 10, 10] }] });
+    setPowerSamplerPeriod(10);
+
+    const { energy } = await measureEnergy(() => sleep(200));
+    expect(energy.samples).toBeGreaterThanOrEqual(8);
+    expect(energy.peak_watts.cpu / energy.mean_watts.cpu).toBeGreaterThan(2);
+    expect(energy.peak_watts.cpu).toBeGreaterThan(energy.mean_watts.cpu);
+  });
+
+  test('should keep overlapping regions independent', async () => {
+    setPowerSource({ type: 'fake', cpu: 3 });
+    setPowerSamplerPeriod(10);
+
+    const outer = beginEnergyRegion();
+    await sleep(50);
+    const inner = Array.from({ length: 1000 }, () => beginEnergyRegion());
+    await sleep(50);
+    const innerRegions = inner.map(endEnergyRegion);
+    await sleep(50);
+    const outerRegion = endEnergyRegion(outer);
+
+    for (const region of innerRegions) {
+      expect(region.mean_watts.cpu).toBeCloseTo(3, 1);
+      expect(region.duration_ms).toBeLessThan(outerRegion.duration_ms);
+    }
+    expect(outerRegion.joules.cpu).toBeGreaterThan(innerRegions[0].joules.cpu * 2);
+    expect(outerRegion.mean_watts.cpu).toBeCloseTo(3, 1);
+    expect(getPowerSamplerStats().open_regions).toBe(0);
+  });
+
+  test('should estimate regions shorter than one window', () => {
+    setPowerSource({ type: 'fake', cpu: 5 });
+    setPowerSamplerPeriod(1000);
+
+    const region = endEnergyRegion(beginEnergyRegion());
+    expect(region.samples).toBe(0);
+    expect(region.mean_watts.cpu).toBeCloseTo(5, 1);
+  });
+
+  test('should end the region when the measured function throws', async () => {
+    setPowerSource({ type: 'fake', cpu: 1 });
+    setPowerSamplerPeriod(10);
+
+    await expect(measureEnergy(() => {
+      throw new Error('build failed');
+    })).rejects.toThrow('build failed');
+    expect(getPowerSamplerStats().open_regions).toBe(0);
+  });
+
+  test('should reject unknown and ended handles', () => {
+    setPowerSource({ type: 'fake', cpu: 1 });
+    setPowerSamplerPeriod(10);
+
+    const handle = beginEnergyRegion();
+    endEnergyRegion(handle);
+    expect(() => endEnergyRegion(handle)).toThrow(TypeError);
+    expect(() => endEnergyRegion(-1)).toThrow(TypeError);
+  });
+});
@@ -0,0 +1,64 @@
+import { describe, test, expect, afterEach } from 'vitest';
+import { getGpuFrequency, getGpuDataSync } from '../src/gpu';
+import { setPowerSource, setPowerSamplerPeriod, getPowerSamplerStats, type CannedChannel } from '../src/power';
+
+// GPU DVFS table and GPU Stats residencies as an M1 reports them
+const dvfs = { gpu: [389, 486, 648, 778, 972, 1278] };
+const states = ['OFF', 'P1', 'P2', 'P3', 'P4', 'P5', 'P6'];
+
+const gpuph = (values: number[][]): CannedChannel =>
+  ({ group: 'GPU Stats', subgroup: 'GPU Performance States', name: 'GPUPH', states, values });
+
+describe('GPU Frequency', () => {
+  afterEach(() => {
+    setPowerSource();
+    setPowerSamplerPeriod(0);
+  });
+
+  test('should weight active residency by the DVFS table', () => {
+    setPowerSource({
+      type: 'canned',
+      channels: [{ name: 'GPU Energy', values: [500] }, gpuph([[40, 0, 0, 20, 0, 0, 40]])],
+      dvfs
+    });
+    setPowerSamplerPeriod(10);
+
+    const gpu = getGpuFrequency()!;
+    expect(gpu).toMatchObject({ name: 'GPUPH', max_mhz: 1278 });
+    expect(gpu.active_ratio).toBeCloseTo(0.6, 6);
+    expect(gpu.idle_ratio).toBeCloseTo(0.4, 6);
+    expect(gpu.active_mhz).toBeCloseTo((648 + 2 * 1278) / 3, 6);
+    expect(gpu.states.map((state) => state.mhz)).toEqual(dvfs.gpu);
+    expect(gpu.states.map((state) => state.ratio)).toEqual([0, 0, 0.2, 0, 0, 0.4]);
+    expect(getPowerSamplerStats().groups).toEqual(['Energy Model', 'GPU Stats/GPU Performance States']);
+  });
+
+  test('should take GPU usage from the active residency', () => {
+    setPowerSource({ type: 'canned', channels: [gpuph([[25, 75, 0, 0, 0, 0, 0]])], dvfs });
+    setPowerSamplerPeriod(10);
+
+    // Usage does not wait for the first GPU Stats sample
+    getGpuFrequency();
+    expect(getGpuDataSync().usage).toBe(75);
+  });
+
+  test('should not wait on a sampler that cannot start', () => {
+    setPowerSource({ type: 'fake', gpu: 1, fail_starts: 1000 });
+    setPowerSamplerPeriod(200);
+
+    const started = performance.now();
+    for (let i = 0; i < 10; i++) {
+      getGpuDataSync();
+      expect(getGpuFrequency()).toBeNull();
+    }
+    // Waiting for a GPU Stats sample would take 700 ms per read
+    expect(performance.now() - started).toBeLessThan(250);
+    expect(getPowerSamplerStats().unavailable).toBe(true);
+  });
+
+  test('should report nothing for a source without GPU Stats', () => {
+    setPowerSource({ type: 'fake', gpu: 1 });
+    setPowerSamplerPeriod(10);
+    expect(getGpuFrequency()).toBeNull();
+  });
+});
@@ -0,0 +1,13 @@
+// SMC value encoders for simulated transport keys
+
+// fpe2: unsigned 14.2 fixed point, big-endian
+export function fpe2(value: number): number[] {
+  return [(value * 4) >> 8, (value * 4) & 0xff];
+}
+
+// flt: little-endian float (Apple Silicon)
+export function flt(value: number): number[] {
+  const buffer = Buffer.alloc(4);
+  buffer.writeFloatLE(value);
+  return [...buffer];
+}
@@ -0,0 +1,137 @@
+import { describe, test, expect, afterEach } from 'vitest';
+import { Worker } from 'node:worker_threads';
+import { createRequire } from 'node:module';
+import {
+  METRICS_BLOCK_VALUES,
+  MetricsBlockOffset,
+  openMetricsBlock,
+  stopMetricsBlock,
+  createMetricsBlockReader
+} from '../src/metrics-block';
+import { setPowerSource, setPowerSamplerPeriod } from '../src/power';
+
+const requireNative = createRequire(import.meta.url);
+const smc = requireNative('../build/Release/smc.node');
+
+const sleep = (ms: number) => new Promise((resolve) => setTimeout(resolve, ms));
+
+async function waitForSamples(buffer: SharedArrayBuffer, count: number): Promise<void> {
+  const reader = createMetricsBlockReader(buffer);
+  while (reader.sample().samples < count) {
+    await sleep(5);
+  }
+}
+
+// The reader protocol of createMetricsBlockReader(), checking every copy for
+// values from two different samples
+const workerSource = `
+const { parentPort, workerData } = require('node:worker_threads');
+const { buffer, offsets, until } = workerData;
+const header = new Int32Array(buffer, 0, 4);
+const values = new Float64Array(buffer, 16, header[2]);
+const copy = new Float64Array(header[2]);
+let reads = 0, torn = 0, last = 0;
+
+while (Date.now() < until) {
+  for (;;) {
+    const before = Atomics.load(header, 0);
+    if (before & 1) continue;
+    copy.set(values);
+    if (Atomics.compareExchange(header, 0, before, before) === before) break;
+  }
+  const power = offsets.power;
+  const all = copy[power] + copy[power + 1] + copy[power + 2];
+  if (copy[offsets.samples] < last || copy[power + 3] !== all) torn++;
+  last = copy[offsets.samples];
+  reads++;
+}
+parentPort.postMessage({ reads, torn, last });
+`;
+
+describe('Metrics Block', () => {
+  afterEach(() => {
+    stopMetricsBlock();
+    setPowerSource();
+    setPowerSamplerPeriod(0);
+  });
+
+  test('should match the documented layout', () => {
+    const names: string[] = smc.metricsSchema().block;
+    expect(names).toHaveLength(METRICS_BLOCK_VALUES);
+    expect(names[MetricsBlockOffset.samples]).toBe('samples');
+    expect(names[MetricsBlockOffset.timestamp]).toBe('timestamp');
+    expect(names[MetricsBlockOffset.ram]).toBe('ram.total');
+    expect(names[MetricsBlockOffset.cpuUsage]).toBe('cpu_usage.user_load');
+    expect(names[MetricsBlockOffset.power]).toBe('power.cpu');
+    expect(names[METRICS_BLOCK_VALUES - 1]).toBe('power.gpu_ram');
+
+    const buffer = openMetricsBlock();
+    expect(buffer).toBeInstanceOf(SharedArrayBuffer);
+    expect(buffer.byteLength).toBe(16 + METRICS_BLOCK_VALUES * 8);
+  });
+
+  test('should publish the latest sample', async () => {
+    setPowerSource({ type: 'fake', cpu: 4, gpu: 2, ane: 1 });
+    setPowerSamplerPeriod(10);
+    const buffer = openMetricsBlock(20);
+    await waitForSamples(buffer, 3);
+
+    const sample = createMetricsBlockReader(buffer).sample();
+    expect(sample.intervalMs).toBe(20);
+    expect(sample.ram.total).toBe(smc.getRAMUsageData().total);
+    expect(sample.cpuUsage.idle_load).toBeGreaterThanOrEqual(0);
+    expect(sample.power.cpu).toBeCloseTo(4, 0);
+    expect(sample.power.all).toBe(sample.power.cpu + sample.power.gpu + sample.power.ane);
+    expect(Date.now() - sample.timestamp).toBeLessThan(1000);
+
+    // Every call maps the same memory
+    const again = createMetricsBlockReader(openMetricsBlock(20));
+    expect(again.sample().samples).toBeGreaterThanOrEqual(sample.samples);
+  });
+
+  test('should keep its last sample when stopped', async () => {
+    const buffer = openMetricsBlock(5);
+    await waitForSamples(buffer, 2);
+    stopMetricsBlock();
+
+    const reader = createMetricsBlockReader(buffer);
+    const samples = reader.sample().samples;
+    await sleep(30);
+    expect(reader.sample().samples).toBe(samples);
+  });
+
+  test('should never show a torn sample to concurrent readers', async () => {
+    // Power values change every sample, so a mixed copy breaks all = cpu + gpu + ane
+    setPowerSource({ type: 'fake', cpu: 4, gpu: 2, ane: 1 });
+    setPowerSamplerPeriod(1);
+    const buffer = openMetricsBlock(1);
+    await waitForSamples(buffer, 1);
+
+    const until = Date.now() + 500;
+    const results = await Promise.all(Array.from({ length: 4 }, () => new Promise<{ reads: number; torn: number }>(
+      (resolve, reject) => {
+        const worker = new Worker(workerSource, {
+          eval: true,
+          workerData: { buffer, offsets: MetricsBlockOffset, until }
+        });
+        worker.once('message', resolve);
+        worker.once('error', reject);
+      }
+    )));
+
+    const reader = createMetricsBlockReader(buffer);
+    let last = 0;
+    while (Date.now() < until + 100) {
+      const sample = reader.sample();
+      expect(sample.samples).toBeGreaterThanOrEqual(last);
+      expect(sample.power.all).toBe(sample.power.cpu + sample.power.gpu + sample.power.ane);
+      last = sample.samples;
+    }
+
+    for (const result of results) {
+      expect(result.reads).toBeGreaterThan(0);
+      expect(result.torn).toBe(0);
+    }
+    expect(last).toBeGreaterThan(10);
+  });
+});
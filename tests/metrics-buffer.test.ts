@@ -0,0 +1,79 @@
+import { describe, test, expect, afterEach } from 'vitest';
+import { createRequire } from 'node:module';
+import {
+  getMetricsSchema,
+  readRAMUsageInto,
+  readCPUUsageInto,
+  readPowerInto,
+  readSensorsInto
+} from '../src/metrics-buffer';
+import { setPowerSource, setPowerSamplerPeriod } from '../src/power';
+
+const requireNative = createRequire(import.meta.url);
+const smc = requireNative('../build/Release/smc.node');
+
+describe('Metric Buffers', () => {
+  afterEach(() => {
+    setPowerSource();
+    setPowerSamplerPeriod(0);
+  });
+
+  test('should describe the object getters', () => {
+    const schema = getMetricsSchema();
+    expect(schema.ram).toEqual(Object.keys(smc.getRAMUsageData()));
+    expect(schema.cpu_usage).toEqual(Object.keys(smc.getCPUUsageData()));
+    expect(schema.power).toEqual(['cpu', 'gpu', 'ane', 'all', 'system', 'ram', 'gpu_ram']);
+
+    const names = smc.getAllTemperatureSensors().map((sensor: { name: string }) => sensor.name);
+    expect(schema.temperatures).toEqual([...names].sort());
+  });
+
+  test('should write RAM usage at the schema offsets', () => {
+    const schema = getMetricsSchema();
+    const out = new Float64Array(schema.ram.length);
+    readRAMUsageInto(out);
+
+    const raw = smc.getRAMUsageData();
+    expect(out[schema.ram.indexOf('total')]).toBe(raw.total);
+    expect(out[schema.ram.indexOf('swap_total')]).toBe(raw.swap_total);
+    expect([1, 2, 4]).toContain(out[schema.ram.indexOf('pressure_level')]);
+  });
+
+  test('should write several metrics into one buffer', async () => {
+    setPowerSource({ type: 'fake', cpu: 4, gpu: 2, ane: 1 });
+    setPowerSamplerPeriod(20);
+    const schema = getMetricsSchema();
+    const powerAt = 3 + schema.cpu_usage.length;
+    const out = new Float64Array(powerAt + schema.power.length + 2).fill(-1);
+
+    readCPUUsageInto(out, 3);
+    readPowerInto(out, powerAt);
+
+    expect(out.subarray(0, 3)).toEqual(new Float64Array([-1, -1, -1]));
+    const total = out[3 + schema.cpu_usage.indexOf('total_usage')];
+    expect(total).toBeGreaterThanOrEqual(0);
+    expect(total).toBeLessThanOrEqual(1);
+    expect(out[powerAt + schema.power.indexOf('cpu')]).toBeCloseTo(4, 1);
+    expect(out[powerAt + schema.power.indexOf('all')]).toBeCloseTo(7, 1);
+    expect(out.subarray(out.length - 2)).toEqual(new Float64Array([-1, -1]));
+  });
+
+  test('should return the sensor count and write what fits', () => {
+    const schema = getMetricsSchema();
+    const out = new Float64Array(schema.temperatures.length);
+    expect(readSensorsInto('temperatures', out)).toBe(schema.temperatures.length);
+
+    const short = new Float64Array(1).fill(-1000);
+    expect(readSensorsInto('temperatures', short)).toBe(schema.temperatures.length);
+    if (schema.temperatures.length > 0) {
+      expect(short[0]).not.toBe(-1000);
+    }
+  });
+
+  test('should reject buffers the layout does not fit in', () => {
+    const schema = getMetricsSchema();
+    expect(() => readRAMUsageInto(new Float64Array(schema.ram.length - 1))).toThrow(RangeError);
+    expect(() => readCPUUsageInto(new Float64Array(schema.cpu_usage.length), 1)).toThrow(RangeError);
+    expect(() => readSensorsInto('voltages', new Float64Array(2), 3)).toThrow(RangeError);
+  });
+});
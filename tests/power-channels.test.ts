@@ -0,0 +1,156 @@
+import { describe, test, expect, afterEach } from 'vitest';
+import {
+  getPowerDataSync,
+  getPowerChannels,
+  getPowerBreakdown,
+  setPowerSource,
+  setPowerSamplerPeriod,
+  stopPowerSampler,
+  getPowerSamplerStats,
+  getEnergyCounters,
+  averagePower,
+  type CannedChannel
+} from '../src/power';
+
+const sleep = (ms: number) => new Promise((resolve) => setTimeout(resolve, ms));
+
+// Energy Model channels as an M1 Pro reports them, mJ per sample
+const m1Pro = [
+  { name: 'CPU Energy', values: [900] },
+  { name: 'EACC_CPU', values: [100] },
+  { name: 'EACC_CPU0', values: [60] },
+  { name: 'EACC_CPU1', values: [40] },
+  { name: 'PACC0_CPU', values: [500] },
+  { name: 'PACC0_CPU0', values: [200] },
+  { name: 'PACC0_CPU1', values: [300] },
+  { name: 'PACC1_CPU', values: [300] },
+  { name: 'PACC1_CPU0', values: [300] },
+  { name: 'PACC0_CPU0_SRAM', values: [20] },
+  { name: 'GPU Energy', values: [2000] },
+  { name: 'GPU SRAM', values: [50] },
+  { name: 'ANE', values: [30000], unit: 'uJ' as const },
+  { name: 'DRAM', values: [400] },
+  { name: 'DISP', values: [250] }
+];
+
+async function sampleCanned(channels: CannedChannel[], samples: number) {
+  setPowerSource({ type: 'canned', channels });
+  setPowerSamplerPeriod(10);
+  getPowerDataSync();
+  const first = getPowerSamplerStats().samples - 1;
+  while (getPowerSamplerStats().samples - first < samples) {
+    await sleep(5);
+  }
+  stopPowerSampler();
+}
+
+describe('Power Channels', () => {
+  afterEach(() => {
+    setPowerSource();
+    setPowerSamplerPeriod(0);
+  });
+
+  test('should classify every channel', async () => {
+    await sampleCanned(m1Pro, 2);
+    const channels = getPowerChannels();
+    expect(channels.map((channel) => channel.name)).toEqual(m1Pro.map((channel) => channel.name));
+
+    const byName = Object.fromEntries(channels.map((channel) => [channel.name, channel]));
+    expect(byName['CPU Energy']).toMatchObject({ component: 'cpu', cluster: null, in_component: true, in_total: true });
+    expect(byName['EACC_CPU']).toMatchObject({ component: 'cpu', cluster: 'E0', core: null, in_component: false });
+    expect(byName['PACC1_CPU0']).toMatchObject({ cluster: 'P1', core: 0, die: 0 });
+    expect(byName['PACC0_CPU0_SRAM']).toMatchObject({ cluster: 'P0', core: 0, sram: true, in_total: false });
+    expect(byName['GPU SRAM']).toMatchObject({ component: 'gpu_ram', in_component: true, in_total: false });
+    expect(byName['DISP']).toMatchObject({ component: 'other', in_component: false, in_total: true });
+    expect(getPowerSamplerStats().source).toBe('canned');
+  });
+
+  test('should accumulate joules in the channel unit', async () => {
+    await sampleCanned(m1Pro, 3);
+    const channels = getPowerChannels();
+    const samples = channels[0].joules / 0.9;
+    expect(samples).toBeGreaterThanOrEqual(3);
+
+    const byName = Object.fromEntries(channels.map((channel) => [channel.name, channel]));
+    expect(byName['ANE'].joules).toBeCloseTo(samples * 0.03, 9);
+    expect(byName['PACC0_CPU1'].joules).toBeCloseTo(samples * 0.3, 9);
+    expect(byName['PACC0_CPU1'].watts / byName['PACC0_CPU0'].watts).toBeCloseTo(1.5, 9);
+  });
+
+  test('should keep whole-component totals unchanged', async () => {
+    await sampleCanned(m1Pro, 2);
+    // Both reads restart the sampler, so compare shares rather than watts
+    const power = getPowerDataSync();
+    const channels = getPowerChannels();
+    const joules = (name: string) => channels.find((channel) => channel.name === name)!.joules;
+
+    expect(power.gpu / power.cpu).toBeCloseTo(joules('GPU Energy') / joules('CPU Energy'), 6);
+    expect(power.gpu_ram / power.cpu).toBeCloseTo(joules('GPU SRAM') / joules('CPU Energy'), 6);
+    // in_total channels make up the Energy Model total; power.system is the SMC's own reading
+    const inTotal = channels.filter((channel) => channel.in_total).reduce((sum, channel) => sum + channel.joules, 0);
+    const from = getEnergyCounters();
+    await sleep(50);
+    const average = averagePower(from, getEnergyCounters());
+    expect(average.total / average.cpu).toBeCloseTo(inTotal / joules('CPU Energy'), 6);
+  });
+
+  test('should group CPU channels by cluster and core', async () => {
+    await sampleCanned(
+      [...m1Pro, { name: 'DIE_1_ECPU0', values: [10] }, { name: 'DIE_1_ECPU1', values: [30] }],
+      2
+    );
+    const { clusters } = getPowerBreakdown();
+    expect(clusters.map((cluster) => `${cluster.die}:${cluster.cluster}`)).toEqual(['0:E0', '0:P0', '0:P1', '1:E0']);
+
+    const p0 = clusters[1];
+    expect(p0.cores.map((core) => core.name)).toEqual(['PACC0_CPU0', 'PACC0_CPU1']);
+    expect(p0.watts / clusters[0].watts).toBeCloseTo(5, 9);
+
+    // No cluster channel on die 1: the cores add up
+    const die1 = clusters[3];
+    expect(die1.joules).toBeCloseTo(die1.cores[0].joules * 4, 9);
+  });
+
+  test('should reset channels when the source changes', async () => {
+    await sampleCanned(m1Pro, 2);
+    setPowerSource({ type: 'fake', cpu: 2, gpu: 1, ram: 0.5 });
+    setPowerSamplerPeriod(10);
+
+    const names = getPowerChannels().map((channel) => channel.name);
+    expect(names).toEqual(['CPU Energy', 'GPU Energy', 'ANE', 'DRAM', 'GPU SRAM', 'Other']);
+    const from = getEnergyCounters();
+    await sleep(50);
+    expect(averagePower(from, getEnergyCounters()).total).toBeCloseTo(3.5, 1);
+  });
+
+  test('should only sample the groups it subscribes to', async () => {
+    const cpuStats = {
+      group: 'CPU Stats',
+      subgroup: 'CPU Core Performance States',
+      name: 'PCPU0',
+      states: ['IDLE', 'V0P5', 'V1P4'],
+      values: [[40, 10, 50]]
+    };
+    await sampleCanned([m1Pro[0], cpuStats, m1Pro[10]], 2);
+
+    expect(getPowerSamplerStats().groups).toEqual([]);
+    expect(getPowerChannels().map((channel) => channel.name)).toEqual(['CPU Energy', 'GPU Energy']);
+    const power = getPowerDataSync();
+    expect(power.gpu / power.cpu).toBeCloseTo(2000 / 900, 6);
+    expect(getPowerSamplerStats().groups).toEqual(['Energy Model']);
+  });
+
+  test('should reject residencies that do not match the states', () => {
+    expect(() => setPowerSource({
+      type: 'canned',
+      channels: [{ group: 'CPU Stats', name: 'PCPU0', states: ['IDLE', 'V0P5'], values: [[1, 2, 3]] }]
+    })).toThrow(TypeError);
+  });
+
+  test('should reject unknown energy units', () => {
+    expect(() => setPowerSource({
+      type: 'canned',
+      channels: [{ name: 'CPU Energy', unit: 'kWh' as 'mJ', values: [1] }]
+    })).toThrow(TypeError);
+  });
+});
@@ -0,0 +1,152 @@
+import { describe, test, expect, afterEach } from 'vitest';
+import {
+  getPowerData,
+  getPowerDataSync,
+  setPowerSource,
+  setPowerSamplerPeriod,
+  stopPowerSampler,
+  getPowerSamplerStats,
+  getEnergyCounters,
+  averagePower
+} from '../src/power';
+
+const sleep = (ms: number) => new Promise((resolve) => setTimeout(resolve, ms));
+
+describe('Power Sampler', () => {
+  afterEach(() => {
+    setPowerSource();
+    setPowerSamplerPeriod(0);
+  });
+
+  test('should report the fake source power', async () => {
+    setPowerSource({ type: 'fake', cpu: 4, gpu: 2, ane: 1, ram: 0.5, gpu_ram: 0.25 });
+    setPowerSamplerPeriod(20);
+
+    const power = await getPowerData();
+    expect(power.cpu).toBeCloseTo(4, 1);
+    expect(power.gpu).toBeCloseTo(2, 1);
+    expect(power.ane).toBeCloseTo(1, 1);
+    expect(power.all).toBeCloseTo(7, 1);
+    expect(getPowerSamplerStats().source).toBe('fake');
+  });
+
+  test('should serve reads from the latest snapshot', async () => {
+    setPowerSource({ type: 'fake', cpu: 3 });
+    setPowerSamplerPeriod(20);
+    getPowerDataSync();
+
+    const before = getPowerSamplerStats();
+    const started = performance.now();
+    for (let i = 0; i < 1000; i++) {
+      getPowerDataSync();
+    }
+    // Without the sampler each read would take a whole window
+    expect(performance.now() - started).toBeLessThan(250);
+
+    const after = getPowerSamplerStats();
+    expect(after.reads - before.reads).toBe(1000);
+    expect(after.waits).toBe(before.waits);
+  });
+
+  test('should keep sampling in the background', async () => {
+    setPowerSource({ type: 'fake', cpu: 1 });
+    setPowerSamplerPeriod(10);
+    getPowerDataSync();
+
+    const before = getPowerSamplerStats().samples;
+    await sleep(200);
+    const stats = getPowerSamplerStats();
+    expect(stats.running).toBe(true);
+    expect(stats.samples - before).toBeGreaterThanOrEqual(5);
+    expect(stats.age_ms).toBeLessThan(100);
+  });
+
+  test('should span failed samples with the next window', async () => {
+    setPowerSource({ type: 'fake', cpu: 2, fail_samples: 2 });
+    setPowerSamplerPeriod(20);
+
+    const power = getPowerDataSync();
+    const stats = getPowerSamplerStats();
+    expect(power.cpu).toBeCloseTo(2, 1);
+    expect(stats.errors).toBeGreaterThanOrEqual(2);
+    expect(stats.window_ms).toBeGreaterThanOrEqual(55);
+  });
+
+  test('should stop and restart on the next read', () => {
+    setPowerSource({ type: 'fake', gpu: 5 });
+    setPowerSamplerPeriod(20);
+    getPowerDataSync();
+
+    stopPowerSampler();
+    expect(getPowerSamplerStats().running).toBe(false);
+    expect(getPowerDataSync().gpu).toBeCloseTo(5, 1);
+    expect(getPowerSamplerStats().running).toBe(true);
+  });
+
+  test('should count energy over measured time', async () => {
+    setPowerSource({ type: 'fake', cpu: 4, gpu: 2, ram: 1 });
+    setPowerSamplerPeriod(10);
+
+    const from = getEnergyCounters();
+    await sleep(100);
+    const to = getEnergyCounters();
+    expect(to.time_ms).toBeGreaterThan(from.time_ms);
+
+    const power = averagePower(from, to);
+    expect(power.cpu).toBeCloseTo(4, 1);
+    expect(power.gpu).toBeCloseTo(2, 1);
+    expect(power.ram).toBeCloseTo(1, 1);
+    expect(power.total).toBeCloseTo(7, 1);
+  });
+
+  test('should keep counting across failed samples and source changes', async () => {
+    setPowerSource({ type: 'fake', cpu: 2 });
+    setPowerSamplerPeriod(10);
+    const first = getEnergyCounters();
+    await sleep(30);
+
+    // The failed samples' energy lands in the next window, so none is lost
+    setPowerSource({ type: 'fake', cpu: 2, fail_samples: 3 });
+    const before = getEnergyCounters();
+    expect(before.cpu).toBeGreaterThanOrEqual(first.cpu);
+    await sleep(100);
+    const after = getEnergyCounters();
+    expect(averagePower(before, after).cpu).toBeCloseTo(2, 1);
+
+    stopPowerSampler();
+    expect(getEnergyCounters().cpu).toBeGreaterThanOrEqual(after.cpu);
+  });
+
+  test('should not wait on a source that cannot start', () => {
+    setPowerSource({ type: 'fake', cpu: 2, fail_starts: 1000 });
+    setPowerSamplerPeriod(200);
+    const before = getPowerSamplerStats();
+
+    const started = performance.now();
+    for (let i = 0; i < 20; i++) {
+      expect(getPowerDataSync().cpu).toBe(0);
+    }
+    // Waiting for a first window would take at least 500 ms per read
+    expect(performance.now() - started).toBeLessThan(250);
+    const stats = getPowerSamplerStats();
+    expect(stats.unavailable).toBe(true);
+    // Only the read that started the thread waited, for its first attempt
+    expect(stats.waits - before.waits).toBeLessThanOrEqual(1);
+  });
+
+  test('should recover once the source starts', async () => {
+    setPowerSource({ type: 'fake', cpu: 2, fail_starts: 2 });
+    setPowerSamplerPeriod(10);
+    getPowerDataSync();
+    expect(getPowerSamplerStats().unavailable).toBe(true);
+
+    // Retries after 10 ms, then 20 ms
+    await sleep(100);
+    expect(getPowerSamplerStats().unavailable).toBe(false);
+    expect(getPowerDataSync().cpu).toBeCloseTo(2, 1);
+  });
+
+  test('should reject unknown power sources', () => {
+    expect(() => setPowerSource({ type: 'nope' as 'fake' })).toThrow(TypeError);
+  });
+});
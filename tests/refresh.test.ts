@@ -0,0 +1,102 @@
+import { describe, test, expect, afterEach } from 'vitest';
+import { createRequire } from 'node:module';
+import { readKeys, setTransport } from '../src/smc';
+import { getFanDataSync } from '../src/fan';
+import { getBatteryDataSync } from '../src/battery';
+import { setRefreshPolicy, setRefreshIntervals, requestRefresh, getRefreshStats } from '../src/refresh';
+
+const requireNative = createRequire(import.meta.url);
+const smc = requireNative('../build/Release/smc.node');
+
+describe('Refresh Policies', () => {
+  afterEach(() => {
+    setRefreshPolicy({ PSTR: 'fast', Tp01: 'fast', 'battery.cycle_count': 'slow' });
+    setRefreshIntervals({ fast_ms: 0, slow_ms: 10000 });
+    setTransport();
+  });
+
+  test('should read fan limits once and skip them afterwards', () => {
+    setTransport({ type: 'simulated', chip: 'M1' });
+    expect(getFanDataSync()).toEqual({ 0: { rpm: 1350, min: 1200, max: 5800 } });
+    expect(getRefreshStats().smc.last_reads).toBe(3);
+
+    const before = smc.smcStats().calls;
+    getFanDataSync();
+    const stats = getRefreshStats().smc;
+    expect(stats.last_reads).toBe(1);
+    expect(stats.last_skipped).toBe(2);
+    // F0Ac only; the fan count is static too
+    expect(smc.smcStats().calls - before).toBe(1);
+  });
+
+  test('should read the fan count once', () => {
+    setTransport({ type: 'simulated', chip: 'M1' });
+    expect(smc.fans()).toBe(1);
+
+    const before = smc.smcStats().calls;
+    expect(smc.fans()).toBe(1);
+    expect(smc.smcStats().calls - before).toBe(0);
+    expect(getRefreshStats().smc.last_skipped).toBe(1);
+
+    requestRefresh(['FNum']);
+    smc.fans();
+    expect(smc.smcStats().calls - before).toBe(0);
+  });
+
+  test('should re-read on-demand keys only when asked', () => {
+    setTransport({ type: 'simulated', chip: 'M1' });
+    setRefreshPolicy({ PSTR: 'on-demand' });
+
+    readKeys(['PSTR']);
+    const before = smc.smcStats().calls;
+    for (let i = 0; i < 5; i++) {
+      expect(readKeys(['PSTR']).values[0]).toBe(9.5);
+    }
+    expect(smc.smcStats().calls - before).toBe(0);
+
+    requestRefresh(['PSTR']);
+    readKeys(['PSTR']);
+    expect(smc.smcStats().calls - before).toBe(1);
+  });
+
+  test('should hold fast keys for fast_ms', () => {
+    setTransport({
+      type: 'simulated',
+      keys: [{ key: 'Tp01', type: 'flt ', wave: { shape: 'ramp', min: 40, max: 80, period_ms: 4000 } }],
+      time_step_ms: 1000
+    });
+    setRefreshIntervals({ fast_ms: 60000 });
+
+    const first = readKeys(['Tp01']).values[0];
+    expect(readKeys(['Tp01']).values[0]).toBe(first);
+    expect(getRefreshStats().smc.last_skipped).toBe(1);
+  });
+
+  test('should read every key again after a transport change', () => {
+    setTransport({ type: 'simulated', chip: 'M1' });
+    getFanDataSync();
+    setTransport({ type: 'simulated', chip: 'Intel' });
+
+    expect(getFanDataSync()[0]).toEqual({ rpm: 1800, min: 1200, max: 6000 });
+    expect(getRefreshStats().smc.last_skipped).toBe(0);
+  });
+
+  test('should count battery fields read and skipped', () => {
+    if (!getBatteryDataSync().battery_installed) return;
+    const first = getRefreshStats().battery;
+    getBatteryDataSync();
+    const second = getRefreshStats().battery;
+
+    expect(second.ticks).toBe(first.ticks + 1);
+    expect(second.last_reads + second.last_skipped).toBe(15);
+    // Design capacity and design cycle count are static
+    expect(second.last_skipped).toBeGreaterThanOrEqual(2);
+  });
+
+  test('should reject unknown metrics and policies', () => {
+    expect(() => setRefreshPolicy({ 'battery.nope': 'slow' })).toThrow(TypeError);
+    expect(() => setRefreshPolicy({ TOOLONG: 'slow' })).toThrow(TypeError);
+    expect(() => setRefreshPolicy({ F0Ac: 'sometimes' as 'slow' })).toThrow(TypeError);
+    expect(() => requestRefresh(['battery.nope'])).toThrow(TypeError);
+  });
+});
@@ -0,0 +1,85 @@
+import { describe, test, expect, afterEach } from 'vitest';
+import { createRequire } from 'node:module';
+import { fpe2 } from './helpers';
+
+const requireNative = createRequire(import.meta.url);
+const smc = requireNative('../build/Release/smc.node');
+
+const fanKeys = [
+  { key: 'FNum', type: 'ui8 ', bytes: [2] },
+  { key: 'F0Ac', type: 'fpe2', bytes: fpe2(1200) },
+  { key: 'F1Ac', type: 'fpe2', bytes: fpe2(1800) }
+];
+
+describe('SMC Connection', () => {
+  afterEach(() => {
+    smc.setTransport();
+  });
+
+  test('should open the connection once across many calls', () => {
+    smc.setTransport({ type: 'simulated', keys: fanKeys });
+    const before = smc.smcStats();
+
+    for (let i = 0; i < 10; i++) {
+      expect(smc.fans()).toBe(2);
+      expect(smc.fanRpm(0)).toBe(1200);
+      expect(smc.fanRpm(1)).toBe(1800);
+    }
+
+    const after = smc.smcStats();
+    expect(after.transport).toBe('simulated');
+    expect(after.opens - before.opens).toBe(1);
+    expect(after.reconnects - before.reconnects).toBe(0);
+    expect(after.connected).toBe(true);
+    expect(after.refs).toBe(0);
+  });
+
+  test('should reconnect lazily after a failed call', () => {
+    smc.setTransport({ type: 'simulated', keys: fanKeys, fail_calls: 1 });
+    const before = smc.smcStats();
+
+    // The first read fails and drops the connection
+    expect(smc.fans()).toBe(0);
+    expect(smc.smcStats().connected).toBe(false);
+
+    // The next caller reopens it
+    expect(smc.fans()).toBe(2);
+
+    const after = smc.smcStats();
+    expect(after.errors - before.errors).toBe(1);
+    expect(after.opens - before.opens).toBe(2);
+    expect(after.reconnects - before.reconnects).toBe(1);
+  });
+
+  test('should count failed opens and retry on the next call', () => {
+    smc.setTransport({ type: 'simulated', keys: fanKeys, fail_opens: 1 });
+    const before = smc.smcStats();
+
+    // SMCOpen() fails, the read behind it retries the open
+    expect(smc.fans()).toBe(2);
+
+    const after = smc.smcStats();
+    expect(after.failed_opens - before.failed_opens).toBe(1);
+    expect(after.opens - before.opens).toBe(1);
+  });
+
+  test('should reject unknown transports', () => {
+    expect(() => smc.setTransport({ type: 'bogus' })).toThrow(TypeError);
+  });
+
+  test('should keep the hardware connection open between getters', () => {
+    smc.setTransport();
+    smc.fans();
+    const before = smc.smcStats();
+
+    smc.temperature();
+    smc.cpuTemperatureDie();
+    smc.cpuVoltage();
+    smc.fans();
+
+    const after = smc.smcStats();
+    expect(after.transport).toBe('iokit');
+    expect(after.opens - before.opens).toBe(0);
+    expect(after.refs).toBe(0);
+  });
+});
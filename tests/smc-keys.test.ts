@@ -0,0 +1,260 @@
+import { describe, test, expect, beforeEach, afterEach } from 'vitest';
+import { createRequire } from 'node:module';
+import { mkdtempSync, readFileSync, writeFileSync, rmSync } from 'node:fs';
+import { tmpdir } from 'node:os';
+import { join } from 'node:path';
+import { compileKeys, readKeys, listKeys, SMCReadStatus } from '../src/smc';
+import { getFanDataSync } from '../src/fan';
+import { fpe2, flt } from './helpers';
+
+const requireNative = createRequire(import.meta.url);
+const smc = requireNative('../build/Release/smc.node');
+
+const fanKeys = [
+  { key: 'FNum', type: 'ui8 ', bytes: [1] },
+  { key: 'F0Ac', type: 'fpe2', bytes: fpe2(2400) },
+  { key: 'F0Mn', type: 'fpe2', bytes: fpe2(1200) },
+  { key: 'F0Mx', type: 'fpe2', bytes: fpe2(6000) }
+];
+
+describe('SMC Key Info Cache', () => {
+  afterEach(() => {
+    smc.setTransport();
+  });
+
+  test('should need a single SMC call for warm reads', () => {
+    smc.setTransport({ type: 'simulated', keys: fanKeys });
+
+    // Cold read: READ_KEYINFO + READ_BYTES
+    let before = smc.smcStats();
+    expect(smc.fanRpm(0)).toBe(2400);
+    let after = smc.smcStats();
+    expect(after.calls - before.calls).toBe(2);
+    expect(after.key_info_misses - before.key_info_misses).toBe(1);
+
+    // Warm reads: READ_BYTES only
+    before = smc.smcStats();
+    for (let i = 0; i < 10; i++) {
+      expect(smc.fanRpm(0)).toBe(2400);
+    }
+    after = smc.smcStats();
+    expect(after.calls - before.calls).toBe(10);
+    expect(after.key_info_hits - before.key_info_hits).toBe(10);
+    expect(after.key_info_misses - before.key_info_misses).toBe(0);
+  });
+
+  test('should cache keys the SMC does not know', () => {
+    smc.setTransport({ type: 'simulated', keys: fanKeys });
+
+    expect(smc.fanRpm(3)).toBe(0);
+    const before = smc.smcStats();
+    expect(smc.fanRpm(3)).toBe(0);
+    const after = smc.smcStats();
+
+    expect(after.calls - before.calls).toBe(0);
+    expect(after.key_info_hits - before.key_info_hits).toBe(1);
+  });
+
+  test('should flush cached key info when the transport changes', () => {
+    smc.setTransport({ type: 'simulated', keys: fanKeys });
+    smc.fanMin(0);
+    smc.fanMax(0);
+    expect(smc.smcStats().key_info_entries).toBe(2);
+
+    smc.setTransport({ type: 'simulated', keys: fanKeys });
+    expect(smc.smcStats().key_info_entries).toBe(0);
+  });
+});
+
+describe('SMC Batch Reads', () => {
+  const keys = [
+    ...fanKeys,
+    { key: 'Tp01', type: 'flt ', bytes: flt(48.5) },
+    { key: 'TC0P', type: 'sp78', bytes: [0x2d, 0x80] },
+    { key: 'RPlt', type: 'ch8*', bytes: [0x6a, 0x33, 0x31, 0x34] }
+  ];
+
+  afterEach(() => {
+    smc.setTransport();
+  });
+
+  test('should decode every key and report per-key status', () => {
+    smc.setTransport({ type: 'simulated', keys });
+
+    const { values, status } = readKeys(['F0Ac', 'Tp01', 'TC0P', 'RPlt', 'Zz99']);
+
+    expect(values).toBeInstanceOf(Float64Array);
+    expect(status).toBeInstanceOf(Int32Array);
+    expect(Array.from(status)).toEqual([
+      SMCReadStatus.OK,
+      SMCReadStatus.OK,
+      SMCReadStatus.OK,
+      SMCReadStatus.UNSUPPORTED_TYPE,
+      SMCReadStatus.NOT_FOUND
+    ]);
+    expect(values[0]).toBe(2400);
+    expect(values[1]).toBeCloseTo(48.5);
+    expect(values[2]).toBe(45.5);
+    expect(values[3]).toBeNaN();
+    expect(values[4]).toBeNaN();
+  });
+
+  test('should decode every SMC data type', () => {
+    const types = [
+      { key: 'Xsp7', type: 'sp78', bytes: [0xe8, 0x80], value: -23.5 },
+      { key: 'Xsp8', type: 'sp87', bytes: [0x16, 0xc0], value: 45.5 },
+      { key: 'Xsp9', type: 'sp96', bytes: [0xff, 0xc0], value: -1 },
+      { key: 'Xfpe', type: 'fpe2', bytes: fpe2(1200), value: 1200 },
+      { key: 'Xfp8', type: 'fp88', bytes: [0x01, 0x80], value: 1.5 },
+      { key: 'Xflt', type: 'flt ', bytes: flt(36.25), value: 36.25 },
+      { key: 'Xui1', type: 'ui8 ', bytes: [200], value: 200 },
+      { key: 'Xui2', type: 'ui16', bytes: [0x09, 0x60], value: 2400 },
+      { key: 'Xui4', type: 'ui32', bytes: [0x00, 0x01, 0x00, 0x00], value: 65536 },
+      { key: 'Xsi1', type: 'si8 ', bytes: [0xf6], value: -10 },
+      { key: 'Xsi2', type: 'si16', bytes: [0xff, 0x10], value: -240 },
+      { key: 'Xflg', type: 'flag', bytes: [0x01], value: 1 },
+      { key: 'Xbad', type: 'sp78', bytes: [0x01], value: NaN }
+    ];
+    smc.setTransport({ type: 'simulated', keys: types });
+
+    const { values } = readKeys(types.map(entry => entry.key));
+    expect(Array.from(values)).toEqual(types.map(entry => entry.value));
+  });
+
+  test('should reuse a compiled key list and caller-provided arrays', () => {
+    smc.setTransport({ type: 'simulated', keys });
+
+    const compiled = compileKeys(['F0Ac', 'F0Mn', 'F0Mx']);
+    const values = new Float64Array(3);
+    const status = new Int32Array(3);
+
+    expect(compiled).toBeInstanceOf(Uint32Array);
+    expect(compiled[0]).toBe(0x46304163); // 'F0Ac'
+
+    for (let i = 0; i < 3; i++) {
+      const result = readKeys(compiled, values, status);
+      expect(result.values).toBe(values);
+      expect(result.status).toBe(status);
+    }
+    expect(Array.from(values)).toEqual([2400, 1200, 6000]);
+  });
+
+  test('should reject invalid key names', () => {
+    expect(() => compileKeys(['TOOLONG'])).toThrow(TypeError);
+    expect(() => readKeys([42 as unknown as string])).toThrow(TypeError);
+  });
+
+  test('should read all fan values in a single batch', () => {
+    smc.setTransport({ type: 'simulated', keys });
+    getFanDataSync();
+
+    const before = smc.smcStats();
+    expect(getFanDataSync()).toEqual({ 0: { rpm: 2400, min: 1200, max: 6000 } });
+    const after = smc.smcStats();
+
+    // F0Ac; the fan count and limits are static and served from the first read
+    expect(after.calls - before.calls).toBe(1);
+  });
+});
+
+describe('SMC Key Catalog', () => {
+  const catalogKeys = [
+    { key: 'Tp01', type: 'flt ', bytes: flt(40) },
+    { key: 'TpZz', type: 'flt ', bytes: flt(50) },
+    { key: 'Te0T', type: 'flt ', bytes: flt(60) },
+    { key: 'TA0P', type: 'sp78', bytes: [0x1e, 0x00] },
+    ...fanKeys
+  ];
+
+  afterEach(() => {
+    smc.setTransport();
+  });
+
+  test('should enumerate every key once', () => {
+    smc.setTransport({ type: 'simulated', keys: catalogKeys });
+
+    const list = listKeys();
+    expect(list.map(entry => entry.key)).toEqual(catalogKeys.map(entry => entry.key));
+    expect(list[0]).toEqual({ key: 'Tp01', type: 'flt', size: 4, attributes: expect.any(Number) });
+    expect(list[3]).toMatchObject({ key: 'TA0P', type: 'sp78', size: 2 });
+    expect(smc.smcStats().catalog_keys).toBe(catalogKeys.length);
+
+    const before = smc.smcStats();
+    listKeys();
+    expect(smc.smcStats().calls - before.calls).toBe(0);
+  });
+
+  test('should warm the key info cache while enumerating', () => {
+    smc.setTransport({ type: 'simulated', keys: catalogKeys });
+    listKeys();
+
+    const before = smc.smcStats();
+    expect(smc.fanRpm(0)).toBe(2400);
+    const after = smc.smcStats();
+    expect(after.calls - before.calls).toBe(1);
+  });
+
+  test('should rebuild the catalog on transport change', () => {
+    smc.setTransport({ type: 'simulated', keys: catalogKeys });
+    expect(listKeys()).toHaveLength(catalogKeys.length);
+
+    smc.setTransport({ type: 'simulated', keys: fanKeys });
+    expect(listKeys().map(entry => entry.key)).toEqual(['FNum', 'F0Ac', 'F0Mn', 'F0Mx']);
+  });
+
+  test.skipIf(process.arch !== 'arm64')('should find temperature keys outside the probed patterns', () => {
+    smc.setTransport({ type: 'simulated', keys: catalogKeys });
+
+    // Tp01, TpZz and Te0T; TA0P is not a CPU sensor
+    expect(smc.temperature()).toBeCloseTo(50, 5);
+  });
+});
+
+describe.skipIf(process.arch !== 'arm64')('SMC Key Discovery Cache', () => {
+  let cacheDir: string;
+
+  beforeEach(() => {
+    cacheDir = mkdtempSync(join(tmpdir(), 'macstats-'));
+    process.env.MACSTATS_CACHE_DIR = cacheDir;
+    smc.setTransport();
+  });
+
+  afterEach(() => {
+    delete process.env.MACSTATS_CACHE_DIR;
+    smc.setTransport();
+    rmSync(cacheDir, { recursive: true, force: true });
+  });
+
+  test('should save discovered keys with model and OS version', () => {
+    smc.temperature();
+    expect(smc.smcStats().key_cache).toBe('saved');
+
+    const lines = readFileSync(join(cacheDir, 'smc-keys'), 'utf8').split('\n');
+    expect(lines[0]).toBe('macstats-smc-keys 1');
+    expect(lines[1]).toBe(`model ${smc.getSystemData().hardware_model}`);
+    expect(lines[2]).toBe(`os ${smc.getSystemData().os_version}`);
+    expect(lines[3]).toMatch(/^cpu( T[pe]\S{2})*$/);
+  });
+
+  test('should load the cache in a fresh process instead of rediscovering', () => {
+    const temperature = smc.temperature();
+
+    // setTransport() drops all discovered keys, like a new process
+    smc.setTransport();
+    const before = smc.smcStats();
+    expect(smc.temperature()).toBeCloseTo(temperature, 0);
+    const after = smc.smcStats();
+
+    expect(after.key_cache).toBe('loaded');
+    expect(after.catalog_keys).toBe(0);
+    expect(after.key_info_misses - before.key_info_misses).toBeLessThan(10);
+  });
+
+  test('should rebuild a stale cache', () => {
+    writeFileSync(join(cacheDir, 'smc-keys'), 'macstats-smc-keys 1\nmodel Mac0,0\nos macOS 1.0\ncpu Tp01\n');
+
+    smc.temperature();
+    expect(smc.smcStats().key_cache).toBe('saved');
+    expect(readFileSync(join(cacheDir, 'smc-keys'), 'utf8')).not.toContain('Mac0,0');
+  });
+});
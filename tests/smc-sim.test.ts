@@ -0,0 +1,102 @@
+import { describe, test, expect, afterEach } from 'vitest';
+import { createRequire } from 'node:module';
+import { readKeys, listKeys, setTransport, SMCReadStatus } from '../src/smc';
+import { getFanDataSync } from '../src/fan';
+
+const requireNative = createRequire(import.meta.url);
+const smc = requireNative('../build/Release/smc.node');
+
+describe('Simulated SMC Device', () => {
+  afterEach(() => {
+    setTransport();
+  });
+
+  test('should select the die temperature key for the simulated chip', () => {
+    setTransport({ type: 'simulated', chip: 'M3' });
+    expect(smc.cpuTemperatureDie()).toBe(51);
+
+    setTransport({ type: 'simulated', chip: 'M1' });
+    expect(smc.cpuTemperatureDie()).toBe(45.5);
+
+    setTransport({ type: 'simulated', chip: 'Intel' });
+    expect(smc.cpuTemperatureDie()).toBe(58.25);
+  });
+
+  test('should fall back to the M4 key table for M5', () => {
+    setTransport({ type: 'simulated', chip: 'M5' });
+    expect(smc.cpuTemperatureDie()).toBe(49);
+  });
+
+  test('should decode preset fans for both key encodings', () => {
+    setTransport({ type: 'simulated', chip: 'Intel' });
+    expect(getFanDataSync()).toEqual({
+      0: { rpm: 1800, min: 1200, max: 6000 },
+      1: { rpm: 1750, min: 1200, max: 5800 }
+    });
+
+    setTransport({ type: 'simulated', chip: 'M3' });
+    expect(getFanDataSync()[1]).toEqual({ rpm: 1550, min: 1200, max: 6000 });
+  });
+
+  test('should let explicit keys override the preset', () => {
+    setTransport({ type: 'simulated', chip: 'M3', keys: [{ key: 'Tf04', type: 'flt ', value: 88 }] });
+    expect(smc.cpuTemperatureDie()).toBe(88);
+  });
+
+  test('should follow a waveform with a fixed time step', () => {
+    setTransport({
+      type: 'simulated',
+      keys: [{ key: 'Tp01', type: 'flt ', value: 0, wave: { shape: 'ramp', min: 40, max: 80, period_ms: 4000 } }],
+      time_step_ms: 1000
+    });
+    const values = Array.from({ length: 5 }, () => readKeys(['Tp01']).values[0]);
+    expect(values).toEqual([40, 50, 60, 70, 40]);
+  });
+
+  test('should keep noise within bounds and repeat it for a seed', () => {
+    const spec = {
+      type: 'simulated' as const,
+      keys: [{ key: 'Tp01', type: 'flt ', wave: { shape: 'noise' as const, min: 30, max: 90 } }],
+      seed: 42
+    };
+    setTransport(spec);
+    const first = Array.from({ length: 20 }, () => readKeys(['Tp01']).values[0]);
+    setTransport(spec);
+    const second = Array.from({ length: 20 }, () => readKeys(['Tp01']).values[0]);
+
+    expect(second).toEqual(first);
+    for (const value of first) {
+      expect(value).toBeGreaterThanOrEqual(30);
+      expect(value).toBeLessThanOrEqual(90);
+    }
+  });
+
+  test('should recover from injected errors', () => {
+    setTransport({ type: 'simulated', chip: 'M2', error_rate: 0.2, seed: 7 });
+    const opens = smc.smcStats().opens;
+    for (let i = 0; i < 50; i++) {
+      const { status } = readKeys(['Tp01', 'F0Ac']);
+      expect(Array.from(status).every((s) => s === SMCReadStatus.OK || s === SMCReadStatus.ERROR)).toBe(true);
+    }
+    const stats = smc.smcStats();
+    expect(stats.sim_errors).toBeGreaterThan(0);
+    expect(stats.opens).toBeGreaterThan(opens);
+  });
+
+  test('should serve large key tables', () => {
+    const keys = Array.from({ length: 500 }, (_, i) => ({
+      key: `T${i.toString(36).padStart(3, '0')}`,
+      type: 'flt ',
+      value: i
+    }));
+    setTransport({ type: 'simulated', keys });
+    expect(listKeys()).toHaveLength(500);
+
+    const { values } = readKeys(keys.map((k) => k.key));
+    expect(Array.from(values)).toEqual(keys.map((k) => k.value));
+  });
+
+  test('should reject unknown chip generations', () => {
+    expect(() => setTransport({ type: 'simulated', chip: 'M9' as 'M1' })).toThrow(TypeError);
+  });
+});
@@ -0,0 +1,89 @@
+import { describe, test, expect, beforeEach, afterEach } from 'vitest';
+import { createRequire } from 'node:module';
+import { mkdtempSync, readFileSync, writeFileSync, rmSync } from 'node:fs';
+import { tmpdir } from 'node:os';
+import { join } from 'node:path';
+import { readKeys, listKeys, setTransport } from '../src/smc';
+import { getFanDataSync } from '../src/fan';
+import { fpe2, flt } from './helpers';
+
+const requireNative = createRequire(import.meta.url);
+const smc = requireNative('../build/Release/smc.node');
+
+const keys = [
+  { key: 'FNum', type: 'ui8 ', bytes: [1] },
+  { key: 'F0Ac', type: 'fpe2', bytes: fpe2(2400) },
+  { key: 'F0Mn', type: 'fpe2', bytes: fpe2(1200) },
+  { key: 'F0Mx', type: 'fpe2', bytes: fpe2(6000) },
+  { key: 'Tp01', type: 'flt ', bytes: flt(48.5) }
+];
+
+const HEADER_SIZE = 16;
+const RECORD_SIZE = 80;
+
+describe('SMC Record/Replay', () => {
+  let dir: string;
+  let trace: string;
+
+  beforeEach(() => {
+    dir = mkdtempSync(join(tmpdir(), 'macstats-'));
+    trace = join(dir, 'test.smctrace');
+  });
+
+  afterEach(() => {
+    setTransport();
+    rmSync(dir, { recursive: true, force: true });
+  });
+
+  test('should record every SMC call to the trace file', () => {
+    setTransport({ type: 'record', path: trace, source: { type: 'simulated', keys } });
+    expect(getFanDataSync()).toEqual({ 0: { rpm: 2400, min: 1200, max: 6000 } });
+    const calls = smc.smcStats().calls;
+    expect(smc.smcStats().trace_records).toBe(calls);
+    setTransport();
+
+    const data = readFileSync(trace);
+    expect(data.subarray(0, 8).toString()).toBe('SMCTRACE');
+    expect(data.readUInt32LE(8)).toBe(1);
+    expect(data.readUInt32LE(12)).toBe(RECORD_SIZE);
+    expect(data.length).toBe(HEADER_SIZE + calls * RECORD_SIZE);
+  });
+
+  test('should replay the same values with the same call count', () => {
+    setTransport({ type: 'record', path: trace, source: { type: 'simulated', keys } });
+    const recorded = readKeys(['F0Ac', 'Tp01', 'Zz99']);
+    const recordedKeys = listKeys();
+    const recordedCalls = smc.smcStats().calls;
+    setTransport();
+
+    setTransport({ type: 'replay', path: trace });
+    const before = smc.smcStats().calls;
+    const replayed = readKeys(['F0Ac', 'Tp01', 'Zz99']);
+    expect(listKeys()).toEqual(recordedKeys);
+
+    expect(Array.from(replayed.values)).toEqual(Array.from(recorded.values));
+    expect(Array.from(replayed.status)).toEqual(Array.from(recorded.status));
+    expect(smc.smcStats().calls - before).toBe(recordedCalls);
+    expect(smc.smcStats().replay_misses).toBe(0);
+    expect(smc.smcStats().transport).toBe('replay');
+  });
+
+  test('should report keys the trace never saw as missing', () => {
+    setTransport({ type: 'record', path: trace, source: { type: 'simulated', keys } });
+    readKeys(['F0Ac']);
+    setTransport();
+
+    setTransport({ type: 'replay', path: trace });
+    const { status } = readKeys(['Tp01']);
+    expect(status[0]).toBe(1); // NOT_FOUND
+    expect(smc.smcStats().replay_misses).toBe(1);
+  });
+
+  test('should reject missing or foreign trace files', () => {
+    expect(() => setTransport({ type: 'replay', path: join(dir, 'missing') })).toThrow();
+
+    writeFileSync(trace, 'not a trace file');
+    expect(() => setTransport({ type: 'replay', path: trace })).toThrow();
+    expect(() => setTransport({ type: 'record', path: '' })).toThrow(TypeError);
+  });
+});
@@ -0,0 +1,53 @@
+import { describe, test, expect, afterEach } from 'vitest';
+import { createRequire } from 'node:module';
+import { setTransport } from '../src/smc';
+import { getFanDataSync } from '../src/fan';
+import { getCpuDataSync } from '../src/cpu';
+import { setPowerSource, setPowerSamplerPeriod } from '../src/power';
+import { getSnapshot, getSnapshotSync, SnapshotMetricName } from '../src/snapshot';
+
+const requireNative = createRequire(import.meta.url);
+const smc = requireNative('../build/Release/smc.node');
+
+describe('Snapshot', () => {
+  afterEach(() => {
+    setTransport();
+    setPowerSource();
+    setPowerSamplerPeriod(0);
+  });
+
+  test('should return only the requested metrics', () => {
+    const snapshot = getSnapshotSync(['fans', 'cpuUsage']);
+    expect(Object.keys(snapshot).sort()).toEqual(['cpuUsage', 'fans']);
+  });
+
+  test('should return every metric by default', async () => {
+    const snapshot = await getSnapshot();
+    expect(Object.keys(snapshot).sort()).toEqual([
+      'battery', 'cpu', 'cpuUsage', 'disks', 'fans', 'gpu', 'memory', 'power', 'ram', 'sensors', 'system'
+    ]);
+    expect(Array.isArray(snapshot.sensors?.temperatures)).toBe(true);
+    expect(snapshot.ram?.total).toBeGreaterThan(0);
+  });
+
+  test('should match the module getters on a simulated device', async () => {
+    setTransport({ type: 'simulated', chip: 'M3' });
+    const snapshot = await getSnapshot(['fans', 'cpu']);
+
+    expect(snapshot.fans).toEqual(getFanDataSync());
+    expect(snapshot.cpu?.temperatureDie).toBe(Math.round(getCpuDataSync().temperatureDie));
+  });
+
+  test('should read power from the sampler', () => {
+    setPowerSource({ type: 'fake', cpu: 3, gpu: 1 });
+    setPowerSamplerPeriod(20);
+    const { power } = getSnapshotSync(['power']);
+    expect(power?.cpu).toBeCloseTo(3, 1);
+    expect(power?.all).toBeCloseTo(4, 1);
+  });
+
+  test('should reject unknown metrics', () => {
+    expect(() => getSnapshotSync(['nope' as SnapshotMetricName])).toThrow(TypeError);
+    expect(() => smc.snapshot(1 << 20)).toThrow(TypeError);
+  });
+});
@@ -0,0 +1,88 @@
+import { describe, test, expect, afterEach } from 'vitest';
+import { setTransport } from '../src/smc';
+import { subscribe, Subscription, SubscriptionSample } from '../src/snapshot';
+
+const sleep = (ms: number) => new Promise((resolve) => setTimeout(resolve, ms));
+
+function busy(ms: number) {
+  const until = Date.now() + ms;
+  while (Date.now() < until);
+}
+
+describe('Subscriptions', () => {
+  let subscription: Subscription | undefined;
+
+  afterEach(() => {
+    subscription?.unsubscribe();
+    subscription = undefined;
+    setTransport();
+  });
+
+  test('should push samples in timestamp order', async () => {
+    setTransport({ type: 'simulated', chip: 'M1' });
+    const received: SubscriptionSample[] = [];
+    subscription = subscribe({ metrics: ['fans'], intervalMs: 20 }, (samples) => received.push(...samples));
+
+    await sleep(300);
+    expect(received.length).toBeGreaterThanOrEqual(5);
+    expect(received[0].fans).toEqual({ 0: { rpm: 1350, min: 1200, max: 5800 } });
+    expect(Object.keys(received[0]).sort()).toEqual(['fans', 'timestamp']);
+    for (let i = 1; i < received.length; i++) {
+      expect(received[i].timestamp).toBeGreaterThan(received[i - 1].timestamp);
+    }
+  });
+
+  test('should stop after unsubscribing', async () => {
+    setTransport({ type: 'simulated', chip: 'M1' });
+    let count = 0;
+    subscription = subscribe({ metrics: ['fans'], intervalMs: 10 }, (samples) => (count += samples.length));
+    await sleep(100);
+    subscription.unsubscribe();
+
+    const after = count;
+    await sleep(100);
+    expect(count).toBe(after);
+    expect(subscription.stats().delivered).toBe(after);
+  });
+
+  test('should drop the oldest samples while JS is busy', async () => {
+    setTransport({ type: 'simulated', chip: 'M1' });
+    const batches: number[] = [];
+    subscription = subscribe({ metrics: ['fans'], intervalMs: 5, bufferSize: 4 }, (samples) => batches.push(samples.length));
+
+    busy(200);
+    await sleep(20);
+    const stats = subscription.stats();
+    expect(Math.max(...batches)).toBeLessThanOrEqual(4);
+    expect(stats.dropped).toBeGreaterThan(0);
+    // One sample may be in flight between the sampling thread and the buffer
+    const accounted = stats.delivered + stats.dropped + stats.pending;
+    expect(stats.samples - accounted).toBeGreaterThanOrEqual(0);
+    expect(stats.samples - accounted).toBeLessThanOrEqual(1);
+  });
+
+  test('should coalesce pending samples into the newest', async () => {
+    setTransport({ type: 'simulated', chip: 'M1' });
+    const batches: SubscriptionSample[][] = [];
+    subscription = subscribe(
+      { metrics: ['fans'], intervalMs: 5, bufferSize: 4, overflow: 'coalesce' },
+      (samples) => batches.push(samples)
+    );
+
+    busy(100);
+    await sleep(20);
+    const stats = subscription.stats();
+    expect(batches.every((batch) => batch.length === 1)).toBe(true);
+    expect(stats.coalesced).toBeGreaterThan(0);
+    expect(stats.dropped).toBe(0);
+    // One sample may be in flight between the sampling thread and the buffer
+    const accounted = stats.delivered + stats.coalesced + stats.pending;
+    expect(stats.samples - accounted).toBeGreaterThanOrEqual(0);
+    expect(stats.samples - accounted).toBeLessThanOrEqual(1);
+  });
+
+  test('should reject bad options', () => {
+    expect(() => subscribe({ intervalMs: 0 }, () => {})).toThrow(TypeError);
+    expect(() => subscribe({ metrics: ['nope' as 'fans'] }, () => {})).toThrow(TypeError);
+  });
+});
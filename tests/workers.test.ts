@@ -0,0 +1,76 @@
+import { describe, test, expect } from 'vitest';
+import { Worker } from 'node:worker_threads';
+import { fileURLToPath } from 'node:url';
+import { createRequire } from 'node:module';
+
+const addonPath = fileURLToPath(new URL('../build/Release/smc.node', import.meta.url));
+const requireNative = createRequire(import.meta.url);
+const smc = requireNative('../build/Release/smc.node');
+
+// Each worker loads its own instance of the addon, reads through the shared
+// SMC connection and runs a subscription on its own event loop
+const workerSource = `
+const { parentPort, workerData } = require('node:worker_threads');
+const smc = require(workerData.addonPath);
+
+const ram = smc.getRAMUsageData();
+const cpu = smc.getCPUUsageData();
+const power = smc.getAllPower();
+smc.readKeys(['FNum']);
+const buffer = new Float64Array(smc.metricsSchema().ram.length);
+smc.getRAMUsageData(buffer);
+
+smc.snapshotAsync(1 << 2 | 1 << 5).then((snapshot) => {
+  const id = smc.subscribe(1 << 5, 10, 4, false, (samples) => {
+    if (workerData.leaveSubscribed) {
+      parentPort.postMessage({ done: true });
+      return;
+    }
+    smc.unsubscribe(id);
+    parentPort.postMessage({
+      ramTotal: ram.total,
+      bufferTotal: buffer[0],
+      cpuKeys: Object.keys(cpu),
+      powerKeys: Object.keys(power),
+      snapshotKeys: Object.keys(snapshot),
+      sampled: samples[0].ram.total
+    });
+  });
+});
+`;
+
+function runWorker(leaveSubscribed = false): Promise<Record<string, unknown>> {
+  return new Promise((resolve, reject) => {
+    const worker = new Worker(workerSource, { eval: true, workerData: { addonPath, leaveSubscribed } });
+    worker.once('message', (message) => {
+      worker.terminate().then(() => resolve(message), reject);
+    });
+    worker.once('error', reject);
+  });
+}
+
+describe('Worker Threads', () => {
+  test('should load in several workers at once', async () => {
+    const results = await Promise.all(Array.from({ length: 4 }, () => runWorker()));
+    const ram = smc.getRAMUsageData();
+
+    for (const result of results) {
+      expect(result.ramTotal).toBe(ram.total);
+      expect(result.bufferTotal).toBe(ram.total);
+      expect(result.sampled).toBe(ram.total);
+      expect(result.cpuKeys).toEqual(Object.keys(smc.getCPUUsageData()));
+      expect(result.powerKeys).toEqual(['cpu', 'gpu', 'ane', 'all', 'system', 'ram', 'gpu_ram']);
+      expect(result.snapshotKeys).toEqual(['cpu_usage', 'ram']);
+    }
+  });
+
+  test('should keep working on the main thread after workers exit', async () => {
+    // Worker teardown stops a subscription left running
+    await Promise.all([runWorker(true), runWorker(true)]);
+
+    expect(smc.getRAMUsageData().total).toBeGreaterThan(0);
+    expect(smc.readKeys(['FNum']).values).toHaveLength(1);
+    const power = smc.getAllPower();
+    expect(power.all).toBeGreaterThanOrEqual(0);
+  });
+});